@@ -25,6 +25,129 @@
 
 #define DBUS_PROPS_IFACE "org.freedesktop.DBus.Properties"
 
+/* Failed checks are cached together with their error messages so that missing
+ * or too old dependencies are not probed again and again. The cached failures
+ * are only valid for the generation of the dependency checks they were recorded
+ * in (see bd_utils_get_deps_cache_generation()). Slots are keyed by the checked
+ * dependency (e.g. utility name and required version), not by the address of its
+ * spec, so that plugins reloaded by bd_reinit() reuse them. They are never freed
+ * or reused for a different dependency so they can be read without any locking.
+ */
+#define MAX_FAILED_DEPS 64
+
+typedef struct FailedDep {
+    gchar *key;
+    gchar *message;
+    volatile gint generation;
+} FailedDep;
+
+static FailedDep failed_deps[MAX_FAILED_DEPS];
+static volatile gint n_failed_deps = 0;
+static GMutex failed_deps_lock;
+
+typedef gchar* (*DepKeyFunc) (gconstpointer spec);
+
+static gchar* util_dep_key (gconstpointer spec) {
+    const UtilDep *dep = (const UtilDep *) spec;
+
+    return g_strdup_printf ("util:%s:%s:%s:%s", dep->name, dep->version ? dep->version : "",
+                            dep->ver_arg ? dep->ver_arg : "", dep->ver_regexp ? dep->ver_regexp : "");
+}
+
+static gchar* module_dep_key (gconstpointer spec) {
+    return g_strdup_printf ("module:%s", *((const gchar *const *) spec));
+}
+
+static gchar* feature_dep_key (gconstpointer spec) {
+    const UtilFeatureDep *dep = (const UtilFeatureDep *) spec;
+
+    return g_strdup_printf ("feature:%s:%s:%s:%s", dep->util_name, dep->feature,
+                            dep->feature_arg ? dep->feature_arg : "",
+                            dep->feature_regexp ? dep->feature_regexp : "");
+}
+
+static const gchar* get_failed_dep (const gchar *key, guint generation) {
+    gint n_failed = g_atomic_int_get (&n_failed_deps);
+    gint i = 0;
+
+    for (i=0; i < n_failed; i++)
+        if ((guint) g_atomic_int_get (&(failed_deps[i].generation)) == generation &&
+            g_strcmp0 (failed_deps[i].key, key) == 0)
+            return failed_deps[i].message;
+
+    return NULL;
+}
+
+static void add_failed_dep (const gchar *key, guint generation, const gchar *message) {
+    gint n_failed = 0;
+    gint i = 0;
+
+    g_mutex_lock (&failed_deps_lock);
+    n_failed = g_atomic_int_get (&n_failed_deps);
+    for (i=0; i < n_failed; i++) {
+        if (g_strcmp0 (failed_deps[i].key, key) == 0 && g_strcmp0 (failed_deps[i].message, message) == 0) {
+            g_atomic_int_set (&(failed_deps[i].generation), (gint) generation);
+            g_mutex_unlock (&failed_deps_lock);
+            return;
+        }
+    }
+
+    /* if there's no free slot, the failure is just not cached */
+    if (n_failed < MAX_FAILED_DEPS) {
+        failed_deps[n_failed].key = g_strdup (key);
+        failed_deps[n_failed].message = g_strdup (message);
+        g_atomic_int_set (&(failed_deps[n_failed].generation), (gint) generation);
+        /* publish the new slot */
+        g_atomic_int_inc (&n_failed_deps);
+    } else
+        bd_utils_log_format (BD_UTILS_LOG_WARNING, "No free slot to cache the failed dependency check '%s'", key);
+    g_mutex_unlock (&failed_deps_lock);
+}
+
+static void set_dep_error (GError **error, GQuark domain, gint code, const gchar *message) {
+    if (!error)
+        return;
+
+    if (*error)
+        g_prefix_error (error, "%s\n", message);
+    else
+        g_set_error (error, domain, code, "%s", message);
+}
+
+/**
+ * get_cached_failures: (skip)
+ *
+ * Returns: whether all the @req_deps not available in @val failed in the
+ *          @generation or not, @error is populated with the cached errors
+ *          in the former case
+ */
+static gboolean get_cached_failures (guint val, guint req_deps, gconstpointer specs, gsize spec_size, guint l_deps,
+                                     DepKeyFunc key_func, guint generation, GQuark domain, gint code, GError **error) {
+    guint i = 0;
+    gchar *key = NULL;
+    const gchar *message = NULL;
+
+    for (i=0; i < l_deps; i++) {
+        if (((1 << i) & req_deps) && !((1 << i) & val)) {
+            key = key_func ((const guint8 *) specs + i * spec_size);
+            message = get_failed_dep (key, generation);
+            g_free (key);
+            if (!message)
+                return FALSE;
+        }
+    }
+
+    for (i=0; i < l_deps; i++) {
+        if (((1 << i) & req_deps) && !((1 << i) & val)) {
+            key = key_func ((const guint8 *) specs + i * spec_size);
+            message = get_failed_dep (key, generation);
+            g_free (key);
+            set_dep_error (error, domain, code, message);
+        }
+    }
+
+    return TRUE;
+}
 
 G_GNUC_INTERNAL gboolean
 check_deps (volatile guint *avail_deps, guint req_deps, const UtilDep *deps_specs, guint l_deps, GMutex *deps_check_lock, GError **error) {
@@ -32,12 +155,20 @@ check_deps (volatile guint *avail_deps, guint req_deps, const UtilDep *deps_spec
     gboolean ret = FALSE;
     GError *l_error = NULL;
     guint val = 0;
+    guint generation = 0;
+    const gchar *message = NULL;
 
     val = (guint) g_atomic_int_get (avail_deps);
     if ((val & req_deps) == req_deps)
         /* we have everything we need */
         return TRUE;
 
+    /* no need to check again if all the missing deps are known to be missing */
+    generation = bd_utils_get_deps_cache_generation ();
+    if (get_cached_failures (val, req_deps, deps_specs, sizeof (UtilDep), l_deps, util_dep_key, generation,
+                             BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_CHECK_ERROR, error))
+        return FALSE;
+
     /* else */
     /* grab a lock to prevent multiple checks from running in parallel */
     g_mutex_lock (deps_check_lock);
@@ -51,17 +182,19 @@ check_deps (volatile guint *avail_deps, guint req_deps, const UtilDep *deps_spec
 
     for (i=0; i < l_deps; i++) {
         if (((1 << i) & req_deps) && !((1 << i) & val)) {
+            g_autofree gchar *key = util_dep_key (&(deps_specs[i]));
+
+            message = get_failed_dep (key, generation);
+            if (message) {
+                set_dep_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_CHECK_ERROR, message);
+                continue;
+            }
             ret = bd_utils_check_util_version (deps_specs[i].name, deps_specs[i].version,
                                                deps_specs[i].ver_arg, deps_specs[i].ver_regexp, &l_error);
             /* if not ret and l_error -> set/prepend error */
             if (!ret) {
-                if (error) {
-                    if (*error)
-                        g_prefix_error (error, "%s\n", l_error->message);
-                    else
-                        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_CHECK_ERROR,
-                                     "%s", l_error->message);
-                }
+                add_failed_dep (key, generation, l_error->message);
+                set_dep_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_CHECK_ERROR, l_error->message);
                 g_clear_error (&l_error);
             } else
                 g_atomic_int_or (avail_deps, 1 << i);
@@ -79,12 +212,21 @@ check_module_deps (volatile guint *avail_deps, guint req_deps, const gchar *cons
     gboolean ret = FALSE;
     GError *l_error = NULL;
     guint val = 0;
+    guint generation = 0;
+    const gchar *message = NULL;
+    gchar *not_avail_msg = NULL;
 
     val = (guint) g_atomic_int_get (avail_deps);
     if ((val & req_deps) == req_deps)
         /* we have everything we need */
         return TRUE;
 
+    /* no need to check again if all the missing modules are known to be missing */
+    generation = bd_utils_get_deps_cache_generation ();
+    if (get_cached_failures (val, req_deps, modules, sizeof (gchar *), l_modules, module_dep_key, generation,
+                             BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_MODULE_CHECK_ERROR, error))
+        return FALSE;
+
     /* else */
     /* grab a lock to prevent multiple checks from running in parallel */
     g_mutex_lock (deps_check_lock);
@@ -98,27 +240,26 @@ check_module_deps (volatile guint *avail_deps, guint req_deps, const gchar *cons
 
     for (i=0; i < l_modules; i++) {
         if (((1 << i) & req_deps) && !((1 << i) & val)) {
+            g_autofree gchar *key = module_dep_key (&(modules[i]));
+
+            message = get_failed_dep (key, generation);
+            if (message) {
+                set_dep_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_MODULE_CHECK_ERROR, message);
+                continue;
+            }
             ret = bd_utils_have_kernel_module (modules[i], &l_error);
             /* if not ret and l_error -> set/prepend error */
             if (!ret) {
                 if (l_error) {
-                    if (error) {
-                        if (*error)
-                            g_prefix_error (error, "%s\n", l_error->message);
-                        else
-                            g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_MODULE_CHECK_ERROR,
-                                         "%s", l_error->message);
-                    }
+                    add_failed_dep (key, generation, l_error->message);
+                    set_dep_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_MODULE_CHECK_ERROR, l_error->message);
                     g_clear_error (&l_error);
                 } else {
                     /* no error from have_kernel_module means we don't have it */
-                    if (error) {
-                        if (*error)
-                            g_prefix_error (error, "Kernel module '%s' not available\n", modules[i]);
-                        else
-                            g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_MODULE_CHECK_ERROR,
-                                         "Kernel module '%s' not available", modules[i]);
-                    }
+                    not_avail_msg = g_strdup_printf ("Kernel module '%s' not available", modules[i]);
+                    add_failed_dep (key, generation, not_avail_msg);
+                    set_dep_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_MODULE_CHECK_ERROR, not_avail_msg);
+                    g_free (not_avail_msg);
                 }
 
             } else
@@ -326,12 +467,20 @@ check_features (volatile guint *avail_deps, guint req_deps, const UtilFeatureDep
     gboolean ret = FALSE;
     GError *l_error = NULL;
     guint val = 0;
+    guint generation = 0;
+    const gchar *message = NULL;
 
     val = (guint) g_atomic_int_get (avail_deps);
     if ((val & req_deps) == req_deps)
         /* we have everything we need */
         return TRUE;
 
+    /* no need to check again if all the missing features are known to be missing */
+    generation = bd_utils_get_deps_cache_generation ();
+    if (get_cached_failures (val, req_deps, deps_specs, sizeof (UtilFeatureDep), l_deps, feature_dep_key, generation,
+                             BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_FEATURE_CHECK_ERROR, error))
+        return FALSE;
+
     /* else */
     /* grab a lock to prevent multiple checks from running in parallel */
     g_mutex_lock (deps_check_lock);
@@ -345,18 +494,20 @@ check_features (volatile guint *avail_deps, guint req_deps, const UtilFeatureDep
 
     for (i=0; i < l_deps; i++) {
         if (((1 << i) & req_deps) && !((1 << i) & val)) {
+            g_autofree gchar *key = feature_dep_key (&(deps_specs[i]));
+
+            message = get_failed_dep (key, generation);
+            if (message) {
+                set_dep_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_FEATURE_CHECK_ERROR, message);
+                continue;
+            }
             ret = _check_util_feature (deps_specs[i].util_name, deps_specs[i].feature,
                                        deps_specs[i].feature_arg, deps_specs[i].feature_regexp, &l_error);
             /* if not ret and l_error -> set/prepend error */
             if (!ret) {
                 if (l_error) {
-                    if (error) {
-                        if (*error)
-                            g_prefix_error (error, "%s\n", l_error->message);
-                        else
-                            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_FEATURE_CHECK_ERROR,
-                                        "%s", l_error->message);
-                    }
+                    add_failed_dep (key, generation, l_error->message);
+                    set_dep_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_FEATURE_CHECK_ERROR, l_error->message);
                     g_clear_error (&l_error);
                 }
             } else
@@ -27,6 +27,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <blkid.h>
+#include <libdevmapper.h>
 #include <sys/types.h>
 #include <keyutils.h>
 #include <blockdev/utils.h>
@@ -258,6 +259,29 @@ BDCryptoBITLKInfo* bd_crypto_bitlk_info_copy (BDCryptoBITLKInfo *info) {
     return new_info;
 }
 
+void bd_crypto_tc_match_free (BDCryptoTCMatch *match) {
+    if (match == NULL)
+        return;
+
+    g_free (match->hash);
+    g_free (match->cipher);
+    g_free (match->mode);
+    g_free (match);
+}
+
+BDCryptoTCMatch* bd_crypto_tc_match_copy (BDCryptoTCMatch *match) {
+    if (match == NULL)
+        return NULL;
+
+    BDCryptoTCMatch *new_match = g_new0 (BDCryptoTCMatch, 1);
+
+    new_match->hash = g_strdup (match->hash);
+    new_match->cipher = g_strdup (match->cipher);
+    new_match->mode = g_strdup (match->mode);
+
+    return new_match;
+}
+
 void bd_crypto_integrity_info_free (BDCryptoIntegrityInfo *info) {
     if (info == NULL)
         return;
@@ -286,6 +310,35 @@ BDCryptoIntegrityInfo* bd_crypto_integrity_info_copy (BDCryptoIntegrityInfo *inf
     return new_info;
 }
 
+void bd_crypto_integrity_status_free (BDCryptoIntegrityStatus *status) {
+    if (status == NULL)
+        return;
+
+    g_free (status->name);
+    g_free (status->algorithm);
+    g_free (status);
+}
+
+BDCryptoIntegrityStatus* bd_crypto_integrity_status_copy (BDCryptoIntegrityStatus *status) {
+    if (status == NULL)
+        return NULL;
+
+    BDCryptoIntegrityStatus *new_status = g_new0 (BDCryptoIntegrityStatus, 1);
+
+    new_status->name = g_strdup (status->name);
+    new_status->mode = status->mode;
+    new_status->algorithm = g_strdup (status->algorithm);
+    new_status->tag_size = status->tag_size;
+    new_status->block_size = status->block_size;
+    new_status->sectors_per_bit = status->sectors_per_bit;
+    new_status->mismatches = status->mismatches;
+    new_status->provided_data_sectors = status->provided_data_sectors;
+    new_status->recalculating = status->recalculating;
+    new_status->recalc_sector = status->recalc_sector;
+
+    return new_status;
+}
+
 void bd_crypto_luks_token_info_free (BDCryptoLUKSTokenInfo *info) {
     if (info == NULL)
         return;
@@ -2939,6 +2992,356 @@ gboolean bd_crypto_integrity_close (const gchar *integrity_device, GError **erro
     return _crypto_close (integrity_device, "integrity", error);
 }
 
+/**
+ * get_dm_map_name: (skip)
+ *
+ * Returns: (transfer full): name of the DM map specified by @device which can
+ *                           be either the name of the map or a path to it
+ */
+static gchar* get_dm_map_name (const gchar *device, GError **error) {
+    gchar *dev_path = NULL;
+    gchar *sys_path = NULL;
+    gchar *name = NULL;
+    gchar *dev_name = NULL;
+
+    if (g_str_has_prefix (device, "/dev/mapper/"))
+        return g_strdup (device + 12);
+    else if (!g_str_has_prefix (device, "/dev/"))
+        return g_strdup (device);
+
+    dev_path = bd_utils_resolve_device (device, error);
+    if (!dev_path)
+        /* error is already populated */
+        return NULL;
+
+    dev_name = g_path_get_basename (dev_path);
+    sys_path = g_strdup_printf ("/sys/class/block/%s/dm/name", dev_name);
+    if (!g_file_get_contents (sys_path, &name, NULL, NULL)) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Device '%s' is not a device mapper device", device);
+        name = NULL;
+    } else
+        g_strstrip (name);
+
+    g_free (sys_path);
+    g_free (dev_name);
+    g_free (dev_path);
+
+    return name;
+}
+
+/**
+ * get_integrity_params: (skip)
+ *
+ * Returns: (transfer full): params of the (only) target of the integrity DM
+ *                           map @map_name for the @task_type task
+ */
+static gchar* get_integrity_params (const gchar *map_name, int task_type, GError **error) {
+    struct dm_task *task = NULL;
+    struct dm_info info;
+    guint64 start = 0;
+    guint64 length = 0;
+    gchar *type = NULL;
+    gchar *params = NULL;
+    gchar *ret = NULL;
+
+    task = dm_task_create (task_type);
+    if (!task) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to create DM task for the map '%s'", map_name);
+        return NULL;
+    }
+
+    if (dm_task_set_name (task, map_name) == 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to create DM task for the map '%s'", map_name);
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    if (dm_task_run (task) == 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to run the DM task for the map '%s'", map_name);
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    if (dm_task_get_info (task, &info) == 0 || !info.exists) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "The map '%s' doesn't exist", map_name);
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    dm_get_next_target (task, NULL, &start, &length, &type, &params);
+    if (g_strcmp0 (type, "integrity") != 0 || !params) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_STATE,
+                     "The map '%s' is not an integrity map", map_name);
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    ret = g_strdup (params);
+    dm_task_destroy (task);
+
+    return ret;
+}
+
+/**
+ * get_integrity_status: (skip)
+ *
+ * Parses the DM table and status of the @map_name integrity map.
+ */
+static BDCryptoIntegrityStatus* get_integrity_status (const gchar *map_name, GError **error) {
+    gchar *table = NULL;
+    gchar *status = NULL;
+    gchar **items = NULL;
+    gchar **item_p = NULL;
+    guint n_items = 0;
+    BDCryptoIntegrityStatus *ret = NULL;
+
+    table = get_integrity_params (map_name, DM_DEVICE_TABLE, error);
+    if (!table)
+        /* error is already populated */
+        return NULL;
+
+    status = get_integrity_params (map_name, DM_DEVICE_STATUS, error);
+    if (!status) {
+        /* error is already populated */
+        g_free (table);
+        return NULL;
+    }
+
+    ret = g_new0 (BDCryptoIntegrityStatus, 1);
+    ret->name = g_strdup (map_name);
+
+    /* <dev> <offset> <tag_size> <mode> <#opt_params> <opt_params> */
+    items = g_strsplit (table, " ", -1);
+    n_items = g_strv_length (items);
+    if (n_items < 5) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to parse DM table of the map '%s': '%s'", map_name, table);
+        g_strfreev (items);
+        g_free (status);
+        g_free (table);
+        bd_crypto_integrity_status_free (ret);
+        return NULL;
+    }
+
+    ret->tag_size = (guint32) g_ascii_strtoull (items[2], NULL, 10);
+    switch (items[3][0]) {
+        case 'J':
+            ret->mode = BD_CRYPTO_INTEGRITY_MODE_JOURNAL;
+            break;
+        case 'B':
+            ret->mode = BD_CRYPTO_INTEGRITY_MODE_BITMAP;
+            break;
+        case 'D':
+            ret->mode = BD_CRYPTO_INTEGRITY_MODE_DIRECT;
+            break;
+        case 'R':
+            ret->mode = BD_CRYPTO_INTEGRITY_MODE_RECOVERY;
+            break;
+        default:
+            ret->mode = BD_CRYPTO_INTEGRITY_MODE_UNKNOWN;
+    }
+
+    ret->block_size = 512;
+    for (item_p=items + 5; *item_p; item_p++) {
+        if (g_str_has_prefix (*item_p, "block_size:"))
+            ret->block_size = (guint32) g_ascii_strtoull (*item_p + 11, NULL, 10);
+        else if (g_str_has_prefix (*item_p, "sectors_per_bit:"))
+            ret->sectors_per_bit = g_ascii_strtoull (*item_p + 16, NULL, 10);
+        else if (g_str_has_prefix (*item_p, "internal_hash:"))
+            /* internal_hash:<algorithm>[:<key>] */
+            ret->algorithm = g_strndup (*item_p + 14, strcspn (*item_p + 14, ":"));
+    }
+    g_strfreev (items);
+    g_free (table);
+
+    /* <mismatches> <provided_data_sectors> <recalc_sector or '-'> */
+    items = g_strsplit (status, " ", -1);
+    n_items = g_strv_length (items);
+    if (n_items < 3) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to parse DM status of the map '%s': '%s'", map_name, status);
+        g_strfreev (items);
+        g_free (status);
+        bd_crypto_integrity_status_free (ret);
+        return NULL;
+    }
+
+    ret->mismatches = g_ascii_strtoull (items[0], NULL, 10);
+    ret->provided_data_sectors = g_ascii_strtoull (items[1], NULL, 10);
+    if (g_strcmp0 (items[2], "-") != 0) {
+        ret->recalculating = TRUE;
+        ret->recalc_sector = g_ascii_strtoull (items[2], NULL, 10);
+    }
+    g_strfreev (items);
+    g_free (status);
+
+    return ret;
+}
+
+/**
+ * bd_crypto_integrity_status:
+ * @integrity_device: integrity device (name of the DM map or path) to get the status of
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): runtime status of the active @integrity_device or
+ *                           %NULL in case of error
+ *
+ * Tech category: %BD_CRYPTO_TECH_INTEGRITY-%BD_CRYPTO_TECH_MODE_QUERY
+ */
+BDCryptoIntegrityStatus* bd_crypto_integrity_status (const gchar *integrity_device, GError **error) {
+    gchar *map_name = NULL;
+    BDCryptoIntegrityStatus *ret = NULL;
+
+    map_name = get_dm_map_name (integrity_device, error);
+    if (!map_name)
+        /* error is already populated */
+        return NULL;
+
+    ret = get_integrity_status (map_name, error);
+    g_free (map_name);
+
+    return ret;
+}
+
+/**
+ * bd_crypto_integrity_status_all:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (array zero-terminated=1) (transfer full): runtime status of all the
+ *                                                     active integrity devices
+ *                                                     or %NULL in case of error
+ *
+ * Tech category: %BD_CRYPTO_TECH_INTEGRITY-%BD_CRYPTO_TECH_MODE_QUERY
+ */
+BDCryptoIntegrityStatus** bd_crypto_integrity_status_all (GError **error) {
+    struct dm_task *task = NULL;
+    struct dm_names *names = NULL;
+    guint next = 0;
+    GPtrArray *ret = NULL;
+    BDCryptoIntegrityStatus *status = NULL;
+    GError *l_error = NULL;
+
+    task = dm_task_create (DM_DEVICE_LIST);
+    if (!task) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to create DM task");
+        return NULL;
+    }
+
+    if (dm_task_run (task) == 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to list DM devices");
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    names = dm_task_get_names (task);
+    if (!names) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to list DM devices");
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    ret = g_ptr_array_new ();
+    if (names->dev) {
+        do {
+            names = (void *)((char *) names + next);
+            status = get_integrity_status (names->name, &l_error);
+            if (status)
+                g_ptr_array_add (ret, status);
+            else if (g_error_matches (l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_STATE))
+                /* not an integrity device */
+                g_clear_error (&l_error);
+            else {
+                /* the device may have disappeared in the meantime, just log it */
+                bd_utils_log_format (BD_UTILS_LOG_DEBUG, "Failed to get integrity status of '%s': %s",
+                                     names->name, l_error->message);
+                g_clear_error (&l_error);
+            }
+            next = names->next;
+        } while (next);
+    }
+    dm_task_destroy (task);
+
+    g_ptr_array_add (ret, NULL);
+    return (BDCryptoIntegrityStatus **) g_ptr_array_free (ret, FALSE);
+}
+
+/**
+ * bd_crypto_integrity_wait_recalculation:
+ * @integrity_device: integrity device (name of the DM map or path) to wait for
+ * @timeout: maximum time to wait (in seconds) or 0 to wait until the recalculation finishes
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Waits for the recalculation of the integrity tags (see
+ * %BD_CRYPTO_INTEGRITY_OPEN_RECALCULATE) on @integrity_device to finish and
+ * reports its progress using the progress reporting functionality of the
+ * library (see bd_utils_init_prog_reporting()).
+ *
+ * Returns: whether the recalculation finished (or no recalculation was running)
+ *          or not (in case of error or if @timeout was reached)
+ *
+ * Tech category: %BD_CRYPTO_TECH_INTEGRITY-%BD_CRYPTO_TECH_MODE_QUERY
+ */
+gboolean bd_crypto_integrity_wait_recalculation (const gchar *integrity_device, guint64 timeout, GError **error) {
+    gchar *map_name = NULL;
+    gchar *msg = NULL;
+    guint64 progress_id = 0;
+    gint64 end_time = 0;
+    guint64 completion = 0;
+    BDCryptoIntegrityStatus *status = NULL;
+    GError *l_error = NULL;
+
+    map_name = get_dm_map_name (integrity_device, error);
+    if (!map_name)
+        /* error is already populated */
+        return FALSE;
+
+    if (timeout > 0)
+        end_time = g_get_monotonic_time () + (gint64) timeout * G_USEC_PER_SEC;
+
+    msg = g_strdup_printf ("Waiting for integrity recalculation on '%s'", map_name);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    status = get_integrity_status (map_name, &l_error);
+    while (status && status->recalculating) {
+        if (status->provided_data_sectors > 0)
+            completion = MIN (status->recalc_sector * 100 / status->provided_data_sectors, 100);
+        bd_utils_report_progress (progress_id, completion, NULL);
+
+        if (end_time > 0 && g_get_monotonic_time () >= end_time) {
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_STATE,
+                         "Timed out waiting for integrity recalculation on '%s'", map_name);
+            bd_crypto_integrity_status_free (status);
+            status = NULL;
+            break;
+        }
+
+        g_usleep (500 * 1000); /* microseconds */
+        bd_crypto_integrity_status_free (status);
+        status = get_integrity_status (map_name, &l_error);
+    }
+
+    g_free (map_name);
+    if (!status) {
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    bd_crypto_integrity_status_free (status);
+    bd_utils_report_finished (progress_id, "Completed");
+
+    return TRUE;
+}
+
 /**
  * bd_crypto_keyring_add_key:
  * @key_desc: kernel keyring key description
@@ -3031,6 +3434,127 @@ gboolean bd_crypto_device_seems_encrypted (const gchar *device, GError **error)
     return SQUARE_LOWER_LIMIT < chi_square && chi_square < SQUARE_UPPER_LIMIT;
 }
 
+/* hashes used for TrueCrypt/VeraCrypt header key derivation (legacy ones excluded) */
+static const gchar *const tc_hashes[] = {"sha512", "whirlpool", "ripemd160", NULL};
+static const gchar *const vc_only_hashes[] = {"sha256", "stribog512", NULL};
+
+typedef struct TCTrial {
+    const gchar *device;
+    struct crypt_params_tcrypt params;
+    struct crypt_device *cd;
+    gint ret;
+} TCTrial;
+
+typedef struct TCTrials {
+    GMutex lock;
+    TCTrial *winner;
+} TCTrials;
+
+/**
+ * tc_trial_run: (skip)
+ *
+ * Tries to load the TrueCrypt/VeraCrypt header with the hash from @data. Runs
+ * in a worker thread, every trial uses its own crypt device context.
+ */
+static void tc_trial_run (gpointer data, gpointer user_data) {
+    TCTrial *trial = (TCTrial *) data;
+    TCTrials *trials = (TCTrials *) user_data;
+    struct crypt_device *cd = NULL;
+    gboolean found = FALSE;
+
+    /* no need to run the (expensive) key derivation if some other trial already succeeded */
+    g_mutex_lock (&trials->lock);
+    found = trials->winner != NULL;
+    g_mutex_unlock (&trials->lock);
+    if (found) {
+        trial->ret = -ECANCELED;
+        return;
+    }
+
+    trial->ret = crypt_init (&cd, trial->device);
+    if (trial->ret != 0)
+        return;
+
+    trial->ret = crypt_load (cd, CRYPT_TCRYPT, &trial->params);
+    if (trial->ret != 0) {
+        crypt_free (cd);
+        return;
+    }
+
+    g_mutex_lock (&trials->lock);
+    if (trials->winner == NULL) {
+        trials->winner = trial;
+        trial->cd = cd;
+        cd = NULL;
+    }
+    g_mutex_unlock (&trials->lock);
+
+    crypt_free (cd);
+}
+
+/**
+ * tc_load_parallel: (skip)
+ *
+ * Tries all candidate hashes for the header key derivation in parallel (at most
+ * one thread per CPU) and returns the crypt device context loaded by the first
+ * successful trial. The hash that matched is stored in @hash.
+ *
+ * Returns: 0 on success, negative error code of the first failed trial otherwise
+ */
+static gint tc_load_parallel (const gchar *device, struct crypt_params_tcrypt *params, gboolean veracrypt,
+                              struct crypt_device **cd, const gchar **hash, GError **error) {
+    TCTrials trials = { .winner = NULL };
+    TCTrial *trial_data = NULL;
+    GThreadPool *pool = NULL;
+    guint n_tc_hashes = 0;
+    guint n_trials = 0;
+    guint n_threads = 0;
+    gint ret = 0;
+    guint i;
+
+    n_tc_hashes = g_strv_length ((gchar **) tc_hashes);
+    n_trials = n_tc_hashes;
+    if (veracrypt)
+        n_trials += g_strv_length ((gchar **) vc_only_hashes);
+
+    trial_data = g_new0 (TCTrial, n_trials);
+    for (i = 0; i < n_trials; i++) {
+        trial_data[i].device = device;
+        trial_data[i].params = *params;
+        if (i < n_tc_hashes)
+            trial_data[i].params.hash_name = tc_hashes[i];
+        else
+            trial_data[i].params.hash_name = vc_only_hashes[i - n_tc_hashes];
+    }
+
+    n_threads = MIN (n_trials, g_get_num_processors ());
+    g_mutex_init (&trials.lock);
+    pool = g_thread_pool_new (tc_trial_run, &trials, n_threads, TRUE, error);
+    if (!pool) {
+        g_prefix_error (error, "Failed to start threads for opening the device: ");
+        g_mutex_clear (&trials.lock);
+        g_free (trial_data);
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < n_trials; i++)
+        g_thread_pool_push (pool, &trial_data[i], NULL);
+
+    /* wait for all the trials to finish */
+    g_thread_pool_free (pool, FALSE, TRUE);
+    g_mutex_clear (&trials.lock);
+
+    if (trials.winner) {
+        *cd = trials.winner->cd;
+        *hash = trials.winner->params.hash_name;
+        ret = 0;
+    } else
+        ret = trial_data[0].ret;
+
+    g_free (trial_data);
+    return ret;
+}
+
 /**
  * bd_crypto_tc_open:
  * @device: the device to open
@@ -3051,12 +3575,50 @@ gboolean bd_crypto_device_seems_encrypted (const gchar *device, GError **error)
  * Tech category: %BD_CRYPTO_TECH_TRUECRYPT-%BD_CRYPTO_TECH_MODE_OPEN_CLOSE
  */
 gboolean bd_crypto_tc_open (const gchar *device, const gchar *name, BDCryptoKeyslotContext *context, const gchar **keyfiles, gboolean hidden, gboolean system, gboolean veracrypt, guint32 veracrypt_pim, gboolean read_only, GError **error) {
+    return bd_crypto_tc_open_with_hints (device, name, context, keyfiles, hidden, system, veracrypt, veracrypt_pim, read_only,
+                                         NULL, NULL, FALSE, NULL, error);
+}
+
+/**
+ * bd_crypto_tc_open_with_hints:
+ * @device: the device to open
+ * @name: name for the TrueCrypt/VeraCrypt device
+ * @context: (nullable): passphrase key slot context for this TrueCrypt/VeraCrypt volume
+ * @keyfiles: (nullable) (array zero-terminated=1): paths to the keyfiles for the TrueCrypt/VeraCrypt volume
+ * @hidden: whether a hidden volume inside the volume should be opened
+ * @system: whether to try opening as an encrypted system (with boot loader)
+ * @veracrypt: whether to try VeraCrypt modes (TrueCrypt modes are tried anyway)
+ * @veracrypt_pim: VeraCrypt PIM value (only used if @veracrypt is %TRUE)
+ * @read_only: whether to open as read-only or not (meaning read-write)
+ * @hash: (nullable): hash of the header key derivation to try (e.g. "sha512") or %NULL to try all
+ * @cipher: (nullable): cipher (cascade) to try (e.g. "aes" or "aes-twofish-serpent") or %NULL to try all
+ * @parallel: whether to try the candidate hashes in parallel (only used if @hash is %NULL)
+ * @match: (out) (optional) (transfer full): place to store the hash and cipher combination
+ *                                           the @device was opened with
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Same as bd_crypto_tc_open(), but allows limiting the hash and cipher
+ * combinations that need to be tried. Without hints every combination is
+ * tried serially which, with VeraCrypt iteration counts, may take very long.
+ * With @parallel the key derivation for each candidate hash runs in its own
+ * thread (at most one thread per CPU).
+ *
+ * The hash in @match is only known if @hash was given or @parallel was used.
+ *
+ * Supported @context types for this function: passphrase
+ *
+ * Returns: whether the @device was successfully opened or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_TRUECRYPT-%BD_CRYPTO_TECH_MODE_OPEN_CLOSE
+ */
+gboolean bd_crypto_tc_open_with_hints (const gchar *device, const gchar *name, BDCryptoKeyslotContext *context, const gchar **keyfiles, gboolean hidden, gboolean system, gboolean veracrypt, guint32 veracrypt_pim, gboolean read_only, const gchar *hash, const gchar *cipher, gboolean parallel, BDCryptoTCMatch **match, GError **error) {
     struct crypt_device *cd = NULL;
     gint ret = 0;
     guint64 progress_id = 0;
     gchar *msg = NULL;
     struct crypt_params_tcrypt params = ZERO_INIT;
     gsize keyfiles_count = 0;
+    const gchar *matched_hash = NULL;
     guint i;
     GError *l_error = NULL;
 
@@ -3089,19 +3651,23 @@ gboolean bd_crypto_tc_open (const gchar *device, const gchar *name, BDCryptoKeys
         return FALSE;
     }
 
-    ret = crypt_init (&cd, device);
-    if (ret != 0) {
-        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+#ifndef LIBCRYPTSETUP_24
+    /* libcryptsetup ignores the hash and cipher in the parameters before 2.4.0 */
+    if (hash || cipher || parallel) {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_TECH_UNAVAIL,
+                     "Hash and cipher hints for TrueCrypt/VeraCrypt devices require libcryptsetup 2.4.0 or newer.");
         bd_utils_report_finished (progress_id, l_error->message);
         g_propagate_error (error, l_error);
         return FALSE;
     }
+#endif
 
     params.passphrase = context ? (const char*) context->u.passphrase.pass_data : NULL;
     params.passphrase_size = context ? context->u.passphrase.data_len : 0;
     params.keyfiles = keyfiles;
     params.keyfiles_count = keyfiles_count;
+    params.hash_name = hash;
+    params.cipher = cipher;
 
     if (veracrypt)
         params.flags |= CRYPT_TCRYPT_VERA_MODES;
@@ -3112,14 +3678,36 @@ gboolean bd_crypto_tc_open (const gchar *device, const gchar *name, BDCryptoKeys
     if (veracrypt && veracrypt_pim != 0)
         params.veracrypt_pim = veracrypt_pim;
 
-    ret = crypt_load (cd, CRYPT_TCRYPT, &params);
-    if (ret != 0) {
-        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to load device's parameters: %s", strerror_l (-ret, c_locale));
-        crypt_free (cd);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return FALSE;
+    if (parallel && !hash) {
+        ret = tc_load_parallel (device, &params, veracrypt, &cd, &matched_hash, &l_error);
+        if (ret != 0 && !l_error)
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to load device's parameters: %s", strerror_l (-ret, c_locale));
+        if (ret != 0) {
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
+    } else {
+        ret = crypt_init (&cd, device);
+        if (ret != 0) {
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
+
+        ret = crypt_load (cd, CRYPT_TCRYPT, &params);
+        if (ret != 0) {
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to load device's parameters: %s", strerror_l (-ret, c_locale));
+            crypt_free (cd);
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
+        matched_hash = hash;
     }
 
     ret = crypt_activate_by_volume_key (cd, name, NULL, 0,
@@ -3134,6 +3722,13 @@ gboolean bd_crypto_tc_open (const gchar *device, const gchar *name, BDCryptoKeys
         return FALSE;
     }
 
+    if (match) {
+        *match = g_new0 (BDCryptoTCMatch, 1);
+        (*match)->hash = g_strdup (matched_hash);
+        (*match)->cipher = g_strdup (crypt_get_cipher (cd));
+        (*match)->mode = g_strdup (crypt_get_cipher_mode (cd));
+    }
+
     crypt_free (cd);
     bd_utils_report_finished (progress_id, "Completed");
     return TRUE;
@@ -211,6 +211,25 @@ typedef struct BDCryptoBITLKInfo {
 void bd_crypto_bitlk_info_free (BDCryptoBITLKInfo *info);
 BDCryptoBITLKInfo* bd_crypto_bitlk_info_copy (BDCryptoBITLKInfo *info);
 
+/**
+ * BDCryptoTCMatch:
+ * @hash: hash used by the header key derivation (e.g. "sha512") or %NULL if not known
+ * @cipher: cipher (cascade) used by the volume (e.g. "aes" or "aes-twofish-serpent")
+ * @mode: used cipher mode (e.g. "xts-plain64")
+ *
+ * Hash and cipher combination a TrueCrypt/VeraCrypt volume was successfully
+ * opened with. @hash and @cipher can be passed as hints to
+ * bd_crypto_tc_open_with_hints() to speed up subsequent openings.
+ */
+typedef struct BDCryptoTCMatch {
+    gchar *hash;
+    gchar *cipher;
+    gchar *mode;
+} BDCryptoTCMatch;
+
+void bd_crypto_tc_match_free (BDCryptoTCMatch *match);
+BDCryptoTCMatch* bd_crypto_tc_match_copy (BDCryptoTCMatch *match);
+
 /**
  * BDCryptoIntegrityInfo:
  * @algorithm: integrity algorithm
@@ -236,6 +255,52 @@ typedef struct BDCryptoIntegrityInfo {
 void bd_crypto_integrity_info_free (BDCryptoIntegrityInfo *info);
 BDCryptoIntegrityInfo* bd_crypto_integrity_info_copy (BDCryptoIntegrityInfo *info);
 
+/**
+ * BDCryptoIntegrityMode:
+ * @BD_CRYPTO_INTEGRITY_MODE_UNKNOWN: unknown mode
+ * @BD_CRYPTO_INTEGRITY_MODE_JOURNAL: writes go through the journal
+ * @BD_CRYPTO_INTEGRITY_MODE_BITMAP: dirty regions are tracked in a bitmap (no journal)
+ * @BD_CRYPTO_INTEGRITY_MODE_DIRECT: direct writes (no journal nor bitmap)
+ * @BD_CRYPTO_INTEGRITY_MODE_RECOVERY: recovery mode (integrity tags are not checked)
+ */
+typedef enum {
+    BD_CRYPTO_INTEGRITY_MODE_UNKNOWN = 0,
+    BD_CRYPTO_INTEGRITY_MODE_JOURNAL,
+    BD_CRYPTO_INTEGRITY_MODE_BITMAP,
+    BD_CRYPTO_INTEGRITY_MODE_DIRECT,
+    BD_CRYPTO_INTEGRITY_MODE_RECOVERY,
+} BDCryptoIntegrityMode;
+
+/**
+ * BDCryptoIntegrityStatus:
+ * @name: name of the integrity device (DM map)
+ * @mode: mode the integrity device is active in
+ * @algorithm: internal integrity algorithm (%NULL if the tags are provided by
+ *             an upper layer, e.g. dm-crypt with authenticated encryption)
+ * @tag_size: tag size per-sector in bytes
+ * @block_size: integrity block (sector) size in bytes
+ * @sectors_per_bit: number of 512-byte sectors per bitmap bit (bitmap mode only)
+ * @mismatches: number of integrity mismatches detected so far
+ * @provided_data_sectors: number of 512-byte data sectors provided by the device
+ * @recalculating: whether the integrity tags are being recalculated or not
+ * @recalc_sector: the 512-byte sector the recalculation got to (if @recalculating)
+ */
+typedef struct BDCryptoIntegrityStatus {
+    gchar *name;
+    BDCryptoIntegrityMode mode;
+    gchar *algorithm;
+    guint32 tag_size;
+    guint32 block_size;
+    guint64 sectors_per_bit;
+    guint64 mismatches;
+    guint64 provided_data_sectors;
+    gboolean recalculating;
+    guint64 recalc_sector;
+} BDCryptoIntegrityStatus;
+
+void bd_crypto_integrity_status_free (BDCryptoIntegrityStatus *status);
+BDCryptoIntegrityStatus* bd_crypto_integrity_status_copy (BDCryptoIntegrityStatus *status);
+
 /**
  * BDCryptoLUKSTokenInfo:
  * @id: ID of the token
@@ -302,11 +367,15 @@ BDCryptoLUKSTokenInfo** bd_crypto_luks_token_info (const gchar *device, GError *
 gboolean bd_crypto_integrity_format (const gchar *device, const gchar *algorithm, gboolean wipe, BDCryptoKeyslotContext *context, BDCryptoIntegrityExtra *extra, GError **error);
 gboolean bd_crypto_integrity_open (const gchar *device, const gchar *name, const gchar *algorithm, BDCryptoKeyslotContext *context, BDCryptoIntegrityOpenFlags flags, BDCryptoIntegrityExtra *extra, GError **error);
 gboolean bd_crypto_integrity_close (const gchar *integrity_device, GError **error);
+BDCryptoIntegrityStatus* bd_crypto_integrity_status (const gchar *integrity_device, GError **error);
+BDCryptoIntegrityStatus** bd_crypto_integrity_status_all (GError **error);
+gboolean bd_crypto_integrity_wait_recalculation (const gchar *integrity_device, guint64 timeout, GError **error);
 
 gboolean bd_crypto_keyring_add_key (const gchar *key_desc, const guint8 *key_data, gsize data_len, GError **error);
 
 gboolean bd_crypto_device_seems_encrypted (const gchar *device, GError **error);
 gboolean bd_crypto_tc_open (const gchar *device, const gchar *name, BDCryptoKeyslotContext *context, const gchar **keyfiles, gboolean hidden, gboolean system, gboolean veracrypt, guint32 veracrypt_pim, gboolean read_only, GError **error);
+gboolean bd_crypto_tc_open_with_hints (const gchar *device, const gchar *name, BDCryptoKeyslotContext *context, const gchar **keyfiles, gboolean hidden, gboolean system, gboolean veracrypt, guint32 veracrypt_pim, gboolean read_only, const gchar *hash, const gchar *cipher, gboolean parallel, BDCryptoTCMatch **match, GError **error);
 gboolean bd_crypto_tc_close (const gchar *tc_device, GError **error);
 
 gboolean bd_crypto_bitlk_open (const gchar *device, const gchar *name, BDCryptoKeyslotContext *context, gboolean read_only, GError **error);
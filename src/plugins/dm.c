@@ -23,6 +23,7 @@
 #include <libdevmapper.h>
 #include <stdarg.h>
 #include <syslog.h>
+#include <string.h>
 
 #include "dm.h"
 #include "check_deps.h"
@@ -342,3 +343,549 @@ gboolean bd_dm_map_exists (const gchar *map_name, gboolean live_only, gboolean a
 
     return ret;
 }
+
+/**
+ * dm_stats_message: (skip)
+ *
+ * Sends the @message to the @map_name map and returns the response.
+ *
+ * Returns: (transfer full): response to the message (possibly an empty string)
+ *                           or %NULL in case of error
+ */
+static gchar* dm_stats_message (const gchar *map_name, const gchar *message, GError **error) {
+    struct dm_task *task = NULL;
+    const gchar *response = NULL;
+    gchar *ret = NULL;
+
+    if (geteuid () != 0) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_NOT_ROOT,
+                     "Not running as root, cannot manage DM statistics");
+        return NULL;
+    }
+
+    task = dm_task_create (DM_DEVICE_TARGET_MSG);
+    if (!task) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_TASK,
+                     "Failed to create DM task for the map '%s'", map_name);
+        return NULL;
+    }
+
+    if (dm_task_set_name (task, map_name) == 0 || dm_task_set_sector (task, 0) == 0 ||
+        dm_task_set_message (task, message) == 0) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_TASK,
+                     "Failed to create DM task for the map '%s'", map_name);
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    if (dm_task_run (task) == 0) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_TASK,
+                     "Failed to send the message '%s' to the map '%s'", message, map_name);
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    response = dm_task_get_message_response (task);
+    ret = g_strdup (response ? response : "");
+
+    dm_task_destroy (task);
+    return ret;
+}
+
+/* parses a "<start>+<length>" range */
+static gboolean parse_stats_range (const gchar *str, guint64 *start, guint64 *length) {
+    gchar *endptr = NULL;
+
+    *start = g_ascii_strtoull (str, &endptr, 10);
+    if (endptr == str || *endptr != '+')
+        return FALSE;
+
+    str = endptr + 1;
+    *length = g_ascii_strtoull (str, &endptr, 10);
+    return endptr != str && *endptr == '\0';
+}
+
+/* parses a list of numbers separated by @sep into a newly allocated array */
+static gboolean parse_stats_numbers (const gchar *str, const gchar *sep, guint64 **numbers, guint *n_numbers) {
+    gchar **items = NULL;
+    gchar *endptr = NULL;
+    guint i = 0;
+
+    items = g_strsplit (str, sep, -1);
+    *n_numbers = g_strv_length (items);
+    *numbers = g_new0 (guint64, *n_numbers);
+
+    for (i = 0; i < *n_numbers; i++) {
+        (*numbers)[i] = g_ascii_strtoull (items[i], &endptr, 10);
+        if (endptr == items[i] || *endptr != '\0') {
+            g_free (*numbers);
+            *numbers = NULL;
+            *n_numbers = 0;
+            g_strfreev (items);
+            return FALSE;
+        }
+    }
+
+    g_strfreev (items);
+    return TRUE;
+}
+
+/**
+ * bd_dm_stats_create:
+ * @map_name: name of the map to create the statistics region on
+ * @start: start of the region (in sectors)
+ * @length: length of the region (in sectors), 0 for the whole device (@start needs
+ *          to be 0 too in such case)
+ * @area_size: size of the areas (in sectors) the region should be split into, 0 to
+ *             use @n_areas instead
+ * @n_areas: number of areas of the same size the region should be split into, 0
+ *           for a single area if @area_size is 0 too
+ * @program_id: (nullable): ID of the program creating the region (used to filter
+ *              regions in bd_dm_stats_list()) or %NULL
+ * @histogram_bounds: (nullable) (array length=n_histogram_bounds): ascending boundaries
+ *                    of the latency histogram to collect (in milliseconds or in
+ *                    nanoseconds if @precise_timestamps is %TRUE) or %NULL for no histogram
+ * @n_histogram_bounds: number of items in @histogram_bounds
+ * @precise_timestamps: whether to use nanoseconds instead of milliseconds for the counters
+ * @region_id: (out): place to store the ID of the new region
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Creates a new dm-stats region on @map_name. Statistics regions are kept by the
+ * kernel until deleted (or until the map is removed).
+ *
+ * Returns: whether the statistics region was successfully created or not
+ *
+ * Tech category: %BD_DM_TECH_STATS-%BD_DM_TECH_MODE_CREATE_ACTIVATE
+ */
+gboolean bd_dm_stats_create (const gchar *map_name, guint64 start, guint64 length, guint64 area_size, guint64 n_areas, const gchar *program_id, const guint64 *histogram_bounds, guint n_histogram_bounds, gboolean precise_timestamps, guint64 *region_id, GError **error) {
+    GString *message = NULL;
+    g_autofree gchar *message_str = NULL;
+    g_autofree gchar *response = NULL;
+    gchar *endptr = NULL;
+    guint n_args = 0;
+    guint i = 0;
+
+    if (length == 0 && start != 0) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_INVAL,
+                     "Region length needs to be specified if start is not 0");
+        return FALSE;
+    }
+
+    if (program_id && (*program_id == '\0' || strpbrk (program_id, " \t\n") != NULL)) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_INVAL,
+                     "Invalid program ID '%s'", program_id);
+        return FALSE;
+    }
+
+    for (i = 1; i < n_histogram_bounds; i++) {
+        if (histogram_bounds[i] <= histogram_bounds[i - 1]) {
+            g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_INVAL,
+                         "Histogram boundaries need to be in ascending order");
+            return FALSE;
+        }
+    }
+
+    message = g_string_new ("@stats_create ");
+
+    if (length == 0)
+        g_string_append (message, "-");
+    else
+        g_string_append_printf (message, "%"G_GUINT64_FORMAT"+%"G_GUINT64_FORMAT, start, length);
+
+    if (area_size != 0)
+        g_string_append_printf (message, " %"G_GUINT64_FORMAT, area_size);
+    else
+        g_string_append_printf (message, " /%"G_GUINT64_FORMAT, n_areas != 0 ? n_areas : 1);
+
+    n_args = (precise_timestamps ? 1 : 0) + (n_histogram_bounds > 0 ? 1 : 0);
+    /* always give the number of the optional arguments explicitly, otherwise
+       a numeric program ID would be taken for it */
+    g_string_append_printf (message, " %u", n_args);
+    if (precise_timestamps)
+        g_string_append (message, " precise_timestamps");
+    if (n_histogram_bounds > 0) {
+        g_string_append (message, " histogram:");
+        for (i = 0; i < n_histogram_bounds; i++)
+            g_string_append_printf (message, "%s%"G_GUINT64_FORMAT, i > 0 ? "," : "", histogram_bounds[i]);
+    }
+
+    if (program_id)
+        g_string_append_printf (message, " %s", program_id);
+
+    message_str = g_string_free (message, FALSE);
+    response = dm_stats_message (map_name, message_str, error);
+    if (!response)
+        return FALSE;
+
+    g_strstrip (response);
+    *region_id = g_ascii_strtoull (response, &endptr, 10);
+    if (endptr == response || *endptr != '\0') {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_PARSE,
+                     "Failed to parse region ID from '%s'", response);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_dm_stats_delete:
+ * @map_name: name of the map to delete the statistics region from
+ * @region_id: ID of the region to delete
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the statistics region was successfully deleted or not
+ *
+ * Tech category: %BD_DM_TECH_STATS-%BD_DM_TECH_MODE_REMOVE_DEACTIVATE
+ */
+gboolean bd_dm_stats_delete (const gchar *map_name, guint64 region_id, GError **error) {
+    g_autofree gchar *message = NULL;
+    g_autofree gchar *response = NULL;
+
+    message = g_strdup_printf ("@stats_delete %"G_GUINT64_FORMAT, region_id);
+    response = dm_stats_message (map_name, message, error);
+
+    return response != NULL;
+}
+
+/**
+ * bd_dm_stats_clear:
+ * @map_name: name of the map with the statistics region
+ * @region_id: ID of the region to clear
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Resets all the counters of the region (except for the in-flight I/Os).
+ *
+ * Returns: whether the statistics region was successfully cleared or not
+ *
+ * Tech category: %BD_DM_TECH_STATS-%BD_DM_TECH_MODE_MODIFY
+ */
+gboolean bd_dm_stats_clear (const gchar *map_name, guint64 region_id, GError **error) {
+    g_autofree gchar *message = NULL;
+    g_autofree gchar *response = NULL;
+
+    message = g_strdup_printf ("@stats_clear %"G_GUINT64_FORMAT, region_id);
+    response = dm_stats_message (map_name, message, error);
+
+    return response != NULL;
+}
+
+/* parses a line of the @stats_list response:
+   "<id>: <start>+<length> <area_size> <program_id> <aux_data> [precise_timestamps] [histogram:<b1>,<b2>,...]" */
+static BDDMStatsRegion* parse_stats_region (const gchar *line, GError **error) {
+    gchar **fields = NULL;
+    BDDMStatsRegion *region = NULL;
+    gchar *endptr = NULL;
+    guint n_fields = 0;
+    guint i = 0;
+
+    fields = g_strsplit_set (line, " ", -1);
+    n_fields = g_strv_length (fields);
+    if (n_fields < 5)
+        goto fail;
+
+    region = g_new0 (BDDMStatsRegion, 1);
+
+    region->region_id = g_ascii_strtoull (fields[0], &endptr, 10);
+    if (endptr == fields[0] || g_strcmp0 (endptr, ":") != 0)
+        goto fail;
+
+    if (!parse_stats_range (fields[1], &(region->start), &(region->length)))
+        goto fail;
+
+    region->area_size = g_ascii_strtoull (fields[2], &endptr, 10);
+    if (endptr == fields[2] || *endptr != '\0')
+        goto fail;
+
+    if (g_strcmp0 (fields[3], "-") != 0)
+        region->program_id = g_strdup (fields[3]);
+    if (g_strcmp0 (fields[4], "-") != 0)
+        region->aux_data = g_strdup (fields[4]);
+
+    for (i = 5; i < n_fields; i++) {
+        if (g_strcmp0 (fields[i], "precise_timestamps") == 0)
+            region->precise_timestamps = TRUE;
+        else if (g_str_has_prefix (fields[i], "histogram:")) {
+            if (!parse_stats_numbers (fields[i] + strlen ("histogram:"), ",",
+                                      &(region->histogram_bounds), &(region->n_histogram_bounds)))
+                goto fail;
+        }
+        /* ignore anything unknown possibly added by newer kernels */
+    }
+
+    g_strfreev (fields);
+    return region;
+
+ fail:
+    g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_PARSE,
+                 "Failed to parse statistics region from '%s'", line);
+    g_strfreev (fields);
+    bd_dm_stats_region_free (region);
+    return NULL;
+}
+
+/**
+ * bd_dm_stats_list:
+ * @map_name: name of the map to list the statistics regions of
+ * @program_id: (nullable): list only regions created by the program with this ID
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): statistics regions of @map_name
+ *                                                    or %NULL in case of error
+ *
+ * Tech category: %BD_DM_TECH_STATS-%BD_DM_TECH_MODE_QUERY
+ */
+BDDMStatsRegion** bd_dm_stats_list (const gchar *map_name, const gchar *program_id, GError **error) {
+    g_autofree gchar *message = NULL;
+    g_autofree gchar *response = NULL;
+    gchar **lines = NULL;
+    GPtrArray *regions = NULL;
+    BDDMStatsRegion *region = NULL;
+    gchar **line_p = NULL;
+
+    if (program_id)
+        message = g_strdup_printf ("@stats_list %s", program_id);
+    else
+        message = g_strdup ("@stats_list");
+
+    response = dm_stats_message (map_name, message, error);
+    if (!response)
+        return NULL;
+
+    regions = g_ptr_array_new_with_free_func ((GDestroyNotify) bd_dm_stats_region_free);
+    lines = g_strsplit (response, "\n", -1);
+    for (line_p = lines; *line_p; line_p++) {
+        g_strstrip (*line_p);
+        if (**line_p == '\0')
+            continue;
+
+        region = parse_stats_region (*line_p, error);
+        if (!region) {
+            g_ptr_array_free (regions, TRUE);
+            g_strfreev (lines);
+            return NULL;
+        }
+        g_ptr_array_add (regions, region);
+    }
+    g_strfreev (lines);
+
+    g_ptr_array_set_free_func (regions, NULL);
+    g_ptr_array_add (regions, NULL);
+
+    return (BDDMStatsRegion **) g_ptr_array_free (regions, FALSE);
+}
+
+/* parses a line of the @stats_print response:
+   "<start>+<length> <13 counters> [<h0>:<h1>:...:<hN>]" */
+static BDDMStatsArea* parse_stats_area (const gchar *line, GError **error) {
+    gchar **fields = NULL;
+    BDDMStatsArea *area = NULL;
+    guint64 counters[13];
+    gchar *endptr = NULL;
+    guint n_fields = 0;
+    guint i = 0;
+
+    fields = g_strsplit_set (line, " ", -1);
+    n_fields = g_strv_length (fields);
+    if (n_fields < 14)
+        goto fail;
+
+    area = g_new0 (BDDMStatsArea, 1);
+    if (!parse_stats_range (fields[0], &(area->start), &(area->length)))
+        goto fail;
+
+    for (i = 0; i < 13; i++) {
+        counters[i] = g_ascii_strtoull (fields[i + 1], &endptr, 10);
+        if (endptr == fields[i + 1] || *endptr != '\0')
+            goto fail;
+    }
+
+    area->reads = counters[0];
+    area->reads_merged = counters[1];
+    area->sectors_read = counters[2];
+    area->read_ticks = counters[3];
+    area->writes = counters[4];
+    area->writes_merged = counters[5];
+    area->sectors_written = counters[6];
+    area->write_ticks = counters[7];
+    area->in_flight = counters[8];
+    area->io_ticks = counters[9];
+    area->time_in_queue = counters[10];
+    area->read_io_ticks = counters[11];
+    area->write_io_ticks = counters[12];
+
+    if (n_fields > 14 && !parse_stats_numbers (fields[14], ":", &(area->histogram), &(area->n_histogram)))
+        goto fail;
+
+    g_strfreev (fields);
+    return area;
+
+ fail:
+    g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_PARSE,
+                 "Failed to parse statistics area counters from '%s'", line);
+    g_strfreev (fields);
+    bd_dm_stats_area_free (area);
+    return NULL;
+}
+
+/**
+ * bd_dm_stats_print:
+ * @map_name: name of the map with the statistics region
+ * @region_id: ID of the region to get the counters of
+ * @clear: whether to atomically clear the counters after getting them
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): counters of the areas of the
+ *                                                    region or %NULL in case of error
+ *
+ * Tech category: %BD_DM_TECH_STATS-%BD_DM_TECH_MODE_QUERY
+ */
+BDDMStatsArea** bd_dm_stats_print (const gchar *map_name, guint64 region_id, gboolean clear, GError **error) {
+    g_autofree gchar *message = NULL;
+    g_autofree gchar *response = NULL;
+    gchar **lines = NULL;
+    GPtrArray *areas = NULL;
+    BDDMStatsArea *area = NULL;
+    gchar **line_p = NULL;
+
+    message = g_strdup_printf ("%s %"G_GUINT64_FORMAT, clear ? "@stats_print_clear" : "@stats_print", region_id);
+    response = dm_stats_message (map_name, message, error);
+    if (!response)
+        return NULL;
+
+    areas = g_ptr_array_new_with_free_func ((GDestroyNotify) bd_dm_stats_area_free);
+    lines = g_strsplit (response, "\n", -1);
+    for (line_p = lines; *line_p; line_p++) {
+        g_strstrip (*line_p);
+        if (**line_p == '\0')
+            continue;
+
+        area = parse_stats_area (*line_p, error);
+        if (!area) {
+            g_ptr_array_free (areas, TRUE);
+            g_strfreev (lines);
+            return NULL;
+        }
+        g_ptr_array_add (areas, area);
+    }
+    g_strfreev (lines);
+
+    g_ptr_array_set_free_func (areas, NULL);
+    g_ptr_array_add (areas, NULL);
+
+    return (BDDMStatsArea **) g_ptr_array_free (areas, FALSE);
+}
+
+/* difference of two samples of a counter, 0 if the counters were cleared in between */
+static inline guint64 counter_delta (guint64 old, guint64 new) {
+    return new >= old ? new - old : 0;
+}
+
+/**
+ * bd_dm_stats_sample:
+ * @map_name: name of the map with the statistics region
+ * @region_id: ID of the region to sample
+ * @interval: time (in milliseconds) between the two samples of the counters
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Takes two samples of the region's counters @interval milliseconds apart and
+ * computes the I/O rates of the individual areas from them. Doesn't clear the
+ * counters so it can be used together with other users of the region.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): I/O rates of the areas of the
+ *                                                    region or %NULL in case of error
+ *
+ * Tech category: %BD_DM_TECH_STATS-%BD_DM_TECH_MODE_QUERY
+ */
+BDDMStatsAreaRate** bd_dm_stats_sample (const gchar *map_name, guint64 region_id, guint interval, GError **error) {
+    BDDMStatsRegion **regions = NULL;
+    BDDMStatsRegion **region_p = NULL;
+    BDDMStatsArea **first = NULL;
+    BDDMStatsArea **second = NULL;
+    BDDMStatsAreaRate **ret = NULL;
+    gboolean found = FALSE;
+    gdouble ticks_per_ms = 1.0;
+    gdouble elapsed = 0.0;
+    gint64 first_time = 0;
+    guint64 reads = 0;
+    guint64 writes = 0;
+    guint n_areas = 0;
+    guint i = 0;
+
+    /* the region's timestamps tell us the unit of the time counters */
+    regions = bd_dm_stats_list (map_name, NULL, error);
+    if (!regions)
+        return NULL;
+    for (region_p = regions; *region_p; region_p++) {
+        if ((*region_p)->region_id == region_id) {
+            found = TRUE;
+            if ((*region_p)->precise_timestamps)
+                ticks_per_ms = 1000000.0;
+        }
+        bd_dm_stats_region_free (*region_p);
+    }
+    g_free (regions);
+
+    if (!found) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_INVAL,
+                     "Statistics region %"G_GUINT64_FORMAT" doesn't exist on the map '%s'",
+                     region_id, map_name);
+        return NULL;
+    }
+
+    first = bd_dm_stats_print (map_name, region_id, FALSE, error);
+    if (!first)
+        return NULL;
+    first_time = g_get_monotonic_time ();
+
+    g_usleep ((gulong) interval * 1000);
+
+    second = bd_dm_stats_print (map_name, region_id, FALSE, error);
+    if (!second)
+        goto out;
+    elapsed = (gdouble) (g_get_monotonic_time () - first_time) / G_USEC_PER_SEC;
+
+    for (n_areas = 0; first[n_areas] && second[n_areas]; n_areas++);
+    if (first[n_areas] || second[n_areas]) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_PARSE,
+                     "Number of areas of the statistics region %"G_GUINT64_FORMAT" changed while sampling",
+                     region_id);
+        goto out;
+    }
+
+    if (elapsed <= 0.0)
+        elapsed = 1.0 / G_USEC_PER_SEC;
+
+    ret = g_new0 (BDDMStatsAreaRate*, n_areas + 1);
+    for (i = 0; i < n_areas; i++) {
+        ret[i] = g_new0 (BDDMStatsAreaRate, 1);
+        ret[i]->start = second[i]->start;
+        ret[i]->length = second[i]->length;
+
+        reads = counter_delta (first[i]->reads, second[i]->reads);
+        writes = counter_delta (first[i]->writes, second[i]->writes);
+        ret[i]->read_iops = reads / elapsed;
+        ret[i]->write_iops = writes / elapsed;
+        ret[i]->read_bytes_per_sec = counter_delta (first[i]->sectors_read, second[i]->sectors_read) * 512 / elapsed;
+        ret[i]->write_bytes_per_sec = counter_delta (first[i]->sectors_written, second[i]->sectors_written) * 512 / elapsed;
+        ret[i]->utilization = counter_delta (first[i]->io_ticks, second[i]->io_ticks) / ticks_per_ms / (elapsed * 1000);
+        if (ret[i]->utilization > 1.0)
+            ret[i]->utilization = 1.0;
+        if (reads > 0)
+            ret[i]->read_latency = counter_delta (first[i]->read_ticks, second[i]->read_ticks) / ticks_per_ms / reads;
+        if (writes > 0)
+            ret[i]->write_latency = counter_delta (first[i]->write_ticks, second[i]->write_ticks) / ticks_per_ms / writes;
+    }
+
+ out:
+    for (i = 0; first[i]; i++)
+        bd_dm_stats_area_free (first[i]);
+    g_free (first);
+    if (second) {
+        for (i = 0; second[i]; i++)
+            bd_dm_stats_area_free (second[i]);
+        g_free (second);
+    }
+
+    return ret;
+}
@@ -13,18 +13,75 @@ typedef enum {
     BD_DM_ERROR_RAID_FAIL,
     BD_DM_ERROR_RAID_NO_DEVS,
     BD_DM_ERROR_RAID_NO_EXIST,
+    BD_DM_ERROR_PARSE,
+    BD_DM_ERROR_INVAL,
 } BDDMError;
 
 typedef enum {
     BD_DM_TECH_MAP = 0,
+    BD_DM_TECH_STATS,
 } BDDMTech;
 
 typedef enum {
     BD_DM_TECH_MODE_CREATE_ACTIVATE   = 1 << 0,
     BD_DM_TECH_MODE_REMOVE_DEACTIVATE = 1 << 1,
     BD_DM_TECH_MODE_QUERY             = 1 << 2,
+    BD_DM_TECH_MODE_MODIFY            = 1 << 3,
 } BDDMTechMode;
 
+typedef struct BDDMStatsRegion {
+    guint64 region_id;
+    guint64 start;
+    guint64 length;
+    guint64 area_size;
+    gchar *program_id;
+    gchar *aux_data;
+    gboolean precise_timestamps;
+    guint64 *histogram_bounds;
+    guint n_histogram_bounds;
+} BDDMStatsRegion;
+
+BDDMStatsRegion* bd_dm_stats_region_copy (BDDMStatsRegion *region);
+void bd_dm_stats_region_free (BDDMStatsRegion *region);
+
+typedef struct BDDMStatsArea {
+    guint64 start;
+    guint64 length;
+    guint64 reads;
+    guint64 reads_merged;
+    guint64 sectors_read;
+    guint64 read_ticks;
+    guint64 writes;
+    guint64 writes_merged;
+    guint64 sectors_written;
+    guint64 write_ticks;
+    guint64 in_flight;
+    guint64 io_ticks;
+    guint64 time_in_queue;
+    guint64 read_io_ticks;
+    guint64 write_io_ticks;
+    guint64 *histogram;
+    guint n_histogram;
+} BDDMStatsArea;
+
+BDDMStatsArea* bd_dm_stats_area_copy (BDDMStatsArea *area);
+void bd_dm_stats_area_free (BDDMStatsArea *area);
+
+typedef struct BDDMStatsAreaRate {
+    guint64 start;
+    guint64 length;
+    gdouble read_iops;
+    gdouble write_iops;
+    gdouble read_bytes_per_sec;
+    gdouble write_bytes_per_sec;
+    gdouble utilization;
+    gdouble read_latency;
+    gdouble write_latency;
+} BDDMStatsAreaRate;
+
+BDDMStatsAreaRate* bd_dm_stats_area_rate_copy (BDDMStatsAreaRate *rate);
+void bd_dm_stats_area_rate_free (BDDMStatsAreaRate *rate);
+
 /*
  * If using the plugin as a standalone library, the following functions should
  * be called to:
@@ -45,4 +102,11 @@ gchar* bd_dm_name_from_node (const gchar *dm_node, GError **error);
 gchar* bd_dm_node_from_name (const gchar *map_name, GError **error);
 gchar* bd_dm_get_subsystem_from_name (const gchar *device_name, GError **error);
 
+gboolean bd_dm_stats_create (const gchar *map_name, guint64 start, guint64 length, guint64 area_size, guint64 n_areas, const gchar *program_id, const guint64 *histogram_bounds, guint n_histogram_bounds, gboolean precise_timestamps, guint64 *region_id, GError **error);
+gboolean bd_dm_stats_delete (const gchar *map_name, guint64 region_id, GError **error);
+gboolean bd_dm_stats_clear (const gchar *map_name, guint64 region_id, GError **error);
+BDDMStatsRegion** bd_dm_stats_list (const gchar *map_name, const gchar *program_id, GError **error);
+BDDMStatsArea** bd_dm_stats_print (const gchar *map_name, guint64 region_id, gboolean clear, GError **error);
+BDDMStatsAreaRate** bd_dm_stats_sample (const gchar *map_name, guint64 region_id, guint interval, GError **error);
+
 #endif  /* BD_DM */
@@ -20,6 +20,12 @@
 #include <blockdev/utils.h>
 #include <check_deps.h>
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/btrfs.h>
 
 #include "btrfs.h"
 #include "fs.h"
@@ -407,6 +413,75 @@ BDFSBtrfsInfo* bd_fs_btrfs_get_info (const gchar *mpoint, GError **error) {
     return ret;
 }
 
+/* grows the single device file system mounted on @mpoint in-process (what
+   'btrfs filesystem resize' does), @done is set to FALSE if the 'btrfs'
+   utility needs to be used instead (shrinking, unsupported,...) */
+static gboolean btrfs_online_grow (const gchar *mpoint, guint64 new_size, gboolean *done, GError **error) {
+    struct btrfs_ioctl_fs_info_args fs_info;
+    struct btrfs_ioctl_dev_info_args dev_info;
+    struct btrfs_ioctl_vol_args resize;
+    guint64 devid = 0;
+    gboolean found = FALSE;
+    gint fd = -1;
+
+    *done = FALSE;
+
+    fd = open (mpoint, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+    if (fd == -1)
+        return TRUE;
+
+    memset (&fs_info, 0, sizeof (fs_info));
+    if (ioctl (fd, BTRFS_IOC_FS_INFO, &fs_info) != 0) {
+        close (fd);
+        return TRUE;
+    }
+
+    if (fs_info.num_devices != 1) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Btrfs filesystem mounted on %s spans multiple devices (%"G_GUINT64_FORMAT")." \
+                     "Filesystem plugin is not suitable for multidevice Btrfs volumes, please use " \
+                     "Btrfs plugin instead.", mpoint, (guint64) fs_info.num_devices);
+        close (fd);
+        return FALSE;
+    }
+
+    /* the only device doesn't need to have devid 1 (e.g. after a replace) */
+    for (devid = 1; !found && devid <= fs_info.max_id; devid++) {
+        memset (&dev_info, 0, sizeof (dev_info));
+        dev_info.devid = devid;
+        found = ioctl (fd, BTRFS_IOC_DEV_INFO, &dev_info) == 0;
+    }
+    if (!found || (new_size != 0 && new_size < dev_info.total_bytes)) {
+        close (fd);
+        return TRUE;
+    }
+
+    memset (&resize, 0, sizeof (resize));
+    if (new_size == 0)
+        g_snprintf (resize.name, sizeof (resize.name), "%"G_GUINT64_FORMAT":max", (guint64) dev_info.devid);
+    else
+        g_snprintf (resize.name, sizeof (resize.name), "%"G_GUINT64_FORMAT":%"G_GUINT64_FORMAT,
+                    (guint64) dev_info.devid, new_size);
+
+    if (ioctl (fd, BTRFS_IOC_RESIZE, &resize) != 0) {
+        if (errno == ENOTTY || errno == EOPNOTSUPP) {
+            bd_utils_log_format (BD_UTILS_LOG_INFO, "Online resize of '%s' not possible in-process: %s",
+                                 mpoint, strerror_l (errno, _C_LOCALE));
+            close (fd);
+            return TRUE;
+        }
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to resize the file system mounted on '%s': %s",
+                     mpoint, strerror_l (errno, _C_LOCALE));
+        close (fd);
+        return FALSE;
+    }
+    close (fd);
+
+    *done = TRUE;
+    return TRUE;
+}
+
 /**
  * bd_fs_btrfs_resize:
  * @mpoint: a mountpoint of the to be resized btrfs filesystem
@@ -421,13 +496,25 @@ BDFSBtrfsInfo* bd_fs_btrfs_get_info (const gchar *mpoint, GError **error) {
  * Note: This function WON'T WORK for multi device btrfs filesystems,
  *       for more complicated setups use the btrfs plugin instead.
  *
+ * Growing the filesystem is done directly with the BTRFS_IOC_RESIZE ioctl
+ * (unless @extra is given), the 'btrfs' utility is used in all the other cases.
+ *
  * Tech category: %BD_BTRFS_TECH_FS-%BD_BTRFS_TECH_MODE_MODIFY
  */
 gboolean bd_fs_btrfs_resize (const gchar *mpoint, guint64 new_size, const BDExtraArg **extra, GError **error) {
     const gchar *argv[6] = {"btrfs", "filesystem", "resize", NULL, mpoint, NULL};
     gboolean ret = FALSE;
+    gboolean done = FALSE;
     BDFSBtrfsInfo *info = NULL;
 
+    /* extra options are for the 'btrfs' utility, use it if some are given */
+    if (!extra) {
+        if (!btrfs_online_grow (mpoint, new_size, &done, error))
+            return FALSE;
+        if (done)
+            return TRUE;
+    }
+
     if (!check_deps (&avail_deps, DEPS_BTRFS_MASK, deps, DEPS_LAST, &deps_check_lock, error))
         return FALSE;
 
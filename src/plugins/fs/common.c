@@ -21,10 +21,15 @@
 #include <blkid.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/sysmacros.h>
+#include <linux/fs.h>
 #include <fcntl.h>
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <stdlib.h>
+#include <limits.h>
 #include <uuid.h>
 
 #include <blockdev/utils.h>
@@ -153,3 +158,169 @@ check_uuid (const gchar *uuid, GError **error) {
 
     return TRUE;
 }
+
+static gboolean
+read_sysfs_u64 (const gchar *sys_dir, const gchar *attr, guint64 *value) {
+    g_autofree gchar *path = NULL;
+    g_autofree gchar *contents = NULL;
+    gchar *endptr = NULL;
+
+    path = g_build_filename (sys_dir, attr, NULL);
+    if (!g_file_get_contents (path, &contents, NULL, NULL))
+        return FALSE;
+
+    *value = g_ascii_strtoull (g_strstrip (contents), &endptr, 10);
+    return endptr && *endptr == '\0';
+}
+
+/* number of data disks for the MD @level with @raid_disks members and @layout */
+static guint64
+md_data_disks (const gchar *level, guint64 raid_disks, guint64 layout) {
+    guint64 copies = 0;
+
+    if (g_strcmp0 (level, "raid0") == 0)
+        return raid_disks;
+    else if (g_strcmp0 (level, "raid4") == 0 || g_strcmp0 (level, "raid5") == 0)
+        return raid_disks > 1 ? raid_disks - 1 : 0;
+    else if (g_strcmp0 (level, "raid6") == 0)
+        return raid_disks > 2 ? raid_disks - 2 : 0;
+    else if (g_strcmp0 (level, "raid10") == 0) {
+        /* near copies in the lowest byte, far copies in the second one */
+        copies = (layout & 0xff) * ((layout >> 8) & 0xff);
+        return copies > 0 ? raid_disks / copies : 0;
+    }
+
+    /* linear, raid1,... -- no striping */
+    return 0;
+}
+
+/**
+ * get_stripe_geometry: (skip)
+ * @device: device to get the stripe geometry for
+ * @stripe_unit: (out): stripe unit (chunk size) in bytes, 0 if the device is not striped
+ * @stripe_width: (out): number of data stripes, 0 if the device is not striped
+ *
+ * MD RAID arrays are inspected directly (chunk size, level and number of member
+ * devices), for all other devices (including LVM striped and RAID LVs which
+ * propagate their stripe size this way) the I/O hints from `queue/minimum_io_size`
+ * and `queue/optimal_io_size` are used.
+ *
+ * Returns: whether the geometry was successfully determined or not
+ */
+G_GNUC_INTERNAL gboolean
+get_stripe_geometry (const gchar *device, guint32 *stripe_unit, guint32 *stripe_width, GError **error) {
+    g_autofree gchar *sys_dir = NULL;
+    g_autofree gchar *md_dir = NULL;
+    g_autofree gchar *disk_name = NULL;
+    g_autofree gchar *level = NULL;
+    g_autofree gchar *level_path = NULL;
+    g_autofree gchar *dev_name = NULL;
+    gchar real_path[PATH_MAX] = {0};
+    guint64 min_io = 0;
+    guint64 opt_io = 0;
+    guint64 chunk = 0;
+    guint64 raid_disks = 0;
+    guint64 layout = 0;
+    guint64 data_disks = 0;
+
+    *stripe_unit = 0;
+    *stripe_width = 0;
+
+    if (!realpath (device, real_path)) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to resolve the device '%s': %s",
+                     device, strerror_l (errno, _C_LOCALE));
+        return FALSE;
+    }
+
+    dev_name = g_path_get_basename (real_path);
+    sys_dir = g_build_filename ("/sys/class/block", dev_name, NULL);
+    if (!g_file_test (sys_dir, G_FILE_TEST_IS_DIR)) {
+        /* not a block device (e.g. an image file), nothing to align to */
+        bd_utils_log_format (BD_UTILS_LOG_INFO, "No topology information available for '%s'", device);
+        return TRUE;
+    }
+
+    /* partitions inherit the geometry of the whole device */
+    disk_name = bd_utils_get_whole_disk_name (dev_name, NULL);
+    if (disk_name) {
+        g_free (sys_dir);
+        sys_dir = g_build_filename ("/sys/class/block", disk_name, NULL);
+    }
+
+    md_dir = g_build_filename (sys_dir, "md", NULL);
+    if (g_file_test (md_dir, G_FILE_TEST_IS_DIR)) {
+        level_path = g_build_filename (md_dir, "level", NULL);
+        if (g_file_get_contents (level_path, &level, NULL, NULL) &&
+            read_sysfs_u64 (md_dir, "chunk_size", &chunk) &&
+            read_sysfs_u64 (md_dir, "raid_disks", &raid_disks)) {
+            g_strstrip (level);
+            if (g_strcmp0 (level, "raid10") == 0 && !read_sysfs_u64 (md_dir, "layout", &layout))
+                layout = 0;
+            data_disks = md_data_disks (level, raid_disks, layout);
+            if (chunk > 0 && data_disks > 0 && chunk <= G_MAXUINT32) {
+                *stripe_unit = (guint32) chunk;
+                *stripe_width = (guint32) data_disks;
+                return TRUE;
+            }
+        }
+    }
+
+    if (!read_sysfs_u64 (sys_dir, "queue/minimum_io_size", &min_io) ||
+        !read_sysfs_u64 (sys_dir, "queue/optimal_io_size", &opt_io)) {
+        bd_utils_log_format (BD_UTILS_LOG_INFO, "No I/O hints available for '%s'", device);
+        return TRUE;
+    }
+
+    /* minimum I/O size equal to (or smaller than) a page is just the physical sector
+       size, optimal I/O size which is not a multiple of the minimum one is a bogus
+       value reported by some devices (USB bridges,...) */
+    if (min_io <= 4096 || opt_io < min_io || opt_io % min_io != 0 || min_io > G_MAXUINT32)
+        return TRUE;
+
+    *stripe_unit = (guint32) min_io;
+    *stripe_width = (guint32) (opt_io / min_io);
+
+    return TRUE;
+}
+
+/* size (in bytes) of the block device with the @devno device number */
+G_GNUC_INTERNAL gboolean
+get_blockdev_size (dev_t devno, guint64 *size, GError **error) {
+    g_autofree gchar *dev_path = NULL;
+    gint fd = -1;
+
+    dev_path = g_strdup_printf ("/dev/block/%u:%u", major (devno), minor (devno));
+    fd = open (dev_path, O_RDONLY|O_CLOEXEC);
+    if (fd == -1) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to open the device '%s': %s",
+                     dev_path, strerror_l (errno, _C_LOCALE));
+        return FALSE;
+    }
+
+    if (ioctl (fd, BLKGETSIZE64, size) != 0) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to get size of the device '%s': %s",
+                     dev_path, strerror_l (errno, _C_LOCALE));
+        close (fd);
+        return FALSE;
+    }
+    close (fd);
+
+    return TRUE;
+}
+
+G_GNUC_INTERNAL void
+free_space_hist_add (FreeSpaceHist *hist, guint64 length) {
+    guint bucket = 0;
+
+    if (length == 0)
+        return;
+
+    /* position of the highest bit set, g_bit_nth_msf() works with gulong which
+       is just 32 bits long on 32-bit systems */
+    bucket = 63 - __builtin_clzll (length);
+    hist->extents[bucket]++;
+    hist->bytes[bucket] += length;
+}
@@ -1,5 +1,6 @@
 #include <glib.h>
 #include <blkid.h>
+#include <sys/types.h>
 
 #ifndef BD_FS_COMMON
 #define BD_FS_COMMON
@@ -10,5 +11,17 @@
 gint synced_close (gint fd);
 gboolean get_uuid_label (const gchar *device, gchar **uuid, gchar **label, GError **error);
 gboolean check_uuid (const gchar *uuid, GError **error);
+gboolean get_stripe_geometry (const gchar *device, guint32 *stripe_unit, guint32 *stripe_width, GError **error);
+gboolean get_blockdev_size (dev_t devno, guint64 *size, GError **error);
+
+/* free extents counted by the position of their size's highest bit */
+typedef struct FreeSpaceHist {
+    guint64 extents[64];
+    guint64 bytes[64];
+} FreeSpaceHist;
+
+void free_space_hist_add (FreeSpaceHist *hist, guint64 length);
+/* implemented in ext.c (with ext2fs) */
+gboolean ext_get_free_space_hist (const gchar *device, FreeSpaceHist *hist, GError **error);
 
 #endif  /* BD_FS_COMMON */
@@ -19,6 +19,15 @@
 
 #include <ext2fs.h>
 #include <e2p.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <linux/magic.h>
+#include <linux/types.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
 
 #include <blockdev/utils.h>
 #include <check_deps.h>
@@ -26,11 +35,17 @@
 #include "common.h"
 #include "fs.h"
 #include "ext.h"
+#include "mount.h"
 
 #define EXT2 "ext2"
 #define EXT3 "ext3"
 #define EXT4 "ext4"
 
+/* not exported in the kernel UAPI headers (fs/ext4/ext4.h) */
+#ifndef EXT4_IOC_RESIZE_FS
+#define EXT4_IOC_RESIZE_FS _IOW ('f', 16, __u64)
+#endif
+
 static volatile guint avail_deps = 0;
 static GMutex deps_check_lock;
 
@@ -238,9 +253,29 @@ void bd_fs_ext4_info_free (BDFSExt4Info *data) {
     bd_fs_ext2_info_free ((BDFSExt2Info*) data);
 }
 
-static BDExtraArg **ext_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra) {
+/* block size for the stride/stripe_width computation, either from @extra or the mke2fs default */
+static guint64 ext_mkfs_block_size (const BDExtraArg **extra) {
+    const BDExtraArg **extra_p = NULL;
+    guint64 block_size = 0;
+
+    if (extra) {
+        for (extra_p = extra; *extra_p; extra_p++) {
+            if (g_strcmp0 ((*extra_p)->opt, "-b") == 0 && (*extra_p)->val)
+                block_size = g_ascii_strtoull ((*extra_p)->val, NULL, 10);
+        }
+    }
+
+    return block_size > 0 ? block_size : 4096;
+}
+
+static BDExtraArg **ext_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra, const gchar *ext_version) {
     GPtrArray *options_array = g_ptr_array_new ();
+    GPtrArray *ext_opts = g_ptr_array_new_with_free_func (g_free);
     const BDExtraArg **extra_p = NULL;
+    g_autofree gchar *ext_opts_str = NULL;
+    g_autofree gchar *journal_opts = NULL;
+    guint64 block_size = 0;
+    guint64 stride = 0;
 
     if (options->label && g_strcmp0 (options->label, "") != 0)
         g_ptr_array_add (options_array, bd_extra_arg_new ("-L", options->label));
@@ -251,8 +286,55 @@ static BDExtraArg **ext_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg
     if (options->dry_run)
         g_ptr_array_add (options_array, bd_extra_arg_new ("-n", ""));
 
+    /* mke2fs only takes the last '-E' option into account so all the extended
+       options need to be passed together */
     if (options->no_discard)
-        g_ptr_array_add (options_array, bd_extra_arg_new ("-E", "nodiscard"));
+        g_ptr_array_add (ext_opts, g_strdup ("nodiscard"));
+
+    if (options->stripe_unit > 0 && options->stripe_width > 0) {
+        block_size = ext_mkfs_block_size (extra);
+        if (options->stripe_unit % block_size == 0) {
+            stride = options->stripe_unit / block_size;
+            g_ptr_array_add (ext_opts, g_strdup_printf ("stride=%"G_GUINT64_FORMAT, stride));
+            g_ptr_array_add (ext_opts, g_strdup_printf ("stripe_width=%"G_GUINT64_FORMAT,
+                                                        stride * options->stripe_width));
+        } else {
+            bd_utils_log_format (BD_UTILS_LOG_INFO,
+                                 "Stripe unit %"G_GUINT32_FORMAT" is not a multiple of the block size, "
+                                 "not setting stride", options->stripe_unit);
+            options->stripe_unit = 0;
+            options->stripe_width = 0;
+        }
+    } else {
+        options->stripe_unit = 0;
+        options->stripe_width = 0;
+    }
+
+    if (options->lazy_itable_init != BD_FS_MKFS_LAZY_INIT_DEFAULT)
+        g_ptr_array_add (ext_opts, g_strdup_printf ("lazy_itable_init=%d",
+                                                    options->lazy_itable_init == BD_FS_MKFS_LAZY_INIT_ENABLE));
+
+    if (options->lazy_journal_init != BD_FS_MKFS_LAZY_INIT_DEFAULT)
+        g_ptr_array_add (ext_opts, g_strdup_printf ("lazy_journal_init=%d",
+                                                    options->lazy_journal_init == BD_FS_MKFS_LAZY_INIT_ENABLE));
+
+    if (ext_opts->len > 0) {
+        g_ptr_array_add (ext_opts, NULL);
+        ext_opts_str = g_strjoinv (",", (gchar **) ext_opts->pdata);
+        g_ptr_array_add (options_array, bd_extra_arg_new ("-E", ext_opts_str));
+    }
+    g_ptr_array_free (ext_opts, TRUE);
+
+    /* ext2 has no journal, adding one would turn it into ext3 */
+    if (g_strcmp0 (ext_version, EXT2) != 0) {
+        if (options->journal_device && g_strcmp0 (options->journal_device, "") != 0)
+            journal_opts = g_strdup_printf ("device=%s", options->journal_device);
+        else if (options->journal_size > 0)
+            journal_opts = g_strdup_printf ("size=%"G_GUINT32_FORMAT, options->journal_size);
+
+        if (journal_opts)
+            g_ptr_array_add (options_array, bd_extra_arg_new ("-J", journal_opts));
+    }
 
     if (options->force)
         g_ptr_array_add (options_array, bd_extra_arg_new ("-F", ""));
@@ -269,17 +351,17 @@ static BDExtraArg **ext_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg
 
 G_GNUC_INTERNAL BDExtraArg **
 bd_fs_ext2_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra) {
-    return ext_mkfs_options (options, extra);
+    return ext_mkfs_options (options, extra, EXT2);
 }
 
 G_GNUC_INTERNAL BDExtraArg **
 bd_fs_ext3_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra) {
-    return ext_mkfs_options (options, extra);
+    return ext_mkfs_options (options, extra, EXT3);
 }
 
 G_GNUC_INTERNAL BDExtraArg **
 bd_fs_ext4_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra) {
-    return ext_mkfs_options (options, extra);
+    return ext_mkfs_options (options, extra, EXT4);
 }
 
 static gboolean ext_mkfs (const gchar *device, const BDExtraArg **extra, const gchar *ext_version, GError **error) {
@@ -753,6 +835,61 @@ static BDFSExtInfo* ext_get_info (const gchar *device, GError **error) {
     return ret;
 }
 
+/* adds all free extents of the ext file system on @device to @hist */
+G_GNUC_INTERNAL gboolean
+ext_get_free_space_hist (const gchar *device, FreeSpaceHist *hist, GError **error) {
+    errcode_t retval;
+    ext2_filsys fs;
+    blk64_t start = 0;
+    blk64_t end = 0;
+    blk64_t free_start = 0;
+    blk64_t free_end = 0;
+    guint64 block_size = 0;
+
+    int flags = (EXT2_FLAG_SOFTSUPP_FEATURES | EXT2_FLAG_64BITS |
+                 EXT2_FLAG_IGNORE_CSUM_ERRORS);
+
+#ifdef EXT2_FLAG_THREADS
+    flags |= EXT2_FLAG_THREADS;
+#endif
+
+    retval = ext2fs_open (device,
+                          flags,
+                          0, /* use_superblock */
+                          0, /* use_blocksize */
+                          unix_io_manager,
+                          &fs);
+    if (retval) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL, "Failed to open ext4 file system");
+        return FALSE;
+    }
+
+    retval = ext2fs_read_block_bitmap (fs);
+    if (retval) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to read block bitmaps of the file system on '%s'", device);
+        ext2fs_close_free (&fs);
+        return FALSE;
+    }
+
+    block_size = EXT2_BLOCK_SIZE (fs->super);
+    start = fs->super->s_first_data_block;
+    end = ext2fs_blocks_count (fs->super) - 1;
+    while (start <= end) {
+        if (ext2fs_find_first_zero_block_bitmap2 (fs->block_map, start, end, &free_start) != 0)
+            /* no more free blocks */
+            break;
+        if (ext2fs_find_first_set_block_bitmap2 (fs->block_map, free_start, end, &free_end) != 0)
+            /* free till the end of the file system */
+            free_end = end + 1;
+        free_space_hist_add (hist, (free_end - free_start) * block_size);
+        start = free_end + 1;
+    }
+
+    ext2fs_close_free (&fs);
+    return TRUE;
+}
+
 /**
  * bd_fs_ext2_get_info:
  * @device: the device the file system of which to get info for
@@ -795,9 +932,79 @@ BDFSExt4Info* bd_fs_ext4_get_info (const gchar *device, GError **error) {
     return (BDFSExt4Info*) ext_get_info (device, error);
 }
 
+/* grows the mounted file system on @device in-process (what resize2fs does for
+   mounted file systems), @done is set to FALSE if the file system needs to be
+   resized by resize2fs instead (not mounted, shrinking, unsupported,...) */
+static gboolean ext_online_grow (const gchar *device, guint64 new_size, gboolean *done, GError **error) {
+    g_autofree gchar *mountpoint = NULL;
+    struct statfs sfs;
+    struct stat st;
+    guint64 dev_size = 0;
+    __u64 new_blocks = 0;
+    gint fd = -1;
+
+    *done = FALSE;
+
+    /* not mounted (or the mount table cannot be read) -> offline resize */
+    mountpoint = bd_fs_get_mountpoint (device, NULL);
+    if (!mountpoint)
+        return TRUE;
+
+    if (new_size == 0) {
+        if (stat (device, &st) != 0 || !S_ISBLK (st.st_mode) ||
+            !get_blockdev_size (st.st_rdev, &dev_size, NULL))
+            return TRUE;
+        new_size = dev_size;
+    }
+
+    fd = open (mountpoint, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+    if (fd == -1)
+        return TRUE;
+
+    if (fstatfs (fd, &sfs) != 0 || sfs.f_type != EXT4_SUPER_MAGIC || sfs.f_bsize == 0) {
+        close (fd);
+        return TRUE;
+    }
+
+    /* f_blocks doesn't include the file system's overhead so this doesn't catch
+       all shrink requests, the kernel refuses the rest with EINVAL */
+    new_blocks = new_size / sfs.f_bsize;
+    if (new_blocks < sfs.f_blocks) {
+        close (fd);
+        return TRUE;
+    }
+
+    if (ioctl (fd, EXT4_IOC_RESIZE_FS, &new_blocks) != 0) {
+        if (errno == ENOTTY || errno == EOPNOTSUPP || errno == EINVAL) {
+            bd_utils_log_format (BD_UTILS_LOG_INFO, "Online resize of '%s' not possible in-process: %s",
+                                 device, strerror_l (errno, _C_LOCALE));
+            close (fd);
+            return TRUE;
+        }
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to resize the file system mounted on '%s': %s",
+                     mountpoint, strerror_l (errno, _C_LOCALE));
+        close (fd);
+        return FALSE;
+    }
+    close (fd);
+
+    *done = TRUE;
+    return TRUE;
+}
+
 static gboolean ext_resize (const gchar *device, guint64 new_size, const BDExtraArg **extra, GError **error) {
     const gchar *args[4] = {"resize2fs", device, NULL, NULL};
     gboolean ret = FALSE;
+    gboolean done = FALSE;
+
+    /* extra options are for resize2fs, use it if some are given */
+    if (!extra) {
+        if (!ext_online_grow (device, new_size, &done, error))
+            return FALSE;
+        if (done)
+            return TRUE;
+    }
 
     if (!check_deps (&avail_deps, DEPS_RESIZE2FS_MASK, deps, DEPS_LAST, &deps_check_lock, error))
         return FALSE;
@@ -854,6 +1061,9 @@ gboolean bd_fs_ext3_resize (const gchar *device, guint64 new_size, const BDExtra
  *                                                 passed to the 'resize2fs' utility)
  * @error: (out) (optional): place to store error (if any)
  *
+ * Growing a mounted file system is done directly with the EXT4_IOC_RESIZE_FS
+ * ioctl (unless @extra is given), 'resize2fs' is used in all the other cases.
+ *
  * Returns: whether the file system on @device was successfully resized or not
  *
  * Tech category: %BD_FS_TECH_EXT4-%BD_FS_TECH_MODE_RESIZE
@@ -41,6 +41,9 @@ static GMutex deps_check_lock;
 
 #define DEPS_LAST 5
 
+/* size of an f2fs segment (512 4 KiB blocks) */
+#define F2FS_SEGMENT_SIZE (2 MiB)
+
 static const UtilDep deps[DEPS_LAST] = {
     {"mkfs.f2fs", NULL, NULL, NULL},
     {"fsck.f2fs", "1.11.0", "-V", "fsck.f2fs\\s+([\\d\\.]+).+"},
@@ -175,6 +178,8 @@ G_GNUC_INTERNAL BDExtraArg **
 bd_fs_f2fs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra) {
     GPtrArray *options_array = g_ptr_array_new ();
     const BDExtraArg **extra_p = NULL;
+    gchar *segs_option = NULL;
+    guint64 full_stripe = 0;
 
     if (options->label && g_strcmp0 (options->label, "") != 0)
         g_ptr_array_add (options_array, bd_extra_arg_new ("-l", options->label));
@@ -185,6 +190,19 @@ bd_fs_f2fs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra) {
     if (options->force)
         g_ptr_array_add (options_array, bd_extra_arg_new ("-f", ""));
 
+    full_stripe = (guint64) options->stripe_unit * options->stripe_width;
+    if (full_stripe > F2FS_SEGMENT_SIZE && full_stripe % F2FS_SEGMENT_SIZE == 0) {
+        /* make sections (the unit of GC) span whole stripes */
+        segs_option = g_strdup_printf ("%"G_GUINT64_FORMAT, full_stripe / F2FS_SEGMENT_SIZE);
+        g_ptr_array_add (options_array, bd_extra_arg_new ("-s", segs_option));
+        g_free (segs_option);
+    } else if (full_stripe == 0 || F2FS_SEGMENT_SIZE % full_stripe != 0) {
+        /* segments can't be aligned to stripes (or no stripes at all) */
+        options->stripe_unit = 0;
+        options->stripe_width = 0;
+    }
+    /* else: segments are naturally aligned to full stripes */
+
     if (extra) {
         for (extra_p = extra; *extra_p; extra_p++)
             g_ptr_array_add (options_array, bd_extra_arg_copy ((BDExtraArg *) *extra_p));
@@ -24,7 +24,12 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/ioctl.h>
+#include <sys/statfs.h>
+#include <sys/sysmacros.h>
 #include <linux/fs.h>
+#include <linux/fsmap.h>
+#include <libmount/libmount.h>
+#include <libdevmapper.h>
 #include <fcntl.h>
 #include <errno.h>
 
@@ -63,7 +68,7 @@ static const BDFSFeatures fs_features[BD_FS_LAST_FS] = {
     /* EXT2 */
     { .resize = BD_FS_ONLINE_GROW | BD_FS_OFFLINE_GROW | BD_FS_OFFLINE_SHRINK,
       .mkfs = BD_FS_MKFS_LABEL | BD_FS_MKFS_UUID | BD_FS_MKFS_DRY_RUN | BD_FS_MKFS_NODISCARD |
-              BD_FS_MKFS_FORCE,
+              BD_FS_MKFS_FORCE | BD_FS_MKFS_GEOMETRY | BD_FS_MKFS_LAZY_INIT,
       .fsck = BD_FS_FSCK_CHECK | BD_FS_FSCK_REPAIR,
       .configure = BD_FS_SUPPORT_SET_LABEL | BD_FS_SUPPORT_SET_UUID,
       .features =  BD_FS_FEATURE_OWNERS,
@@ -74,7 +79,7 @@ static const BDFSFeatures fs_features[BD_FS_LAST_FS] = {
     /* EXT3 */
     { .resize = BD_FS_ONLINE_GROW | BD_FS_OFFLINE_GROW | BD_FS_OFFLINE_SHRINK,
       .mkfs = BD_FS_MKFS_LABEL | BD_FS_MKFS_UUID | BD_FS_MKFS_DRY_RUN | BD_FS_MKFS_NODISCARD |
-              BD_FS_MKFS_FORCE,
+              BD_FS_MKFS_FORCE | BD_FS_MKFS_GEOMETRY | BD_FS_MKFS_LAZY_INIT | BD_FS_MKFS_JOURNAL,
       .fsck = BD_FS_FSCK_CHECK | BD_FS_FSCK_REPAIR,
       .configure = BD_FS_SUPPORT_SET_LABEL | BD_FS_SUPPORT_SET_UUID,
       .features =  BD_FS_FEATURE_OWNERS,
@@ -85,7 +90,7 @@ static const BDFSFeatures fs_features[BD_FS_LAST_FS] = {
     /* EXT4 */
     { .resize = BD_FS_ONLINE_GROW | BD_FS_OFFLINE_GROW | BD_FS_OFFLINE_SHRINK,
       .mkfs = BD_FS_MKFS_LABEL | BD_FS_MKFS_UUID | BD_FS_MKFS_DRY_RUN | BD_FS_MKFS_NODISCARD |
-              BD_FS_MKFS_FORCE,
+              BD_FS_MKFS_FORCE | BD_FS_MKFS_GEOMETRY | BD_FS_MKFS_LAZY_INIT | BD_FS_MKFS_JOURNAL,
       .fsck = BD_FS_FSCK_CHECK | BD_FS_FSCK_REPAIR,
       .configure = BD_FS_SUPPORT_SET_LABEL | BD_FS_SUPPORT_SET_UUID,
       .features =  BD_FS_FEATURE_OWNERS,
@@ -96,7 +101,7 @@ static const BDFSFeatures fs_features[BD_FS_LAST_FS] = {
     /* XFS */
     { .resize = BD_FS_ONLINE_GROW | BD_FS_OFFLINE_GROW,
       .mkfs = BD_FS_MKFS_LABEL | BD_FS_MKFS_UUID | BD_FS_MKFS_DRY_RUN | BD_FS_MKFS_NODISCARD |
-              BD_FS_MKFS_FORCE,
+              BD_FS_MKFS_FORCE | BD_FS_MKFS_GEOMETRY | BD_FS_MKFS_JOURNAL,
       .fsck = BD_FS_FSCK_CHECK | BD_FS_FSCK_REPAIR,
       .configure = BD_FS_SUPPORT_SET_LABEL | BD_FS_SUPPORT_SET_UUID,
       .features =  BD_FS_FEATURE_OWNERS,
@@ -126,7 +131,7 @@ static const BDFSFeatures fs_features[BD_FS_LAST_FS] = {
       .max_size = 16 TiB },
     /* F2FS */
     { .resize = BD_FS_OFFLINE_GROW | BD_FS_OFFLINE_SHRINK,
-      .mkfs = BD_FS_MKFS_LABEL | BD_FS_MKFS_NODISCARD | BD_FS_MKFS_FORCE,
+      .mkfs = BD_FS_MKFS_LABEL | BD_FS_MKFS_NODISCARD | BD_FS_MKFS_FORCE | BD_FS_MKFS_GEOMETRY,
       .fsck = BD_FS_FSCK_CHECK | BD_FS_FSCK_REPAIR,
       .configure =  0,
       .features = BD_FS_FEATURE_OWNERS,
@@ -722,21 +727,22 @@ static gboolean xfs_resize_device (const gchar *device, guint64 new_size, const
     gboolean success = FALSE;
     gboolean unmount = FALSE;
     GError *local_error = NULL;
-    BDFSXfsInfo* xfs_info = NULL;
-
-    xfs_info = bd_fs_xfs_get_info (device, error);
-    if (!xfs_info) {
-        return FALSE;
-    }
+    struct statfs sfs;
 
     mountpoint = fs_mount (device, "xfs", FALSE, &unmount, error);
     if (!mountpoint)
         return FALSE;
 
-    new_size = (new_size + xfs_info->block_size - 1) / xfs_info->block_size;
-    bd_fs_xfs_info_free (xfs_info);
-
-    success = bd_fs_xfs_resize (mountpoint, new_size, extra, error);
+    /* block size of the mounted file system, no need to run xfs_spaceman for it */
+    if (statfs (mountpoint, &sfs) != 0 || sfs.f_bsize == 0) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to get block size of the file system on '%s': %s",
+                     device, strerror_l (errno, _C_LOCALE));
+        success = FALSE;
+    } else {
+        new_size = (new_size + sfs.f_bsize - 1) / sfs.f_bsize;
+        success = bd_fs_xfs_resize (mountpoint, new_size, extra, error);
+    }
 
     if (unmount) {
         ret = bd_fs_unmount (mountpoint, FALSE, FALSE, NULL, &local_error);
@@ -1907,6 +1913,873 @@ gboolean bd_fs_unfreeze (const gchar *mountpoint, GError **error) {
     return fs_freeze (mountpoint, FALSE, error);
 }
 
+/**
+ * bd_fs_trim_options_copy: (skip)
+ * @data: (nullable): %BDFSTrimOptions to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDFSTrimOptions* bd_fs_trim_options_copy (BDFSTrimOptions *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDFSTrimOptions *ret = g_new0 (BDFSTrimOptions, 1);
+
+    ret->min_extent = data->min_extent;
+    ret->chunk_size = data->chunk_size;
+    ret->max_bandwidth = data->max_bandwidth;
+    ret->max_iops = data->max_iops;
+
+    return ret;
+}
+
+/**
+ * bd_fs_trim_options_free: (skip)
+ * @data: (nullable): %BDFSTrimOptions to free
+ *
+ * Frees @data.
+ */
+void bd_fs_trim_options_free (BDFSTrimOptions *data) {
+    g_free (data);
+}
+
+/**
+ * bd_fs_trim_result_copy: (skip)
+ * @data: (nullable): %BDFSTrimResult to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDFSTrimResult* bd_fs_trim_result_copy (BDFSTrimResult *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDFSTrimResult *ret = g_new0 (BDFSTrimResult, 1);
+
+    ret->mountpoint = g_strdup (data->mountpoint);
+    ret->trimmed = data->trimmed;
+    ret->thin_pool = g_strdup (data->thin_pool);
+    ret->pool_used_before = data->pool_used_before;
+    ret->pool_used_after = data->pool_used_after;
+
+    return ret;
+}
+
+/**
+ * bd_fs_trim_result_free: (skip)
+ * @data: (nullable): %BDFSTrimResult to free
+ *
+ * Frees @data.
+ */
+void bd_fs_trim_result_free (BDFSTrimResult *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->mountpoint);
+    g_free (data->thin_pool);
+    g_free (data);
+}
+
+/* Returns: device number of the block device the filesystem mounted on @mountpoint
+            lives on or 0 if it cannot be determined (e.g. not a block device based fs) */
+static dev_t get_mount_devno (const gchar *mountpoint) {
+    struct libmnt_table *table = NULL;
+    struct libmnt_fs *fs = NULL;
+    const gchar *source = NULL;
+    struct stat st;
+    dev_t devno = 0;
+
+    if (stat (mountpoint, &st) != 0)
+        return 0;
+    if (major (st.st_dev) != 0)
+        return st.st_dev;
+
+    /* anonymous device number (e.g. btrfs), try the mount source instead */
+    table = mnt_new_table ();
+    if (mnt_table_parse_mtab (table, NULL) == 0) {
+        fs = mnt_table_find_target (table, mountpoint, MNT_ITER_BACKWARD);
+        if (fs)
+            source = mnt_fs_get_srcpath (fs);
+        if (source && stat (source, &st) == 0 && S_ISBLK (st.st_mode))
+            devno = st.st_rdev;
+    }
+    mnt_free_table (table);
+
+    return devno;
+}
+
+/* adds names of the whole disks backing the block device represented by @sys_dir to @disks */
+static void add_backing_disks (const gchar *sys_dir, GHashTable *disks) {
+    g_autofree gchar *slaves_dir = NULL;
+    g_autofree gchar *real_dir = NULL;
+    g_autofree gchar *name = NULL;
+    gchar *disk = NULL;
+    GDir *dir = NULL;
+    const gchar *slave = NULL;
+    gboolean has_slaves = FALSE;
+
+    real_dir = realpath (sys_dir, NULL);
+    if (!real_dir)
+        return;
+
+    /* partitions are represented by their parent disks */
+    name = g_path_get_basename (real_dir);
+    disk = bd_utils_get_whole_disk_name (name, NULL);
+    if (disk && g_strcmp0 (disk, name) != 0) {
+        g_hash_table_add (disks, disk);
+        return;
+    }
+    g_free (disk);
+
+    slaves_dir = g_build_filename (real_dir, "slaves", NULL);
+    dir = g_dir_open (slaves_dir, 0, NULL);
+    if (dir) {
+        while ((slave = g_dir_read_name (dir))) {
+            g_autofree gchar *slave_dir = g_build_filename ("/sys/class/block", slave, NULL);
+            add_backing_disks (slave_dir, disks);
+            has_slaves = TRUE;
+        }
+        g_dir_close (dir);
+    }
+
+    if (!has_slaves)
+        g_hash_table_add (disks, g_strdup (name));
+}
+
+static gchar* devno_sys_dir (dev_t devno) {
+    return g_strdup_printf ("/sys/dev/block/%u:%u", major (devno), minor (devno));
+}
+
+/**
+ * get_dm_params: (skip)
+ *
+ * Reads the table or status (based on @task_type, %DM_DEVICE_TABLE or %DM_DEVICE_STATUS)
+ * of the single-target DM map @dm_name with target of the @target_type type.
+ *
+ * Returns: (transfer full): the target params split into fields or %NULL if the map
+ *                           couldn't be queried or is not a single @target_type target
+ */
+static gchar** get_dm_params (const gchar *dm_name, int task_type, const gchar *target_type) {
+    struct dm_task *task = NULL;
+    struct dm_info info;
+    guint64 start = 0;
+    guint64 length = 0;
+    gchar *type = NULL;
+    gchar *params = NULL;
+    gchar **fields = NULL;
+
+    task = dm_task_create (task_type);
+    if (!task)
+        return NULL;
+
+    if (dm_task_set_name (task, dm_name) == 0 || dm_task_run (task) == 0 ||
+        dm_task_get_info (task, &info) == 0 || !info.exists) {
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    if (dm_get_next_target (task, NULL, &start, &length, &type, &params) != NULL) {
+        /* more than one target */
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    if (g_strcmp0 (type, target_type) == 0 && params)
+        fields = g_strsplit_set (params, " ", -1);
+
+    dm_task_destroy (task);
+    return fields;
+}
+
+/* Returns: (transfer full): name of the DM device represented by @sys_dir or %NULL if not a DM device */
+static gchar* get_dm_name (const gchar *sys_dir) {
+    g_autofree gchar *name_path = NULL;
+    gchar *dm_name = NULL;
+
+    name_path = g_build_filename (sys_dir, "dm", "name", NULL);
+    if (!g_file_get_contents (name_path, &dm_name, NULL, NULL))
+        return NULL;
+
+    return g_strstrip (dm_name);
+}
+
+/**
+ * find_thin_pool: (skip)
+ *
+ * Walks down the device stack from @devno following single-device mappings
+ * (e.g. LUKS on top of a thin LV) looking for a thin LV (dm-thin device).
+ *
+ * Returns: (transfer full): `major:minor` of the thin pool @devno is backed by or
+ *                           %NULL if not backed by a thin pool
+ */
+static gchar* find_thin_pool (dev_t devno) {
+    g_autofree gchar *sys_dir = NULL;
+    gchar *dm_name = NULL;
+    gchar **table = NULL;
+    gchar *pool = NULL;
+    gchar *slave = NULL;
+    gchar *slaves_dir = NULL;
+    const gchar *entry = NULL;
+    GDir *dir = NULL;
+    guint n_slaves = 0;
+
+    sys_dir = devno_sys_dir (devno);
+    while (!pool) {
+        dm_name = get_dm_name (sys_dir);
+        if (!dm_name)
+            return NULL;
+
+        /* thin table params: <pool dev> <dev id> */
+        table = get_dm_params (dm_name, DM_DEVICE_TABLE, "thin");
+        g_free (dm_name);
+        if (table && g_strv_length (table) >= 2)
+            pool = g_strdup (table[0]);
+        g_strfreev (table);
+        if (pool)
+            break;
+
+        slaves_dir = g_build_filename (sys_dir, "slaves", NULL);
+        dir = g_dir_open (slaves_dir, 0, NULL);
+        g_free (slaves_dir);
+        if (!dir)
+            return NULL;
+        n_slaves = 0;
+        while ((entry = g_dir_read_name (dir))) {
+            n_slaves++;
+            g_free (slave);
+            slave = g_strdup (entry);
+        }
+        g_dir_close (dir);
+        if (n_slaves != 1) {
+            g_free (slave);
+            return NULL;
+        }
+
+        g_free (sys_dir);
+        sys_dir = g_build_filename ("/sys/class/block", slave, NULL);
+        g_clear_pointer (&slave, g_free);
+    }
+
+    return pool;
+}
+
+/**
+ * get_thin_pool_usage: (skip)
+ *
+ * Gets data space usage of the thin pool @devno is backed by from `<used>/<total>`
+ * data blocks in the pool's status and data block size (in sectors) in its table.
+ *
+ * Returns: whether @devno is backed by a thin pool (and its usage was read) or not
+ */
+static gboolean get_thin_pool_usage (dev_t devno, gchar **pool_name, guint64 *used) {
+    g_autofree gchar *pool = NULL;
+    g_autofree gchar *pool_sys_dir = NULL;
+    gchar *dm_name = NULL;
+    gchar **pool_table = NULL;
+    gchar **pool_status = NULL;
+    gboolean ret = FALSE;
+
+    if (devno == 0)
+        return FALSE;
+
+    pool = find_thin_pool (devno);
+    if (!pool)
+        return FALSE;
+
+    pool_sys_dir = g_strdup_printf ("/sys/dev/block/%s", pool);
+    dm_name = get_dm_name (pool_sys_dir);
+    if (!dm_name)
+        return FALSE;
+
+    /* pool table params: <metadata dev> <data dev> <data block size> ...
+       pool status params: <transaction id> <used>/<total metadata> <used>/<total data> ... */
+    pool_table = get_dm_params (dm_name, DM_DEVICE_TABLE, "thin-pool");
+    pool_status = get_dm_params (dm_name, DM_DEVICE_STATUS, "thin-pool");
+    if (pool_table && g_strv_length (pool_table) >= 3 && pool_status && g_strv_length (pool_status) >= 3) {
+        *used = g_ascii_strtoull (pool_status[2], NULL, 10) * g_ascii_strtoull (pool_table[2], NULL, 10) * 512;
+        *pool_name = dm_name;
+        dm_name = NULL;
+        ret = TRUE;
+    }
+
+    g_free (dm_name);
+    g_strfreev (pool_table);
+    g_strfreev (pool_status);
+    return ret;
+}
+
+/* throttles the trimming to the limits given in @options */
+static void trim_throttle (BDFSTrimOptions *options, gint64 start_time, guint64 trimmed, guint64 calls) {
+    gint64 elapsed = g_get_monotonic_time () - start_time;
+    gint64 expected = 0;
+
+    if (options->max_bandwidth > 0)
+        expected = (gint64) ((gdouble) trimmed / options->max_bandwidth * G_USEC_PER_SEC);
+    if (options->max_iops > 0)
+        expected = MAX (expected, (gint64) ((gdouble) calls / options->max_iops * G_USEC_PER_SEC));
+
+    if (expected > elapsed)
+        g_usleep (expected - elapsed);
+}
+
+static BDFSTrimResult* fs_trim (const gchar *mountpoint, dev_t devno, BDFSTrimOptions *options, GError **error) {
+    BDFSTrimOptions defaults = { 0 };
+    BDFSTrimResult *ret = NULL;
+    struct fstrim_range range;
+    struct statfs sfs;
+    guint64 fs_size = 0;
+    guint64 offset = 0;
+    guint64 calls = 0;
+    gboolean last = FALSE;
+    gint64 start_time = 0;
+    gint fd = -1;
+    GError *l_error = NULL;
+
+    if (!options)
+        options = &defaults;
+
+    if (!bd_fs_is_mountpoint (mountpoint, &l_error)) {
+        if (l_error) {
+            g_propagate_prefixed_error (error, l_error, "Failed to check mountpoint '%s': ", mountpoint);
+            return NULL;
+        }
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_NOT_MOUNTED,
+                     "'%s' doesn't appear to be a mountpoint.", mountpoint);
+        return NULL;
+    }
+
+    fd = open (mountpoint, O_RDONLY);
+    if (fd == -1) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to open the mountpoint '%s': %s",
+                     mountpoint, strerror_l (errno, _C_LOCALE));
+        return NULL;
+    }
+
+    if (fstatfs (fd, &sfs) != 0) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to get size of the filesystem mounted on '%s': %s",
+                     mountpoint, strerror_l (errno, _C_LOCALE));
+        close (fd);
+        return NULL;
+    }
+    fs_size = (guint64) sfs.f_blocks * sfs.f_bsize;
+
+    ret = g_new0 (BDFSTrimResult, 1);
+    ret->mountpoint = g_strdup (mountpoint);
+    if (get_thin_pool_usage (devno, &(ret->thin_pool), &(ret->pool_used_before)))
+        ret->pool_used_after = ret->pool_used_before;
+
+    start_time = g_get_monotonic_time ();
+    while (!last) {
+        /* the last chunk goes all the way to the end of the address space, the
+           size reported by statfs() excludes the filesystem's own overhead */
+        last = options->chunk_size == 0 || offset + options->chunk_size >= fs_size;
+
+        range.start = offset;
+        range.len = last ? G_MAXUINT64 - offset : options->chunk_size;
+        range.minlen = options->min_extent;
+        if (ioctl (fd, FITRIM, &range) != 0) {
+            if (errno == EOPNOTSUPP)
+                g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_NOT_SUPPORTED,
+                             "Filesystem mounted on '%s' or its device doesn't support discard",
+                             mountpoint);
+            else
+                g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                             "Failed to trim the filesystem mounted on '%s': %s",
+                             mountpoint, strerror_l (errno, _C_LOCALE));
+            bd_fs_trim_result_free (ret);
+            close (fd);
+            return NULL;
+        }
+        /* the kernel updates len to the number of bytes discarded */
+        ret->trimmed += range.len;
+        calls++;
+        offset += options->chunk_size;
+
+        if (!last)
+            trim_throttle (options, start_time, ret->trimmed, calls);
+    }
+    close (fd);
+
+    if (ret->thin_pool) {
+        g_free (ret->thin_pool);
+        ret->thin_pool = NULL;
+        get_thin_pool_usage (devno, &(ret->thin_pool), &(ret->pool_used_after));
+    }
+
+    return ret;
+}
+
+/**
+ * bd_fs_trim:
+ * @mountpoint: mountpoint of the filesystem to trim
+ * @options: (nullable): options for the trim operation, %NULL for defaults
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Discards unused blocks of the filesystem mounted on @mountpoint (online
+ * discard using the `FITRIM` ioctl, same as `fstrim`). The filesystem and
+ * the underlying device must support discard.
+ *
+ * Returns: (transfer full): information about the trimmed filesystem or %NULL
+ *                           in case of error (@error is set in this case)
+ */
+BDFSTrimResult* bd_fs_trim (const gchar *mountpoint, BDFSTrimOptions *options, GError **error) {
+    return fs_trim (mountpoint, get_mount_devno (mountpoint), options, error);
+}
+
+typedef struct TrimJob {
+    GArray *indices;
+    const gchar **mountpoints;
+    dev_t *devnos;
+    BDFSTrimOptions *options;
+    BDFSTrimResult **results;
+    GError **errors;
+    BDUtilsExecPolicy *exec_policy;
+} TrimJob;
+
+static gpointer trim_job_run (gpointer data) {
+    TrimJob *job = (TrimJob *) data;
+    guint idx = 0;
+
+    /* the execution policy is per-thread, new threads need the caller's one */
+    if (job->exec_policy)
+        bd_utils_set_exec_policy_thread (job->exec_policy, NULL);
+
+    for (guint i = 0; i < job->indices->len; i++) {
+        idx = g_array_index (job->indices, guint, i);
+        job->results[idx] = fs_trim (job->mountpoints[idx], job->devnos[idx], job->options, &(job->errors[idx]));
+    }
+
+    return NULL;
+}
+
+static guint find_root (guint *parents, guint i) {
+    while (parents[i] != i)
+        i = parents[i] = parents[parents[i]];
+    return i;
+}
+
+/**
+ * bd_fs_trim_many:
+ * @mountpoints: (array zero-terminated=1): mountpoints of the filesystems to trim
+ * @options: (nullable): options for the trim operations, %NULL for defaults
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Trims all filesystems mounted on @mountpoints (see bd_fs_trim()). Filesystems
+ * not sharing any physical disks are trimmed in parallel, filesystems on the same
+ * disks are trimmed one after another. The limits in @options apply to each
+ * filesystem separately.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): information about the trimmed
+ *                                                    filesystems (in the order of
+ *                                                    @mountpoints) or %NULL in case
+ *                                                    of error (@error is set in this case)
+ */
+BDFSTrimResult** bd_fs_trim_many (const gchar **mountpoints, BDFSTrimOptions *options, GError **error) {
+    guint n_mountpoints = g_strv_length ((gchar **) mountpoints);
+    g_autofree dev_t *devnos = g_new0 (dev_t, n_mountpoints);
+    g_autofree guint *parents = g_new0 (guint, n_mountpoints);
+    g_autofree GError **errors = g_new0 (GError *, n_mountpoints);
+    BDFSTrimResult **results = g_new0 (BDFSTrimResult *, n_mountpoints + 1);
+    g_autoptr(GHashTable) disk_owners = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    g_autoptr(GHashTable) jobs = g_hash_table_new (g_direct_hash, g_direct_equal);
+    g_autoptr(GPtrArray) threads = g_ptr_array_new ();
+    BDUtilsExecPolicy *exec_policy = NULL;
+    GHashTableIter iter;
+    gpointer key = NULL;
+    gpointer value = NULL;
+    TrimJob *job = NULL;
+    gboolean failed = FALSE;
+    guint root = 0;
+    guint i = 0;
+
+    /* group the filesystems sharing (some of) the physical disks together,
+       filesystems with unknown backing devices all go to one group */
+    for (i = 0; i < n_mountpoints; i++) {
+        g_autoptr(GHashTable) disks = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+        parents[i] = i;
+        devnos[i] = get_mount_devno (mountpoints[i]);
+        if (devnos[i] != 0) {
+            g_autofree gchar *sys_dir = devno_sys_dir (devnos[i]);
+            add_backing_disks (sys_dir, disks);
+        }
+        if (g_hash_table_size (disks) == 0)
+            g_hash_table_add (disks, g_strdup (""));
+
+        g_hash_table_iter_init (&iter, disks);
+        while (g_hash_table_iter_next (&iter, &key, NULL)) {
+            if (g_hash_table_lookup_extended (disk_owners, key, NULL, &value))
+                parents[find_root (parents, i)] = find_root (parents, GPOINTER_TO_UINT (value));
+            else
+                g_hash_table_insert (disk_owners, g_strdup (key), GUINT_TO_POINTER (i));
+        }
+    }
+
+    exec_policy = bd_utils_get_exec_policy ();
+    for (i = 0; i < n_mountpoints; i++) {
+        root = find_root (parents, i);
+        job = g_hash_table_lookup (jobs, GUINT_TO_POINTER (root));
+        if (!job) {
+            job = g_new0 (TrimJob, 1);
+            job->indices = g_array_new (FALSE, FALSE, sizeof (guint));
+            job->mountpoints = mountpoints;
+            job->devnos = devnos;
+            job->options = options;
+            job->results = results;
+            job->errors = errors;
+            g_hash_table_insert (jobs, GUINT_TO_POINTER (root), job);
+        }
+        g_array_append_val (job->indices, i);
+    }
+
+    /* one thread per group of filesystems, no need for a thread if there's just one
+       (and no need to set the execution policy in the caller's thread then) */
+    if (g_hash_table_size (jobs) == 1) {
+        g_hash_table_iter_init (&iter, jobs);
+        g_hash_table_iter_next (&iter, NULL, &value);
+        trim_job_run (value);
+    } else {
+        g_hash_table_iter_init (&iter, jobs);
+        while (g_hash_table_iter_next (&iter, NULL, &value)) {
+            ((TrimJob *) value)->exec_policy = exec_policy;
+            g_ptr_array_add (threads, g_thread_new ("bd-fs-trim", trim_job_run, value));
+        }
+        for (i = 0; i < threads->len; i++)
+            g_thread_join (g_ptr_array_index (threads, i));
+    }
+
+    g_hash_table_iter_init (&iter, jobs);
+    while (g_hash_table_iter_next (&iter, NULL, &value)) {
+        job = (TrimJob *) value;
+        g_array_free (job->indices, TRUE);
+        g_free (job);
+    }
+    bd_utils_exec_policy_free (exec_policy);
+
+    /* report the first error (in the order of @mountpoints) */
+    for (i = 0; i < n_mountpoints; i++) {
+        if (errors[i]) {
+            if (!failed)
+                g_propagate_error (error, errors[i]);
+            else
+                g_error_free (errors[i]);
+            failed = TRUE;
+        }
+    }
+
+    if (failed) {
+        for (i = 0; i < n_mountpoints; i++)
+            bd_fs_trim_result_free (results[i]);
+        g_free (results);
+        return NULL;
+    }
+
+    return results;
+}
+
+/**
+ * bd_fs_free_space_bucket_copy: (skip)
+ * @data: (nullable): %BDFSFreeSpaceBucket to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDFSFreeSpaceBucket* bd_fs_free_space_bucket_copy (BDFSFreeSpaceBucket *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDFSFreeSpaceBucket *ret = g_new0 (BDFSFreeSpaceBucket, 1);
+
+    ret->min_size = data->min_size;
+    ret->max_size = data->max_size;
+    ret->extents = data->extents;
+    ret->bytes = data->bytes;
+
+    return ret;
+}
+
+/**
+ * bd_fs_free_space_bucket_free: (skip)
+ * @data: (nullable): %BDFSFreeSpaceBucket to free
+ *
+ * Frees @data.
+ */
+void bd_fs_free_space_bucket_free (BDFSFreeSpaceBucket *data) {
+    g_free (data);
+}
+
+/**
+ * bd_fs_space_map_extent_copy: (skip)
+ * @data: (nullable): %BDFSSpaceMapExtent to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDFSSpaceMapExtent* bd_fs_space_map_extent_copy (BDFSSpaceMapExtent *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDFSSpaceMapExtent *ret = g_new0 (BDFSSpaceMapExtent, 1);
+
+    ret->offset = data->offset;
+    ret->length = data->length;
+    ret->metadata = data->metadata;
+
+    return ret;
+}
+
+/**
+ * bd_fs_space_map_extent_free: (skip)
+ * @data: (nullable): %BDFSSpaceMapExtent to free
+ *
+ * Frees @data.
+ */
+void bd_fs_space_map_extent_free (BDFSSpaceMapExtent *data) {
+    g_free (data);
+}
+
+/* number of records asked for with a single GETFSMAP call */
+#define FSMAP_BATCH 1024
+
+typedef void (*FsmapFunc) (const struct fsmap *rec, gpointer user_data);
+
+/* calls @func for all GETFSMAP records of the data device of the filesystem mounted on @mountpoint */
+static gboolean walk_fsmap (const gchar *mountpoint, FsmapFunc func, gpointer user_data, GError **error) {
+    g_autofree struct fsmap_head *head = NULL;
+    struct fsmap *rec = NULL;
+    struct stat st;
+    guint32 fs_dev = 0;
+    gboolean last = FALSE;
+    guint i = 0;
+    gint fd = -1;
+
+    fd = open (mountpoint, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+    if (fd == -1) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to open the mountpoint '%s': %s",
+                     mountpoint, strerror_l (errno, _C_LOCALE));
+        return FALSE;
+    }
+
+    if (fstat (fd, &st) != 0) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to get device of the filesystem mounted on '%s': %s",
+                     mountpoint, strerror_l (errno, _C_LOCALE));
+        close (fd);
+        return FALSE;
+    }
+    /* the kernel's new_encode_dev() format used for fmr_device */
+    fs_dev = (minor (st.st_dev) & 0xff) | (major (st.st_dev) << 8) | ((minor (st.st_dev) & ~0xff) << 12);
+
+    head = g_malloc0 (fsmap_sizeof (FSMAP_BATCH));
+    head->fmh_count = FSMAP_BATCH;
+    head->fmh_keys[1].fmr_device = G_MAXUINT32;
+    head->fmh_keys[1].fmr_flags = G_MAXUINT32;
+    head->fmh_keys[1].fmr_physical = G_MAXUINT64;
+    head->fmh_keys[1].fmr_owner = G_MAXUINT64;
+    head->fmh_keys[1].fmr_offset = G_MAXUINT64;
+
+    while (!last) {
+        if (ioctl (fd, FS_IOC_GETFSMAP, head) != 0) {
+            if (errno == ENOTTY || errno == EOPNOTSUPP)
+                g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_NOT_SUPPORTED,
+                             "Filesystem mounted on '%s' doesn't support getting its space map",
+                             mountpoint);
+            else
+                g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                             "Failed to get space map of the filesystem mounted on '%s': %s",
+                             mountpoint, strerror_l (errno, _C_LOCALE));
+            close (fd);
+            return FALSE;
+        }
+        if (head->fmh_entries == 0)
+            break;
+
+        for (i = 0; i < head->fmh_entries; i++) {
+            rec = &(head->fmh_recs[i]);
+            /* skip external log and realtime devices */
+            if (!(head->fmh_oflags & FMH_OF_DEV_T) || rec->fmr_device == fs_dev)
+                func (rec, user_data);
+        }
+        last = head->fmh_recs[head->fmh_entries - 1].fmr_flags & FMR_OF_LAST;
+        fsmap_advance (head);
+    }
+    close (fd);
+
+    return TRUE;
+}
+
+typedef struct FreeExtentWalk {
+    FreeSpaceHist *hist;
+    guint64 start;
+    guint64 length;
+} FreeExtentWalk;
+
+/* free space is reported per AG so contiguous records need to be merged */
+static void add_free_fsmap_rec (const struct fsmap *rec, gpointer user_data) {
+    FreeExtentWalk *walk = (FreeExtentWalk *) user_data;
+
+    if (!(rec->fmr_flags & FMR_OF_SPECIAL_OWNER) || rec->fmr_owner != FMR_OWN_FREE)
+        return;
+
+    if (walk->length > 0 && walk->start + walk->length == rec->fmr_physical) {
+        walk->length += rec->fmr_length;
+        return;
+    }
+
+    free_space_hist_add (walk->hist, walk->length);
+    walk->start = rec->fmr_physical;
+    walk->length = rec->fmr_length;
+}
+
+/**
+ * bd_fs_get_free_space_histogram:
+ * @device: the device with file system to get the free space histogram for
+ * @fstype: (nullable): the filesystem type on @device or %NULL to detect
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Get sizes of the free extents of the filesystem on @device grouped into buckets
+ * by powers of two (like e2freefrag and xfs_db's freesp command do). For ext2/3/4
+ * the block bitmaps are read directly from @device, an XFS filesystem needs to be
+ * mounted (its free space btrees are read with the GETFSMAP ioctl). This function
+ * will return an error for other filesystems.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): non-empty buckets of free
+ *                                                    extents (smallest first) or
+ *                                                    %NULL in case of error
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_QUERY
+ */
+BDFSFreeSpaceBucket** bd_fs_get_free_space_histogram (const gchar *device, const gchar *fstype, GError **error) {
+    g_autofree gchar* detected_fstype = NULL;
+    g_autofree gchar* mountpoint = NULL;
+    FreeSpaceHist hist;
+    FreeExtentWalk walk = { &hist, 0, 0 };
+    GPtrArray *buckets = NULL;
+    BDFSFreeSpaceBucket *bucket = NULL;
+    GError *l_error = NULL;
+    guint i = 0;
+
+    if (!fstype) {
+        detected_fstype = bd_fs_get_fstype (device, error);
+        if (!detected_fstype) {
+            if (error) {
+                if (*error == NULL) {
+                    g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_NOFS,
+                                "No filesystem detected on the device '%s'", device);
+                    return NULL;
+                } else {
+                    g_prefix_error (error, "Error when trying to detect filesystem on '%s': ", device);
+                    return NULL;
+                }
+            } else
+                return NULL;
+        }
+    } else
+        detected_fstype = g_strdup (fstype);
+
+    memset (&hist, 0, sizeof (hist));
+
+    if (g_strcmp0 (detected_fstype, "ext2") == 0 || g_strcmp0 (detected_fstype, "ext3") == 0
+                                                 || g_strcmp0 (detected_fstype, "ext4") == 0) {
+        if (!ext_get_free_space_hist (device, &hist, error))
+            return NULL;
+    } else if (g_strcmp0 (detected_fstype, "xfs") == 0) {
+        mountpoint = bd_fs_get_mountpoint (device, &l_error);
+        if (!mountpoint) {
+            if (l_error)
+                g_propagate_error (error, l_error);
+            else
+                g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_NOT_MOUNTED,
+                             "XFS filesystem on '%s' needs to be mounted to get its free space histogram",
+                             device);
+            return NULL;
+        }
+        if (!walk_fsmap (mountpoint, add_free_fsmap_rec, &walk, error))
+            return NULL;
+        free_space_hist_add (&hist, walk.length);
+    } else {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_NOT_SUPPORTED,
+                     "Getting free space histogram of filesystem '%s' is not supported.", detected_fstype);
+        return NULL;
+    }
+
+    buckets = g_ptr_array_new ();
+    for (i = 0; i < 64; i++) {
+        if (hist.extents[i] == 0)
+            continue;
+        bucket = g_new0 (BDFSFreeSpaceBucket, 1);
+        bucket->min_size = G_GUINT64_CONSTANT (1) << i;
+        bucket->max_size = i < 63 ? G_GUINT64_CONSTANT (1) << (i + 1) : G_MAXUINT64;
+        bucket->extents = hist.extents[i];
+        bucket->bytes = hist.bytes[i];
+        g_ptr_array_add (buckets, bucket);
+    }
+    g_ptr_array_add (buckets, NULL);
+
+    return (BDFSFreeSpaceBucket **) g_ptr_array_free (buckets, FALSE);
+}
+
+/* merges contiguous used records of the same kind */
+static void add_used_fsmap_rec (const struct fsmap *rec, gpointer user_data) {
+    GPtrArray *extents = (GPtrArray *) user_data;
+    BDFSSpaceMapExtent *extent = NULL;
+    gboolean metadata = FALSE;
+    guint64 end = 0;
+
+    if ((rec->fmr_flags & FMR_OF_SPECIAL_OWNER) && rec->fmr_owner == FMR_OWN_FREE)
+        return;
+
+    /* everything not owned by an inode is metadata, unless the owner is unknown
+       (XFS without the reverse mapping btree) */
+    metadata = (rec->fmr_flags & FMR_OF_SPECIAL_OWNER) && rec->fmr_owner != FMR_OWN_UNKNOWN;
+    if (extents->len > 0) {
+        extent = g_ptr_array_index (extents, extents->len - 1);
+        /* contiguous or overlapping, shared (reflinked) extents are reported once
+           for every owner */
+        if (extent->metadata == metadata && rec->fmr_physical <= extent->offset + extent->length) {
+            end = MAX (extent->offset + extent->length, rec->fmr_physical + rec->fmr_length);
+            extent->length = end - extent->offset;
+            return;
+        }
+    }
+
+    extent = g_new0 (BDFSSpaceMapExtent, 1);
+    extent->offset = rec->fmr_physical;
+    extent->length = rec->fmr_length;
+    extent->metadata = metadata;
+    g_ptr_array_add (extents, extent);
+}
+
+/**
+ * bd_fs_get_space_map:
+ * @mountpoint: mountpoint of the filesystem to get the space map for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Get byte ranges of the filesystem's (data) device that are in use. Uses the
+ * GETFSMAP ioctl so the filesystem needs to support it (ext4 and XFS do).
+ * Adjacent ranges of the same kind are merged.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): used extents of the filesystem
+ *                                                    mounted on @mountpoint (sorted
+ *                                                    by offset) or %NULL in case of
+ *                                                    error
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_QUERY
+ */
+BDFSSpaceMapExtent** bd_fs_get_space_map (const gchar *mountpoint, GError **error) {
+    GPtrArray *extents = NULL;
+
+    extents = g_ptr_array_new_with_free_func ((GDestroyNotify) bd_fs_space_map_extent_free);
+    if (!walk_fsmap (mountpoint, add_used_fsmap_rec, extents, error)) {
+        g_ptr_array_free (extents, TRUE);
+        return NULL;
+    }
+    g_ptr_array_set_free_func (extents, NULL);
+    g_ptr_array_add (extents, NULL);
+
+    return (BDFSSpaceMapExtent **) g_ptr_array_free (extents, FALSE);
+}
+
 extern BDExtraArg** bd_fs_exfat_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
 extern BDExtraArg** bd_fs_ext2_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
 extern BDExtraArg** bd_fs_ext3_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
@@ -1939,6 +2812,13 @@ extern BDExtraArg** bd_fs_udf_mkfs_options (BDFSMkfsOptions *options, const BDEx
  * specified using @options. Extra options are added after the @options and
  * there are no additional checks for duplicate and/or conflicting options.
  *
+ * If @options has the @topology field set, the stripe geometry is derived from
+ * the topology of @device (MD chunk size and number of data disks, I/O hints of
+ * LVM striped and RAID LVs and other devices) and translated into the @fstype
+ * specific options (e.g. stride/stripe_width for ext4, su/sw for XFS or segments
+ * per section for F2FS). The @stripe_unit and @stripe_width fields of @options
+ * are updated to reflect the geometry actually applied (zero if none).
+ *
  * Returns: whether @fstype was successfully created on @device or not.
  *
  * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_MKFS
@@ -1947,6 +2827,18 @@ extern BDExtraArg** bd_fs_udf_mkfs_options (BDFSMkfsOptions *options, const BDEx
 gboolean bd_fs_mkfs (const gchar *device, const gchar *fstype, BDFSMkfsOptions *options, const BDExtraArg **extra, GError **error) {
     BDExtraArg **extra_args = NULL;
     gboolean ret = FALSE;
+    BDFSTech tech = fstype_to_tech (fstype);
+
+    if (fs_features[tech].mkfs & BD_FS_MKFS_GEOMETRY) {
+        if (options->topology && !get_stripe_geometry (device, &(options->stripe_unit), &(options->stripe_width), error)) {
+            g_prefix_error (error, "Failed to get stripe geometry for '%s': ", device);
+            return FALSE;
+        }
+    } else {
+        /* stripe geometry not supported for this filesystem */
+        options->stripe_unit = 0;
+        options->stripe_width = 0;
+    }
 
     if (g_strcmp0 (fstype, "exfat") == 0) {
         extra_args = bd_fs_exfat_mkfs_options (options, extra);
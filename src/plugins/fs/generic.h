@@ -10,6 +10,52 @@ gchar* bd_fs_get_fstype (const gchar *device,  GError **error);
 gboolean bd_fs_freeze (const gchar *mountpoint, GError **error);
 gboolean bd_fs_unfreeze (const gchar *mountpoint, GError **error);
 
+typedef struct BDFSTrimOptions {
+    guint64 min_extent;
+    guint64 chunk_size;
+    guint64 max_bandwidth;
+    guint64 max_iops;
+} BDFSTrimOptions;
+
+BDFSTrimOptions* bd_fs_trim_options_copy (BDFSTrimOptions *data);
+void bd_fs_trim_options_free (BDFSTrimOptions *data);
+
+typedef struct BDFSTrimResult {
+    gchar *mountpoint;
+    guint64 trimmed;
+    gchar *thin_pool;
+    guint64 pool_used_before;
+    guint64 pool_used_after;
+} BDFSTrimResult;
+
+BDFSTrimResult* bd_fs_trim_result_copy (BDFSTrimResult *data);
+void bd_fs_trim_result_free (BDFSTrimResult *data);
+
+BDFSTrimResult* bd_fs_trim (const gchar *mountpoint, BDFSTrimOptions *options, GError **error);
+BDFSTrimResult** bd_fs_trim_many (const gchar **mountpoints, BDFSTrimOptions *options, GError **error);
+
+typedef struct BDFSFreeSpaceBucket {
+    guint64 min_size;
+    guint64 max_size;
+    guint64 extents;
+    guint64 bytes;
+} BDFSFreeSpaceBucket;
+
+BDFSFreeSpaceBucket* bd_fs_free_space_bucket_copy (BDFSFreeSpaceBucket *data);
+void bd_fs_free_space_bucket_free (BDFSFreeSpaceBucket *data);
+
+typedef struct BDFSSpaceMapExtent {
+    guint64 offset;
+    guint64 length;
+    gboolean metadata;
+} BDFSSpaceMapExtent;
+
+BDFSSpaceMapExtent* bd_fs_space_map_extent_copy (BDFSSpaceMapExtent *data);
+void bd_fs_space_map_extent_free (BDFSSpaceMapExtent *data);
+
+BDFSFreeSpaceBucket** bd_fs_get_free_space_histogram (const gchar *device, const gchar *fstype, GError **error);
+BDFSSpaceMapExtent** bd_fs_get_space_map (const gchar *mountpoint, GError **error);
+
 typedef enum {
     BD_FS_MKFS_LABEL     = 1 << 0,
     BD_FS_MKFS_UUID      = 1 << 1,
@@ -17,8 +63,17 @@ typedef enum {
     BD_FS_MKFS_NODISCARD = 1 << 3,
     BD_FS_MKFS_FORCE     = 1 << 4,
     BD_FS_MKFS_NOPT      = 1 << 5,
+    BD_FS_MKFS_GEOMETRY  = 1 << 6,
+    BD_FS_MKFS_LAZY_INIT = 1 << 7,
+    BD_FS_MKFS_JOURNAL   = 1 << 8,
 } BDFSMkfsOptionsFlags;
 
+typedef enum {
+    BD_FS_MKFS_LAZY_INIT_DEFAULT = 0,
+    BD_FS_MKFS_LAZY_INIT_ENABLE,
+    BD_FS_MKFS_LAZY_INIT_DISABLE,
+} BDFSMkfsLazyInit;
+
 typedef struct BDFSMkfsOptions {
     const gchar *label;
     const gchar *uuid;
@@ -26,7 +81,13 @@ typedef struct BDFSMkfsOptions {
     gboolean no_discard;
     gboolean force;
     gboolean no_pt;
-    guint8 reserve[32];
+    gboolean topology;
+    BDFSMkfsLazyInit lazy_itable_init;
+    BDFSMkfsLazyInit lazy_journal_init;
+    guint32 journal_size;
+    const gchar *journal_device;
+    guint32 stripe_unit;
+    guint32 stripe_width;
 } BDFSMkfsOptions;
 
 BDFSMkfsOptions* bd_fs_mkfs_options_copy (BDFSMkfsOptions *data);
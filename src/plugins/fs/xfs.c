@@ -21,11 +21,52 @@
 #include <check_deps.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/types.h>
 
 #include "xfs.h"
 #include "fs.h"
 #include "common.h"
 
+/* the XFS ioctl ABI from xfs/xfs_fs.h (xfsprogs-devel, not a build dependency) */
+struct bd_xfs_fsop_geom_v1 {
+    __u32 blocksize;
+    __u32 rtextsize;
+    __u32 agblocks;
+    __u32 agcount;
+    __u32 logblocks;
+    __u32 sectsize;
+    __u32 inodesize;
+    __u32 imaxpct;
+    __u64 datablocks;
+    __u64 rtblocks;
+    __u64 rtextents;
+    __u64 logstart;
+    unsigned char uuid[16];
+    __u32 sunit;
+    __u32 swidth;
+    __s32 version;
+    __u32 flags;
+    __u32 logsectsize;
+    __u32 rtsectsize;
+    __u32 dirblocksize;
+};
+
+struct bd_xfs_growfs_data {
+    __u64 newblocks;
+    __u32 imaxpct;
+};
+
+#define BD_XFS_IOC_FSGEOMETRY_V1 _IOR ('X', 100, struct bd_xfs_fsop_geom_v1)
+#define BD_XFS_IOC_FSGROWFSDATA _IOW ('X', 110, struct bd_xfs_growfs_data)
+
+/* the kernel drops the last AG if it would be smaller than this */
+#define BD_XFS_MIN_AG_BLOCKS 64
+
 static volatile guint avail_deps = 0;
 static GMutex deps_check_lock;
 
@@ -126,6 +167,8 @@ bd_fs_xfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra) {
     GPtrArray *options_array = g_ptr_array_new ();
     const BDExtraArg **extra_p = NULL;
     gchar *uuid_option = NULL;
+    gchar *data_option = NULL;
+    gchar *log_option = NULL;
 
     if (options->label && g_strcmp0 (options->label, "") != 0)
         g_ptr_array_add (options_array, bd_extra_arg_new ("-L", options->label));
@@ -145,6 +188,30 @@ bd_fs_xfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra) {
     if (options->force)
         g_ptr_array_add (options_array, bd_extra_arg_new ("-f", ""));
 
+    if (options->stripe_unit > 0 && options->stripe_width > 0) {
+        data_option = g_strdup_printf ("su=%"G_GUINT32_FORMAT",sw=%"G_GUINT32_FORMAT,
+                                       options->stripe_unit, options->stripe_width);
+        g_ptr_array_add (options_array, bd_extra_arg_new ("-d", data_option));
+        g_free (data_option);
+    } else {
+        options->stripe_unit = 0;
+        options->stripe_width = 0;
+    }
+
+    if (options->journal_device && g_strcmp0 (options->journal_device, "") != 0) {
+        if (options->journal_size > 0)
+            log_option = g_strdup_printf ("logdev=%s,size=%"G_GUINT32_FORMAT"m",
+                                          options->journal_device, options->journal_size);
+        else
+            log_option = g_strdup_printf ("logdev=%s", options->journal_device);
+    } else if (options->journal_size > 0)
+        log_option = g_strdup_printf ("size=%"G_GUINT32_FORMAT"m", options->journal_size);
+
+    if (log_option) {
+        g_ptr_array_add (options_array, bd_extra_arg_new ("-l", log_option));
+        g_free (log_option);
+    }
+
     if (extra) {
         for (extra_p = extra; *extra_p; extra_p++)
             g_ptr_array_add (options_array, bd_extra_arg_copy ((BDExtraArg *) *extra_p));
@@ -428,6 +495,72 @@ BDFSXfsInfo* bd_fs_xfs_get_info (const gchar *device, GError **error) {
     return ret;
 }
 
+/* grows the file system mounted on @mpoint in-process (what xfs_growfs does),
+   @done is set to FALSE if xfs_growfs needs to be used instead (shrinking,
+   unsupported,...) */
+static gboolean xfs_online_grow (const gchar *mpoint, guint64 new_size, gboolean *done, GError **error) {
+    struct bd_xfs_fsop_geom_v1 geo;
+    struct bd_xfs_growfs_data grow;
+    struct stat st;
+    guint64 dev_size = 0;
+    guint64 last_ag = 0;
+    gint fd = -1;
+
+    *done = FALSE;
+
+    fd = open (mpoint, O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+    if (fd == -1)
+        return TRUE;
+
+    memset (&geo, 0, sizeof (geo));
+    if (ioctl (fd, BD_XFS_IOC_FSGEOMETRY_V1, &geo) != 0 || geo.blocksize == 0 || geo.agblocks == 0) {
+        close (fd);
+        return TRUE;
+    }
+
+    if (new_size == 0) {
+        /* the data device is the one the mountpoint is on */
+        if (fstat (fd, &st) != 0 || !get_blockdev_size (st.st_dev, &dev_size, NULL)) {
+            close (fd);
+            return TRUE;
+        }
+        new_size = dev_size / geo.blocksize;
+    }
+
+    /* same rounding as done by the kernel so that growing to the current size
+       with a too small last AG is a no-op (like with xfs_growfs) */
+    last_ag = new_size % geo.agblocks;
+    if (last_ag != 0 && last_ag < BD_XFS_MIN_AG_BLOCKS)
+        new_size -= last_ag;
+
+    if (new_size < geo.datablocks) {
+        close (fd);
+        return TRUE;
+    }
+
+    if (new_size > geo.datablocks) {
+        grow.newblocks = new_size;
+        grow.imaxpct = geo.imaxpct;
+        if (ioctl (fd, BD_XFS_IOC_FSGROWFSDATA, &grow) != 0) {
+            if (errno == ENOTTY || errno == EOPNOTSUPP || errno == EINVAL) {
+                bd_utils_log_format (BD_UTILS_LOG_INFO, "Online resize of '%s' not possible in-process: %s",
+                                     mpoint, strerror_l (errno, _C_LOCALE));
+                close (fd);
+                return TRUE;
+            }
+            g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                         "Failed to grow the file system mounted on '%s': %s",
+                         mpoint, strerror_l (errno, _C_LOCALE));
+            close (fd);
+            return FALSE;
+        }
+    }
+    close (fd);
+
+    *done = TRUE;
+    return TRUE;
+}
+
 /**
  * bd_fs_xfs_resize:
  * @mpoint: the mount point of the file system to resize
@@ -437,6 +570,9 @@ BDFSXfsInfo* bd_fs_xfs_get_info (const gchar *device, GError **error) {
  *                                                 passed to the 'xfs_growfs' utility)
  * @error: (out) (optional): place to store error (if any)
  *
+ * Growing the data section is done directly with the XFS_IOC_FSGROWFSDATA ioctl
+ * (unless @extra is given), 'xfs_growfs' is used in all the other cases.
+ *
  * Returns: whether the file system mounted on @mpoint was successfully resized or not
  *
  * Tech category: %BD_FS_TECH_XFS-%BD_FS_TECH_MODE_RESIZE
@@ -445,6 +581,15 @@ gboolean bd_fs_xfs_resize (const gchar *mpoint, guint64 new_size, const BDExtraA
     const gchar *args[5] = {"xfs_growfs", NULL, NULL, NULL, NULL};
     gchar *size_str = NULL;
     gboolean ret = FALSE;
+    gboolean done = FALSE;
+
+    /* extra options are for xfs_growfs, use it if some are given */
+    if (!extra) {
+        if (!xfs_online_grow (mpoint, new_size, &done, error))
+            return FALSE;
+        if (done)
+            return TRUE;
+    }
 
     if (!check_deps (&avail_deps, DEPS_XFS_GROWFS_MASK, deps, DEPS_LAST, &deps_check_lock, error))
         return FALSE;
@@ -29,6 +29,9 @@
 #include "check_deps.h"
 #include "dm_logging.h"
 #include "vdo_stats.h"
+#include "lvm_topology.h"
+#include "lvm_cache.h"
+#include "lvm_thin.h"
 
 #define INT_FLOAT_EPS 1e-5
 #define SECTOR_SIZE 512
@@ -251,6 +254,68 @@ void bd_lvm_cache_stats_free (BDLVMCacheStats *data) {
     g_free (data);
 }
 
+BDLVMCacheSettings* bd_lvm_cache_settings_copy (BDLVMCacheSettings *settings) {
+    if (settings == NULL)
+        return NULL;
+
+    BDLVMCacheSettings *new = g_new0 (BDLVMCacheSettings, 1);
+
+    new->policy = g_strdup (settings->policy);
+    new->migration_threshold = settings->migration_threshold;
+    new->chunk_size = settings->chunk_size;
+
+    return new;
+}
+
+void bd_lvm_cache_settings_free (BDLVMCacheSettings *settings) {
+    if (settings == NULL)
+        return;
+
+    g_free (settings->policy);
+    g_free (settings);
+}
+
+BDLVMCacheSettings* bd_lvm_cache_settings_new (void) {
+    BDLVMCacheSettings *ret = g_new0 (BDLVMCacheSettings, 1);
+
+    ret->migration_threshold = -1;
+
+    return ret;
+}
+
+BDLVMWritecacheSettings* bd_lvm_writecache_settings_copy (BDLVMWritecacheSettings *settings) {
+    if (settings == NULL)
+        return NULL;
+
+    BDLVMWritecacheSettings *new = g_new0 (BDLVMWritecacheSettings, 1);
+
+    new->high_watermark = settings->high_watermark;
+    new->low_watermark = settings->low_watermark;
+    new->writeback_jobs = settings->writeback_jobs;
+    new->autocommit_blocks = settings->autocommit_blocks;
+    new->autocommit_time = settings->autocommit_time;
+    new->pause_writeback = settings->pause_writeback;
+
+    return new;
+}
+
+void bd_lvm_writecache_settings_free (BDLVMWritecacheSettings *settings) {
+    g_free (settings);
+}
+
+BDLVMWritecacheSettings* bd_lvm_writecache_settings_new (void) {
+    BDLVMWritecacheSettings *ret = g_new0 (BDLVMWritecacheSettings, 1);
+
+    ret->high_watermark = -1;
+    ret->low_watermark = -1;
+    ret->writeback_jobs = -1;
+    ret->autocommit_blocks = -1;
+    ret->autocommit_time = -1;
+    ret->pause_writeback = -1;
+
+    return ret;
+}
+
 static gboolean setup_dbus_connection (GError **error) {
     gchar *addr = NULL;
 
@@ -293,11 +358,17 @@ static GMutex deps_check_lock;
 #define DEPS_LVM_MASK (1 << DEPS_LVM)
 #define DEPS_LVMDEVICES 1
 #define DEPS_LVMDEVICES_MASK (1 << DEPS_LVMDEVICES)
-#define DEPS_LAST 2
+#define DEPS_THINLS 2
+#define DEPS_THINLS_MASK (1 << DEPS_THINLS)
+#define DEPS_THINDELTA 3
+#define DEPS_THINDELTA_MASK (1 << DEPS_THINDELTA)
+#define DEPS_LAST 4
 
 static const UtilDep deps[DEPS_LAST] = {
     {"lvm", LVM_MIN_VERSION, "version", "LVM version:\\s+([\\d\\.]+)"},
     {"lvmdevices", NULL, NULL, NULL},
+    {"thin_ls", NULL, NULL, NULL},
+    {"thin_delta", NULL, NULL, NULL},
 };
 
 #define DBUS_DEPS_LVMDBUSD 0
@@ -576,6 +647,111 @@ static gboolean unbox_params_and_add (GVariant *params, GVariantBuilder *builder
     return FALSE;
 }
 
+/* LVM config and devices filter effective for the current thread -- the ones set
+   on the thread's context (if any) take precedence over the global ones */
+static void get_lvm_config (gchar **config, gchar **devices) {
+    BDContext *ctx = bd_context_get_thread ();
+    gchar **ctx_devices = NULL;
+    gboolean config_set = FALSE;
+    gboolean devices_set = FALSE;
+
+    *config = NULL;
+    *devices = NULL;
+
+    if (ctx) {
+        config_set = bd_context_get_lvm_config (ctx, config);
+        devices_set = bd_context_get_lvm_devices (ctx, &ctx_devices);
+        if (ctx_devices) {
+            *devices = g_strjoinv (",", ctx_devices);
+            g_strfreev (ctx_devices);
+        }
+    }
+
+    if (!config_set || !devices_set) {
+        g_mutex_lock (&global_config_lock);
+        if (!config_set)
+            *config = g_strdup (global_config_str);
+        if (!devices_set)
+            *devices = g_strdup (global_devices_str);
+        g_mutex_unlock (&global_config_lock);
+    }
+}
+
+/**
+ * build_lvm_argv:
+ * @args: arguments for lvm (without "lvm")
+ * @extra_config: (nullable): additional config to append to the effective config
+ * @config_arg: (out): place to store the "--config" argument (needs to be freed)
+ * @devices_arg: (out): place to store the "--devices" argument (needs to be freed)
+ *
+ * Returns: (transfer container): argv for running lvm with @args
+ */
+static const gchar** build_lvm_argv (const gchar **args, const gchar *extra_config, gchar **config_arg, gchar **devices_arg) {
+    guint i = 0;
+    guint args_length = g_strv_length ((gchar **) args);
+    g_autofree gchar *config = NULL;
+    g_autofree gchar *devices = NULL;
+
+    get_lvm_config (&config, &devices);
+
+    /* allocate enough space for the args plus "lvm", "--config", "--devices" and NULL */
+    const gchar **argv = g_new0 (const gchar*, args_length + 4);
+
+    argv[0] = "lvm";
+    for (i=0; i < args_length; i++)
+        argv[i+1] = args[i];
+    if (config || extra_config) {
+        *config_arg = g_strdup_printf ("--config=%s%s%s", config ? config : "",
+                                       (config && extra_config) ? " " : "",
+                                       extra_config ? extra_config : "");
+        argv[++args_length] = *config_arg;
+    }
+    if (devices) {
+        *devices_arg = g_strdup_printf ("--devices=%s", devices);
+        argv[++args_length] = *devices_arg;
+    }
+
+    return argv;
+}
+
+/**
+ * call_lvm_and_report_error:
+ *
+ * Runs the LVM command @args directly (with the global/context config applied) for
+ * the few operations lvmdbusd has no method for.
+ */
+static gboolean call_lvm_and_report_error (const gchar **args, const BDExtraArg **extra, const gchar *extra_config, GError **error) {
+    g_autofree gchar *config_arg = NULL;
+    g_autofree gchar *devices_arg = NULL;
+    g_autofree const gchar **argv = NULL;
+
+    if (!check_deps (&avail_deps, DEPS_LVM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return FALSE;
+
+    argv = build_lvm_argv (args, extra_config, &config_arg, &devices_arg);
+
+    return bd_utils_exec_and_report_error (argv, extra, error);
+}
+
+/**
+ * call_lvm_and_capture_output:
+ *
+ * Same as call_lvm_and_report_error(), but captures the output of the command
+ * (for the few reports lvmdbusd provides no property for).
+ */
+static gboolean call_lvm_and_capture_output (const gchar **args, const BDExtraArg **extra, gchar **output, GError **error) {
+    g_autofree gchar *config_arg = NULL;
+    g_autofree gchar *devices_arg = NULL;
+    g_autofree const gchar **argv = NULL;
+
+    if (!check_deps (&avail_deps, DEPS_LVM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return FALSE;
+
+    argv = build_lvm_argv (args, NULL, &config_arg, &devices_arg);
+
+    return bd_utils_exec_and_capture_output (argv, extra, output, error);
+}
+
 /**
  * call_lvm_method
  * @obj: lvmdbusd object path
@@ -586,13 +762,12 @@ static gboolean unbox_params_and_add (GVariant *params, GVariantBuilder *builder
  * @extra_args: extra command line argument to be passed to the LVM command
  * @task_id: (out): task ID to watch progress of the operation
  * @progress_id: (out): progress ID to watch progress of the operation
- * @lock_config: whether to lock %global_config_lock or not (if %FALSE is given, caller is responsible
- *               for holding the lock for this call)
+ * @extra_config: (nullable): additional LVM config to append to the effective config
  * @error: (out) (optional): place to store error (if any)
  *
  * Returns: (transfer full): return value of @method (variant)
  */
-static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, guint64 *task_id, guint64 *progress_id, gboolean lock_config, GError **error) {
+static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, guint64 *task_id, guint64 *progress_id, const gchar *extra_config, GError **error) {
     GVariant *config = NULL;
     GVariant *devices = NULL;
     GVariant *param = NULL;
@@ -608,17 +783,23 @@ static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gch
     gchar *prog_msg = NULL;
     const BDExtraArg **extra_p = NULL;
     gboolean added_extra = FALSE;
+    gchar *lvm_config = NULL;
+    gchar *lvm_devices = NULL;
+    gchar *tmp = NULL;
 
     if (!check_dbus_deps (&avail_dbus_deps, DBUS_DEPS_LVMDBUSD_MASK, dbus_deps, DBUS_DEPS_LAST, &deps_check_lock, error))
         return NULL;
 
-    /* don't allow global config string changes during the run */
-    if (lock_config)
-        g_mutex_lock (&global_config_lock);
+    get_lvm_config (&lvm_config, &lvm_devices);
+    if (extra_config) {
+        tmp = lvm_config;
+        lvm_config = g_strdup_printf ("%s%s%s", tmp ? tmp : "", tmp ? " " : "", extra_config);
+        g_free (tmp);
+    }
 
-    if (global_config_str || global_devices_str || extra_params || extra_args) {
-        if (global_config_str || global_devices_str || extra_args) {
-            /* add the global config to the extra_params */
+    if (lvm_config || lvm_devices || extra_params || extra_args) {
+        if (lvm_config || lvm_devices || extra_args) {
+            /* add the config to the extra_params */
             g_variant_builder_init (&extra_builder, G_VARIANT_TYPE_DICTIONARY);
 
             if (extra_params)
@@ -633,13 +814,13 @@ static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gch
                     added_extra = TRUE;
                 }
             }
-            if (global_config_str) {
-                config = g_variant_new ("s", global_config_str);
+            if (lvm_config) {
+                config = g_variant_new ("s", lvm_config);
                 g_variant_builder_add (&extra_builder, "{sv}", "--config", config);
                 added_extra = TRUE;
             }
-            if (global_devices_str) {
-                devices = g_variant_new ("s", global_devices_str);
+            if (lvm_devices) {
+                devices = g_variant_new ("s", lvm_devices);
                 g_variant_builder_add (&extra_builder, "{sv}", "--devices", devices);
                 added_extra = TRUE;
             }
@@ -690,9 +871,9 @@ static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gch
     /* now do the call with all the parameters */
     ret = g_dbus_connection_call_sync (bus, LVM_BUS_NAME, obj, intf, method, all_params,
                                        NULL, G_DBUS_CALL_FLAGS_NONE, METHOD_CALL_TIMEOUT, NULL, error);
+    g_free (lvm_config);
+    g_free (lvm_devices);
 
-    if (lock_config)
-         g_mutex_unlock (&global_config_lock);
     prog_msg = g_strdup_printf ("Started the '%s.%s' method on the '%s' object with the following parameters: '%s'",
                                intf, method, obj, params_str);
     g_free (params_str);
@@ -715,13 +896,12 @@ static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gch
  * @params: parameters for @method
  * @extra_params: extra parameters for @method
  * @extra_args: extra command line argument to be passed to the LVM command
- * @lock_config: whether to lock %global_config_lock or not (if %FALSE is given, caller is responsible
- *               for holding the lock for this call)
+ * @extra_config: (nullable): additional LVM config to append to the effective config
  * @error: (out) (optional): place to store error (if any)
  *
  * Returns: whether calling the method was successful or not
  */
-static gboolean call_lvm_method_sync (const gchar *obj, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, gboolean lock_config, GError **error) {
+static gboolean call_lvm_method_sync (const gchar *obj, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, const gchar *extra_config, GError **error) {
     GVariant *ret = NULL;
     gchar *obj_path = NULL;
     gchar *task_path = NULL;
@@ -734,7 +914,7 @@ static gboolean call_lvm_method_sync (const gchar *obj, const gchar *intf, const
     gchar *error_msg = NULL;
     GError *l_error = NULL;
 
-    ret = call_lvm_method (obj, intf, method, params, extra_params, extra_args, &log_task_id, &prog_id, lock_config, &l_error);
+    ret = call_lvm_method (obj, intf, method, params, extra_params, extra_args, &log_task_id, &prog_id, extra_config, &l_error);
     bd_utils_log_task_status (log_task_id, "Done.");
     if (!ret) {
         if (l_error) {
@@ -899,30 +1079,30 @@ static gboolean call_lvm_method_sync (const gchar *obj, const gchar *intf, const
     return TRUE;
 }
 
-static gboolean call_lvm_obj_method_sync (const gchar *obj_id, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, gboolean lock_config, GError **error) {
+static gboolean call_lvm_obj_method_sync (const gchar *obj_id, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, const gchar *extra_config, GError **error) {
     g_autofree gchar *obj_path = get_object_path (obj_id, error);
     if (!obj_path)
         return FALSE;
 
-    return call_lvm_method_sync (obj_path, intf, method, params, extra_params, extra_args, lock_config, error);
+    return call_lvm_method_sync (obj_path, intf, method, params, extra_params, extra_args, extra_config, error);
 }
 
-static gboolean call_lv_method_sync (const gchar *vg_name, const gchar *lv_name, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, gboolean lock_config, GError **error) {
+static gboolean call_lv_method_sync (const gchar *vg_name, const gchar *lv_name, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, const gchar *extra_config, GError **error) {
     g_autofree gchar *obj_id = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    return call_lvm_obj_method_sync (obj_id, LV_INTF, method, params, extra_params, extra_args, lock_config, error);
+    return call_lvm_obj_method_sync (obj_id, LV_INTF, method, params, extra_params, extra_args, extra_config, error);
 }
 
-static gboolean call_thpool_method_sync (const gchar *vg_name, const gchar *pool_name, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, gboolean lock_config, GError **error) {
+static gboolean call_thpool_method_sync (const gchar *vg_name, const gchar *pool_name, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, const gchar *extra_config, GError **error) {
     g_autofree gchar *obj_id = g_strdup_printf ("%s/%s", vg_name, pool_name);
 
-    return call_lvm_obj_method_sync (obj_id, THPOOL_INTF, method, params, extra_params, extra_args, lock_config, error);
+    return call_lvm_obj_method_sync (obj_id, THPOOL_INTF, method, params, extra_params, extra_args, extra_config, error);
 }
 
-static gboolean call_vdopool_method_sync (const gchar *vg_name, const gchar *pool_name, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, gboolean lock_config, GError **error) {
+static gboolean call_vdopool_method_sync (const gchar *vg_name, const gchar *pool_name, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, const gchar *extra_config, GError **error) {
     g_autofree gchar *obj_id = g_strdup_printf ("%s/%s", vg_name, pool_name);
 
-    return call_lvm_obj_method_sync (obj_id, VDO_POOL_INTF, method, params, extra_params, extra_args, lock_config, error);
+    return call_lvm_obj_method_sync (obj_id, VDO_POOL_INTF, method, params, extra_params, extra_args, extra_config, error);
 }
 
 static GVariant* get_lv_property (const gchar *vg_name, const gchar *lv_name, const gchar *property, GError **error) {
@@ -1758,7 +1938,7 @@ gboolean bd_lvm_pvcreate (const gchar *device, guint64 data_alignment, guint64 m
 
     params = g_variant_new ("(s)", device);
 
-    return call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "PvCreate", params, extra_params, extra, TRUE, error);
+    return call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "PvCreate", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -1784,7 +1964,7 @@ gboolean bd_lvm_pvresize (const gchar *device, guint64 size, const BDExtraArg **
         return FALSE;
 
     params = g_variant_new ("(t)", size);
-    return call_lvm_method_sync (obj_path, PV_INTF, "ReSize", params, NULL, extra, TRUE, error);
+    return call_lvm_method_sync (obj_path, PV_INTF, "ReSize", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -1818,7 +1998,7 @@ gboolean bd_lvm_pvremove (const gchar *device, const BDExtraArg **extra, GError
 
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
-    ret = call_lvm_obj_method_sync (device, PV_INTF, "Remove", NULL, params, extra, TRUE, &l_error);
+    ret = call_lvm_obj_method_sync (device, PV_INTF, "Remove", NULL, params, extra, NULL, &l_error);
     if (!ret && l_error && g_error_matches (l_error, BD_LVM_ERROR, BD_LVM_ERROR_NOEXIST)) {
         /* if the object doesn't exist, the given device is not a PV and thus
            this function should be a noop */
@@ -1899,7 +2079,7 @@ gboolean bd_lvm_pvmove (const gchar *src, const gchar *dest, const BDExtraArg **
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    ret = call_lvm_method_sync (vg_obj_path, VG_INTF, "Move", params, NULL, extra, TRUE, error);
+    ret = call_lvm_method_sync (vg_obj_path, VG_INTF, "Move", params, NULL, extra, NULL, error);
 
     g_free (src_path);
     g_free (dest_path);
@@ -1948,7 +2128,7 @@ gboolean bd_lvm_pvscan (const gchar *device, gboolean update_cache, const BDExtr
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "PvScan", params, NULL, extra, TRUE, error);
+    return call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "PvScan", params, NULL, extra, NULL, error);
 }
 
 
@@ -1977,7 +2157,7 @@ static gboolean _manage_lvm_tags (const gchar *objpath, const gchar *pv_path, co
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    ret = call_lvm_method_sync (objpath, intf, func, params, NULL, NULL, TRUE, error);
+    ret = call_lvm_method_sync (objpath, intf, func, params, NULL, NULL, NULL, error);
     g_free (tags_array);
     return ret;
 }
@@ -2184,7 +2364,7 @@ gboolean bd_lvm_vgcreate (const gchar *name, const gchar **pv_list, guint64 pe_s
     extra_params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "VgCreate", params, extra_params, extra, TRUE, error);
+    return call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "VgCreate", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -2199,7 +2379,7 @@ gboolean bd_lvm_vgcreate (const gchar *name, const gchar **pv_list, guint64 pe_s
  * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_REMOVE
  */
 gboolean bd_lvm_vgremove (const gchar *vg_name, const BDExtraArg **extra, GError **error) {
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Remove", NULL, NULL, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Remove", NULL, NULL, extra, NULL, error);
 }
 
 /**
@@ -2216,7 +2396,7 @@ gboolean bd_lvm_vgremove (const gchar *vg_name, const BDExtraArg **extra, GError
  */
 gboolean bd_lvm_vgrename (const gchar *old_vg_name, const gchar *new_vg_name, const BDExtraArg **extra, GError **error) {
     GVariant *params = g_variant_new ("(s)", new_vg_name);
-    return call_lvm_obj_method_sync (old_vg_name, VG_INTF, "Rename", params, NULL, extra, TRUE, error);
+    return call_lvm_obj_method_sync (old_vg_name, VG_INTF, "Rename", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2232,7 +2412,7 @@ gboolean bd_lvm_vgrename (const gchar *old_vg_name, const gchar *new_vg_name, co
  */
 gboolean bd_lvm_vgactivate (const gchar *vg_name, const BDExtraArg **extra, GError **error) {
     GVariant *params = g_variant_new ("(t)", (guint64) 0);
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Activate", params, NULL, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Activate", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2248,7 +2428,7 @@ gboolean bd_lvm_vgactivate (const gchar *vg_name, const BDExtraArg **extra, GErr
  */
 gboolean bd_lvm_vgdeactivate (const gchar *vg_name, const BDExtraArg **extra, GError **error) {
     GVariant *params = g_variant_new ("(t)", (guint64) 0);
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Deactivate", params, NULL, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Deactivate", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2276,7 +2456,7 @@ gboolean bd_lvm_vgextend (const gchar *vg_name, const gchar *device, const BDExt
     pv_var = g_variant_new ("o", pv);
     pvs = g_variant_new_array (NULL, &pv_var, 1);
     params = g_variant_new_tuple (&pvs, 1);
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Extend", params, NULL, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Extend", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2332,7 +2512,7 @@ gboolean bd_lvm_vgreduce (const gchar *vg_name, const gchar *device, const BDExt
         g_variant_builder_clear (&builder);
     }
 
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Reduce", params, extra_params, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Reduce", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -2383,7 +2563,7 @@ static gboolean _vglock_start_stop (const gchar *vg_name, gboolean start, const
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Change", NULL, params, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Change", NULL, params, extra, NULL, error);
 }
 
 /**
@@ -2597,7 +2777,85 @@ gboolean bd_lvm_lvcreate (const gchar *vg_name, const gchar *lv_name, guint64 si
         g_variant_builder_clear (&builder);
     }
 
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "LvCreate", params, extra_params, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "LvCreate", params, extra_params, extra, NULL, error);
+}
+
+/**
+ * bd_lvm_select_pvs:
+ * @vg_name: name of the VG to select the PVs from
+ * @size: requested size of the new LV
+ * @type: (nullable): type of the new LV ("striped", "raid1",..., see lvcreate (8))
+ * @n_pvs: number of PVs the new LV should be spread over (number of stripes for
+ *         "striped", images for "raid1", data stripes plus parity for "raid5",...)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Selects PVs from @vg_name for a new LV so that no two of them share a physical
+ * device (e.g. partitions of the same disk or multiple paths to the same disk) and
+ * the PVs are spread over as many controllers (HBAs, NVMe controllers,...) as
+ * possible. Only PVs with enough free space for their part of the LV are considered.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): list of PVs to use as @pv_list
+ *                                                     for bd_lvm_lvcreate() or %NULL
+ *                                                     in case of error (e.g. not enough
+ *                                                     PVs on distinct physical devices)
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+gchar** bd_lvm_select_pvs (const gchar *vg_name, guint64 size, const gchar *type, guint n_pvs, GError **error) {
+    BDLVMPVdata **pvs = NULL;
+    BDLVMPVdata **pv_p = NULL;
+    gchar **ret = NULL;
+
+    pvs = bd_lvm_pvs (error);
+    if (!pvs)
+        return NULL;
+
+    ret = lvm_select_pvs (pvs, vg_name, size, type, n_pvs, error);
+
+    for (pv_p = pvs; *pv_p; pv_p++)
+        bd_lvm_pvdata_free (*pv_p);
+    g_free (pvs);
+
+    return ret;
+}
+
+/**
+ * bd_lvm_lvcreate_spread:
+ * @vg_name: name of the VG to create a new LV in
+ * @lv_name: name of the to-be-created LV
+ * @size: requested size of the new LV
+ * @type: (nullable): type of the new LV ("striped", "raid1",..., see lvcreate (8))
+ * @n_pvs: number of PVs the new LV should be spread over, see bd_lvm_select_pvs()
+ * @extra: (nullable) (array zero-terminated=1): extra options for the LV creation
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Creates a new LV on PVs selected with bd_lvm_select_pvs().
+ *
+ * Returns: whether the given @vg_name/@lv_name LV was successfully created or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_CREATE
+ */
+gboolean bd_lvm_lvcreate_spread (const gchar *vg_name, const gchar *lv_name, guint64 size, const gchar *type, guint n_pvs, const BDExtraArg **extra, GError **error) {
+    gchar **pv_list = NULL;
+    BDExtraArg **layout_extra = NULL;
+    gboolean success = FALSE;
+
+    pv_list = bd_lvm_select_pvs (vg_name, size, type, n_pvs, error);
+    if (!pv_list)
+        return FALSE;
+
+    layout_extra = lvm_layout_extra_args (type, n_pvs, extra);
+    /* the number of stripes for striped LVs is in @layout_extra, bd_lvm_lvcreate()
+       must not add it again (plain --stripes makes the LV striped) */
+    if (g_strcmp0 (type, "striped") == 0)
+        type = NULL;
+    success = bd_lvm_lvcreate (vg_name, lv_name, size, type, (const gchar **) pv_list, (const BDExtraArg **) layout_extra, error);
+
+    bd_extra_arg_list_free (layout_extra);
+    g_strfreev (pv_list);
+
+    return success;
 }
 
 /**
@@ -2626,7 +2884,7 @@ gboolean bd_lvm_lvremove (const gchar *vg_name, const gchar *lv_name, gboolean f
     extra_params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lv_method_sync (vg_name, lv_name, "Remove", NULL, extra_params, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, lv_name, "Remove", NULL, extra_params, extra, NULL, error);
 }
 
 /**
@@ -2647,7 +2905,7 @@ gboolean bd_lvm_lvrename (const gchar *vg_name, const gchar *lv_name, const gcha
     GVariant *params = NULL;
 
     params = g_variant_new ("(s)", new_name);
-    return call_lv_method_sync (vg_name, lv_name, "Rename", params, NULL, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, lv_name, "Rename", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2690,7 +2948,7 @@ gboolean bd_lvm_lvresize (const gchar *vg_name, const gchar *lv_name, guint64 si
       g_variant_builder_clear (&builder);
     }
 
-    return call_lv_method_sync (vg_name, lv_name, "Resize", params, extra_params, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, lv_name, "Resize", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -2732,7 +2990,7 @@ gboolean bd_lvm_lvrepair (const gchar *vg_name, const gchar *lv_name, const gcha
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lv_method_sync (vg_name, lv_name, "RepairRaidLv", params, NULL, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, lv_name, "RepairRaidLv", params, NULL, extra, NULL, error);
 
   return FALSE;
 }
@@ -2769,7 +3027,7 @@ gboolean bd_lvm_lvactivate (const gchar *vg_name, const gchar *lv_name, gboolean
         g_variant_builder_clear (&builder);
     }
 
-    return call_lv_method_sync (vg_name, lv_name, "Activate", params, extra_params, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, lv_name, "Activate", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -2786,7 +3044,7 @@ gboolean bd_lvm_lvactivate (const gchar *vg_name, const gchar *lv_name, gboolean
  */
 gboolean bd_lvm_lvdeactivate (const gchar *vg_name, const gchar *lv_name, const BDExtraArg **extra, GError **error) {
     GVariant *params = g_variant_new ("(t)", (guint64) 0);
-    return call_lv_method_sync (vg_name, lv_name, "Deactivate", params, NULL, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, lv_name, "Deactivate", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2814,7 +3072,7 @@ gboolean bd_lvm_lvsnapshotcreate (const gchar *vg_name, const gchar *origin_name
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lv_method_sync (vg_name, origin_name, "Snapshot", params, NULL, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, origin_name, "Snapshot", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2840,7 +3098,7 @@ gboolean bd_lvm_lvsnapshotmerge (const gchar *vg_name, const gchar *snapshot_nam
     if (!obj_path)
         return FALSE;
 
-    return call_lvm_method_sync (obj_path, SNAP_INTF, "Merge", NULL, NULL, extra, TRUE, error);
+    return call_lvm_method_sync (obj_path, SNAP_INTF, "Merge", NULL, NULL, extra, NULL, error);
 }
 
 /**
@@ -3330,7 +3588,7 @@ gboolean bd_lvm_thpoolcreate (const gchar *vg_name, const gchar *lv_name, guint6
     extra_params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "LvCreateLinear", params, extra_params, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "LvCreateLinear", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -3357,7 +3615,7 @@ gboolean bd_lvm_thlvcreate (const gchar *vg_name, const gchar *pool_name, const
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_thpool_method_sync (vg_name, pool_name, "LvCreate", params, NULL, extra, TRUE, error);
+    return call_thpool_method_sync (vg_name, pool_name, "LvCreate", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -3404,6 +3662,93 @@ gchar* bd_lvm_thlvpoolname (const gchar *vg_name, const gchar *lv_name, GError *
     return ret;
 }
 
+/**
+ * bd_lvm_thpool_space_usage:
+ * @vg_name: name of the VG containing the @pool_name thin pool
+ * @pool_name: name of the (active) thin pool
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Gets the number of mapped, exclusive and shared data blocks of all the thin
+ * devices in the @vg_name/@pool_name thin pool. Unlike the data_percent of a
+ * thin LV, the exclusive blocks tell how much space would be freed by removing
+ * the thin LV when it shares blocks with its snapshots (or origin).
+ *
+ * The numbers are read from a metadata snapshot taken (and released again) for
+ * the query so the live pool is not suspended. Requires the thin_ls utility.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): space usage of the thin devices
+ *                                                    in the pool or %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMThinSpaceUsage** bd_lvm_thpool_space_usage (const gchar *vg_name, const gchar *pool_name, GError **error) {
+    const gchar *args[7] = {"lvs", "--noheadings", "--separator=:", "-o", LVM_THIN_LVS_FIELDS, vg_name, NULL};
+    g_autofree gchar *output = NULL;
+    GHashTable *thin_lvs = NULL;
+    BDLVMThinSpaceUsage **ret = NULL;
+
+    if (!check_deps (&avail_deps, DEPS_THINLS_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return NULL;
+
+    if (!call_lvm_and_capture_output (args, NULL, &output, error))
+        return NULL;
+
+    thin_lvs = lvm_thin_parse_lvs (output, pool_name);
+    ret = lvm_thpool_space_usage (vg_name, pool_name, thin_lvs, error);
+    g_hash_table_destroy (thin_lvs);
+
+    return ret;
+}
+
+/**
+ * bd_lvm_thin_delta:
+ * @vg_name: name of the VG containing the thin LVs
+ * @lv_name1: name of the first (older) thin LV, e.g. the snapshot of the last backup
+ * @lv_name2: name of the second (newer) thin LV from the same pool, e.g. the
+ *            snapshot for the current backup
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Compares the block mappings of two thin LVs from the same (active) thin pool
+ * and returns the ranges where they differ -- the only parts of @lv_name2 an
+ * incremental backup needs to read (or discard for the %BD_LVM_THIN_DELTA_LEFT_ONLY
+ * ranges). Ranges mapped to the same blocks in both thin LVs are not reported.
+ *
+ * The mappings are read from a metadata snapshot taken (and released again) for
+ * the query so the live pool is not suspended. Requires the thin_delta utility.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): ranges (ordered by offset) in which
+ *                                                    @lv_name1 and @lv_name2 differ or
+ *                                                    %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMThinDeltaRange** bd_lvm_thin_delta (const gchar *vg_name, const gchar *lv_name1, const gchar *lv_name2, GError **error) {
+    const gchar *args[7] = {"lvs", "--noheadings", "--separator=:", "-o", LVM_THIN_LVS_FIELDS, vg_name, NULL};
+    g_autofree gchar *output = NULL;
+    g_autofree gchar *pool_name1 = NULL;
+    g_autofree gchar *pool_name2 = NULL;
+    guint64 thin_id1 = 0;
+    guint64 thin_id2 = 0;
+
+    if (!check_deps (&avail_deps, DEPS_THINDELTA_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return NULL;
+
+    if (!call_lvm_and_capture_output (args, NULL, &output, error))
+        return NULL;
+
+    if (!lvm_thin_lv_id (output, vg_name, lv_name1, &thin_id1, &pool_name1, error) ||
+        !lvm_thin_lv_id (output, vg_name, lv_name2, &thin_id2, &pool_name2, error))
+        return NULL;
+
+    if (g_strcmp0 (pool_name1, pool_name2) != 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Thin LVs '%s' and '%s' are not in the same thin pool", lv_name1, lv_name2);
+        return NULL;
+    }
+
+    return lvm_thin_delta (vg_name, pool_name1, thin_id1, thin_id2, error);
+}
+
 /**
  * bd_lvm_thsnapshotcreate:
  * @vg_name: name of the VG containing the thin LV a new snapshot should be created of
@@ -3437,7 +3782,7 @@ gboolean bd_lvm_thsnapshotcreate (const gchar *vg_name, const gchar *origin_name
         g_variant_builder_clear (&builder);
     }
 
-    return call_lv_method_sync (vg_name, origin_name, "Snapshot", params, extra_params, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, origin_name, "Snapshot", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -3451,7 +3796,8 @@ gboolean bd_lvm_thsnapshotcreate (const gchar *vg_name, const gchar *origin_name
  *       in libblockdev, it doesn't change the global lvm.conf config file.
  *       Calling this function with `backup {backup=0 archive=0}` for example
  *       means `--config=backup {backup=0 archive=0}"` will be added to all
- *       calls libblockdev makes.
+ *       calls libblockdev makes. A config set with bd_context_set_lvm_config()
+ *       on the thread's #BDContext takes precedence.
  *
  * Returns: whether the new requested global config @new_config was successfully
  *          set or not
@@ -3753,7 +4099,7 @@ gboolean bd_lvm_cache_create_pool (const gchar *vg_name, const gchar *pool_name,
     extra = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    success = call_lvm_obj_method_sync (vg_name, VG_INTF, "CreateCachePool", params, extra, NULL, TRUE, &l_error);
+    success = call_lvm_obj_method_sync (vg_name, VG_INTF, "CreateCachePool", params, extra, NULL, NULL, &l_error);
     if (!success) {
         bd_utils_report_finished (progress_id, l_error->message);
         g_propagate_error (error, l_error);
@@ -3795,7 +4141,7 @@ gboolean bd_lvm_cache_attach (const gchar *vg_name, const gchar *data_lv, const
 
     lv_id = g_strdup_printf ("%s/%s", vg_name, cache_pool_lv);
 
-    ret = call_lvm_obj_method_sync (lv_id, CACHE_POOL_INTF, "CacheLv", params, NULL, extra, TRUE, error);
+    ret = call_lvm_obj_method_sync (lv_id, CACHE_POOL_INTF, "CacheLv", params, NULL, extra, NULL, error);
     g_free (lv_id);
     return ret;
 }
@@ -3830,7 +4176,7 @@ gboolean bd_lvm_cache_detach (const gchar *vg_name, const gchar *cached_lv, gboo
     if (!cache_pool_name)
         return FALSE;
     lv_id = g_strdup_printf ("%s/%s", vg_name, cached_lv);
-    return call_lvm_obj_method_sync (lv_id, CACHED_LV_INTF, "DetachCachePool", params, NULL, extra, TRUE, error);
+    return call_lvm_obj_method_sync (lv_id, CACHED_LV_INTF, "DetachCachePool", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -3943,7 +4289,7 @@ gboolean bd_lvm_writecache_attach (const gchar *vg_name, const gchar *data_lv, c
 
     lv_id = g_strdup_printf ("%s/%s", vg_name, cache_lv);
 
-    success = call_lvm_obj_method_sync (lv_id, LV_INTF, "WriteCacheLv", params, NULL, extra, TRUE, error);
+    success = call_lvm_obj_method_sync (lv_id, LV_INTF, "WriteCacheLv", params, NULL, extra, NULL, error);
     g_free (lv_id);
     return success;
 }
@@ -4032,6 +4378,71 @@ gboolean bd_lvm_writecache_create_cached_lv (const gchar *vg_name, const gchar *
     return TRUE;
 }
 
+/**
+ * bd_lvm_writecache_get_settings:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached LV to get the writecache settings for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): current settings of the active writecache of @cached_lv
+ *                           or %NULL in case of error
+ *
+ * Note: The settings are read directly from the active DM writecache target, no
+ *       LVM command is run. Settings not explicitly set for the target (kernel
+ *       defaults) are reported as unset.
+ *
+ * Tech category: %BD_LVM_TECH_WRITECACHE-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMWritecacheSettings* bd_lvm_writecache_get_settings (const gchar *vg_name, const gchar *cached_lv, GError **error) {
+    return lvm_writecache_get_settings (vg_name, cached_lv, error);
+}
+
+/**
+ * bd_lvm_writecache_set_settings:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached LV to change the writecache settings for
+ * @settings: settings to set (unset settings are left untouched)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the settings were successfully changed or not
+ *
+ * Note: The dm-writecache target has no messages for changing its settings so
+ *       the settings are always stored in the LVM metadata and LVM reloads the
+ *       active target with them.
+ *
+ * Tech category: %BD_LVM_TECH_WRITECACHE-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_writecache_set_settings (const gchar *vg_name, const gchar *cached_lv, const BDLVMWritecacheSettings *settings, GError **error) {
+    const gchar *args[5] = {"lvchange", "--cachesettings", NULL, NULL, NULL};
+    g_autofree gchar *cache_settings = NULL;
+    g_autofree gchar *lv_spec = NULL;
+
+    cache_settings = lvm_writecache_settings_str (settings);
+
+    /* nothing to change */
+    if (!cache_settings)
+        return TRUE;
+
+    lv_spec = g_strdup_printf ("%s/%s", vg_name, cached_lv);
+    args[2] = cache_settings;
+    args[3] = lv_spec;
+
+    return call_lvm_and_report_error (args, NULL, NULL, error);
+}
+
+/**
+ * bd_lvm_writecache_settings_to_extra:
+ * @settings: writecache settings to convert
+ *
+ * Returns: (transfer full) (array zero-terminated=1): extra arguments for
+ *          bd_lvm_writecache_attach() applying @settings when creating the cache
+ *
+ * Tech category: %BD_LVM_TECH_WRITECACHE no mode (it is ignored)
+ */
+BDExtraArg** bd_lvm_writecache_settings_to_extra (const BDLVMWritecacheSettings *settings) {
+    return lvm_writecache_settings_extra_args (settings);
+}
+
 /**
  * bd_lvm_cache_pool_name:
  * @vg_name: name of the VG containing the @cached_lv
@@ -4215,6 +4626,90 @@ BDLVMCacheStats* bd_lvm_cache_stats (const gchar *vg_name, const gchar *cached_l
     return ret;
 }
 
+/**
+ * bd_lvm_cache_get_settings:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached LV to get the cache settings for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): current settings of the active cache of @cached_lv
+ *                           or %NULL in case of error
+ *
+ * Note: The settings are read directly from the active DM cache target, no LVM
+ *       command is run. For cached thin pools use the data LV of the pool
+ *       (e.g. "pool_tdata") as @cached_lv.
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMCacheSettings* bd_lvm_cache_get_settings (const gchar *vg_name, const gchar *cached_lv, GError **error) {
+    return lvm_cache_get_settings (vg_name, cached_lv, error);
+}
+
+/**
+ * bd_lvm_cache_set_settings:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached LV to change the cache settings for
+ * @settings: settings to set (unset settings are left untouched)
+ * @persistent: whether to store the settings in the LVM metadata or only change
+ *              them in the active DM cache target
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the settings were successfully changed or not
+ *
+ * Note: With @persistent set to %FALSE, the migration threshold is changed by
+ *       sending a message to the active DM cache target and the change is lost
+ *       when the LV is deactivated. Changing the cache policy requires a table
+ *       reload and is therefore only possible with @persistent set to %TRUE.
+ *       The chunk size of an existing cache cannot be changed at all.
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_cache_set_settings (const gchar *vg_name, const gchar *cached_lv, const BDLVMCacheSettings *settings, gboolean persistent, GError **error) {
+    const gchar *args[7] = {"lvchange", NULL, NULL, NULL, NULL, NULL, NULL};
+    guint next_arg = 1;
+    g_autofree gchar *cache_settings = NULL;
+    g_autofree gchar *lv_spec = NULL;
+
+    if (!lvm_cache_check_settings (vg_name, cached_lv, settings, persistent, error))
+        return FALSE;
+
+    if (!persistent)
+        return lvm_cache_set_dm_settings (vg_name, cached_lv, settings, error);
+
+    if (settings->policy) {
+        args[next_arg++] = "--cachepolicy";
+        args[next_arg++] = settings->policy;
+    }
+
+    cache_settings = lvm_cache_settings_str (settings);
+    if (cache_settings) {
+        args[next_arg++] = "--cachesettings";
+        args[next_arg++] = cache_settings;
+    }
+
+    /* nothing to change */
+    if (next_arg == 1)
+        return TRUE;
+
+    lv_spec = g_strdup_printf ("%s/%s", vg_name, cached_lv);
+    args[next_arg++] = lv_spec;
+
+    return call_lvm_and_report_error (args, NULL, NULL, error);
+}
+
+/**
+ * bd_lvm_cache_settings_to_extra:
+ * @settings: cache settings to convert
+ *
+ * Returns: (transfer full) (array zero-terminated=1): extra arguments for
+ *          bd_lvm_cache_attach() applying @settings when creating the cache
+ *
+ * Tech category: %BD_LVM_TECH_CACHE no mode (it is ignored)
+ */
+BDExtraArg** bd_lvm_cache_settings_to_extra (const BDLVMCacheSettings *settings) {
+    return lvm_cache_settings_extra_args (settings);
+}
+
 /**
  * bd_lvm_thpool_convert:
  * @vg_name: name of the VG to create the new thin pool in
@@ -4259,7 +4754,7 @@ gboolean bd_lvm_thpool_convert (const gchar *vg_name, const gchar *data_lv, cons
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    ret = call_lvm_obj_method_sync (vg_name, VG_INTF, "CreateThinPool", params, NULL, extra, TRUE, error);
+    ret = call_lvm_obj_method_sync (vg_name, VG_INTF, "CreateThinPool", params, NULL, extra, NULL, error);
     if (ret && name)
         bd_lvm_lvrename (vg_name, data_lv, name, NULL, error);
     return ret;
@@ -4309,7 +4804,7 @@ gboolean bd_lvm_cache_pool_convert (const gchar *vg_name, const gchar *data_lv,
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    ret = call_lvm_obj_method_sync (vg_name, VG_INTF, "CreateCachePool", params, NULL, extra, TRUE, error);
+    ret = call_lvm_obj_method_sync (vg_name, VG_INTF, "CreateCachePool", params, NULL, extra, NULL, error);
 
     if (!ret && name)
         bd_lvm_lvrename (vg_name, data_lv, name, NULL, error);
@@ -4340,7 +4835,7 @@ gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, con
     GVariantBuilder builder;
     GVariant *params = NULL;
     GVariant *extra_params = NULL;
-    gchar *old_config = NULL;
+    gchar *vdo_config = NULL;
     const gchar *write_policy_str = NULL;
     g_autofree gchar *name = NULL;
     gboolean ret = FALSE;
@@ -4372,21 +4867,14 @@ gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, con
     g_variant_builder_clear (&builder);
 
     /* index_memory and write_policy can be specified only using the config */
-    g_mutex_lock (&global_config_lock);
-    old_config = global_config_str;
     if (index_memory != 0)
-        global_config_str = g_strdup_printf ("%s allocation {vdo_index_memory_size_mb=%"G_GUINT64_FORMAT" vdo_write_policy=\"%s\"}", old_config ? old_config : "",
-                                                                                                                                     index_memory / (1024 * 1024),
-                                                                                                                                     write_policy_str);
+        vdo_config = g_strdup_printf ("allocation {vdo_index_memory_size_mb=%"G_GUINT64_FORMAT" vdo_write_policy=\"%s\"}",
+                                      index_memory / (1024 * 1024), write_policy_str);
     else
-        global_config_str = g_strdup_printf ("%s allocation {vdo_write_policy=\"%s\"}", old_config ? old_config : "",
-                                                                                        write_policy_str);
+        vdo_config = g_strdup_printf ("allocation {vdo_write_policy=\"%s\"}", write_policy_str);
 
-    ret = call_lvm_obj_method_sync (vg_name, VG_VDO_INTF, "CreateVdoPoolandLv", params, extra_params, extra, FALSE, error);
-
-    g_free (global_config_str);
-    global_config_str = old_config;
-    g_mutex_unlock (&global_config_lock);
+    ret = call_lvm_obj_method_sync (vg_name, VG_VDO_INTF, "CreateVdoPoolandLv", params, extra_params, extra, vdo_config, error);
+    g_free (vdo_config);
 
     return ret;
 }
@@ -4404,7 +4892,7 @@ gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, con
  * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_MODIFY
  */
 gboolean bd_lvm_vdo_enable_compression (const gchar *vg_name, const gchar *pool_name, const BDExtraArg **extra, GError **error) {
-    return call_vdopool_method_sync (vg_name, pool_name, "EnableCompression", NULL, NULL, extra, TRUE, error);
+    return call_vdopool_method_sync (vg_name, pool_name, "EnableCompression", NULL, NULL, extra, NULL, error);
 }
 
 /**
@@ -4420,7 +4908,7 @@ gboolean bd_lvm_vdo_enable_compression (const gchar *vg_name, const gchar *pool_
  * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_MODIFY
  */
 gboolean bd_lvm_vdo_disable_compression (const gchar *vg_name, const gchar *pool_name, const BDExtraArg **extra, GError **error) {
-    return call_vdopool_method_sync (vg_name, pool_name, "DisableCompression", NULL, NULL, extra, TRUE, error);
+    return call_vdopool_method_sync (vg_name, pool_name, "DisableCompression", NULL, NULL, extra, NULL, error);
 }
 
 /**
@@ -4436,7 +4924,7 @@ gboolean bd_lvm_vdo_disable_compression (const gchar *vg_name, const gchar *pool
  * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_MODIFY
  */
 gboolean bd_lvm_vdo_enable_deduplication (const gchar *vg_name, const gchar *pool_name, const BDExtraArg **extra, GError **error) {
-    return call_vdopool_method_sync (vg_name, pool_name, "EnableDeduplication", NULL, NULL, extra, TRUE, error);
+    return call_vdopool_method_sync (vg_name, pool_name, "EnableDeduplication", NULL, NULL, extra, NULL, error);
 }
 
 /**
@@ -4452,7 +4940,7 @@ gboolean bd_lvm_vdo_enable_deduplication (const gchar *vg_name, const gchar *poo
  * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_MODIFY
  */
 gboolean bd_lvm_vdo_disable_deduplication (const gchar *vg_name, const gchar *pool_name, const BDExtraArg **extra, GError **error) {
-    return call_vdopool_method_sync (vg_name, pool_name, "DisableDeduplication", NULL, NULL, extra, TRUE, error);
+    return call_vdopool_method_sync (vg_name, pool_name, "DisableDeduplication", NULL, NULL, extra, NULL, error);
 }
 
 /**
@@ -4808,20 +5296,21 @@ static gboolean _lvm_devices_enabled () {
     gboolean enabled = FALSE;
     gint scanned = 0;
     g_autofree gchar *config_arg = NULL;
+    g_autofree gchar *lvm_config = NULL;
+    g_autofree gchar *lvm_devices = NULL;
 
     /* try full config first -- if we get something from this it means the feature is
        explicitly enabled or disabled by system lvm.conf or using the --config option */
     args[2] = "full";
 
-    /* make sure to include the global config from us when getting the current config value */
-    g_mutex_lock (&global_config_lock);
-    if (global_config_str) {
-        config_arg = g_strdup_printf ("--config=%s", global_config_str);
+    /* make sure to include the config from us when getting the current config value */
+    get_lvm_config (&lvm_config, &lvm_devices);
+    if (lvm_config) {
+        config_arg = g_strdup_printf ("--config=%s", lvm_config);
         args[4] = config_arg;
     }
 
     ret = bd_utils_exec_and_capture_output (args, NULL, &output, &loc_error);
-    g_mutex_unlock (&global_config_lock);
     if (ret) {
         scanned = sscanf (output, "use_devicesfile=%u", &enabled);
         g_free (output);
@@ -28,6 +28,9 @@
 #include "check_deps.h"
 #include "dm_logging.h"
 #include "vdo_stats.h"
+#include "lvm_topology.h"
+#include "lvm_cache.h"
+#include "lvm_thin.h"
 
 #define INT_FLOAT_EPS 1e-5
 #define SECTOR_SIZE 512
@@ -297,6 +300,68 @@ void bd_lvm_cache_stats_free (BDLVMCacheStats *data) {
     g_free (data);
 }
 
+BDLVMCacheSettings* bd_lvm_cache_settings_copy (BDLVMCacheSettings *settings) {
+    if (settings == NULL)
+        return NULL;
+
+    BDLVMCacheSettings *new = g_new0 (BDLVMCacheSettings, 1);
+
+    new->policy = g_strdup (settings->policy);
+    new->migration_threshold = settings->migration_threshold;
+    new->chunk_size = settings->chunk_size;
+
+    return new;
+}
+
+void bd_lvm_cache_settings_free (BDLVMCacheSettings *settings) {
+    if (settings == NULL)
+        return;
+
+    g_free (settings->policy);
+    g_free (settings);
+}
+
+BDLVMCacheSettings* bd_lvm_cache_settings_new (void) {
+    BDLVMCacheSettings *ret = g_new0 (BDLVMCacheSettings, 1);
+
+    ret->migration_threshold = -1;
+
+    return ret;
+}
+
+BDLVMWritecacheSettings* bd_lvm_writecache_settings_copy (BDLVMWritecacheSettings *settings) {
+    if (settings == NULL)
+        return NULL;
+
+    BDLVMWritecacheSettings *new = g_new0 (BDLVMWritecacheSettings, 1);
+
+    new->high_watermark = settings->high_watermark;
+    new->low_watermark = settings->low_watermark;
+    new->writeback_jobs = settings->writeback_jobs;
+    new->autocommit_blocks = settings->autocommit_blocks;
+    new->autocommit_time = settings->autocommit_time;
+    new->pause_writeback = settings->pause_writeback;
+
+    return new;
+}
+
+void bd_lvm_writecache_settings_free (BDLVMWritecacheSettings *settings) {
+    g_free (settings);
+}
+
+BDLVMWritecacheSettings* bd_lvm_writecache_settings_new (void) {
+    BDLVMWritecacheSettings *ret = g_new0 (BDLVMWritecacheSettings, 1);
+
+    ret->high_watermark = -1;
+    ret->low_watermark = -1;
+    ret->writeback_jobs = -1;
+    ret->autocommit_blocks = -1;
+    ret->autocommit_time = -1;
+    ret->pause_writeback = -1;
+
+    return ret;
+}
+
 
 static volatile guint avail_deps = 0;
 static volatile guint avail_features = 0;
@@ -307,11 +372,17 @@ static GMutex deps_check_lock;
 #define DEPS_LVM_MASK (1 << DEPS_LVM)
 #define DEPS_LVMDEVICES 1
 #define DEPS_LVMDEVICES_MASK (1 << DEPS_LVMDEVICES)
-#define DEPS_LAST 2
+#define DEPS_THINLS 2
+#define DEPS_THINLS_MASK (1 << DEPS_THINLS)
+#define DEPS_THINDELTA 3
+#define DEPS_THINDELTA_MASK (1 << DEPS_THINDELTA)
+#define DEPS_LAST 4
 
 static const UtilDep deps[DEPS_LAST] = {
     {"lvm", LVM_MIN_VERSION, "version", "LVM version:\\s+([\\d\\.]+)"},
     {"lvmdevices", NULL, NULL, NULL},
+    {"thin_ls", NULL, NULL, NULL},
+    {"thin_delta", NULL, NULL, NULL},
 };
 
 #define FEATURES_VDO 0
@@ -402,19 +473,52 @@ gboolean bd_lvm_is_tech_avail (BDLVMTech tech, guint64 mode, GError **error) {
     }
 }
 
-static gboolean call_lvm_and_report_error (const gchar **args, const BDExtraArg **extra, gboolean lock_config, GError **error) {
-    gboolean success = FALSE;
+/* LVM config and devices filter effective for the current thread -- the ones set
+   on the thread's context (if any) take precedence over the global ones */
+static void get_lvm_config (gchar **config, gchar **devices) {
+    BDContext *ctx = bd_context_get_thread ();
+    gchar **ctx_devices = NULL;
+    gboolean config_set = FALSE;
+    gboolean devices_set = FALSE;
+
+    *config = NULL;
+    *devices = NULL;
+
+    if (ctx) {
+        config_set = bd_context_get_lvm_config (ctx, config);
+        devices_set = bd_context_get_lvm_devices (ctx, &ctx_devices);
+        if (ctx_devices) {
+            *devices = g_strjoinv (",", ctx_devices);
+            g_strfreev (ctx_devices);
+        }
+    }
+
+    if (!config_set || !devices_set) {
+        g_mutex_lock (&global_config_lock);
+        if (!config_set)
+            *config = g_strdup (global_config_str);
+        if (!devices_set)
+            *devices = g_strdup (global_devices_str);
+        g_mutex_unlock (&global_config_lock);
+    }
+}
+
+/**
+ * build_lvm_argv:
+ * @args: arguments for lvm (without "lvm")
+ * @extra_config: (nullable): additional config to append to the effective config
+ * @config_arg: (out): place to store the "--config" argument (needs to be freed)
+ * @devices_arg: (out): place to store the "--devices" argument (needs to be freed)
+ *
+ * Returns: (transfer container): argv for running lvm with @args
+ */
+static const gchar** build_lvm_argv (const gchar **args, const gchar *extra_config, gchar **config_arg, gchar **devices_arg) {
     guint i = 0;
     guint args_length = g_strv_length ((gchar **) args);
-    g_autofree gchar *config_arg = NULL;
-    g_autofree gchar *devices_arg = NULL;
+    g_autofree gchar *config = NULL;
+    g_autofree gchar *devices = NULL;
 
-    if (!check_deps (&avail_deps, DEPS_LVM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
-        return FALSE;
-
-    /* don't allow global config string changes during the run */
-    if (lock_config)
-        g_mutex_lock (&global_config_lock);
+    get_lvm_config (&config, &devices);
 
     /* allocate enough space for the args plus "lvm", "--config", "--devices" and NULL */
     const gchar **argv = g_new0 (const gchar*, args_length + 4);
@@ -423,19 +527,32 @@ static gboolean call_lvm_and_report_error (const gchar **args, const BDExtraArg
     argv[0] = "lvm";
     for (i=0; i < args_length; i++)
         argv[i+1] = args[i];
-    if (global_config_str) {
-        config_arg = g_strdup_printf ("--config=%s", global_config_str);
-        argv[++args_length] = config_arg;
+    if (config || extra_config) {
+        *config_arg = g_strdup_printf ("--config=%s%s%s", config ? config : "",
+                                       (config && extra_config) ? " " : "",
+                                       extra_config ? extra_config : "");
+        argv[++args_length] = *config_arg;
     }
-    if (global_devices_str) {
-        devices_arg = g_strdup_printf ("--devices=%s", global_devices_str);
-        argv[++args_length] = devices_arg;
+    if (devices) {
+        *devices_arg = g_strdup_printf ("--devices=%s", devices);
+        argv[++args_length] = *devices_arg;
     }
     argv[++args_length] = NULL;
 
+    return argv;
+}
+
+static gboolean call_lvm_and_report_error (const gchar **args, const BDExtraArg **extra, const gchar *extra_config, GError **error) {
+    gboolean success = FALSE;
+    g_autofree gchar *config_arg = NULL;
+    g_autofree gchar *devices_arg = NULL;
+    const gchar **argv = NULL;
+
+    if (!check_deps (&avail_deps, DEPS_LVM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return FALSE;
+
+    argv = build_lvm_argv (args, extra_config, &config_arg, &devices_arg);
     success = bd_utils_exec_and_report_error (argv, extra, error);
-    if (lock_config)
-        g_mutex_unlock (&global_config_lock);
     g_free (argv);
 
     return success;
@@ -443,36 +560,15 @@ static gboolean call_lvm_and_report_error (const gchar **args, const BDExtraArg
 
 static gboolean call_lvm_and_capture_output (const gchar **args, const BDExtraArg **extra, gchar **output, GError **error) {
     gboolean success = FALSE;
-    guint i = 0;
-    guint args_length = g_strv_length ((gchar **) args);
     g_autofree gchar *config_arg = NULL;
     g_autofree gchar *devices_arg = NULL;
+    const gchar **argv = NULL;
 
     if (!check_deps (&avail_deps, DEPS_LVM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
         return FALSE;
 
-    /* don't allow global config string changes during the run */
-    g_mutex_lock (&global_config_lock);
-
-    /* allocate enough space for the args plus "lvm", "--config", "--devices" and NULL */
-    const gchar **argv = g_new0 (const gchar*, args_length + 4);
-
-    /* construct argv from args with "lvm" prepended */
-    argv[0] = "lvm";
-    for (i=0; i < args_length; i++)
-        argv[i+1] = args[i];
-    if (global_config_str) {
-        config_arg = g_strdup_printf ("--config=%s", global_config_str);
-        argv[++args_length] = config_arg;
-    }
-    if (global_devices_str) {
-        devices_arg = g_strdup_printf ("--devices=%s", global_devices_str);
-        argv[++args_length] = devices_arg;
-    }
-    argv[++args_length] = NULL;
-
+    argv = build_lvm_argv (args, NULL, &config_arg, &devices_arg);
     success = bd_utils_exec_and_capture_output (argv, extra, output, error);
-    g_mutex_unlock (&global_config_lock);
     g_free (argv);
 
     return success;
@@ -1122,7 +1218,7 @@ gboolean bd_lvm_pvcreate (const gchar *device, guint64 data_alignment, guint64 m
         args[next_arg++] = metadata_str;
     }
 
-    ret = call_lvm_and_report_error (args, extra, TRUE, error);
+    ret = call_lvm_and_report_error (args, extra, NULL, error);
     g_free (dataalign_str);
     g_free (metadata_str);
 
@@ -1163,7 +1259,7 @@ gboolean bd_lvm_pvresize (const gchar *device, guint64 size, const BDExtraArg **
 
     args[next_pos] = device;
 
-    ret = call_lvm_and_report_error (args, extra, TRUE, error);
+    ret = call_lvm_and_report_error (args, extra, NULL, error);
     if (to_free_pos > 0)
         g_free ((gchar *) args[to_free_pos]);
 
@@ -1186,7 +1282,7 @@ gboolean bd_lvm_pvremove (const gchar *device, const BDExtraArg **extra, GError
        bug, at least not in this code) */
     const gchar *args[6] = {"pvremove", "--force", "--force", "--yes", device, NULL};
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 static gboolean extract_pvmove_progress (const gchar *line, guint8 *completion) {
@@ -1255,7 +1351,7 @@ gboolean bd_lvm_pvscan (const gchar *device, gboolean update_cache, const BDExtr
         if (device)
             bd_utils_log_format (BD_UTILS_LOG_WARNING, "Ignoring the device argument in pvscan (cache update not requested)");
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 static gboolean _manage_lvm_tags (const gchar *devspec, const gchar **tags, const gchar *action, const gchar *cmd, GError **error) {
@@ -1272,7 +1368,7 @@ static gboolean _manage_lvm_tags (const gchar *devspec, const gchar **tags, cons
     argv[next_arg++] = devspec;
     argv[next_arg] = NULL;
 
-    success = call_lvm_and_report_error (argv, NULL, TRUE, error);
+    success = call_lvm_and_report_error (argv, NULL, NULL, error);
     g_free (argv);
     return success;
 }
@@ -1453,7 +1549,7 @@ gboolean bd_lvm_vgcreate (const gchar *name, const gchar **pv_list, guint64 pe_s
     }
     argv[i] = NULL;
 
-    success = call_lvm_and_report_error (argv, extra, TRUE, error);
+    success = call_lvm_and_report_error (argv, extra, NULL, error);
     g_free ((gchar *) argv[2]);
     g_free (argv);
 
@@ -1474,7 +1570,7 @@ gboolean bd_lvm_vgcreate (const gchar *name, const gchar **pv_list, guint64 pe_s
 gboolean bd_lvm_vgremove (const gchar *vg_name, const BDExtraArg **extra, GError **error) {
     const gchar *args[4] = {"vgremove", "--force", vg_name, NULL};
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1492,7 +1588,7 @@ gboolean bd_lvm_vgremove (const gchar *vg_name, const BDExtraArg **extra, GError
 gboolean bd_lvm_vgrename (const gchar *old_vg_name, const gchar *new_vg_name, const BDExtraArg **extra, GError **error) {
     const gchar *args[4] = {"vgrename", old_vg_name, new_vg_name, NULL};
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1509,7 +1605,7 @@ gboolean bd_lvm_vgrename (const gchar *old_vg_name, const gchar *new_vg_name, co
 gboolean bd_lvm_vgactivate (const gchar *vg_name, const BDExtraArg **extra, GError **error) {
     const gchar *args[4] = {"vgchange", "-ay", vg_name, NULL};
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1526,7 +1622,7 @@ gboolean bd_lvm_vgactivate (const gchar *vg_name, const BDExtraArg **extra, GErr
 gboolean bd_lvm_vgdeactivate (const gchar *vg_name, const BDExtraArg **extra, GError **error) {
     const gchar *args[4] = {"vgchange", "-an", vg_name, NULL};
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1544,7 +1640,7 @@ gboolean bd_lvm_vgdeactivate (const gchar *vg_name, const BDExtraArg **extra, GE
 gboolean bd_lvm_vgextend (const gchar *vg_name, const gchar *device, const BDExtraArg **extra, GError **error) {
     const gchar *args[4] = {"vgextend", vg_name, device, NULL};
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1575,7 +1671,7 @@ gboolean bd_lvm_vgreduce (const gchar *vg_name, const gchar *device, const BDExt
         args[2] = device;
     }
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1614,7 +1710,7 @@ static gboolean _vglock_start_stop (const gchar *vg_name, gboolean start, const
     else
         args[1] = "--lockstop";
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1841,7 +1937,7 @@ gboolean bd_lvm_lvcreate (const gchar *vg_name, const gchar *lv_name, guint64 si
 
     args[i] = NULL;
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free (size_str);
     g_free (type_str);
     g_free (args);
@@ -1849,6 +1945,84 @@ gboolean bd_lvm_lvcreate (const gchar *vg_name, const gchar *lv_name, guint64 si
     return success;
 }
 
+/**
+ * bd_lvm_select_pvs:
+ * @vg_name: name of the VG to select the PVs from
+ * @size: requested size of the new LV
+ * @type: (nullable): type of the new LV ("striped", "raid1",..., see lvcreate (8))
+ * @n_pvs: number of PVs the new LV should be spread over (number of stripes for
+ *         "striped", images for "raid1", data stripes plus parity for "raid5",...)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Selects PVs from @vg_name for a new LV so that no two of them share a physical
+ * device (e.g. partitions of the same disk or multiple paths to the same disk) and
+ * the PVs are spread over as many controllers (HBAs, NVMe controllers,...) as
+ * possible. Only PVs with enough free space for their part of the LV are considered.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): list of PVs to use as @pv_list
+ *                                                     for bd_lvm_lvcreate() or %NULL
+ *                                                     in case of error (e.g. not enough
+ *                                                     PVs on distinct physical devices)
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+gchar** bd_lvm_select_pvs (const gchar *vg_name, guint64 size, const gchar *type, guint n_pvs, GError **error) {
+    BDLVMPVdata **pvs = NULL;
+    BDLVMPVdata **pv_p = NULL;
+    gchar **ret = NULL;
+
+    pvs = bd_lvm_pvs (error);
+    if (!pvs)
+        return NULL;
+
+    ret = lvm_select_pvs (pvs, vg_name, size, type, n_pvs, error);
+
+    for (pv_p = pvs; *pv_p; pv_p++)
+        bd_lvm_pvdata_free (*pv_p);
+    g_free (pvs);
+
+    return ret;
+}
+
+/**
+ * bd_lvm_lvcreate_spread:
+ * @vg_name: name of the VG to create a new LV in
+ * @lv_name: name of the to-be-created LV
+ * @size: requested size of the new LV
+ * @type: (nullable): type of the new LV ("striped", "raid1",..., see lvcreate (8))
+ * @n_pvs: number of PVs the new LV should be spread over, see bd_lvm_select_pvs()
+ * @extra: (nullable) (array zero-terminated=1): extra options for the LV creation
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Creates a new LV on PVs selected with bd_lvm_select_pvs().
+ *
+ * Returns: whether the given @vg_name/@lv_name LV was successfully created or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_CREATE
+ */
+gboolean bd_lvm_lvcreate_spread (const gchar *vg_name, const gchar *lv_name, guint64 size, const gchar *type, guint n_pvs, const BDExtraArg **extra, GError **error) {
+    gchar **pv_list = NULL;
+    BDExtraArg **layout_extra = NULL;
+    gboolean success = FALSE;
+
+    pv_list = bd_lvm_select_pvs (vg_name, size, type, n_pvs, error);
+    if (!pv_list)
+        return FALSE;
+
+    layout_extra = lvm_layout_extra_args (type, n_pvs, extra);
+    /* the number of stripes for striped LVs is in @layout_extra, bd_lvm_lvcreate()
+       must not add it again (plain --stripes makes the LV striped) */
+    if (g_strcmp0 (type, "striped") == 0)
+        type = NULL;
+    success = bd_lvm_lvcreate (vg_name, lv_name, size, type, (const gchar **) pv_list, (const BDExtraArg **) layout_extra, error);
+
+    bd_extra_arg_list_free (layout_extra);
+    g_strfreev (pv_list);
+
+    return success;
+}
+
 /**
  * bd_lvm_lvremove:
  * @vg_name: name of the VG containing the to-be-removed LV
@@ -1875,7 +2049,7 @@ gboolean bd_lvm_lvremove (const gchar *vg_name, const gchar *lv_name, gboolean f
 
     args[next_arg] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[next_arg]);
 
     return success;
@@ -1897,7 +2071,7 @@ gboolean bd_lvm_lvremove (const gchar *vg_name, const gchar *lv_name, gboolean f
  */
 gboolean bd_lvm_lvrename (const gchar *vg_name, const gchar *lv_name, const gchar *new_name, const BDExtraArg **extra, GError **error) {
     const gchar *args[5] = {"lvrename", vg_name, lv_name, new_name, NULL};
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 
@@ -1935,7 +2109,7 @@ gboolean bd_lvm_lvresize (const gchar *vg_name, const gchar *lv_name, guint64 si
     lvspec = g_strdup_printf ("%s/%s", vg_name, lv_name);
     args[next_arg++] = lvspec;
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[3]);
 
     return success;
@@ -1969,7 +2143,7 @@ gboolean bd_lvm_lvrepair (const gchar *vg_name, const gchar *lv_name, const gcha
     }
     argv[i] = NULL;
 
-    success = call_lvm_and_report_error (argv, extra, TRUE, error);
+    success = call_lvm_and_report_error (argv, extra, NULL, error);
     g_free ((gchar *) argv[3]);
     g_free (argv);
 
@@ -2007,7 +2181,7 @@ gboolean bd_lvm_lvactivate (const gchar *vg_name, const gchar *lv_name, gboolean
     }
     args[next_arg] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[next_arg]);
 
     return success;
@@ -2031,7 +2205,7 @@ gboolean bd_lvm_lvdeactivate (const gchar *vg_name, const gchar *lv_name, const
 
     args[2] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[2]);
 
     return success;
@@ -2059,7 +2233,7 @@ gboolean bd_lvm_lvsnapshotcreate (const gchar *vg_name, const gchar *origin_name
     args[3] = g_strdup_printf ("%"G_GUINT64_FORMAT"K", size / 1024);
     args[6] = g_strdup_printf ("%s/%s", vg_name, origin_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[3]);
     g_free ((gchar *) args[6]);
 
@@ -2084,7 +2258,7 @@ gboolean bd_lvm_lvsnapshotmerge (const gchar *vg_name, const gchar *snapshot_nam
 
     args[2] = g_strdup_printf ("%s/%s", vg_name, snapshot_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[2]);
 
     return success;
@@ -2434,7 +2608,7 @@ gboolean bd_lvm_thpoolcreate (const gchar *vg_name, const gchar *lv_name, guint6
 
     args[next_arg] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[3]);
     g_free ((gchar *) args[4]);
     g_free ((gchar *) args[5]);
@@ -2465,7 +2639,7 @@ gboolean bd_lvm_thlvcreate (const gchar *vg_name, const gchar *pool_name, const
     args[2] = g_strdup_printf ("%s/%s", vg_name, pool_name);
     args[4] = g_strdup_printf ("%"G_GUINT64_FORMAT"K", size / 1024);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[2]);
     g_free ((gchar *) args[4]);
 
@@ -2499,6 +2673,93 @@ gchar* bd_lvm_thlvpoolname (const gchar *vg_name, const gchar *lv_name, GError *
     return g_strstrip (output);
 }
 
+/**
+ * bd_lvm_thpool_space_usage:
+ * @vg_name: name of the VG containing the @pool_name thin pool
+ * @pool_name: name of the (active) thin pool
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Gets the number of mapped, exclusive and shared data blocks of all the thin
+ * devices in the @vg_name/@pool_name thin pool. Unlike the data_percent of a
+ * thin LV, the exclusive blocks tell how much space would be freed by removing
+ * the thin LV when it shares blocks with its snapshots (or origin).
+ *
+ * The numbers are read from a metadata snapshot taken (and released again) for
+ * the query so the live pool is not suspended. Requires the thin_ls utility.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): space usage of the thin devices
+ *                                                    in the pool or %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMThinSpaceUsage** bd_lvm_thpool_space_usage (const gchar *vg_name, const gchar *pool_name, GError **error) {
+    const gchar *args[7] = {"lvs", "--noheadings", "--separator=:", "-o", LVM_THIN_LVS_FIELDS, vg_name, NULL};
+    g_autofree gchar *output = NULL;
+    GHashTable *thin_lvs = NULL;
+    BDLVMThinSpaceUsage **ret = NULL;
+
+    if (!check_deps (&avail_deps, DEPS_THINLS_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return NULL;
+
+    if (!call_lvm_and_capture_output (args, NULL, &output, error))
+        return NULL;
+
+    thin_lvs = lvm_thin_parse_lvs (output, pool_name);
+    ret = lvm_thpool_space_usage (vg_name, pool_name, thin_lvs, error);
+    g_hash_table_destroy (thin_lvs);
+
+    return ret;
+}
+
+/**
+ * bd_lvm_thin_delta:
+ * @vg_name: name of the VG containing the thin LVs
+ * @lv_name1: name of the first (older) thin LV, e.g. the snapshot of the last backup
+ * @lv_name2: name of the second (newer) thin LV from the same pool, e.g. the
+ *            snapshot for the current backup
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Compares the block mappings of two thin LVs from the same (active) thin pool
+ * and returns the ranges where they differ -- the only parts of @lv_name2 an
+ * incremental backup needs to read (or discard for the %BD_LVM_THIN_DELTA_LEFT_ONLY
+ * ranges). Ranges mapped to the same blocks in both thin LVs are not reported.
+ *
+ * The mappings are read from a metadata snapshot taken (and released again) for
+ * the query so the live pool is not suspended. Requires the thin_delta utility.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): ranges (ordered by offset) in which
+ *                                                    @lv_name1 and @lv_name2 differ or
+ *                                                    %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMThinDeltaRange** bd_lvm_thin_delta (const gchar *vg_name, const gchar *lv_name1, const gchar *lv_name2, GError **error) {
+    const gchar *args[7] = {"lvs", "--noheadings", "--separator=:", "-o", LVM_THIN_LVS_FIELDS, vg_name, NULL};
+    g_autofree gchar *output = NULL;
+    g_autofree gchar *pool_name1 = NULL;
+    g_autofree gchar *pool_name2 = NULL;
+    guint64 thin_id1 = 0;
+    guint64 thin_id2 = 0;
+
+    if (!check_deps (&avail_deps, DEPS_THINDELTA_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return NULL;
+
+    if (!call_lvm_and_capture_output (args, NULL, &output, error))
+        return NULL;
+
+    if (!lvm_thin_lv_id (output, vg_name, lv_name1, &thin_id1, &pool_name1, error) ||
+        !lvm_thin_lv_id (output, vg_name, lv_name2, &thin_id2, &pool_name2, error))
+        return NULL;
+
+    if (g_strcmp0 (pool_name1, pool_name2) != 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Thin LVs '%s' and '%s' are not in the same thin pool", lv_name1, lv_name2);
+        return NULL;
+    }
+
+    return lvm_thin_delta (vg_name, pool_name1, thin_id1, thin_id2, error);
+}
+
 /**
  * bd_lvm_thsnapshotcreate:
  * @vg_name: name of the VG containing the thin LV a new snapshot should be created of
@@ -2528,7 +2789,7 @@ gboolean bd_lvm_thsnapshotcreate (const gchar *vg_name, const gchar *origin_name
 
     args[next_arg] = g_strdup_printf ("%s/%s", vg_name, origin_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[next_arg]);
 
     return success;
@@ -2545,7 +2806,8 @@ gboolean bd_lvm_thsnapshotcreate (const gchar *vg_name, const gchar *origin_name
  *       in libblockdev, it doesn't change the global lvm.conf config file.
  *       Calling this function with `backup {backup=0 archive=0}` for example
  *       means `--config=backup {backup=0 archive=0}"` will be added to all
- *       calls libblockdev makes.
+ *       calls libblockdev makes. A config set with bd_context_set_lvm_config()
+ *       on the thread's #BDContext takes precedence.
  *
  * Returns: whether the new requested global config @new_config was successfully
  *          set or not
@@ -2820,7 +3082,7 @@ gboolean bd_lvm_cache_create_pool (const gchar *vg_name, const gchar *pool_name,
     }
     name = g_strdup_printf ("%s/%s", vg_name, pool_name);
     args[8] = name;
-    success = call_lvm_and_report_error (args, NULL, TRUE, &l_error);
+    success = call_lvm_and_report_error (args, NULL, NULL, &l_error);
     g_free ((gchar *) args[5]);
     g_free ((gchar *) args[8]);
 
@@ -2858,7 +3120,7 @@ gboolean bd_lvm_cache_attach (const gchar *vg_name, const gchar *data_lv, const
 
     args[5] = g_strdup_printf ("%s/%s", vg_name, cache_pool_lv);
     args[6] = g_strdup_printf ("%s/%s", vg_name, data_lv);
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
 
     g_free ((gchar *) args[5]);
     g_free ((gchar *) args[6]);
@@ -2888,7 +3150,7 @@ gboolean bd_lvm_cache_detach (const gchar *vg_name, const gchar *cached_lv, gboo
 
     args[3] = destroy ? "--uncache" : "--splitcache";
     args[4] = g_strdup_printf ("%s/%s", vg_name, cached_lv);
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
 
     g_free ((gchar *) args[4]);
     return success;
@@ -2990,7 +3252,7 @@ gboolean bd_lvm_writecache_attach (const gchar *vg_name, const gchar *data_lv, c
 
     args[5] = g_strdup_printf ("%s/%s", vg_name, cache_lv);
     args[6] = g_strdup_printf ("%s/%s", vg_name, data_lv);
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
 
     g_free ((gchar *) args[5]);
     g_free ((gchar *) args[6]);
@@ -3081,6 +3343,71 @@ gboolean bd_lvm_writecache_create_cached_lv (const gchar *vg_name, const gchar *
     return TRUE;
 }
 
+/**
+ * bd_lvm_writecache_get_settings:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached LV to get the writecache settings for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): current settings of the active writecache of @cached_lv
+ *                           or %NULL in case of error
+ *
+ * Note: The settings are read directly from the active DM writecache target, no
+ *       LVM command is run. Settings not explicitly set for the target (kernel
+ *       defaults) are reported as unset.
+ *
+ * Tech category: %BD_LVM_TECH_WRITECACHE-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMWritecacheSettings* bd_lvm_writecache_get_settings (const gchar *vg_name, const gchar *cached_lv, GError **error) {
+    return lvm_writecache_get_settings (vg_name, cached_lv, error);
+}
+
+/**
+ * bd_lvm_writecache_set_settings:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached LV to change the writecache settings for
+ * @settings: settings to set (unset settings are left untouched)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the settings were successfully changed or not
+ *
+ * Note: The dm-writecache target has no messages for changing its settings so
+ *       the settings are always stored in the LVM metadata and LVM reloads the
+ *       active target with them.
+ *
+ * Tech category: %BD_LVM_TECH_WRITECACHE-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_writecache_set_settings (const gchar *vg_name, const gchar *cached_lv, const BDLVMWritecacheSettings *settings, GError **error) {
+    const gchar *args[5] = {"lvchange", "--cachesettings", NULL, NULL, NULL};
+    g_autofree gchar *cache_settings = NULL;
+    g_autofree gchar *lv_spec = NULL;
+
+    cache_settings = lvm_writecache_settings_str (settings);
+
+    /* nothing to change */
+    if (!cache_settings)
+        return TRUE;
+
+    lv_spec = g_strdup_printf ("%s/%s", vg_name, cached_lv);
+    args[2] = cache_settings;
+    args[3] = lv_spec;
+
+    return call_lvm_and_report_error (args, NULL, NULL, error);
+}
+
+/**
+ * bd_lvm_writecache_settings_to_extra:
+ * @settings: writecache settings to convert
+ *
+ * Returns: (transfer full) (array zero-terminated=1): extra arguments for
+ *          bd_lvm_writecache_attach() applying @settings when creating the cache
+ *
+ * Tech category: %BD_LVM_TECH_WRITECACHE no mode (it is ignored)
+ */
+BDExtraArg** bd_lvm_writecache_settings_to_extra (const BDLVMWritecacheSettings *settings) {
+    return lvm_writecache_settings_extra_args (settings);
+}
+
 /**
  * bd_lvm_cache_pool_name:
  * @vg_name: name of the VG containing the @cached_lv
@@ -3252,6 +3579,90 @@ BDLVMCacheStats* bd_lvm_cache_stats (const gchar *vg_name, const gchar *cached_l
     return ret;
 }
 
+/**
+ * bd_lvm_cache_get_settings:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached LV to get the cache settings for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): current settings of the active cache of @cached_lv
+ *                           or %NULL in case of error
+ *
+ * Note: The settings are read directly from the active DM cache target, no LVM
+ *       command is run. For cached thin pools use the data LV of the pool
+ *       (e.g. "pool_tdata") as @cached_lv.
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMCacheSettings* bd_lvm_cache_get_settings (const gchar *vg_name, const gchar *cached_lv, GError **error) {
+    return lvm_cache_get_settings (vg_name, cached_lv, error);
+}
+
+/**
+ * bd_lvm_cache_set_settings:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached LV to change the cache settings for
+ * @settings: settings to set (unset settings are left untouched)
+ * @persistent: whether to store the settings in the LVM metadata or only change
+ *              them in the active DM cache target
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the settings were successfully changed or not
+ *
+ * Note: With @persistent set to %FALSE, the migration threshold is changed by
+ *       sending a message to the active DM cache target and the change is lost
+ *       when the LV is deactivated. Changing the cache policy requires a table
+ *       reload and is therefore only possible with @persistent set to %TRUE.
+ *       The chunk size of an existing cache cannot be changed at all.
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_cache_set_settings (const gchar *vg_name, const gchar *cached_lv, const BDLVMCacheSettings *settings, gboolean persistent, GError **error) {
+    const gchar *args[7] = {"lvchange", NULL, NULL, NULL, NULL, NULL, NULL};
+    guint next_arg = 1;
+    g_autofree gchar *cache_settings = NULL;
+    g_autofree gchar *lv_spec = NULL;
+
+    if (!lvm_cache_check_settings (vg_name, cached_lv, settings, persistent, error))
+        return FALSE;
+
+    if (!persistent)
+        return lvm_cache_set_dm_settings (vg_name, cached_lv, settings, error);
+
+    if (settings->policy) {
+        args[next_arg++] = "--cachepolicy";
+        args[next_arg++] = settings->policy;
+    }
+
+    cache_settings = lvm_cache_settings_str (settings);
+    if (cache_settings) {
+        args[next_arg++] = "--cachesettings";
+        args[next_arg++] = cache_settings;
+    }
+
+    /* nothing to change */
+    if (next_arg == 1)
+        return TRUE;
+
+    lv_spec = g_strdup_printf ("%s/%s", vg_name, cached_lv);
+    args[next_arg++] = lv_spec;
+
+    return call_lvm_and_report_error (args, NULL, NULL, error);
+}
+
+/**
+ * bd_lvm_cache_settings_to_extra:
+ * @settings: cache settings to convert
+ *
+ * Returns: (transfer full) (array zero-terminated=1): extra arguments for
+ *          bd_lvm_cache_attach() applying @settings when creating the cache
+ *
+ * Tech category: %BD_LVM_TECH_CACHE no mode (it is ignored)
+ */
+BDExtraArg** bd_lvm_cache_settings_to_extra (const BDLVMCacheSettings *settings) {
+    return lvm_cache_settings_extra_args (settings);
+}
+
 /**
  * bd_lvm_thpool_convert:
  * @vg_name: name of the VG to create the new thin pool in
@@ -3276,7 +3687,7 @@ gboolean bd_lvm_thpool_convert (const gchar *vg_name, const gchar *data_lv, cons
 
     args[6] = g_strdup_printf ("%s/%s", vg_name, data_lv);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[6]);
 
     if (success && name)
@@ -3309,7 +3720,7 @@ gboolean bd_lvm_cache_pool_convert (const gchar *vg_name, const gchar *data_lv,
 
     args[6] = g_strdup_printf ("%s/%s", vg_name, data_lv);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[6]);
 
     if (success && name)
@@ -3343,7 +3754,7 @@ gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, con
                              "--deduplication", deduplication ? "y" : "n",
                              "-y", NULL, NULL};
     gboolean success = FALSE;
-    gchar *old_config = NULL;
+    gchar *vdo_config = NULL;
     const gchar *write_policy_str = NULL;
 
     write_policy_str = bd_lvm_get_vdo_write_policy_str (write_policy, error);
@@ -3359,21 +3770,14 @@ gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, con
         args[14] = vg_name;
 
     /* index_memory and write_policy can be specified only using the config */
-    g_mutex_lock (&global_config_lock);
-    old_config = global_config_str;
     if (index_memory != 0)
-        global_config_str = g_strdup_printf ("%s allocation {vdo_index_memory_size_mb=%"G_GUINT64_FORMAT" vdo_write_policy=\"%s\"}", old_config ? old_config : "",
-                                                                                                                                     index_memory / (1024 * 1024),
-                                                                                                                                     write_policy_str);
+        vdo_config = g_strdup_printf ("allocation {vdo_index_memory_size_mb=%"G_GUINT64_FORMAT" vdo_write_policy=\"%s\"}",
+                                      index_memory / (1024 * 1024), write_policy_str);
     else
-        global_config_str = g_strdup_printf ("%s allocation {vdo_write_policy=\"%s\"}", old_config ? old_config : "",
-                                                                                        write_policy_str);
+        vdo_config = g_strdup_printf ("allocation {vdo_write_policy=\"%s\"}", write_policy_str);
 
-    success = call_lvm_and_report_error (args, extra, FALSE, error);
-
-    g_free (global_config_str);
-    global_config_str = old_config;
-    g_mutex_unlock (&global_config_lock);
+    success = call_lvm_and_report_error (args, extra, vdo_config, error);
+    g_free (vdo_config);
 
     g_free ((gchar *) args[6]);
     g_free ((gchar *) args[8]);
@@ -3390,7 +3794,7 @@ static gboolean _vdo_set_compression_deduplication (const gchar *vg_name, const
 
     args[3] = g_strdup_printf ("%s/%s", vg_name, pool_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[3]);
 
     return success;
@@ -3598,7 +4002,7 @@ gboolean bd_lvm_vdo_pool_convert (const gchar *vg_name, const gchar *pool_lv, co
     guint next_arg = 4;
     gchar *size_str = NULL;
     gchar *lv_spec = NULL;
-    gchar *old_config = NULL;
+    gchar *vdo_config = NULL;
     const gchar *write_policy_str = NULL;
 
     write_policy_str = bd_lvm_get_vdo_write_policy_str (write_policy, error);
@@ -3617,21 +4021,14 @@ gboolean bd_lvm_vdo_pool_convert (const gchar *vg_name, const gchar *pool_lv, co
     args[next_arg++] = lv_spec;
 
     /* index_memory and write_policy can be specified only using the config */
-    g_mutex_lock (&global_config_lock);
-    old_config = global_config_str;
     if (index_memory != 0)
-        global_config_str = g_strdup_printf ("%s allocation {vdo_index_memory_size_mb=%"G_GUINT64_FORMAT" vdo_write_policy=\"%s\"}", old_config ? old_config : "",
-                                                                                                                                     index_memory / (1024 * 1024),
-                                                                                                                                     write_policy_str);
+        vdo_config = g_strdup_printf ("allocation {vdo_index_memory_size_mb=%"G_GUINT64_FORMAT" vdo_write_policy=\"%s\"}",
+                                      index_memory / (1024 * 1024), write_policy_str);
     else
-        global_config_str = g_strdup_printf ("%s allocation {vdo_write_policy=\"%s\"}", old_config ? old_config : "",
-                                                                                        write_policy_str);
+        vdo_config = g_strdup_printf ("allocation {vdo_write_policy=\"%s\"}", write_policy_str);
 
-    success = call_lvm_and_report_error (args, extra, FALSE, error);
-
-    g_free (global_config_str);
-    global_config_str = old_config;
-    g_mutex_unlock (&global_config_lock);
+    success = call_lvm_and_report_error (args, extra, vdo_config, error);
+    g_free (vdo_config);
 
     g_free (size_str);
     g_free (lv_spec);
@@ -188,6 +188,56 @@ typedef struct BDLVMCacheStats {
 void bd_lvm_cache_stats_free (BDLVMCacheStats *data);
 BDLVMCacheStats* bd_lvm_cache_stats_copy (BDLVMCacheStats *data);
 
+typedef struct BDLVMCacheSettings {
+    gchar *policy;
+    gint64 migration_threshold;
+    guint64 chunk_size;
+} BDLVMCacheSettings;
+
+void bd_lvm_cache_settings_free (BDLVMCacheSettings *settings);
+BDLVMCacheSettings* bd_lvm_cache_settings_copy (BDLVMCacheSettings *settings);
+BDLVMCacheSettings* bd_lvm_cache_settings_new (void);
+
+typedef struct BDLVMWritecacheSettings {
+    gint64 high_watermark;
+    gint64 low_watermark;
+    gint64 writeback_jobs;
+    gint64 autocommit_blocks;
+    gint64 autocommit_time;
+    gint64 pause_writeback;
+} BDLVMWritecacheSettings;
+
+void bd_lvm_writecache_settings_free (BDLVMWritecacheSettings *settings);
+BDLVMWritecacheSettings* bd_lvm_writecache_settings_copy (BDLVMWritecacheSettings *settings);
+BDLVMWritecacheSettings* bd_lvm_writecache_settings_new (void);
+
+typedef struct BDLVMThinSpaceUsage {
+    gchar *lv_name;
+    guint64 thin_id;
+    guint64 mapped_blocks;
+    guint64 exclusive_blocks;
+    guint64 shared_blocks;
+    guint64 block_size;
+} BDLVMThinSpaceUsage;
+
+void bd_lvm_thin_space_usage_free (BDLVMThinSpaceUsage *usage);
+BDLVMThinSpaceUsage* bd_lvm_thin_space_usage_copy (BDLVMThinSpaceUsage *usage);
+
+typedef enum {
+    BD_LVM_THIN_DELTA_DIFFERENT,
+    BD_LVM_THIN_DELTA_LEFT_ONLY,
+    BD_LVM_THIN_DELTA_RIGHT_ONLY,
+} BDLVMThinDeltaType;
+
+typedef struct BDLVMThinDeltaRange {
+    guint64 offset;
+    guint64 length;
+    BDLVMThinDeltaType type;
+} BDLVMThinDeltaRange;
+
+void bd_lvm_thin_delta_range_free (BDLVMThinDeltaRange *range);
+BDLVMThinDeltaRange* bd_lvm_thin_delta_range_copy (BDLVMThinDeltaRange *range);
+
 typedef enum {
     BD_LVM_TECH_BASIC = 0,
     BD_LVM_TECH_BASIC_SNAP,
@@ -260,6 +310,8 @@ BDLVMVGdata** bd_lvm_vgs (GError **error);
 
 gchar* bd_lvm_lvorigin (const gchar *vg_name, const gchar *lv_name, GError **error);
 gboolean bd_lvm_lvcreate (const gchar *vg_name, const gchar *lv_name, guint64 size, const gchar *type, const gchar **pv_list, const BDExtraArg **extra, GError **error);
+gchar** bd_lvm_select_pvs (const gchar *vg_name, guint64 size, const gchar *type, guint n_pvs, GError **error);
+gboolean bd_lvm_lvcreate_spread (const gchar *vg_name, const gchar *lv_name, guint64 size, const gchar *type, guint n_pvs, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_lvremove (const gchar *vg_name, const gchar *lv_name, gboolean force, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_lvrename (const gchar *vg_name, const gchar *lv_name, const gchar *new_name, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_lvresize (const gchar *vg_name, const gchar *lv_name, guint64 size, const BDExtraArg **extra, GError **error);
@@ -278,6 +330,8 @@ BDLVMLVdata** bd_lvm_lvs_tree (const gchar *vg_name, GError **error);
 gboolean bd_lvm_thpoolcreate (const gchar *vg_name, const gchar *lv_name, guint64 size, guint64 md_size, guint64 chunk_size, const gchar *profile, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_thlvcreate (const gchar *vg_name, const gchar *pool_name, const gchar *lv_name, guint64 size, const BDExtraArg **extra, GError **error);
 gchar* bd_lvm_thlvpoolname (const gchar *vg_name, const gchar *lv_name, GError **error);
+BDLVMThinSpaceUsage** bd_lvm_thpool_space_usage (const gchar *vg_name, const gchar *pool_name, GError **error);
+BDLVMThinDeltaRange** bd_lvm_thin_delta (const gchar *vg_name, const gchar *lv_name1, const gchar *lv_name2, GError **error);
 gboolean bd_lvm_thsnapshotcreate (const gchar *vg_name, const gchar *origin_name, const gchar *snapshot_name, const gchar *pool_name, const BDExtraArg **extra, GError **error);
 
 gboolean bd_lvm_set_global_config (const gchar *new_config, GError **error);
@@ -296,10 +350,16 @@ gboolean bd_lvm_cache_create_cached_lv (const gchar *vg_name, const gchar *lv_na
                                         const gchar **slow_pvs, const gchar **fast_pvs, GError **error);
 gchar* bd_lvm_cache_pool_name (const gchar *vg_name, const gchar *cached_lv, GError **error);
 BDLVMCacheStats* bd_lvm_cache_stats (const gchar *vg_name, const gchar *cached_lv, GError **error);
+BDLVMCacheSettings* bd_lvm_cache_get_settings (const gchar *vg_name, const gchar *cached_lv, GError **error);
+gboolean bd_lvm_cache_set_settings (const gchar *vg_name, const gchar *cached_lv, const BDLVMCacheSettings *settings, gboolean persistent, GError **error);
+BDExtraArg** bd_lvm_cache_settings_to_extra (const BDLVMCacheSettings *settings);
 
 gboolean bd_lvm_writecache_attach (const gchar *vg_name, const gchar *data_lv, const gchar *cache_lv, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_writecache_detach (const gchar *vg_name, const gchar *cached_lv, gboolean destroy, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_writecache_create_cached_lv (const gchar *vg_name, const gchar *lv_name, guint64 data_size, guint64 cache_size, const gchar **slow_pvs, const gchar **fast_pvs, GError **error);
+BDLVMWritecacheSettings* bd_lvm_writecache_get_settings (const gchar *vg_name, const gchar *cached_lv, GError **error);
+gboolean bd_lvm_writecache_set_settings (const gchar *vg_name, const gchar *cached_lv, const BDLVMWritecacheSettings *settings, GError **error);
+BDExtraArg** bd_lvm_writecache_settings_to_extra (const BDLVMWritecacheSettings *settings);
 
 gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, const gchar *pool_name, guint64 data_size, guint64 virtual_size, guint64 index_memory, gboolean compression, gboolean deduplication, BDLVMVDOWritePolicy write_policy, const BDExtraArg **extra, GError **error);
 BDLVMVDOPooldata *bd_lvm_vdo_info (const gchar *vg_name, const gchar *lv_name, GError **error);
@@ -0,0 +1,401 @@
+/*
+ * Copyright (C) 2024  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <unistd.h>
+#include <libdevmapper.h>
+#include <blockdev/utils.h>
+
+#include "lvm_cache.h"
+#include "lvm.h"
+
+#define SECTOR_SIZE 512
+
+#define WRITECACHE_SETTING(name) {#name, G_STRUCT_OFFSET (BDLVMWritecacheSettings, name)}
+
+/* dm-writecache optional arguments we have a field for, the names are the same for
+   the DM table and the LVM --cachesettings option */
+static const struct {
+    const gchar *name;
+    glong offset;
+} writecache_settings[] = {
+    WRITECACHE_SETTING (high_watermark),
+    WRITECACHE_SETTING (low_watermark),
+    WRITECACHE_SETTING (writeback_jobs),
+    WRITECACHE_SETTING (autocommit_blocks),
+    WRITECACHE_SETTING (autocommit_time),
+    WRITECACHE_SETTING (pause_writeback),
+};
+
+/* other dm-writecache optional arguments that take a value, everything else is a flag */
+static const gchar *const writecache_valued_args[] = {"start_sector", "max_age", NULL};
+
+static gchar* get_map_name (const gchar *vg_name, const gchar *lv_name) {
+    struct dm_pool *pool = NULL;
+    gchar *ret = NULL;
+
+    pool = dm_pool_create ("bd-pool", 20);
+    ret = g_strdup (dm_build_dm_name (pool, vg_name, lv_name, NULL));
+    dm_pool_destroy (pool);
+
+    return ret;
+}
+
+/**
+ * get_target_params: (skip)
+ * @vg_name: name of the VG containing the @lv_name LV
+ * @lv_name: name of the LV to get the DM target params for
+ * @task_type: DM task to run (%DM_DEVICE_STATUS or %DM_DEVICE_TABLE)
+ * @target_type: expected type of the DM target
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): the status or table params of the (first) target of
+ *                           the DM map of @vg_name/@lv_name or %NULL in case of error
+ */
+static gchar* get_target_params (const gchar *vg_name, const gchar *lv_name, int task_type, const gchar *target_type, GError **error) {
+    struct dm_task *task = NULL;
+    struct dm_info info;
+    g_autofree gchar *map_name = NULL;
+    guint64 start = 0;
+    guint64 length = 0;
+    gchar *type = NULL;
+    gchar *params = NULL;
+    gchar *ret = NULL;
+
+    if (geteuid () != 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOT_ROOT,
+                     "Not running as root, cannot query DM maps");
+        return NULL;
+    }
+
+    map_name = get_map_name (vg_name, lv_name);
+
+    task = dm_task_create (task_type);
+    if (!task) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to create DM task for the map '%s'", map_name);
+        return NULL;
+    }
+
+    if (dm_task_set_name (task, map_name) == 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to create DM task for the map '%s'", map_name);
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    if (dm_task_run (task) == 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to run the DM task for the map '%s'", map_name);
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    if (dm_task_get_info (task, &info) == 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to get task info for the map '%s'", map_name);
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    if (!info.exists) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_NOCACHE,
+                     "The map '%s' doesn't exist", map_name);
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    dm_get_next_target (task, NULL, &start, &length, &type, &params);
+    if (g_strcmp0 (type, target_type) != 0 || !params) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_NOCACHE,
+                     "The map '%s' is not a %s map", map_name, target_type);
+        dm_task_destroy (task);
+        return NULL;
+    }
+
+    ret = g_strdup (params);
+    dm_task_destroy (task);
+
+    return ret;
+}
+
+static gboolean send_target_message (const gchar *vg_name, const gchar *lv_name, const gchar *message, GError **error) {
+    struct dm_task *task = NULL;
+    g_autofree gchar *map_name = NULL;
+
+    map_name = get_map_name (vg_name, lv_name);
+
+    task = dm_task_create (DM_DEVICE_TARGET_MSG);
+    if (!task) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to create DM task for the map '%s'", map_name);
+        return FALSE;
+    }
+
+    if (dm_task_set_name (task, map_name) == 0 || dm_task_set_sector (task, 0) == 0 ||
+        dm_task_set_message (task, message) == 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to create DM task for the map '%s'", map_name);
+        dm_task_destroy (task);
+        return FALSE;
+    }
+
+    if (dm_task_run (task) == 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to send the message '%s' to the map '%s'", message, map_name);
+        dm_task_destroy (task);
+        return FALSE;
+    }
+
+    dm_task_destroy (task);
+    return TRUE;
+}
+
+/**
+ * lvm_cache_get_settings: (skip)
+ *
+ * Returns: (transfer full): settings of the active dm-cache target of @vg_name/@lv_name
+ *                           taken from its status
+ */
+G_GNUC_INTERNAL BDLVMCacheSettings*
+lvm_cache_get_settings (const gchar *vg_name, const gchar *lv_name, GError **error) {
+    struct dm_pool *pool = NULL;
+    struct dm_status_cache *status = NULL;
+    g_autofree gchar *params = NULL;
+    BDLVMCacheSettings *ret = NULL;
+    int i = 0;
+
+    params = get_target_params (vg_name, lv_name, DM_DEVICE_STATUS, "cache", error);
+    if (!params)
+        return NULL;
+
+    pool = dm_pool_create ("bd-pool", 20);
+    if (dm_get_status_cache (pool, params, &status) == 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
+                     "Failed to get status of the cache map for '%s/%s'", vg_name, lv_name);
+        dm_pool_destroy (pool);
+        return NULL;
+    }
+
+    ret = bd_lvm_cache_settings_new ();
+    ret->policy = g_strdup (status->policy_name);
+    ret->chunk_size = status->block_size * SECTOR_SIZE;
+
+    /* core arguments are key-value pairs */
+    for (i = 0; i + 1 < status->core_argc; i += 2)
+        if (g_strcmp0 (status->core_argv[i], "migration_threshold") == 0)
+            ret->migration_threshold = g_ascii_strtoll (status->core_argv[i + 1], NULL, 10);
+
+    dm_pool_destroy (pool);
+
+    return ret;
+}
+
+/**
+ * lvm_cache_check_settings: (skip)
+ *
+ * Returns: whether @settings can be applied to the active dm-cache target of
+ *          @vg_name/@lv_name or not
+ */
+G_GNUC_INTERNAL gboolean
+lvm_cache_check_settings (const gchar *vg_name, const gchar *lv_name, const BDLVMCacheSettings *settings, gboolean persistent, GError **error) {
+    BDLVMCacheSettings *current = NULL;
+    gboolean ret = TRUE;
+
+    current = lvm_cache_get_settings (vg_name, lv_name, error);
+    if (!current)
+        return FALSE;
+
+    if (settings->chunk_size != 0 && settings->chunk_size != current->chunk_size) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOT_SUPPORTED,
+                     "Chunk size of an existing cache cannot be changed");
+        ret = FALSE;
+    } else if (!persistent && settings->policy && g_strcmp0 (settings->policy, current->policy) != 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOT_SUPPORTED,
+                     "Cache policy can only be changed persistently");
+        ret = FALSE;
+    }
+
+    bd_lvm_cache_settings_free (current);
+
+    return ret;
+}
+
+/**
+ * lvm_cache_set_dm_settings: (skip)
+ *
+ * Changes the tunables from @settings in the active dm-cache target of
+ * @vg_name/@lv_name using DM messages.
+ */
+G_GNUC_INTERNAL gboolean
+lvm_cache_set_dm_settings (const gchar *vg_name, const gchar *lv_name, const BDLVMCacheSettings *settings, GError **error) {
+    g_autofree gchar *msg = NULL;
+
+    if (settings->migration_threshold < 0)
+        return TRUE;
+
+    msg = g_strdup_printf ("migration_threshold %"G_GINT64_FORMAT, settings->migration_threshold);
+    return send_target_message (vg_name, lv_name, msg, error);
+}
+
+/**
+ * lvm_cache_settings_str: (skip)
+ *
+ * Returns: (transfer full): value for the LVM --cachesettings option for @settings
+ *                           or %NULL if there is nothing to set
+ */
+G_GNUC_INTERNAL gchar*
+lvm_cache_settings_str (const BDLVMCacheSettings *settings) {
+    if (settings->migration_threshold < 0)
+        return NULL;
+
+    return g_strdup_printf ("migration_threshold=%"G_GINT64_FORMAT, settings->migration_threshold);
+}
+
+/**
+ * lvm_cache_settings_extra_args: (skip)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): LVM options for @settings
+ */
+G_GNUC_INTERNAL BDExtraArg**
+lvm_cache_settings_extra_args (const BDLVMCacheSettings *settings) {
+    GPtrArray *args = NULL;
+    gchar *val = NULL;
+
+    args = g_ptr_array_new ();
+
+    if (settings->policy)
+        g_ptr_array_add (args, bd_extra_arg_new ("--cachepolicy", settings->policy));
+
+    val = lvm_cache_settings_str (settings);
+    if (val) {
+        g_ptr_array_add (args, bd_extra_arg_new ("--cachesettings", val));
+        g_free (val);
+    }
+
+    if (settings->chunk_size != 0) {
+        val = g_strdup_printf ("%"G_GUINT64_FORMAT"K", settings->chunk_size / 1024);
+        g_ptr_array_add (args, bd_extra_arg_new ("--chunksize", val));
+        g_free (val);
+    }
+
+    g_ptr_array_add (args, NULL);
+    return (BDExtraArg **) g_ptr_array_free (args, FALSE);
+}
+
+/**
+ * lvm_writecache_get_settings: (skip)
+ *
+ * Returns: (transfer full): settings of the active dm-writecache target of
+ *                           @vg_name/@lv_name taken from its table
+ */
+G_GNUC_INTERNAL BDLVMWritecacheSettings*
+lvm_writecache_get_settings (const gchar *vg_name, const gchar *lv_name, GError **error) {
+    g_autofree gchar *params = NULL;
+    gchar **tokens = NULL;
+    BDLVMWritecacheSettings *ret = NULL;
+    guint n_tokens = 0;
+    guint64 n_args = 0;
+    guint i = 0;
+    guint j = 0;
+    gboolean known = FALSE;
+
+    params = get_target_params (vg_name, lv_name, DM_DEVICE_TABLE, "writecache", error);
+    if (!params)
+        return NULL;
+
+    /* <p|s> <origin> <cache> <block size> <#optional args> [<optional args>] */
+    tokens = g_strsplit (g_strstrip (params), " ", -1);
+    n_tokens = g_strv_length (tokens);
+    if (n_tokens >= 5)
+        n_args = g_ascii_strtoull (tokens[4], NULL, 10);
+    if (n_tokens < 5 || n_args > n_tokens - 5) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
+                     "Failed to parse the writecache table '%s'", params);
+        g_strfreev (tokens);
+        return NULL;
+    }
+
+    ret = bd_lvm_writecache_settings_new ();
+    for (i = 5; i < 5 + n_args; i++) {
+        known = FALSE;
+        for (j = 0; j < G_N_ELEMENTS (writecache_settings) && !known; j++) {
+            if (g_strcmp0 (tokens[i], writecache_settings[j].name) == 0 && i + 1 < 5 + n_args) {
+                G_STRUCT_MEMBER (gint64, ret, writecache_settings[j].offset) = g_ascii_strtoll (tokens[++i], NULL, 10);
+                known = TRUE;
+            }
+        }
+        /* skip values of the arguments we don't report */
+        if (!known && g_strv_contains (writecache_valued_args, tokens[i]))
+            i++;
+    }
+    g_strfreev (tokens);
+
+    return ret;
+}
+
+/**
+ * lvm_writecache_settings_str: (skip)
+ *
+ * Returns: (transfer full): value for the LVM --cachesettings option for @settings
+ *                           or %NULL if there is nothing to set
+ */
+G_GNUC_INTERNAL gchar*
+lvm_writecache_settings_str (const BDLVMWritecacheSettings *settings) {
+    GString *str = NULL;
+    gint64 value = 0;
+    guint i = 0;
+
+    str = g_string_new (NULL);
+    for (i = 0; i < G_N_ELEMENTS (writecache_settings); i++) {
+        value = G_STRUCT_MEMBER (gint64, settings, writecache_settings[i].offset);
+        if (value < 0)
+            continue;
+        g_string_append_printf (str, "%s%s=%"G_GINT64_FORMAT, str->len > 0 ? " " : "",
+                                writecache_settings[i].name, value);
+    }
+
+    if (str->len == 0) {
+        g_string_free (str, TRUE);
+        return NULL;
+    }
+
+    return g_string_free (str, FALSE);
+}
+
+/**
+ * lvm_writecache_settings_extra_args: (skip)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): LVM options for @settings
+ */
+G_GNUC_INTERNAL BDExtraArg**
+lvm_writecache_settings_extra_args (const BDLVMWritecacheSettings *settings) {
+    GPtrArray *args = NULL;
+    gchar *val = NULL;
+
+    args = g_ptr_array_new ();
+
+    val = lvm_writecache_settings_str (settings);
+    if (val) {
+        g_ptr_array_add (args, bd_extra_arg_new ("--cachesettings", val));
+        g_free (val);
+    }
+
+    g_ptr_array_add (args, NULL);
+    return (BDExtraArg **) g_ptr_array_free (args, FALSE);
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2024  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <blockdev/utils.h>
+
+#include "lvm.h"
+
+#ifndef BD_LVM_CACHE
+#define BD_LVM_CACHE
+
+BDLVMCacheSettings* lvm_cache_get_settings (const gchar *vg_name, const gchar *lv_name, GError **error);
+gboolean lvm_cache_check_settings (const gchar *vg_name, const gchar *lv_name, const BDLVMCacheSettings *settings, gboolean persistent, GError **error);
+gboolean lvm_cache_set_dm_settings (const gchar *vg_name, const gchar *lv_name, const BDLVMCacheSettings *settings, GError **error);
+gchar* lvm_cache_settings_str (const BDLVMCacheSettings *settings);
+BDExtraArg** lvm_cache_settings_extra_args (const BDLVMCacheSettings *settings);
+
+BDLVMWritecacheSettings* lvm_writecache_get_settings (const gchar *vg_name, const gchar *lv_name, GError **error);
+gchar* lvm_writecache_settings_str (const BDLVMWritecacheSettings *settings);
+BDExtraArg** lvm_writecache_settings_extra_args (const BDLVMWritecacheSettings *settings);
+
+#endif  /* BD_LVM_CACHE */
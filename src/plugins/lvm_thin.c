@@ -0,0 +1,428 @@
+/*
+ * Copyright (C) 2024  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <libdevmapper.h>
+#include <blockdev/utils.h>
+
+#include "lvm_thin.h"
+#include "lvm.h"
+
+#define SECTOR_SIZE 512
+
+/**
+ * get_pool_map: (skip)
+ * @vg_name: name of the VG containing the @pool_name thin pool
+ * @pool_name: name of the thin pool
+ * @map_name: (out): name of the DM map with the thin-pool target
+ * @block_size: (out): data block size of the pool (in bytes)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Finds the DM map with the thin-pool target of @vg_name/@pool_name -- it is the
+ * "-tpool" layer when the pool is used by active thin LVs and the pool LV itself
+ * otherwise.
+ */
+static gboolean get_pool_map (const gchar *vg_name, const gchar *pool_name, gchar **map_name, guint64 *block_size, GError **error) {
+    const gchar *layers[2] = {"tpool", NULL};
+    struct dm_pool *pool = NULL;
+    struct dm_task *task = NULL;
+    struct dm_info info;
+    guint64 start = 0;
+    guint64 length = 0;
+    gchar *type = NULL;
+    gchar *params = NULL;
+    gchar **fields = NULL;
+    gboolean found = FALSE;
+    guint i = 0;
+
+    pool = dm_pool_create ("bd-pool", 20);
+    for (i = 0; i < G_N_ELEMENTS (layers) && !found; i++) {
+        *map_name = g_strdup (dm_build_dm_name (pool, vg_name, pool_name, layers[i]));
+
+        task = dm_task_create (DM_DEVICE_TABLE);
+        if (!task) {
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                         "Failed to create DM task for the map '%s'", *map_name);
+            g_free (*map_name);
+            dm_pool_destroy (pool);
+            return FALSE;
+        }
+
+        if (dm_task_set_name (task, *map_name) != 0 && dm_task_run (task) != 0 &&
+            dm_task_get_info (task, &info) != 0 && info.exists) {
+            dm_get_next_target (task, NULL, &start, &length, &type, &params);
+            if (g_strcmp0 (type, "thin-pool") == 0 && params) {
+                /* <metadata dev> <data dev> <data block size> <low water mark> [<features>] */
+                fields = g_strsplit (params, " ", 4);
+                if (g_strv_length (fields) >= 3) {
+                    *block_size = g_ascii_strtoull (fields[2], NULL, 10) * SECTOR_SIZE;
+                    found = *block_size != 0;
+                }
+                g_strfreev (fields);
+            }
+        }
+
+        dm_task_destroy (task);
+        if (!found)
+            g_clear_pointer (map_name, g_free);
+    }
+    dm_pool_destroy (pool);
+
+    if (!found) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOEXIST,
+                     "Failed to find an active thin pool '%s/%s'", vg_name, pool_name);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean send_pool_message (const gchar *map_name, const gchar *message, GError **error) {
+    struct dm_task *task = NULL;
+
+    task = dm_task_create (DM_DEVICE_TARGET_MSG);
+    if (!task) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to create DM task for the map '%s'", map_name);
+        return FALSE;
+    }
+
+    if (dm_task_set_name (task, map_name) == 0 || dm_task_set_sector (task, 0) == 0 ||
+        dm_task_set_message (task, message) == 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to create DM task for the map '%s'", map_name);
+        dm_task_destroy (task);
+        return FALSE;
+    }
+
+    if (dm_task_run (task) == 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to send the message '%s' to the map '%s'", message, map_name);
+        dm_task_destroy (task);
+        return FALSE;
+    }
+
+    dm_task_destroy (task);
+    return TRUE;
+}
+
+/**
+ * lvm_thin_parse_lvs: (skip)
+ * @output: output of 'lvs --noheadings --separator=: -o LVM_THIN_LVS_FIELDS'
+ * @pool_name: name of the thin pool to get the thin LVs of
+ *
+ * Returns: (transfer full): a hash table with thin IDs (as strings) as keys and
+ *                           names of the thin LVs of @pool_name as values
+ */
+GHashTable* lvm_thin_parse_lvs (const gchar *output, const gchar *pool_name) {
+    GHashTable *ret = NULL;
+    gchar **lines = NULL;
+    gchar **line_p = NULL;
+    gchar **fields = NULL;
+
+    ret = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+    lines = g_strsplit (output, "\n", -1);
+    for (line_p = lines; *line_p; line_p++) {
+        fields = g_strsplit (g_strstrip (*line_p), ":", 3);
+        /* non-thin LVs have no thin ID */
+        if (g_strv_length (fields) == 3 && *fields[0] != '\0' && g_strcmp0 (fields[2], pool_name) == 0)
+            g_hash_table_insert (ret, g_strdup (fields[0]), g_strdup (fields[1]));
+        g_strfreev (fields);
+    }
+    g_strfreev (lines);
+
+    return ret;
+}
+
+/**
+ * run_on_metadata_snap: (skip)
+ * @vg_name: name of the VG containing the @pool_name thin pool
+ * @pool_name: name of the (active) thin pool
+ * @argv: thin-provisioning-tools command to run, the last item before %NULL
+ *        is left empty to be filled with the pool's metadata device
+ * @output: (out): place to store the output of the command
+ * @block_size: (out) (optional): place to store the data block size of the pool (in bytes)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Reserves a metadata snapshot on the pool, runs @argv (which is expected to read
+ * the snapshot, e.g. with "--metadata-snap") and releases the snapshot again. The
+ * snapshot only takes a consistent copy of the metadata root, the pool keeps
+ * serving I/O in the meantime.
+ */
+static gboolean run_on_metadata_snap (const gchar *vg_name, const gchar *pool_name, const gchar **argv, gchar **output, guint64 *block_size, GError **error) {
+    g_autofree gchar *map_name = NULL;
+    g_autofree gchar *meta_lv = NULL;
+    g_autofree gchar *meta_dev = NULL;
+    struct dm_pool *pool = NULL;
+    GError *l_error = NULL;
+    guint64 pool_block_size = 0;
+    gboolean success = FALSE;
+    guint argc = 0;
+
+    if (geteuid () != 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOT_ROOT,
+                     "Not running as root, cannot query thin pool metadata");
+        return FALSE;
+    }
+
+    if (!get_pool_map (vg_name, pool_name, &map_name, &pool_block_size, error))
+        return FALSE;
+    if (block_size)
+        *block_size = pool_block_size;
+
+    meta_lv = g_strdup_printf ("%s_tmeta", pool_name);
+    pool = dm_pool_create ("bd-pool", 20);
+    meta_dev = g_strdup_printf ("%s/%s", dm_dir (), dm_build_dm_name (pool, vg_name, meta_lv, NULL));
+    dm_pool_destroy (pool);
+
+    for (argc = 0; argv[argc + 1]; argc++);
+    argv[argc] = meta_dev;
+
+    if (!send_pool_message (map_name, "reserve_metadata_snap", error)) {
+        g_prefix_error (error, "Failed to reserve metadata snapshot (another one may be held already): ");
+        return FALSE;
+    }
+
+    success = bd_utils_exec_and_capture_output (argv, NULL, output, error);
+
+    /* the snapshot has to be released even if the command failed, a held snapshot
+       blocks others and keeps the old metadata blocks allocated */
+    if (!send_pool_message (map_name, "release_metadata_snap", &l_error)) {
+        if (success) {
+            g_propagate_error (error, l_error);
+            g_clear_pointer (output, g_free);
+            return FALSE;
+        }
+        bd_utils_log_format (BD_UTILS_LOG_WARNING, "%s", l_error->message);
+        g_clear_error (&l_error);
+    }
+
+    return success;
+}
+
+/**
+ * lvm_thpool_space_usage: (skip)
+ * @vg_name: name of the VG containing the @pool_name thin pool
+ * @pool_name: name of the (active) thin pool
+ * @thin_lvs: thin IDs and names of the pool's thin LVs, see lvm_thin_parse_lvs()
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Reads the space usage of the thin devices from a metadata snapshot with thin_ls.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): space usage of the thin devices
+ *                                                    in the pool or %NULL in case of error
+ */
+BDLVMThinSpaceUsage** lvm_thpool_space_usage (const gchar *vg_name, const gchar *pool_name, GHashTable *thin_lvs, GError **error) {
+    const gchar *argv[7] = {"thin_ls", "--metadata-snap", "--no-headers", "--format",
+                            "DEV,MAPPED_BLOCKS,EXCLUSIVE_BLOCKS,SHARED_BLOCKS", "", NULL};
+    g_autofree gchar *output = NULL;
+    g_autofree gchar *thin_id = NULL;
+    GPtrArray *ret = NULL;
+    BDLVMThinSpaceUsage *usage = NULL;
+    guint64 block_size = 0;
+    gchar *line = NULL;
+    gchar *next = NULL;
+
+    if (!run_on_metadata_snap (vg_name, pool_name, argv, &output, &block_size, error))
+        return NULL;
+
+    ret = g_ptr_array_new_with_free_func ((GDestroyNotify) bd_lvm_thin_space_usage_free);
+
+    /* one line per thin device: <dev id> <mapped> <exclusive> <shared> */
+    for (line = output; line && *line; line = next) {
+        next = strchr (line, '\n');
+        if (next)
+            *(next++) = '\0';
+        g_strstrip (line);
+        if (*line == '\0')
+            continue;
+
+        usage = g_new0 (BDLVMThinSpaceUsage, 1);
+        if (sscanf (line, "%"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT,
+                    &(usage->thin_id), &(usage->mapped_blocks), &(usage->exclusive_blocks), &(usage->shared_blocks)) != 4) {
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
+                         "Failed to parse thin device space usage from '%s'", line);
+            bd_lvm_thin_space_usage_free (usage);
+            g_ptr_array_free (ret, TRUE);
+            return NULL;
+        }
+        usage->block_size = block_size;
+
+        thin_id = g_strdup_printf ("%"G_GUINT64_FORMAT, usage->thin_id);
+        usage->lv_name = g_strdup (g_hash_table_lookup (thin_lvs, thin_id));
+        g_clear_pointer (&thin_id, g_free);
+
+        g_ptr_array_add (ret, usage);
+    }
+
+    g_ptr_array_set_free_func (ret, NULL);
+    g_ptr_array_add (ret, NULL);
+
+    return (BDLVMThinSpaceUsage **) g_ptr_array_free (ret, FALSE);
+}
+
+/**
+ * lvm_thin_lv_id: (skip)
+ * @output: output of 'lvs --noheadings --separator=: -o LVM_THIN_LVS_FIELDS'
+ * @vg_name: name of the VG the output is for
+ * @lv_name: name of the thin LV to find
+ * @thin_id: (out): place to store the thin ID of @lv_name
+ * @pool_name: (out): place to store the name of the pool of @lv_name
+ * @error: (out) (optional): place to store error (if any)
+ */
+gboolean lvm_thin_lv_id (const gchar *output, const gchar *vg_name, const gchar *lv_name, guint64 *thin_id, gchar **pool_name, GError **error) {
+    gchar **lines = NULL;
+    gchar **line_p = NULL;
+    gchar **fields = NULL;
+    gchar *endptr = NULL;
+    gboolean found = FALSE;
+
+    lines = g_strsplit (output, "\n", -1);
+    for (line_p = lines; *line_p && !found; line_p++) {
+        fields = g_strsplit (g_strstrip (*line_p), ":", 3);
+        if (g_strv_length (fields) == 3 && *fields[0] != '\0' && g_strcmp0 (fields[1], lv_name) == 0) {
+            *thin_id = g_ascii_strtoull (fields[0], &endptr, 10);
+            found = endptr != fields[0] && *endptr == '\0';
+            if (found)
+                *pool_name = g_strdup (fields[2]);
+        }
+        g_strfreev (fields);
+    }
+    g_strfreev (lines);
+
+    if (!found)
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOEXIST,
+                     "Failed to find thin LV '%s/%s'", vg_name, lv_name);
+
+    return found;
+}
+
+typedef struct ThinDeltaParseData {
+    GPtrArray *ranges;
+    guint64 block_size;
+} ThinDeltaParseData;
+
+static const gchar* get_attribute (const gchar **attribute_names, const gchar **attribute_values, const gchar *name) {
+    guint i = 0;
+
+    for (i = 0; attribute_names[i]; i++)
+        if (g_strcmp0 (attribute_names[i], name) == 0)
+            return attribute_values[i];
+
+    return NULL;
+}
+
+static void thin_delta_start_element (GMarkupParseContext *context G_GNUC_UNUSED, const gchar *element_name,
+                                      const gchar **attribute_names, const gchar **attribute_values,
+                                      gpointer user_data, GError **error) {
+    ThinDeltaParseData *data = (ThinDeltaParseData *) user_data;
+    BDLVMThinDeltaRange *range = NULL;
+    const gchar *begin = NULL;
+    const gchar *length = NULL;
+    const gchar *block_size = NULL;
+    BDLVMThinDeltaType type;
+
+    if (g_strcmp0 (element_name, "superblock") == 0) {
+        block_size = get_attribute (attribute_names, attribute_values, "data_block_size");
+        if (block_size)
+            /* in sectors */
+            data->block_size = g_ascii_strtoull (block_size, NULL, 10) * SECTOR_SIZE;
+        return;
+    }
+
+    if (g_strcmp0 (element_name, "different") == 0)
+        type = BD_LVM_THIN_DELTA_DIFFERENT;
+    else if (g_strcmp0 (element_name, "left_only") == 0)
+        type = BD_LVM_THIN_DELTA_LEFT_ONLY;
+    else if (g_strcmp0 (element_name, "right_only") == 0)
+        type = BD_LVM_THIN_DELTA_RIGHT_ONLY;
+    else
+        /* <diff>, <same> (only with --verbose) and anything new */
+        return;
+
+    begin = get_attribute (attribute_names, attribute_values, "begin");
+    length = get_attribute (attribute_names, attribute_values, "length");
+    if (!begin || !length || data->block_size == 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
+                     "Invalid <%s> element", element_name);
+        return;
+    }
+
+    range = g_new0 (BDLVMThinDeltaRange, 1);
+    range->offset = g_ascii_strtoull (begin, NULL, 10) * data->block_size;
+    range->length = g_ascii_strtoull (length, NULL, 10) * data->block_size;
+    range->type = type;
+    g_ptr_array_add (data->ranges, range);
+}
+
+/**
+ * lvm_thin_delta: (skip)
+ * @vg_name: name of the VG containing the thin LVs
+ * @pool_name: name of the (active) thin pool containing the thin LVs
+ * @thin_id1: thin ID of the first thin LV
+ * @thin_id2: thin ID of the second thin LV
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Reads the differences between the mappings of the two thin devices from
+ * a metadata snapshot with thin_delta.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): ranges in which the two thin
+ *                                                    devices differ or %NULL in case of error
+ */
+BDLVMThinDeltaRange** lvm_thin_delta (const gchar *vg_name, const gchar *pool_name, guint64 thin_id1, guint64 thin_id2, GError **error) {
+    const gchar *argv[8] = {"thin_delta", "--metadata-snap", "--snap1", NULL, "--snap2", NULL, "", NULL};
+    g_autofree gchar *snap1 = NULL;
+    g_autofree gchar *snap2 = NULL;
+    g_autofree gchar *output = NULL;
+    GMarkupParser parser = {thin_delta_start_element, NULL, NULL, NULL, NULL};
+    GMarkupParseContext *context = NULL;
+    ThinDeltaParseData data = {NULL, 0};
+    GError *l_error = NULL;
+    gboolean success = FALSE;
+
+    snap1 = g_strdup_printf ("%"G_GUINT64_FORMAT, thin_id1);
+    snap2 = g_strdup_printf ("%"G_GUINT64_FORMAT, thin_id2);
+    argv[3] = snap1;
+    argv[5] = snap2;
+
+    if (!run_on_metadata_snap (vg_name, pool_name, argv, &output, NULL, error))
+        return NULL;
+
+    /* only the ranges are needed, no need to build a tree of the XML */
+    data.ranges = g_ptr_array_new_with_free_func ((GDestroyNotify) bd_lvm_thin_delta_range_free);
+    context = g_markup_parse_context_new (&parser, 0, &data, NULL);
+    success = g_markup_parse_context_parse (context, output, -1, &l_error) &&
+              g_markup_parse_context_end_parse (context, &l_error);
+    g_markup_parse_context_free (context);
+
+    if (!success) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
+                     "Failed to parse thin_delta output: %s", l_error->message);
+        g_clear_error (&l_error);
+        g_ptr_array_free (data.ranges, TRUE);
+        return NULL;
+    }
+
+    g_ptr_array_set_free_func (data.ranges, NULL);
+    g_ptr_array_add (data.ranges, NULL);
+
+    return (BDLVMThinDeltaRange **) g_ptr_array_free (data.ranges, FALSE);
+}
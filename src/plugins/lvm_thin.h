@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2024  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <blockdev/utils.h>
+
+#include "lvm.h"
+
+#ifndef BD_LVM_THIN
+#define BD_LVM_THIN
+
+#define LVM_THIN_LVS_FIELDS "thin_id,lv_name,pool_lv"
+
+GHashTable* lvm_thin_parse_lvs (const gchar *output, const gchar *pool_name);
+BDLVMThinSpaceUsage** lvm_thpool_space_usage (const gchar *vg_name, const gchar *pool_name, GHashTable *thin_lvs, GError **error);
+gboolean lvm_thin_lv_id (const gchar *output, const gchar *vg_name, const gchar *lv_name, guint64 *thin_id, gchar **pool_name, GError **error);
+BDLVMThinDeltaRange** lvm_thin_delta (const gchar *vg_name, const gchar *pool_name, guint64 thin_id1, guint64 thin_id2, GError **error);
+
+#endif  /* BD_LVM_THIN */
@@ -0,0 +1,389 @@
+/*
+ * Copyright (C) 2024  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <blockdev/utils.h>
+
+#include "lvm_topology.h"
+#include "lvm.h"
+
+/* a PV together with the physical devices and controllers it lives on */
+typedef struct PVCandidate {
+    BDLVMPVdata *pv;
+    GPtrArray *disks;
+    GPtrArray *controllers;
+} PVCandidate;
+
+static void pv_candidate_free (PVCandidate *cand) {
+    g_ptr_array_free (cand->disks, TRUE);
+    g_ptr_array_free (cand->controllers, TRUE);
+    g_free (cand);
+}
+
+static void add_unique (GPtrArray *array, gchar *item) {
+    guint i = 0;
+
+    for (i = 0; i < array->len; i++)
+        if (g_strcmp0 (g_ptr_array_index (array, i), item) == 0) {
+            g_free (item);
+            return;
+        }
+    g_ptr_array_add (array, item);
+}
+
+static gboolean have_common_item (GPtrArray *array1, GPtrArray *array2) {
+    guint i = 0;
+    guint j = 0;
+
+    for (i = 0; i < array1->len; i++)
+        for (j = 0; j < array2->len; j++)
+            if (g_strcmp0 (g_ptr_array_index (array1, i), g_ptr_array_index (array2, j)) == 0)
+                return TRUE;
+
+    return FALSE;
+}
+
+/* whether @component is a PCI address like "0000:00:1f.2" */
+static gboolean is_pci_address (const gchar *component) {
+    return strlen (component) == 12 && component[4] == ':' && component[7] == ':' && component[10] == '.';
+}
+
+/**
+ * get_controller:
+ * @disk: kernel name of a whole disk
+ *
+ * Returns: (transfer full): sysfs path of the PCI device (HBA, NVMe controller,...)
+ *                           @disk is attached to or %NULL if not known (e.g. virtual devices)
+ */
+static gchar* get_controller (const gchar *disk) {
+    gchar *path = NULL;
+    gchar *real_path = NULL;
+    gchar **components = NULL;
+    gchar **comp_p = NULL;
+    gint last_pci = -1;
+    gchar *ret = NULL;
+
+    path = g_strdup_printf ("/sys/block/%s/device", disk);
+    real_path = realpath (path, NULL);
+    g_free (path);
+    if (!real_path)
+        return NULL;
+
+    components = g_strsplit (real_path, "/", -1);
+    free (real_path);
+    for (comp_p = components; *comp_p; comp_p++)
+        if (is_pci_address (*comp_p))
+            last_pci = comp_p - components;
+
+    if (last_pci >= 0) {
+        g_free (components[last_pci + 1]);
+        components[last_pci + 1] = NULL;
+        ret = g_strjoinv ("/", components);
+    }
+    g_strfreev (components);
+
+    return ret;
+}
+
+/* WWID of @disk so that multiple paths to the same device are recognized, or its name */
+static gchar* get_disk_id (const gchar *disk) {
+    gchar *path = NULL;
+    gchar *wwid = NULL;
+
+    path = g_strdup_printf ("/sys/block/%s/wwid", disk);
+    if (!g_file_get_contents (path, &wwid, NULL, NULL)) {
+        g_free (path);
+        path = g_strdup_printf ("/sys/block/%s/device/wwid", disk);
+        if (!g_file_get_contents (path, &wwid, NULL, NULL))
+            wwid = NULL;
+    }
+    g_free (path);
+
+    if (wwid && *g_strstrip (wwid))
+        return wwid;
+
+    g_free (wwid);
+    return g_strdup (disk);
+}
+
+/* adds IDs of the physical devices and their controllers under @name (recursively
+   through the stacked devices) to @cand */
+static void add_physical_devices (const gchar *name, PVCandidate *cand, guint depth) {
+    gchar *disk = NULL;
+    gchar *path = NULL;
+    GDir *dir = NULL;
+    const gchar *slave = NULL;
+    gchar *controller = NULL;
+    gboolean has_slaves = FALSE;
+    const gchar *subdirs[] = {"slaves", "multipath", NULL};
+    const gchar **subdir_p = NULL;
+
+    /* just a safety net against weird loops in sysfs */
+    if (depth > 16)
+        return;
+
+    disk = bd_utils_get_whole_disk_name (name, NULL);
+    if (!disk)
+        disk = g_strdup (name);
+    for (subdir_p = subdirs; *subdir_p; subdir_p++) {
+        path = g_strdup_printf ("/sys/block/%s/%s", disk, *subdir_p);
+        dir = g_dir_open (path, 0, NULL);
+        g_free (path);
+        while (dir && (slave = g_dir_read_name (dir))) {
+            has_slaves = TRUE;
+            add_physical_devices (slave, cand, depth + 1);
+        }
+        if (dir)
+            g_dir_close (dir);
+    }
+
+    if (!has_slaves) {
+        add_unique (cand->disks, get_disk_id (disk));
+        controller = get_controller (disk);
+        /* devices with unknown controller are considered to have their own one */
+        add_unique (cand->controllers, controller ? controller : get_disk_id (disk));
+    }
+    g_free (disk);
+}
+
+static PVCandidate* get_pv_candidate (BDLVMPVdata *pv) {
+    PVCandidate *cand = NULL;
+    gchar *dev_path = NULL;
+    gchar *name = NULL;
+
+    cand = g_new0 (PVCandidate, 1);
+    cand->pv = pv;
+    cand->disks = g_ptr_array_new_with_free_func (g_free);
+    cand->controllers = g_ptr_array_new_with_free_func (g_free);
+
+    dev_path = bd_utils_resolve_device (pv->pv_name, NULL);
+    if (dev_path) {
+        name = g_path_get_basename (dev_path);
+        add_physical_devices (name, cand, 0);
+        g_free (name);
+        g_free (dev_path);
+    }
+
+    if (cand->disks->len == 0) {
+        /* unknown device, at least make sure it is not considered the same as others */
+        g_ptr_array_add (cand->disks, g_strdup (pv->pv_name));
+        g_ptr_array_add (cand->controllers, g_strdup (pv->pv_name));
+    }
+
+    return cand;
+}
+
+/**
+ * get_data_legs:
+ * @type: (nullable): type of the LV
+ * @n_pvs: number of PVs (legs) of the LV
+ * @mirrors: (out) (optional): whether the legs are mirrors
+ *
+ * Returns: number of legs the data is spread over (i.e. without parity/mirrors),
+ *          0 if @n_pvs is too low for @type
+ */
+static guint get_data_legs (const gchar *type, guint n_pvs, gboolean *mirrors) {
+    guint ret = n_pvs;
+
+    if (mirrors)
+        *mirrors = FALSE;
+
+    if (!type)
+        return ret;
+
+    if (g_strcmp0 (type, "raid1") == 0 || g_strcmp0 (type, "mirror") == 0) {
+        if (mirrors)
+            *mirrors = TRUE;
+        ret = n_pvs >= 2 ? 1 : 0;
+    } else if (g_str_has_prefix (type, "raid4") || g_str_has_prefix (type, "raid5"))
+        ret = n_pvs >= 3 ? n_pvs - 1 : 0;
+    else if (g_str_has_prefix (type, "raid6"))
+        ret = n_pvs >= 5 ? n_pvs - 2 : 0;
+    else if (g_strcmp0 (type, "raid10") == 0)
+        ret = (n_pvs >= 4 && n_pvs % 2 == 0) ? n_pvs / 2 : 0;
+
+    return ret;
+}
+
+/* fewer PVs on the same controller first, then more free space */
+static gint compare_candidates (PVCandidate *cand1, guint load1, PVCandidate *cand2, guint load2) {
+    if (load1 != load2)
+        return load1 < load2 ? -1 : 1;
+    if (cand1->pv->pv_free != cand2->pv->pv_free)
+        return cand1->pv->pv_free > cand2->pv->pv_free ? -1 : 1;
+    return g_strcmp0 (cand1->pv->pv_name, cand2->pv->pv_name);
+}
+
+static guint get_controller_load (PVCandidate *cand, GHashTable *load) {
+    guint ret = 0;
+    guint i = 0;
+
+    for (i = 0; i < cand->controllers->len; i++)
+        ret = MAX (ret, GPOINTER_TO_UINT (g_hash_table_lookup (load, g_ptr_array_index (cand->controllers, i))));
+
+    return ret;
+}
+
+/**
+ * lvm_select_pvs:
+ * @pvs: (array zero-terminated=1): all PVs (as returned by bd_lvm_pvs())
+ * @vg_name: name of the VG to select the PVs from
+ * @size: size of the LV to be created
+ * @type: (nullable): type of the LV to be created
+ * @n_pvs: number of PVs (stripes, images,...) the LV should use
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): names of the selected PVs
+ */
+G_GNUC_INTERNAL gchar**
+lvm_select_pvs (BDLVMPVdata **pvs, const gchar *vg_name, guint64 size, const gchar *type, guint n_pvs, GError **error) {
+    GPtrArray *candidates = NULL;
+    GPtrArray *selected = NULL;
+    GPtrArray *used_disks = NULL;
+    GHashTable *load = NULL;
+    BDLVMPVdata **pv_p = NULL;
+    PVCandidate *cand = NULL;
+    PVCandidate *best = NULL;
+    guint best_load = 0;
+    guint cand_load = 0;
+    guint data_legs = 0;
+    guint64 leg_size = 0;
+    guint64 extent_size = 0;
+    gboolean mirrors = FALSE;
+    guint i = 0;
+    guint j = 0;
+
+    data_legs = get_data_legs (type, n_pvs, &mirrors);
+    if (n_pvs == 0 || data_legs == 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Invalid number of PVs (%u) for LV type '%s'", n_pvs, type ? type : "linear");
+        return NULL;
+    }
+
+    candidates = g_ptr_array_new_with_free_func ((GDestroyNotify) pv_candidate_free);
+    for (pv_p = pvs; pv_p && *pv_p; pv_p++) {
+        if (g_strcmp0 ((*pv_p)->vg_name, vg_name) != 0 || (*pv_p)->missing)
+            continue;
+
+        extent_size = (*pv_p)->vg_extent_size;
+        if (extent_size == 0) {
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                         "Failed to get extent size of the VG '%s'", vg_name);
+            g_ptr_array_free (candidates, TRUE);
+            return NULL;
+        }
+
+        /* space needed on every leg rounded up to extents, RAID LVs also need
+           an extent for metadata on each leg */
+        leg_size = mirrors ? size : (size + data_legs - 1) / data_legs;
+        leg_size = ((leg_size + extent_size - 1) / extent_size) * extent_size;
+        if (type && g_str_has_prefix (type, "raid"))
+            leg_size += extent_size;
+
+        if ((*pv_p)->pv_free >= leg_size)
+            g_ptr_array_add (candidates, get_pv_candidate (*pv_p));
+    }
+
+    selected = g_ptr_array_new ();
+    used_disks = g_ptr_array_new ();
+    load = g_hash_table_new (g_str_hash, g_str_equal);
+    for (i = 0; i < n_pvs; i++) {
+        best = NULL;
+        for (j = 0; j < candidates->len; j++) {
+            cand = g_ptr_array_index (candidates, j);
+            /* never put two legs on the same physical device */
+            if (have_common_item (cand->disks, used_disks))
+                continue;
+
+            cand_load = get_controller_load (cand, load);
+            if (!best || compare_candidates (cand, cand_load, best, best_load) < 0) {
+                best = cand;
+                best_load = cand_load;
+            }
+        }
+
+        if (!best) {
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                         "Only %u of the %u requested PVs with enough free space on distinct physical "
+                         "devices found in the VG '%s'", i, n_pvs, vg_name);
+            g_ptr_array_set_free_func (selected, g_free);
+            g_ptr_array_free (selected, TRUE);
+            g_ptr_array_free (used_disks, TRUE);
+            g_hash_table_destroy (load);
+            g_ptr_array_free (candidates, TRUE);
+            return NULL;
+        }
+
+        g_ptr_array_add (selected, g_strdup (best->pv->pv_name));
+        for (j = 0; j < best->disks->len; j++)
+            g_ptr_array_add (used_disks, g_ptr_array_index (best->disks, j));
+        for (j = 0; j < best->controllers->len; j++)
+            g_hash_table_insert (load, g_ptr_array_index (best->controllers, j),
+                                 GUINT_TO_POINTER (GPOINTER_TO_UINT (g_hash_table_lookup (load, g_ptr_array_index (best->controllers, j))) + 1));
+    }
+
+    g_ptr_array_free (used_disks, TRUE);
+    g_hash_table_destroy (load);
+    g_ptr_array_free (candidates, TRUE);
+
+    g_ptr_array_add (selected, NULL);
+    return (gchar **) g_ptr_array_free (selected, FALSE);
+}
+
+/**
+ * lvm_layout_extra_args:
+ * @type: (nullable): type of the LV to be created
+ * @n_pvs: number of PVs the LV should use
+ * @extra: (nullable) (array zero-terminated=1): extra options for the LV creation
+ *
+ * Returns: (transfer full) (array zero-terminated=1): @extra with the options making
+ *                                                     sure all @n_pvs PVs are used for @type
+ */
+G_GNUC_INTERNAL BDExtraArg**
+lvm_layout_extra_args (const gchar *type, guint n_pvs, const BDExtraArg **extra) {
+    GPtrArray *args = NULL;
+    const BDExtraArg **extra_p = NULL;
+    gboolean mirrors = FALSE;
+    guint data_legs = 0;
+    gchar *num = NULL;
+
+    args = g_ptr_array_new ();
+    for (extra_p = extra; extra_p && *extra_p; extra_p++)
+        g_ptr_array_add (args, bd_extra_arg_copy ((BDExtraArg *) *extra_p));
+
+    /* striped LVs use all the given PVs as stripes, linear LVs don't need anything */
+    if (g_strcmp0 (type, "striped") == 0) {
+        num = g_strdup_printf ("%u", n_pvs);
+        g_ptr_array_add (args, bd_extra_arg_new ("--stripes", num));
+        g_free (num);
+    } else if ((type && g_str_has_prefix (type, "raid")) || g_strcmp0 (type, "mirror") == 0) {
+        data_legs = get_data_legs (type, n_pvs, &mirrors);
+        if (mirrors) {
+            num = g_strdup_printf ("%u", n_pvs - 1);
+            g_ptr_array_add (args, bd_extra_arg_new ("--mirrors", num));
+        } else {
+            num = g_strdup_printf ("%u", data_legs);
+            g_ptr_array_add (args, bd_extra_arg_new ("--stripes", num));
+        }
+        g_free (num);
+    }
+
+    g_ptr_array_add (args, NULL);
+    return (BDExtraArg **) g_ptr_array_free (args, FALSE);
+}
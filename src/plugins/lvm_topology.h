@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2024  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <blockdev/utils.h>
+
+#include "lvm.h"
+
+#ifndef BD_LVM_TOPOLOGY
+#define BD_LVM_TOPOLOGY
+
+gchar** lvm_select_pvs (BDLVMPVdata **pvs, const gchar *vg_name, guint64 size, const gchar *type, guint n_pvs, GError **error);
+BDExtraArg** lvm_layout_extra_args (const gchar *type, guint n_pvs, const BDExtraArg **extra);
+
+#endif  /* BD_LVM_TOPOLOGY */
@@ -143,6 +143,56 @@ void bd_md_detail_data_free (BDMDDetailData *data) {
     g_free (data);
 }
 
+BDMDSyncProgress* bd_md_sync_progress_copy (BDMDSyncProgress *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDMDSyncProgress *new_data = g_new0 (BDMDSyncProgress, 1);
+
+    new_data->action = g_strdup (data->action);
+    new_data->completed = data->completed;
+    new_data->total = data->total;
+    new_data->speed = data->speed;
+    new_data->speed_min = data->speed_min;
+    new_data->speed_max = data->speed_max;
+    new_data->speed_limits_local = data->speed_limits_local;
+
+    return new_data;
+}
+
+void bd_md_sync_progress_free (BDMDSyncProgress *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->action);
+    g_free (data);
+}
+
+BDMDBitmapInfo* bd_md_bitmap_info_copy (BDMDBitmapInfo *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDMDBitmapInfo *new_data = g_new0 (BDMDBitmapInfo, 1);
+
+    new_data->location = g_strdup (data->location);
+    new_data->metadata = g_strdup (data->metadata);
+    new_data->chunk_size = data->chunk_size;
+    new_data->time_base = data->time_base;
+    new_data->backlog = data->backlog;
+    new_data->max_backlog_used = data->max_backlog_used;
+
+    return new_data;
+}
+
+void bd_md_bitmap_info_free (BDMDBitmapInfo *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->location);
+    g_free (data->metadata);
+    g_free (data);
+}
+
 
 static volatile guint avail_deps = 0;
 static GMutex deps_check_lock;
@@ -1543,3 +1593,889 @@ gboolean bd_md_request_sync_action (const gchar *raid_spec, const gchar *action,
 
     return TRUE;
 }
+
+/**
+ * get_md_sysfs_attr: (skip)
+ * @raid_node: sysfs name of the RAID device
+ * @attr: attribute to read (relative to the 'md' directory of @raid_node)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): stripped value of the @attr attribute
+ */
+static gchar* get_md_sysfs_attr (const gchar *raid_node, const gchar *attr, GError **error) {
+    gchar *sys_path = NULL;
+    gchar *ret = NULL;
+    gboolean success = FALSE;
+
+    sys_path = g_strdup_printf ("/sys/class/block/%s/md/%s", raid_node, attr);
+    success = g_file_get_contents (sys_path, &ret, NULL, error);
+    g_free (sys_path);
+    if (!success)
+        /* error is already populated */
+        return NULL;
+
+    return g_strstrip (ret);
+}
+
+/**
+ * set_md_sysfs_attr: (skip)
+ * @raid_node: sysfs name of the RAID device
+ * @attr: attribute to write (relative to the 'md' directory of @raid_node)
+ * @value: value to write
+ * @error: (out) (optional): place to store error (if any)
+ */
+static gboolean set_md_sysfs_attr (const gchar *raid_node, const gchar *attr, const gchar *value, GError **error) {
+    gchar *sys_path = NULL;
+    gboolean success = FALSE;
+
+    sys_path = g_strdup_printf ("/sys/class/block/%s/md/%s", raid_node, attr);
+    success = bd_utils_echo_str_to_file (value, sys_path, error);
+    g_free (sys_path);
+
+    return success;
+}
+
+/**
+ * get_member_sysfs_name: (skip)
+ * @raid_node: sysfs name of the RAID device
+ * @device: member device of the RAID
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): name of the directory of @device in the 'md'
+ *                           directory of @raid_node (e.g. "dev-sda1") or %NULL
+ *                           if @device is not a member of the RAID
+ */
+static gchar* get_member_sysfs_name (const gchar *raid_node, const gchar *device, GError **error) {
+    gchar *dev_path = NULL;
+    gchar *dev_name = NULL;
+    gchar *member_name = NULL;
+    gchar *sys_path = NULL;
+
+    dev_path = bd_utils_resolve_device (device, error);
+    if (!dev_path)
+        /* error is already populated */
+        return NULL;
+
+    dev_name = g_path_get_basename (dev_path);
+    g_free (dev_path);
+
+    member_name = g_strdup_printf ("dev-%s", dev_name);
+    sys_path = g_strdup_printf ("/sys/class/block/%s/md/%s", raid_node, member_name);
+    if (access (sys_path, F_OK) != 0) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Device '%s' is not a member of the '%s' RAID", device, raid_node);
+        g_free (member_name);
+        member_name = NULL;
+    }
+
+    g_free (dev_name);
+    g_free (sys_path);
+
+    return member_name;
+}
+
+/**
+ * bd_md_replace:
+ * @raid_spec: specification of the RAID device (name, node or path) to replace @device in
+ * @device: member device of the @raid_spec RAID to replace
+ * @replacement: (nullable): device to replace @device with or %NULL to use any
+ *                           spare device of @raid_spec
+ * @extra: (nullable) (array zero-terminated=1): extra options for the addition of @replacement
+ *                                                 (right now passed to the 'mdadm' utility)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the replacement of @device was successfully started or not
+ *
+ * Unlike failing and removing @device and adding a new device, the data is
+ * copied from @device (and rebuilt from the other members only where @device
+ * fails to provide it) while @device stays in service so the array is never
+ * degraded. @device is marked as faulty once the copy is finished and it can be
+ * removed with bd_md_remove() then. If @replacement is not a member of
+ * @raid_spec, it is added to it as a spare first. Use bd_md_get_sync_progress()
+ * to monitor the progress of the replacement.
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+gboolean bd_md_replace (const gchar *raid_spec, const gchar *device, const gchar *replacement, const BDExtraArg **extra, GError **error) {
+    gchar *raid_node = NULL;
+    gchar *member = NULL;
+    gchar *repl_member = NULL;
+    gchar *attr = NULL;
+    gchar *slot = NULL;
+    gchar *repl_slot = NULL;
+    gboolean success = FALSE;
+    GError *l_error = NULL;
+
+    raid_node = get_sysfs_name_from_input (raid_spec, error);
+    if (!raid_node)
+        /* error is already populated */
+        return FALSE;
+
+    member = get_member_sysfs_name (raid_node, device, error);
+    if (!member) {
+        /* error is already populated */
+        g_free (raid_node);
+        return FALSE;
+    }
+
+    attr = g_strdup_printf ("%s/slot", member);
+    slot = get_md_sysfs_attr (raid_node, attr, error);
+    g_free (attr);
+    if (!slot) {
+        g_prefix_error (error, "Failed to get slot of '%s': ", device);
+        g_free (member);
+        g_free (raid_node);
+        return FALSE;
+    }
+
+    if (g_strcmp0 (slot, "none") == 0) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Device '%s' is not an active member of the '%s' RAID", device, raid_spec);
+        g_free (slot);
+        g_free (member);
+        g_free (raid_node);
+        return FALSE;
+    }
+
+    if (replacement) {
+        repl_member = get_member_sysfs_name (raid_node, replacement, NULL);
+        if (!repl_member) {
+            /* add the replacement as a spare (no redundancy change) */
+            if (!bd_md_add (raid_spec, replacement, 0, extra, error)) {
+                g_prefix_error (error, "Failed to add '%s' as a spare: ", replacement);
+                g_free (slot);
+                g_free (member);
+                g_free (raid_node);
+                return FALSE;
+            }
+            repl_member = get_member_sysfs_name (raid_node, replacement, error);
+            if (!repl_member) {
+                /* error is already populated */
+                g_free (slot);
+                g_free (member);
+                g_free (raid_node);
+                return FALSE;
+            }
+        }
+
+        attr = g_strdup_printf ("%s/slot", repl_member);
+        repl_slot = get_md_sysfs_attr (raid_node, attr, error);
+        if (!repl_slot || g_strcmp0 (repl_slot, "none") != 0) {
+            if (repl_slot)
+                g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                             "Device '%s' is not a spare device of the '%s' RAID", replacement, raid_spec);
+            g_free (repl_slot);
+            g_free (attr);
+            g_free (repl_member);
+            g_free (slot);
+            g_free (member);
+            g_free (raid_node);
+            return FALSE;
+        }
+        g_free (repl_slot);
+        g_free (attr);
+    }
+
+    /* freeze the sync actions so that the kernel doesn't pick some other
+       spare for the replacement before we assign @replacement to the slot */
+    if (!set_md_sysfs_attr (raid_node, "sync_action", "frozen", error)) {
+        g_prefix_error (error, "Failed to freeze sync actions: ");
+        g_free (repl_member);
+        g_free (slot);
+        g_free (member);
+        g_free (raid_node);
+        return FALSE;
+    }
+
+    attr = g_strdup_printf ("%s/state", member);
+    success = set_md_sysfs_attr (raid_node, attr, "want_replacement", &l_error);
+    g_free (attr);
+    if (!success)
+        g_prefix_error (&l_error, "Failed to request replacement of '%s': ", device);
+
+    if (success && repl_member) {
+        attr = g_strdup_printf ("%s/slot", repl_member);
+        success = set_md_sysfs_attr (raid_node, attr, slot, &l_error);
+        g_free (attr);
+        if (!success)
+            g_prefix_error (&l_error, "Failed to assign '%s' as a replacement of '%s': ", replacement, device);
+    }
+
+    /* unfreeze the sync actions which (re)starts the recovery */
+    if (!set_md_sysfs_attr (raid_node, "sync_action", "idle", success ? &l_error : NULL) && success) {
+        g_prefix_error (&l_error, "Failed to unfreeze sync actions: ");
+        success = FALSE;
+    }
+
+    if (!success)
+        g_propagate_error (error, l_error);
+
+    g_free (repl_member);
+    g_free (slot);
+    g_free (member);
+    g_free (raid_node);
+
+    return success;
+}
+
+/**
+ * get_speed_limit: (skip)
+ *
+ * Parses the sync_speed_min/max value ("NUM (system)" or "NUM (local)", NUM in KiB/s)
+ * into bytes per second.
+ */
+static guint64 get_speed_limit (const gchar *value, gboolean *local) {
+    guint64 speed = 0;
+
+    speed = g_ascii_strtoull (value, NULL, 0) * 1024;
+    *local = *local || (strstr (value, "(local)") != NULL);
+
+    return speed;
+}
+
+/**
+ * bd_md_get_sync_progress:
+ * @raid_spec: specification of the RAID device (name, node or path) to get the sync progress of
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): progress of the sync action (e.g. resync, recovery
+ *                           or replacement) running on @raid_spec or %NULL
+ *                           in case of error
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+BDMDSyncProgress* bd_md_get_sync_progress (const gchar *raid_spec, GError **error) {
+    gchar *raid_node = NULL;
+    gchar *value = NULL;
+    gchar **parts = NULL;
+    BDMDSyncProgress *ret = NULL;
+
+    raid_node = get_sysfs_name_from_input (raid_spec, error);
+    if (!raid_node)
+        /* error is already populated */
+        return NULL;
+
+    ret = g_new0 (BDMDSyncProgress, 1);
+
+    ret->action = get_md_sysfs_attr (raid_node, "sync_action", error);
+    if (!ret->action) {
+        /* error is already populated */
+        bd_md_sync_progress_free (ret);
+        g_free (raid_node);
+        return NULL;
+    }
+
+    /* "none" or "COMPLETED / TOTAL" in sectors */
+    value = get_md_sysfs_attr (raid_node, "sync_completed", error);
+    if (!value) {
+        /* error is already populated */
+        bd_md_sync_progress_free (ret);
+        g_free (raid_node);
+        return NULL;
+    }
+    if (g_strcmp0 (value, "none") != 0) {
+        parts = g_strsplit (value, "/", 2);
+        if (g_strv_length (parts) != 2) {
+            g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_PARSE,
+                         "Failed to parse sync progress '%s'", value);
+            g_strfreev (parts);
+            g_free (value);
+            bd_md_sync_progress_free (ret);
+            g_free (raid_node);
+            return NULL;
+        }
+        ret->completed = g_ascii_strtoull (g_strstrip (parts[0]), NULL, 0) * 512;
+        ret->total = g_ascii_strtoull (g_strstrip (parts[1]), NULL, 0) * 512;
+        g_strfreev (parts);
+    }
+    g_free (value);
+
+    /* the current speed in KiB/s ("none" if there's no sync action) */
+    value = get_md_sysfs_attr (raid_node, "sync_speed", NULL);
+    if (value && g_strcmp0 (value, "none") != 0)
+        ret->speed = g_ascii_strtoull (value, NULL, 0) * 1024;
+    g_free (value);
+
+    value = get_md_sysfs_attr (raid_node, "sync_speed_min", NULL);
+    if (value)
+        ret->speed_min = get_speed_limit (value, &(ret->speed_limits_local));
+    g_free (value);
+
+    value = get_md_sysfs_attr (raid_node, "sync_speed_max", NULL);
+    if (value)
+        ret->speed_max = get_speed_limit (value, &(ret->speed_limits_local));
+    g_free (value);
+
+    g_free (raid_node);
+
+    return ret;
+}
+
+/**
+ * bd_md_set_sync_speed_limits:
+ * @raid_spec: specification of the RAID device (name, node or path) to set the sync speed limits for
+ * @speed_min: minimum speed of sync actions (in bytes per second) or 0 to use the system-wide default
+ * @speed_max: maximum speed of sync actions (in bytes per second) or 0 to use the system-wide default
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the sync speed limits were successfully set for @raid_spec or not
+ *
+ * The limits are rounded down to KiB per second (the granularity used by the kernel).
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+gboolean bd_md_set_sync_speed_limits (const gchar *raid_spec, guint64 speed_min, guint64 speed_max, GError **error) {
+    gchar *raid_node = NULL;
+    gchar *value = NULL;
+    gboolean success = FALSE;
+
+    if (speed_min != 0 && speed_max != 0 && speed_min > speed_max) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Minimum sync speed cannot be bigger than the maximum sync speed.");
+        return FALSE;
+    }
+
+    if ((speed_min != 0 && speed_min < 1024) || (speed_max != 0 && speed_max < 1024)) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Sync speed limits must be at least 1 KiB per second.");
+        return FALSE;
+    }
+
+    raid_node = get_sysfs_name_from_input (raid_spec, error);
+    if (!raid_node)
+        /* error is already populated */
+        return FALSE;
+
+    /* writing "system" resets the limit to the system-wide default */
+    if (speed_max != 0)
+        value = g_strdup_printf ("%"G_GUINT64_FORMAT, speed_max / 1024);
+    else
+        value = g_strdup ("system");
+    success = set_md_sysfs_attr (raid_node, "sync_speed_max", value, error);
+    g_free (value);
+    if (!success) {
+        g_prefix_error (error, "Failed to set maximum sync speed: ");
+        g_free (raid_node);
+        return FALSE;
+    }
+
+    if (speed_min != 0)
+        value = g_strdup_printf ("%"G_GUINT64_FORMAT, speed_min / 1024);
+    else
+        value = g_strdup ("system");
+    success = set_md_sysfs_attr (raid_node, "sync_speed_min", value, error);
+    g_free (value);
+    if (!success)
+        g_prefix_error (error, "Failed to set minimum sync speed: ");
+
+    g_free (raid_node);
+
+    return success;
+}
+
+static const gchar* const consistency_policies[] = {"unknown", "none", "resync", "bitmap", "journal", "ppl", NULL};
+
+/**
+ * md_grow: (skip)
+ *
+ * Runs 'mdadm --grow' with the given options for @raid_spec.
+ */
+static gboolean md_grow (const gchar *raid_spec, const gchar *option, const gchar *option2, GError **error) {
+    const gchar *argv[] = {"mdadm", "--grow", NULL, option, option2, NULL};
+    gchar *mdadm_spec = NULL;
+    gboolean ret = FALSE;
+
+    if (!check_deps (&avail_deps, DEPS_MDADM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return FALSE;
+
+    mdadm_spec = get_mdadm_spec_from_input (raid_spec, error);
+    if (!mdadm_spec)
+        /* error is already populated */
+        return FALSE;
+
+    argv[2] = mdadm_spec;
+    ret = bd_utils_exec_and_report_error (argv, NULL, error);
+    g_free (mdadm_spec);
+
+    return ret;
+}
+
+/**
+ * restore_bitmap: (skip)
+ * @raid_spec: specification of the RAID device the bitmap was removed from
+ * @chunk_size: chunk size of the removed bitmap (in bytes) or 0 for the default
+ * @action: description of the failed action for the error message
+ * @error: (inout): the error the @action failed with
+ *
+ * Tries to re-create the internal bitmap removed from @raid_spec before the
+ * failed @action and adds information about the result to @error.
+ */
+static void restore_bitmap (const gchar *raid_spec, guint64 chunk_size, const gchar *action, GError **error) {
+    GError *l_error = NULL;
+    gchar *chunk_str = NULL;
+
+    /* mdadm expects the chunk size in KiB */
+    if (chunk_size != 0)
+        chunk_str = g_strdup_printf ("--bitmap-chunk=%"G_GUINT64_FORMAT, chunk_size / 1024);
+
+    if (md_grow (raid_spec, "--bitmap=internal", chunk_str, &l_error))
+        g_prefix_error (error, "Failed to %s, the previous bitmap was restored: ", action);
+    else {
+        g_prefix_error (error, "Failed to %s and to restore the previous bitmap (%s), the array has no write-intent bitmap now: ",
+                        action, l_error->message);
+        g_clear_error (&l_error);
+    }
+    g_free (chunk_str);
+}
+
+/**
+ * bd_md_get_consistency_policy:
+ * @raid_spec: specification of the RAID device (name, node or path) to get the consistency policy of
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: consistency policy of @raid_spec (the way the array is kept consistent
+ *          after an unclean shutdown) or %BD_MD_CONSISTENCY_POLICY_UNKNOWN in case
+ *          of error
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+BDMDConsistencyPolicy bd_md_get_consistency_policy (const gchar *raid_spec, GError **error) {
+    gchar *raid_node = NULL;
+    gchar *value = NULL;
+    guint i = 0;
+
+    raid_node = get_sysfs_name_from_input (raid_spec, error);
+    if (!raid_node)
+        /* error is already populated */
+        return BD_MD_CONSISTENCY_POLICY_UNKNOWN;
+
+    value = get_md_sysfs_attr (raid_node, "consistency_policy", error);
+    g_free (raid_node);
+    if (!value)
+        /* error is already populated */
+        return BD_MD_CONSISTENCY_POLICY_UNKNOWN;
+
+    for (i=0; consistency_policies[i]; i++) {
+        if (g_strcmp0 (value, consistency_policies[i]) == 0) {
+            g_free (value);
+            return (BDMDConsistencyPolicy) i;
+        }
+    }
+
+    g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_PARSE,
+                 "Unknown consistency policy '%s'", value);
+    g_free (value);
+
+    return BD_MD_CONSISTENCY_POLICY_UNKNOWN;
+}
+
+/**
+ * bd_md_set_consistency_policy:
+ * @raid_spec: specification of the RAID device (name, node or path) to set the consistency policy for
+ * @policy: consistency policy to set
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the @policy was successfully set for @raid_spec or not
+ *
+ * Only switching between %BD_MD_CONSISTENCY_POLICY_RESYNC, %BD_MD_CONSISTENCY_POLICY_BITMAP
+ * (internal bitmap) and %BD_MD_CONSISTENCY_POLICY_PPL (RAID 5 only) is possible
+ * on an active array. Switching to %BD_MD_CONSISTENCY_POLICY_BITMAP creates an
+ * internal bitmap with the default chunk size (see bd_md_set_bitmap_chunk_size()).
+ * If switching between the bitmap and PPL fails, the original policy is set again
+ * (if possible, @error says whether it was).
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+gboolean bd_md_set_consistency_policy (const gchar *raid_spec, BDMDConsistencyPolicy policy, GError **error) {
+    BDMDConsistencyPolicy current = BD_MD_CONSISTENCY_POLICY_UNKNOWN;
+    BDMDBitmapInfo *info = NULL;
+    guint64 bitmap_chunk = 0;
+    gboolean external_bitmap = FALSE;
+
+    if (policy != BD_MD_CONSISTENCY_POLICY_RESYNC && policy != BD_MD_CONSISTENCY_POLICY_BITMAP &&
+        policy != BD_MD_CONSISTENCY_POLICY_PPL) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Only the 'resync', 'bitmap' and 'ppl' consistency policies can be set on an existing array.");
+        return FALSE;
+    }
+
+    current = bd_md_get_consistency_policy (raid_spec, error);
+    if (current == BD_MD_CONSISTENCY_POLICY_UNKNOWN)
+        /* error is already populated (if any) */
+        return FALSE;
+
+    if (current == policy)
+        /* nothing to do */
+        return TRUE;
+
+    if (current != BD_MD_CONSISTENCY_POLICY_RESYNC && current != BD_MD_CONSISTENCY_POLICY_BITMAP &&
+        current != BD_MD_CONSISTENCY_POLICY_PPL) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Cannot change the '%s' consistency policy of an existing array.", consistency_policies[current]);
+        return FALSE;
+    }
+
+    /* bitmap and PPL are mutually exclusive, go through 'resync' */
+    if (current == BD_MD_CONSISTENCY_POLICY_BITMAP) {
+        if (policy == BD_MD_CONSISTENCY_POLICY_PPL) {
+            /* remember the chunk size to be able to restore the bitmap if enabling PPL fails */
+            info = bd_md_get_bitmap_info (raid_spec, error);
+            if (!info)
+                /* error is already populated */
+                return FALSE;
+            external_bitmap = g_strcmp0 (info->location, "file") == 0;
+            bitmap_chunk = info->chunk_size;
+            bd_md_bitmap_info_free (info);
+        }
+
+        if (!md_grow (raid_spec, "--bitmap=none", NULL, error)) {
+            g_prefix_error (error, "Failed to remove the bitmap: ");
+            return FALSE;
+        }
+    } else if (current == BD_MD_CONSISTENCY_POLICY_PPL) {
+        if (!md_grow (raid_spec, "--consistency-policy=resync", NULL, error)) {
+            g_prefix_error (error, "Failed to disable PPL: ");
+            return FALSE;
+        }
+    }
+
+    if (policy == BD_MD_CONSISTENCY_POLICY_BITMAP) {
+        if (!md_grow (raid_spec, "--bitmap=internal", NULL, error)) {
+            if (current == BD_MD_CONSISTENCY_POLICY_PPL) {
+                if (md_grow (raid_spec, "--consistency-policy=ppl", NULL, NULL))
+                    g_prefix_error (error, "Failed to create the bitmap, PPL was enabled again: ");
+                else
+                    g_prefix_error (error, "Failed to create the bitmap and to enable PPL again, the array uses the 'resync' policy now: ");
+            }
+            return FALSE;
+        }
+    } else if (policy == BD_MD_CONSISTENCY_POLICY_PPL) {
+        if (!md_grow (raid_spec, "--consistency-policy=ppl", NULL, error)) {
+            if (current == BD_MD_CONSISTENCY_POLICY_BITMAP) {
+                if (external_bitmap)
+                    /* we don't know the bitmap file to restore the bitmap in it */
+                    g_prefix_error (error, "Failed to enable PPL, the array has no write-intent bitmap now: ");
+                else
+                    restore_bitmap (raid_spec, bitmap_chunk, "enable PPL", error);
+            }
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_md_get_bitmap_info:
+ * @raid_spec: specification of the RAID device (name, node or path) to get the bitmap information for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): information about the write-intent bitmap of @raid_spec
+ *                           or %NULL in case of error
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+BDMDBitmapInfo* bd_md_get_bitmap_info (const gchar *raid_spec, GError **error) {
+    gchar *raid_node = NULL;
+    gchar *value = NULL;
+    BDMDBitmapInfo *ret = NULL;
+
+    raid_node = get_sysfs_name_from_input (raid_spec, error);
+    if (!raid_node)
+        /* error is already populated */
+        return NULL;
+
+    ret = g_new0 (BDMDBitmapInfo, 1);
+
+    ret->location = get_md_sysfs_attr (raid_node, "bitmap/location", error);
+    if (!ret->location) {
+        /* error is already populated */
+        bd_md_bitmap_info_free (ret);
+        g_free (raid_node);
+        return NULL;
+    }
+
+    ret->metadata = get_md_sysfs_attr (raid_node, "bitmap/metadata", NULL);
+
+    value = get_md_sysfs_attr (raid_node, "bitmap/chunksize", NULL);
+    if (value)
+        ret->chunk_size = g_ascii_strtoull (value, NULL, 0);
+    g_free (value);
+
+    value = get_md_sysfs_attr (raid_node, "bitmap/time_base", NULL);
+    if (value)
+        ret->time_base = g_ascii_strtoull (value, NULL, 0);
+    g_free (value);
+
+    value = get_md_sysfs_attr (raid_node, "bitmap/backlog", NULL);
+    if (value)
+        ret->backlog = g_ascii_strtoull (value, NULL, 0);
+    g_free (value);
+
+    value = get_md_sysfs_attr (raid_node, "bitmap/max_backlog_used", NULL);
+    if (value)
+        ret->max_backlog_used = g_ascii_strtoull (value, NULL, 0);
+    g_free (value);
+
+    g_free (raid_node);
+
+    return ret;
+}
+
+/**
+ * bd_md_set_bitmap_chunk_size:
+ * @raid_spec: specification of the RAID device (name, node or path) to set the bitmap chunk size for
+ * @chunk_size: new bitmap chunk size (in bytes, power of two, at least 4 KiB) or 0
+ *              for the default chosen by mdadm
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the internal bitmap of @raid_spec was successfully
+ *          (re)created with the @chunk_size chunk size or not
+ *
+ * The chunk size of an existing bitmap cannot be changed so the internal bitmap
+ * is removed and created again. The array must have an internal bitmap (or no
+ * bitmap with %BD_MD_CONSISTENCY_POLICY_RESYNC). If creating the new bitmap fails,
+ * the bitmap with the previous chunk size is created again (if possible, @error
+ * says whether it was).
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+gboolean bd_md_set_bitmap_chunk_size (const gchar *raid_spec, guint64 chunk_size, GError **error) {
+    BDMDConsistencyPolicy policy = BD_MD_CONSISTENCY_POLICY_UNKNOWN;
+    BDMDBitmapInfo *info = NULL;
+    guint64 old_chunk_size = 0;
+    gchar *chunk_str = NULL;
+    gboolean ret = FALSE;
+
+    if (chunk_size != 0 && (chunk_size < 4 KiB || (chunk_size & (chunk_size - 1)) != 0)) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Bitmap chunk size must be a power of two and at least 4 KiB.");
+        return FALSE;
+    }
+
+    policy = bd_md_get_consistency_policy (raid_spec, error);
+    if (policy == BD_MD_CONSISTENCY_POLICY_UNKNOWN)
+        /* error is already populated (if any) */
+        return FALSE;
+
+    if (policy == BD_MD_CONSISTENCY_POLICY_BITMAP) {
+        info = bd_md_get_bitmap_info (raid_spec, error);
+        if (!info)
+            /* error is already populated */
+            return FALSE;
+
+        if (g_strcmp0 (info->location, "file") == 0) {
+            g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                         "Changing chunk size of an external bitmap is not supported.");
+            bd_md_bitmap_info_free (info);
+            return FALSE;
+        }
+
+        if (chunk_size != 0 && info->chunk_size == chunk_size) {
+            /* nothing to do */
+            bd_md_bitmap_info_free (info);
+            return TRUE;
+        }
+        old_chunk_size = info->chunk_size;
+        bd_md_bitmap_info_free (info);
+
+        if (!md_grow (raid_spec, "--bitmap=none", NULL, error)) {
+            g_prefix_error (error, "Failed to remove the existing bitmap: ");
+            return FALSE;
+        }
+    } else if (policy != BD_MD_CONSISTENCY_POLICY_RESYNC) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Cannot create a bitmap for an array with the '%s' consistency policy.",
+                     consistency_policies[policy]);
+        return FALSE;
+    }
+
+    /* mdadm expects the chunk size in KiB */
+    if (chunk_size != 0)
+        chunk_str = g_strdup_printf ("--bitmap-chunk=%"G_GUINT64_FORMAT, chunk_size / 1024);
+    ret = md_grow (raid_spec, "--bitmap=internal", chunk_str, error);
+    g_free (chunk_str);
+
+    if (!ret && policy == BD_MD_CONSISTENCY_POLICY_BITMAP)
+        restore_bitmap (raid_spec, old_chunk_size, "create the new bitmap", error);
+
+    return ret;
+}
+
+/**
+ * bd_md_set_write_behind:
+ * @raid_spec: specification of the RAID device (name, node or path) to set the write-behind limit for
+ * @backlog: maximum number of outstanding writes to write-mostly members or 0
+ *           to disable write-behind
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the write-behind limit was successfully set for @raid_spec or not
+ *
+ * Write-behind is only supported for RAID 1 arrays with a bitmap and only applies
+ * to write-mostly members (see bd_md_set_member_flags()).
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+gboolean bd_md_set_write_behind (const gchar *raid_spec, guint64 backlog, GError **error) {
+    gchar *raid_node = NULL;
+    gchar *value = NULL;
+    gboolean success = FALSE;
+
+    /* see COUNTER_MAX in the kernel's md-bitmap.h */
+    if (backlog > 16383) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Write-behind limit cannot be bigger than 16383.");
+        return FALSE;
+    }
+
+    raid_node = get_sysfs_name_from_input (raid_spec, error);
+    if (!raid_node)
+        /* error is already populated */
+        return FALSE;
+
+    value = g_strdup_printf ("%"G_GUINT64_FORMAT, backlog);
+    success = set_md_sysfs_attr (raid_node, "bitmap/backlog", value, error);
+    if (!success)
+        g_prefix_error (error, "Failed to set write-behind limit: ");
+
+    g_free (value);
+    g_free (raid_node);
+
+    return success;
+}
+
+/**
+ * get_member_state: (skip)
+ *
+ * Returns: (transfer full): the state flags of @device in @raid_spec and
+ *                           sets @raid_node and @member to the sysfs name
+ *                           of the RAID and of the member directory
+ */
+static gchar** get_member_state (const gchar *raid_spec, const gchar *device, gchar **raid_node, gchar **member, GError **error) {
+    gchar *attr = NULL;
+    gchar *value = NULL;
+    gchar **ret = NULL;
+
+    *raid_node = get_sysfs_name_from_input (raid_spec, error);
+    if (!*raid_node)
+        /* error is already populated */
+        return NULL;
+
+    *member = get_member_sysfs_name (*raid_node, device, error);
+    if (!*member) {
+        /* error is already populated */
+        g_free (*raid_node);
+        *raid_node = NULL;
+        return NULL;
+    }
+
+    attr = g_strdup_printf ("%s/state", *member);
+    value = get_md_sysfs_attr (*raid_node, attr, error);
+    g_free (attr);
+    if (!value) {
+        /* error is already populated */
+        g_free (*member);
+        *member = NULL;
+        g_free (*raid_node);
+        *raid_node = NULL;
+        return NULL;
+    }
+
+    ret = g_strsplit (value, ",", -1);
+    g_free (value);
+
+    return ret;
+}
+
+/**
+ * bd_md_get_member_flags:
+ * @raid_spec: specification of the RAID device (name, node or path) @device belongs to
+ * @device: member device of @raid_spec to get the flags of
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: flags (bitwise combination of #BDMDMemberFlag) set for @device
+ *          in @raid_spec, 0 if none is set or in case of error (check @error)
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+guint64 bd_md_get_member_flags (const gchar *raid_spec, const gchar *device, GError **error) {
+    gchar *raid_node = NULL;
+    gchar *member = NULL;
+    gchar **state = NULL;
+    guint64 flags = 0;
+
+    state = get_member_state (raid_spec, device, &raid_node, &member, error);
+    if (!state)
+        /* error is already populated */
+        return 0;
+
+    if (g_strv_contains ((const gchar * const *) state, "write_mostly"))
+        flags |= BD_MD_MEMBER_FLAG_WRITEMOSTLY;
+    if (g_strv_contains ((const gchar * const *) state, "failfast"))
+        flags |= BD_MD_MEMBER_FLAG_FAILFAST;
+
+    g_strfreev (state);
+    g_free (member);
+    g_free (raid_node);
+
+    return flags;
+}
+
+/**
+ * bd_md_set_member_flags:
+ * @raid_spec: specification of the RAID device (name, node or path) @device belongs to
+ * @device: member device of @raid_spec to set the flags for
+ * @flags: flags (bitwise combination of #BDMDMemberFlag) to set, the flags not
+ *         included in @flags are cleared
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the @flags were successfully set for @device in @raid_spec or not
+ *
+ * %BD_MD_MEMBER_FLAG_WRITEMOSTLY makes the RAID 1 array avoid reads from
+ * @device (e.g. a slow disk or a remote device), %BD_MD_MEMBER_FLAG_FAILFAST
+ * makes the array fail @device on the first I/O error instead of retrying.
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+gboolean bd_md_set_member_flags (const gchar *raid_spec, const gchar *device, guint64 flags, GError **error) {
+    gchar *raid_node = NULL;
+    gchar *member = NULL;
+    gchar **state = NULL;
+    gchar *attr = NULL;
+    gboolean is_set = FALSE;
+    gboolean success = TRUE;
+    guint i = 0;
+    /* flag, name in the state file, value to set it, value to clear it */
+    const struct {
+        BDMDMemberFlag flag;
+        const gchar *state;
+        const gchar *set;
+        const gchar *clear;
+    } flag_names[] = {
+        {BD_MD_MEMBER_FLAG_WRITEMOSTLY, "write_mostly", "writemostly", "-writemostly"},
+        {BD_MD_MEMBER_FLAG_FAILFAST, "failfast", "failfast", "-failfast"},
+    };
+
+    state = get_member_state (raid_spec, device, &raid_node, &member, error);
+    if (!state)
+        /* error is already populated */
+        return FALSE;
+
+    attr = g_strdup_printf ("%s/state", member);
+    for (i=0; success && i < G_N_ELEMENTS (flag_names); i++) {
+        is_set = g_strv_contains ((const gchar * const *) state, flag_names[i].state);
+        if (is_set && !(flags & flag_names[i].flag))
+            success = set_md_sysfs_attr (raid_node, attr, flag_names[i].clear, error);
+        else if (!is_set && (flags & flag_names[i].flag))
+            success = set_md_sysfs_attr (raid_node, attr, flag_names[i].set, error);
+        if (!success)
+            g_prefix_error (error, "Failed to change the '%s' flag of '%s': ", flag_names[i].state, device);
+    }
+
+    g_free (attr);
+    g_strfreev (state);
+    g_free (member);
+    g_free (raid_node);
+
+    return success;
+}
@@ -58,6 +58,45 @@ typedef struct BDMDDetailData {
 void bd_md_detail_data_free (BDMDDetailData *data);
 BDMDDetailData* bd_md_detail_data_copy (BDMDDetailData *data);
 
+typedef struct BDMDSyncProgress {
+    gchar *action;
+    guint64 completed;
+    guint64 total;
+    guint64 speed;
+    guint64 speed_min;
+    guint64 speed_max;
+    gboolean speed_limits_local;
+} BDMDSyncProgress;
+
+void bd_md_sync_progress_free (BDMDSyncProgress *data);
+BDMDSyncProgress* bd_md_sync_progress_copy (BDMDSyncProgress *data);
+
+typedef enum {
+    BD_MD_CONSISTENCY_POLICY_UNKNOWN = 0,
+    BD_MD_CONSISTENCY_POLICY_NONE,
+    BD_MD_CONSISTENCY_POLICY_RESYNC,
+    BD_MD_CONSISTENCY_POLICY_BITMAP,
+    BD_MD_CONSISTENCY_POLICY_JOURNAL,
+    BD_MD_CONSISTENCY_POLICY_PPL,
+} BDMDConsistencyPolicy;
+
+typedef enum {
+    BD_MD_MEMBER_FLAG_WRITEMOSTLY = 1 << 0,
+    BD_MD_MEMBER_FLAG_FAILFAST    = 1 << 1,
+} BDMDMemberFlag;
+
+typedef struct BDMDBitmapInfo {
+    gchar *location;
+    gchar *metadata;
+    guint64 chunk_size;
+    guint64 time_base;
+    guint64 backlog;
+    guint64 max_backlog_used;
+} BDMDBitmapInfo;
+
+void bd_md_bitmap_info_free (BDMDBitmapInfo *data);
+BDMDBitmapInfo* bd_md_bitmap_info_copy (BDMDBitmapInfo *data);
+
 typedef enum {
     BD_MD_TECH_MDRAID = 0,
 } BDMDTech;
@@ -103,5 +142,15 @@ gchar* bd_md_get_status (const gchar *raid_spec, GError **error);
 gboolean bd_md_set_bitmap_location (const gchar *raid_spec, const gchar *location, GError **error);
 gchar* bd_md_get_bitmap_location (const gchar *raid_spec, GError **error);
 gboolean bd_md_request_sync_action (const gchar *raid_spec, const gchar *action, GError **error);
+gboolean bd_md_replace (const gchar *raid_spec, const gchar *device, const gchar *replacement, const BDExtraArg **extra, GError **error);
+BDMDSyncProgress* bd_md_get_sync_progress (const gchar *raid_spec, GError **error);
+gboolean bd_md_set_sync_speed_limits (const gchar *raid_spec, guint64 speed_min, guint64 speed_max, GError **error);
+BDMDConsistencyPolicy bd_md_get_consistency_policy (const gchar *raid_spec, GError **error);
+gboolean bd_md_set_consistency_policy (const gchar *raid_spec, BDMDConsistencyPolicy policy, GError **error);
+BDMDBitmapInfo* bd_md_get_bitmap_info (const gchar *raid_spec, GError **error);
+gboolean bd_md_set_bitmap_chunk_size (const gchar *raid_spec, guint64 chunk_size, GError **error);
+gboolean bd_md_set_write_behind (const gchar *raid_spec, guint64 backlog, GError **error);
+guint64 bd_md_get_member_flags (const gchar *raid_spec, const gchar *device, GError **error);
+gboolean bd_md_set_member_flags (const gchar *raid_spec, const gchar *device, guint64 flags, GError **error);
 
 #endif  /* BD_MD */
@@ -41,6 +41,12 @@
 #define PATH_NVMF_CONFIG  "/etc/nvme/config.json"
 #define MAX_DISC_RETRIES  10
 
+#define NVME_SUBSYS_CLASS_DIR "/sys/class/nvme-subsystem"
+
+/* cached discovery logs of persistent discovery controllers, see bd_nvme_discover() */
+static GMutex disc_cache_lock;
+static GHashTable *disc_cache = NULL;
+
 
 static void parse_extra_args (const BDExtraArg **extra, struct nvme_fabrics_config *cfg, const gchar **config_file, const gchar **hostkey, const gchar **ctrlkey, const gchar **hostsymname) {
     const BDExtraArg **extra_i;
@@ -151,71 +157,8 @@ static void parse_extra_args (const BDExtraArg **extra, struct nvme_fabrics_conf
 }
 
 
-/**
- * bd_nvme_connect:
- * @subsysnqn: The name for the NVMe subsystem to connect to.
- * @transport: The network fabric used for a NVMe-over-Fabrics network.
- * @transport_addr: (nullable): The network address of the Controller. For transports using IP addressing (e.g. `rdma`) this should be an IP-based address.
- * @transport_svcid: (nullable): The transport service id.  For transports using IP addressing (e.g. `rdma`) this field is the port number. By default, the IP port number for the `RDMA` transport is `4420`.
- * @host_traddr: (nullable): The network address used on the host to connect to the Controller. For TCP, this sets the source address on the socket.
- * @host_iface: (nullable): The network interface used on the host to connect to the Controller (e.g. IP `eth1`, `enp2s0`). This forces the connection to be made on a specific interface instead of letting the system decide.
- * @host_nqn: (nullable): Overrides the default Host NQN that identifies the NVMe Host. If this option is %NULL, the default is read from `/etc/nvme/hostnqn` first.
- *                        If that does not exist, the autogenerated NQN value from the NVMe Host kernel module is used next. The Host NQN uniquely identifies the NVMe Host.
- * @host_id: (nullable): User-defined host UUID or %NULL to use default (as defined in `/etc/nvme/hostid`).
- * @extra: (nullable) (array zero-terminated=1): Additional arguments.
- * @error: (out) (nullable): Place to store error (if any).
- *
- * Creates a transport connection to a remote system (specified by @transport_addr and @transport_svcid)
- * and creates a NVMe over Fabrics controller for the NVMe subsystem specified by the @subsysnqn option.
- *
- * Valid values for @transport include:
- * - `"rdma"`: An rdma network (RoCE, iWARP, Infiniband, basic rdma, etc.)
- * - `"fc"`: A Fibre Channel network.
- * - `"tcp"`: A TCP/IP network.
- * - `"loop"`: A NVMe over Fabrics target on the local host.
- *
- * In addition to the primary options it's possible to supply @extra arguments:
- * - `"config"`: Use the specified JSON configuration file instead of the default file (see below) or
- *               specify `"none"` to avoid reading any configuration file.
- * - `"dhchap_key"`: NVMe In-band authentication secret in ASCII format as described
- *                      in the NVMe 2.0 specification. When not specified, the secret is by default read
- *                      from `/etc/nvme/hostkey`. In case that file does not exist no in-band authentication
- *                      is attempted.
- * - `"dhchap_ctrl_key"`: NVMe In-band authentication controller secret for bi-directional authentication.
- *                        When not specified, no bi-directional authentication is attempted.
- * - `"nr_io_queues"`: The number of I/O queues.
- * - `"nr_write_queues"`: Number of additional queues that will be used for write I/O.
- * - `"nr_poll_queues"`: Number of additional queues that will be used for polling latency sensitive I/O.
- * - `"queue_size"`: Number of elements in the I/O queues.
- * - `"keep_alive_tmo"`: The keep alive timeout (in seconds).
- * - `"reconnect_delay"`: The delay (in seconds) before reconnect is attempted after a connect loss.
- * - `"ctrl_loss_tmo"`: The controller loss timeout period (in seconds). A special value of `-1` will cause reconnecting forever.
- * - `"fast_io_fail_tmo"`: Fast I/O Fail timeout (in seconds).
- * - `"tos"`: Type of service.
- * - `"duplicate_connect"`: Allow duplicated connections between same transport host and subsystem port. Boolean value.
- * - `"disable_sqflow"`: Disables SQ flow control to omit head doorbell update for submission queues when sending nvme completions. Boolean value.
- * - `"hdr_digest"`: Generates/verifies header digest (TCP). Boolean value.
- * - `"data_digest"`: Generates/verifies data digest (TCP). Boolean value.
- * - `"tls"`: Enable TLS encryption (TCP). Boolean value.
- * - `"hostsymname"`: TP8010: NVMe host symbolic name.
- * - `"keyring"`: Keyring to store and lookup keys. String value.
- * - `"tls_key"`: TLS PSK for the connection. String value.
- *
- * Boolean values can be expressed by "0"/"1", "on"/"off" or "True"/"False" case-insensitive
- * strings. Failed numerical or boolean string conversions will result in the option being ignored.
- *
- * By default additional options are read from the default configuration file `/etc/nvme/config.json`.
- * This follows the default behaviour of `nvme-cli`. Use the @extra `"config"` argument
- * to either specify a different config file or disable use of it. The JSON configuration
- * file format is documented in [https://raw.githubusercontent.com/linux-nvme/libnvme/master/doc/config-schema.json](https://raw.githubusercontent.com/linux-nvme/libnvme/master/doc/config-schema.json).
- * As a rule @extra key names are kept consistent with the JSON config file schema.
- * Any @extra option generally overrides particular option specified in a configuration file.
- *
- * Returns: %TRUE if the subsystem was connected successfully, %FALSE otherwise with @error set.
- *
- * Tech category: %BD_NVME_TECH_FABRICS-%BD_NVME_TECH_MODE_INITIATOR
- */
-gboolean bd_nvme_connect (const gchar *subsysnqn, const gchar *transport, const gchar *transport_addr, const gchar *transport_svcid, const gchar *host_traddr, const gchar *host_iface, const gchar *host_nqn, const gchar *host_id, const BDExtraArg **extra, GError **error) {
+/* Connects a new controller, on success the caller takes ownership of @root_out and @ctrl_out */
+static gboolean _connect (const gchar *subsysnqn, const gchar *transport, const gchar *transport_addr, const gchar *transport_svcid, const gchar *host_traddr, const gchar *host_iface, const gchar *host_nqn, const gchar *host_id, const BDExtraArg **extra, gboolean persistent_dc, nvme_root_t *root_out, nvme_ctrl_t *ctrl_out, GError **error) {
     int ret;
     const gchar *config_file = PATH_NVMF_CONFIG;
     gchar *host_nqn_val;
@@ -309,6 +252,13 @@ gboolean bd_nvme_connect (const gchar *subsysnqn, const gchar *transport, const
     }
     if (ctrlkey)
         nvme_ctrl_set_dhchap_key (ctrl, ctrlkey);
+    if (persistent_dc) {
+        /* keep-alive is only sent to persistent discovery controllers */
+        nvme_ctrl_set_discovery_ctrl (ctrl, true);
+        nvme_ctrl_set_persistent (ctrl, true);
+        if (cfg.keep_alive_tmo == 0)
+            cfg.keep_alive_tmo = NVMF_DEF_DISC_TMO;
+    }
 
     ret = nvmf_add_ctrl (host, ctrl, &cfg);
     if (ret != 0) {
@@ -318,6 +268,84 @@ gboolean bd_nvme_connect (const gchar *subsysnqn, const gchar *transport, const
         nvme_free_tree (root);
         return FALSE;
     }
+
+    *root_out = root;
+    *ctrl_out = ctrl;
+    return TRUE;
+}
+
+
+/**
+ * bd_nvme_connect:
+ * @subsysnqn: The name for the NVMe subsystem to connect to.
+ * @transport: The network fabric used for a NVMe-over-Fabrics network.
+ * @transport_addr: (nullable): The network address of the Controller. For transports using IP addressing (e.g. `rdma`) this should be an IP-based address.
+ * @transport_svcid: (nullable): The transport service id.  For transports using IP addressing (e.g. `rdma`) this field is the port number. By default, the IP port number for the `RDMA` transport is `4420`.
+ * @host_traddr: (nullable): The network address used on the host to connect to the Controller. For TCP, this sets the source address on the socket.
+ * @host_iface: (nullable): The network interface used on the host to connect to the Controller (e.g. IP `eth1`, `enp2s0`). This forces the connection to be made on a specific interface instead of letting the system decide.
+ * @host_nqn: (nullable): Overrides the default Host NQN that identifies the NVMe Host. If this option is %NULL, the default is read from `/etc/nvme/hostnqn` first.
+ *                        If that does not exist, the autogenerated NQN value from the NVMe Host kernel module is used next. The Host NQN uniquely identifies the NVMe Host.
+ * @host_id: (nullable): User-defined host UUID or %NULL to use default (as defined in `/etc/nvme/hostid`).
+ * @extra: (nullable) (array zero-terminated=1): Additional arguments.
+ * @error: (out) (nullable): Place to store error (if any).
+ *
+ * Creates a transport connection to a remote system (specified by @transport_addr and @transport_svcid)
+ * and creates a NVMe over Fabrics controller for the NVMe subsystem specified by the @subsysnqn option.
+ *
+ * Valid values for @transport include:
+ * - `"rdma"`: An rdma network (RoCE, iWARP, Infiniband, basic rdma, etc.)
+ * - `"fc"`: A Fibre Channel network.
+ * - `"tcp"`: A TCP/IP network.
+ * - `"loop"`: A NVMe over Fabrics target on the local host.
+ *
+ * In addition to the primary options it's possible to supply @extra arguments:
+ * - `"config"`: Use the specified JSON configuration file instead of the default file (see below) or
+ *               specify `"none"` to avoid reading any configuration file.
+ * - `"dhchap_key"`: NVMe In-band authentication secret in ASCII format as described
+ *                      in the NVMe 2.0 specification. When not specified, the secret is by default read
+ *                      from `/etc/nvme/hostkey`. In case that file does not exist no in-band authentication
+ *                      is attempted.
+ * - `"dhchap_ctrl_key"`: NVMe In-band authentication controller secret for bi-directional authentication.
+ *                        When not specified, no bi-directional authentication is attempted.
+ * - `"nr_io_queues"`: The number of I/O queues.
+ * - `"nr_write_queues"`: Number of additional queues that will be used for write I/O.
+ * - `"nr_poll_queues"`: Number of additional queues that will be used for polling latency sensitive I/O.
+ * - `"queue_size"`: Number of elements in the I/O queues.
+ * - `"keep_alive_tmo"`: The keep alive timeout (in seconds).
+ * - `"reconnect_delay"`: The delay (in seconds) before reconnect is attempted after a connect loss.
+ * - `"ctrl_loss_tmo"`: The controller loss timeout period (in seconds). A special value of `-1` will cause reconnecting forever.
+ * - `"fast_io_fail_tmo"`: Fast I/O Fail timeout (in seconds).
+ * - `"tos"`: Type of service.
+ * - `"duplicate_connect"`: Allow duplicated connections between same transport host and subsystem port. Boolean value.
+ * - `"disable_sqflow"`: Disables SQ flow control to omit head doorbell update for submission queues when sending nvme completions. Boolean value.
+ * - `"hdr_digest"`: Generates/verifies header digest (TCP). Boolean value.
+ * - `"data_digest"`: Generates/verifies data digest (TCP). Boolean value.
+ * - `"tls"`: Enable TLS encryption (TCP). Boolean value.
+ * - `"hostsymname"`: TP8010: NVMe host symbolic name.
+ * - `"keyring"`: Keyring to store and lookup keys. String value.
+ * - `"tls_key"`: TLS PSK for the connection. String value.
+ *
+ * Boolean values can be expressed by "0"/"1", "on"/"off" or "True"/"False" case-insensitive
+ * strings. Failed numerical or boolean string conversions will result in the option being ignored.
+ *
+ * By default additional options are read from the default configuration file `/etc/nvme/config.json`.
+ * This follows the default behaviour of `nvme-cli`. Use the @extra `"config"` argument
+ * to either specify a different config file or disable use of it. The JSON configuration
+ * file format is documented in [https://raw.githubusercontent.com/linux-nvme/libnvme/master/doc/config-schema.json](https://raw.githubusercontent.com/linux-nvme/libnvme/master/doc/config-schema.json).
+ * As a rule @extra key names are kept consistent with the JSON config file schema.
+ * Any @extra option generally overrides particular option specified in a configuration file.
+ *
+ * Returns: %TRUE if the subsystem was connected successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_FABRICS-%BD_NVME_TECH_MODE_INITIATOR
+ */
+gboolean bd_nvme_connect (const gchar *subsysnqn, const gchar *transport, const gchar *transport_addr, const gchar *transport_svcid, const gchar *host_traddr, const gchar *host_iface, const gchar *host_nqn, const gchar *host_id, const BDExtraArg **extra, GError **error) {
+    nvme_root_t root;
+    nvme_ctrl_t ctrl;
+
+    if (!_connect (subsysnqn, transport, transport_addr, transport_svcid, host_traddr, host_iface, host_nqn, host_id, extra, FALSE, &root, &ctrl, error))
+        return FALSE;
+
     nvme_free_ctrl (ctrl);
     nvme_free_tree (root);
 
@@ -426,6 +454,406 @@ gboolean bd_nvme_disconnect_by_path (const gchar *path, GError **error) {
 }
 
 
+/**
+ * bd_nvme_discovery_log_entry_free: (skip)
+ * @entry: (nullable): %BDNVMEDiscoveryLogEntry to free
+ *
+ * Frees @entry.
+ */
+void bd_nvme_discovery_log_entry_free (BDNVMEDiscoveryLogEntry *entry) {
+    if (entry == NULL)
+        return;
+
+    g_free (entry->transport_type);
+    g_free (entry->address_family);
+    g_free (entry->transport_addr);
+    g_free (entry->transport_svcid);
+    g_free (entry->subsysnqn);
+    g_free (entry);
+}
+
+/**
+ * bd_nvme_discovery_log_entry_copy: (skip)
+ * @entry: (nullable): %BDNVMEDiscoveryLogEntry to copy
+ *
+ * Creates a new copy of @entry.
+ */
+BDNVMEDiscoveryLogEntry * bd_nvme_discovery_log_entry_copy (BDNVMEDiscoveryLogEntry *entry) {
+    BDNVMEDiscoveryLogEntry *new_entry;
+
+    if (entry == NULL)
+        return NULL;
+
+    new_entry = g_new0 (BDNVMEDiscoveryLogEntry, 1);
+    new_entry->transport_type = g_strdup (entry->transport_type);
+    new_entry->address_family = g_strdup (entry->address_family);
+    new_entry->subsys_type = entry->subsys_type;
+    new_entry->port_id = entry->port_id;
+    new_entry->ctrl_id = entry->ctrl_id;
+    new_entry->transport_addr = g_strdup (entry->transport_addr);
+    new_entry->transport_svcid = g_strdup (entry->transport_svcid);
+    new_entry->subsysnqn = g_strdup (entry->subsysnqn);
+
+    return new_entry;
+}
+
+/**
+ * bd_nvme_discovery_log_free: (skip)
+ * @log: (nullable): %BDNVMEDiscoveryLog to free
+ *
+ * Frees @log.
+ */
+void bd_nvme_discovery_log_free (BDNVMEDiscoveryLog *log) {
+    BDNVMEDiscoveryLogEntry **entries;
+
+    if (log == NULL)
+        return;
+
+    if (log->entries)
+        for (entries = log->entries; *entries; entries++)
+            bd_nvme_discovery_log_entry_free (*entries);
+    g_free (log->entries);
+    g_free (log->discovery_ctrl);
+    g_free (log);
+}
+
+/**
+ * bd_nvme_discovery_log_copy: (skip)
+ * @log: (nullable): %BDNVMEDiscoveryLog to copy
+ *
+ * Creates a new copy of @log.
+ */
+BDNVMEDiscoveryLog * bd_nvme_discovery_log_copy (BDNVMEDiscoveryLog *log) {
+    BDNVMEDiscoveryLog *new_log;
+    BDNVMEDiscoveryLogEntry **entries;
+    GPtrArray *ptr_array;
+
+    if (log == NULL)
+        return NULL;
+
+    new_log = g_new0 (BDNVMEDiscoveryLog, 1);
+    new_log->generation = log->generation;
+    new_log->discovery_ctrl = g_strdup (log->discovery_ctrl);
+
+    ptr_array = g_ptr_array_new ();
+    if (log->entries)
+        for (entries = log->entries; *entries; entries++)
+            g_ptr_array_add (ptr_array, bd_nvme_discovery_log_entry_copy (*entries));
+    g_ptr_array_add (ptr_array, NULL);
+    new_log->entries = (BDNVMEDiscoveryLogEntry **) g_ptr_array_free (ptr_array, FALSE);
+
+    return new_log;
+}
+
+void _nvme_discovery_cache_clear (void) {
+    g_mutex_lock (&disc_cache_lock);
+    if (disc_cache)
+        g_hash_table_destroy (disc_cache);
+    disc_cache = NULL;
+    g_mutex_unlock (&disc_cache_lock);
+}
+
+/* discovery log fields are fixed-size and space padded */
+static gchar * disc_log_str (const char *s, gsize len) {
+    gchar *str;
+
+    str = g_strndup (s, len);
+    g_strchomp (str);
+    if (*str == '\0') {
+        g_free (str);
+        return NULL;
+    }
+    return str;
+}
+
+static BDNVMEDiscoveryLog * parse_discovery_log (struct nvmf_discovery_log *disc_log) {
+    BDNVMEDiscoveryLog *log;
+    GPtrArray *ptr_array;
+    guint64 numrec;
+    guint64 i;
+
+    log = g_new0 (BDNVMEDiscoveryLog, 1);
+    log->generation = GUINT64_FROM_LE (disc_log->genctr);
+
+    ptr_array = g_ptr_array_new ();
+    numrec = GUINT64_FROM_LE (disc_log->numrec);
+    for (i = 0; i < numrec; i++) {
+        struct nvmf_disc_log_entry *e = &disc_log->entries[i];
+        BDNVMEDiscoveryLogEntry *entry;
+
+        entry = g_new0 (BDNVMEDiscoveryLogEntry, 1);
+        entry->transport_type = g_strdup (nvmf_trtype_str (e->trtype));
+        entry->address_family = g_strdup (nvmf_adrfam_str (e->adrfam));
+        switch (e->subtype) {
+            case NVME_NQN_DISC:
+                entry->subsys_type = BD_NVME_DISC_SUBSYS_REFERRAL;
+                break;
+            case NVME_NQN_NVME:
+                entry->subsys_type = BD_NVME_DISC_SUBSYS_NVME;
+                break;
+            case NVME_NQN_CURR:
+                entry->subsys_type = BD_NVME_DISC_SUBSYS_CURRENT;
+                break;
+            default:
+                entry->subsys_type = BD_NVME_DISC_SUBSYS_UNKNOWN;
+        }
+        entry->port_id = GUINT16_FROM_LE (e->portid);
+        entry->ctrl_id = GUINT16_FROM_LE (e->cntlid);
+        entry->transport_addr = disc_log_str (e->traddr, sizeof (e->traddr));
+        entry->transport_svcid = disc_log_str (e->trsvcid, sizeof (e->trsvcid));
+        entry->subsysnqn = disc_log_str (e->subnqn, sizeof (e->subnqn));
+        g_ptr_array_add (ptr_array, entry);
+    }
+    g_ptr_array_add (ptr_array, NULL);  /* trailing NULL element */
+    log->entries = (BDNVMEDiscoveryLogEntry **) g_ptr_array_free (ptr_array, FALSE);
+
+    return log;
+}
+
+/* Reads just the Discovery Log Page header to get the current Generation Counter */
+static gboolean get_discovery_genctr (const gchar *ctrl_name, guint64 *genctr, GError **error) {
+    struct nvmf_discovery_log *hdr;
+    gchar *dev;
+    int fd;
+    int ret;
+
+    dev = g_strdup_printf ("/dev/%s", ctrl_name);
+    fd = _open_dev (dev, error);
+    g_free (dev);
+    if (fd < 0)
+        return FALSE;
+
+    hdr = _nvme_alloc (sizeof (struct nvmf_discovery_log));
+    g_warn_if_fail (hdr != NULL);
+    ret = nvme_get_log_discovery (fd, FALSE /* rae */, 0, sizeof (struct nvmf_discovery_log), hdr);
+    if (ret != 0) {
+        _nvme_status_to_error (ret, FALSE, error);
+        g_prefix_error (error, "NVMe Get Log Page - Discovery Log command error: ");
+        close (fd);
+        free (hdr);
+        return FALSE;
+    }
+    close (fd);
+
+    *genctr = GUINT64_FROM_LE (hdr->genctr);
+    free (hdr);
+    return TRUE;
+}
+
+/* Returns a cache key identifying a particular connection of a discovery controller */
+static gchar * disc_cache_key (nvme_ctrl_t c) {
+    return g_strdup_printf ("%s %s %s", nvme_ctrl_get_name (c),
+                            nvme_ctrl_get_transport (c), nvme_ctrl_get_address (c));
+}
+
+static BDNVMEDiscoveryLog * get_discovery_log (nvme_ctrl_t c, gboolean cache, GError **error) {
+    struct nvmf_discovery_log *disc_log = NULL;
+    BDNVMEDiscoveryLog *log;
+    BDNVMEDiscoveryLog *cached;
+    gchar *key = NULL;
+    guint64 genctr;
+    int ret;
+
+    if (cache) {
+        key = disc_cache_key (c);
+        g_mutex_lock (&disc_cache_lock);
+        cached = disc_cache ? bd_nvme_discovery_log_copy (g_hash_table_lookup (disc_cache, key)) : NULL;
+        g_mutex_unlock (&disc_cache_lock);
+
+        /* the Generation Counter changes on every log update, i.e. whenever
+         * a Discovery Log Page Change AEN is sent to the persistent connection */
+        if (cached) {
+            if (get_discovery_genctr (nvme_ctrl_get_name (c), &genctr, NULL) && genctr == cached->generation) {
+                g_free (key);
+                return cached;
+            }
+            bd_nvme_discovery_log_free (cached);
+        }
+    }
+
+    ret = nvmf_get_discovery_log (c, &disc_log, MAX_DISC_RETRIES);
+    if (ret != 0 || disc_log == NULL) {
+        _nvme_fabrics_errno_to_gerror (ret, errno, error);
+        g_prefix_error (error, "Error retrieving the discovery log: ");
+        g_free (key);
+        return NULL;
+    }
+    log = parse_discovery_log (disc_log);
+    free (disc_log);
+
+    if (cache) {
+        g_mutex_lock (&disc_cache_lock);
+        if (!disc_cache)
+            disc_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                (GDestroyNotify) bd_nvme_discovery_log_free);
+        g_hash_table_replace (disc_cache, key, bd_nvme_discovery_log_copy (log));
+        g_mutex_unlock (&disc_cache_lock);
+    }
+
+    return log;
+}
+
+/**
+ * bd_nvme_discover:
+ * @discovery_ctrl: (nullable): existing persistent discovery controller to use (e.g. `/dev/nvme0`)
+ *                  or %NULL to connect a new one using the transport arguments.
+ * @persistent: whether to keep the newly connected discovery controller connected (ignored when
+ *              @discovery_ctrl is specified).
+ * @transport: (nullable): The network fabric used for a NVMe-over-Fabrics network (see bd_nvme_connect()).
+ * @transport_addr: (nullable): The network address of the Discovery Controller.
+ * @transport_svcid: (nullable): The transport service id.
+ * @host_traddr: (nullable): The network address used on the host to connect to the Discovery Controller.
+ * @host_iface: (nullable): The network interface used on the host to connect to the Discovery Controller.
+ * @host_nqn: (nullable): Overrides the default Host NQN that identifies the NVMe Host.
+ * @host_id: (nullable): User-defined host UUID or %NULL to use default (as defined in `/etc/nvme/hostid`).
+ * @extra: (nullable) (array zero-terminated=1): Additional arguments, same as for bd_nvme_connect().
+ * @error: (out) (nullable): Place to store error (if any).
+ *
+ * Retrieves the Discovery Log Page from a NVMe over Fabrics Discovery Controller, either
+ * an existing persistent one (@discovery_ctrl) or a new one connected to @transport_addr
+ * that is disconnected again afterwards unless @persistent is set.
+ *
+ * Discovery logs retrieved through persistent discovery controllers are cached and only
+ * refreshed when the log Generation Counter changes, which is what the target signals
+ * by the Discovery Log Page Change asynchronous event. Checking the counter only
+ * transfers the log page header.
+ *
+ * Use bd_nvme_connect_all() to connect all the discovered subsystems.
+ *
+ * Returns: (transfer full): the parsed Discovery Log Page or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_FABRICS-%BD_NVME_TECH_MODE_INITIATOR
+ */
+BDNVMEDiscoveryLog * bd_nvme_discover (const gchar *discovery_ctrl, gboolean persistent, const gchar *transport, const gchar *transport_addr, const gchar *transport_svcid, const gchar *host_traddr, const gchar *host_iface, const gchar *host_nqn, const gchar *host_id, const BDExtraArg **extra, GError **error) {
+    nvme_root_t root;
+    nvme_ctrl_t ctrl;
+    BDNVMEDiscoveryLog *log;
+    const gchar *name;
+
+    if (discovery_ctrl) {
+        name = discovery_ctrl;
+        if (g_str_has_prefix (name, "/dev/"))
+            name += 5;
+
+        root = nvme_scan (NULL);
+        if (root == NULL) {
+            g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                         "Failed to scan topology: %s",
+                         strerror_l (errno, _C_LOCALE));
+            return NULL;
+        }
+        ctrl = nvme_scan_ctrl (root, name);
+        if (ctrl == NULL) {
+            g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_NO_MATCH,
+                         "No controllers matching the %s device name found.", discovery_ctrl);
+            nvme_free_tree (root);
+            return NULL;
+        }
+        if (g_strcmp0 (nvme_ctrl_get_subsysnqn (ctrl), NVME_DISC_SUBSYS_NAME) != 0) {
+            g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                         "The %s controller is not a discovery controller", discovery_ctrl);
+            nvme_free_tree (root);
+            return NULL;
+        }
+
+        log = get_discovery_log (ctrl, TRUE, error);
+        if (log)
+            log->discovery_ctrl = g_strdup (nvme_ctrl_get_name (ctrl));
+        nvme_free_tree (root);
+        return log;
+    }
+
+    if (!_connect (NVME_DISC_SUBSYS_NAME, transport, transport_addr, transport_svcid, host_traddr, host_iface, host_nqn, host_id, extra, persistent, &root, &ctrl, error)) {
+        g_prefix_error (error, "Error connecting the discovery controller: ");
+        return NULL;
+    }
+
+    log = get_discovery_log (ctrl, persistent, error);
+    if (log && persistent)
+        log->discovery_ctrl = g_strdup (nvme_ctrl_get_name (ctrl));
+    if (!persistent && nvme_disconnect_ctrl (ctrl) != 0) {
+        if (log)
+            g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                         "Error disconnecting the discovery controller: %s",
+                         strerror_l (errno, _C_LOCALE));
+        bd_nvme_discovery_log_free (log);
+        log = NULL;
+    }
+    nvme_free_ctrl (ctrl);
+    nvme_free_tree (root);
+
+    return log;
+}
+
+/* Whether the host is already connected to the subsystem through the same port */
+static gboolean is_connected (nvme_root_t root, BDNVMEDiscoveryLogEntry *entry) {
+    nvme_host_t h;
+    nvme_subsystem_t s;
+    nvme_ctrl_t c;
+
+    nvme_for_each_host (root, h)
+        nvme_for_each_subsystem (h, s) {
+            if (g_strcmp0 (nvme_subsystem_get_nqn (s), entry->subsysnqn) != 0)
+                continue;
+            nvme_subsystem_for_each_ctrl (s, c)
+                if (g_strcmp0 (nvme_ctrl_get_transport (c), entry->transport_type) == 0 &&
+                    g_strcmp0 (nvme_ctrl_get_traddr (c), entry->transport_addr) == 0 &&
+                    g_strcmp0 (nvme_ctrl_get_trsvcid (c), entry->transport_svcid) == 0)
+                    return TRUE;
+        }
+    return FALSE;
+}
+
+/**
+ * bd_nvme_connect_all:
+ * @entries: (array zero-terminated=1): discovery log entries as returned by bd_nvme_discover().
+ * @host_traddr: (nullable): The network address used on the host to connect to the Controllers.
+ * @host_iface: (nullable): The network interface used on the host to connect to the Controllers.
+ * @host_nqn: (nullable): Overrides the default Host NQN that identifies the NVMe Host.
+ * @host_id: (nullable): User-defined host UUID or %NULL to use default (as defined in `/etc/nvme/hostid`).
+ * @extra: (nullable) (array zero-terminated=1): Additional arguments, same as for bd_nvme_connect().
+ * @error: (out) (nullable): Place to store error (if any).
+ *
+ * Connects all NVM subsystems listed in @entries, the equivalent of `nvme connect-all`.
+ * Referrals to other discovery services are skipped, as are subsystem ports
+ * the host is already connected to.
+ *
+ * Returns: %TRUE if all subsystems were connected successfully, %FALSE otherwise with @error
+ *          set (the connections made before the failure are kept).
+ *
+ * Tech category: %BD_NVME_TECH_FABRICS-%BD_NVME_TECH_MODE_INITIATOR
+ */
+gboolean bd_nvme_connect_all (const BDNVMEDiscoveryLogEntry **entries, const gchar *host_traddr, const gchar *host_iface, const gchar *host_nqn, const gchar *host_id, const BDExtraArg **extra, GError **error) {
+    const BDNVMEDiscoveryLogEntry **e;
+    nvme_root_t root;
+
+    root = nvme_scan (NULL);
+    if (root == NULL) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                     "Failed to scan topology: %s",
+                     strerror_l (errno, _C_LOCALE));
+        return FALSE;
+    }
+
+    for (e = entries; e && *e; e++) {
+        if ((*e)->subsys_type != BD_NVME_DISC_SUBSYS_NVME)
+            continue;
+        if (is_connected (root, (BDNVMEDiscoveryLogEntry *) *e))
+            continue;
+
+        if (!bd_nvme_connect ((*e)->subsysnqn, (*e)->transport_type, (*e)->transport_addr, (*e)->transport_svcid,
+                              host_traddr, host_iface, host_nqn, host_id, extra, error)) {
+            g_prefix_error (error, "Error connecting the '%s' subsystem: ", (*e)->subsysnqn);
+            nvme_free_tree (root);
+            return FALSE;
+        }
+    }
+    nvme_free_tree (root);
+
+    return TRUE;
+}
+
+
 /**
  * bd_nvme_find_ctrls_for_ns:
  * @ns_sysfs_path: NVMe namespace device file.
@@ -509,6 +937,270 @@ gchar ** bd_nvme_find_ctrls_for_ns (const gchar *ns_sysfs_path, const gchar *sub
 }
 
 
+static gchar * read_sysfs_attr (const gchar *dir, const gchar *attr) {
+    gchar *path;
+    gchar *contents = NULL;
+
+    if (dir == NULL)
+        return NULL;
+
+    path = g_build_filename (dir, attr, NULL);
+    if (g_file_get_contents (path, &contents, NULL, NULL))
+        g_strstrip (contents);
+    g_free (path);
+
+    return contents;
+}
+
+static BDNVMEANAState ana_state_from_str (const gchar *state) {
+    if (g_strcmp0 (state, "optimized") == 0)
+        return BD_NVME_ANA_STATE_OPTIMIZED;
+    if (g_strcmp0 (state, "non-optimized") == 0)
+        return BD_NVME_ANA_STATE_NON_OPTIMIZED;
+    if (g_strcmp0 (state, "inaccessible") == 0)
+        return BD_NVME_ANA_STATE_INACCESSIBLE;
+    if (g_strcmp0 (state, "persistent-loss") == 0)
+        return BD_NVME_ANA_STATE_PERSISTENT_LOSS;
+    if (g_strcmp0 (state, "change") == 0)
+        return BD_NVME_ANA_STATE_CHANGE;
+    return BD_NVME_ANA_STATE_UNKNOWN;
+}
+
+static BDNVMENamespacePath * get_ns_path (const gchar *name, const gchar *sysfs_dir, const gchar *ana_state, nvme_ctrl_t c) {
+    BDNVMENamespacePath *path;
+    gchar *s;
+
+    path = g_new0 (BDNVMENamespacePath, 1);
+    path->name = g_strdup (name);
+    path->ctrl_name = g_strdup (nvme_ctrl_get_name (c));
+    path->ctrl_state = g_strdup (nvme_ctrl_get_state (c));
+    path->transport = g_strdup (nvme_ctrl_get_transport (c));
+    path->address = g_strdup (nvme_ctrl_get_address (c));
+
+    if (ana_state)
+        path->ana_state = ana_state_from_str (ana_state);
+    else {
+        s = read_sysfs_attr (sysfs_dir, "ana_state");
+        path->ana_state = ana_state_from_str (s);
+        g_free (s);
+    }
+    s = read_sysfs_attr (sysfs_dir, "ana_grpid");
+    if (s)
+        path->ana_grpid = g_ascii_strtoull (s, NULL, 10);
+    g_free (s);
+
+    return path;
+}
+
+/**
+ * bd_nvme_get_namespace_paths:
+ * @device: a NVMe namespace device (e.g. `/dev/nvme0n1`)
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Lists all paths to the namespace @device as set up by the kernel native NVMe multipath,
+ * each path going through a different controller. When native multipath is disabled
+ * a single path representing @device itself is returned.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): null-terminated list of namespace paths
+ *          or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMENamespacePath ** bd_nvme_get_namespace_paths (const gchar *device, GError **error) {
+    GPtrArray *ptr_array;
+    nvme_root_t root;
+    nvme_host_t h;
+    nvme_subsystem_t s;
+    nvme_ctrl_t c;
+    nvme_ns_t n;
+    nvme_path_t p;
+    const gchar *name;
+    gboolean found = FALSE;
+
+    name = device;
+    if (g_str_has_prefix (name, "/dev/"))
+        name += 5;
+
+    root = nvme_scan (NULL);
+    if (root == NULL) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                     "Failed to scan topology: %s",
+                     strerror_l (errno, _C_LOCALE));
+        return NULL;
+    }
+
+    ptr_array = g_ptr_array_new ();
+    nvme_for_each_host (root, h)
+        nvme_for_each_subsystem (h, s) {
+            /* multipath namespace heads */
+            nvme_subsystem_for_each_ns (s, n)
+                if (g_strcmp0 (nvme_ns_get_name (n), name) == 0) {
+                    found = TRUE;
+                    nvme_namespace_for_each_path (n, p)
+                        g_ptr_array_add (ptr_array, get_ns_path (nvme_path_get_name (p),
+                                                                 nvme_path_get_sysfs_dir (p),
+                                                                 nvme_path_get_ana_state (p),
+                                                                 nvme_path_get_ctrl (p)));
+                }
+            /* namespaces attached directly to a controller (native multipath disabled) */
+            nvme_subsystem_for_each_ctrl (s, c)
+                nvme_ctrl_for_each_ns (c, n)
+                    if (g_strcmp0 (nvme_ns_get_name (n), name) == 0) {
+                        found = TRUE;
+                        g_ptr_array_add (ptr_array, get_ns_path (nvme_ns_get_name (n),
+                                                                 nvme_ns_get_sysfs_dir (n),
+                                                                 NULL, c));
+                    }
+        }
+    nvme_free_tree (root);
+
+    if (!found) {
+        g_ptr_array_free (ptr_array, TRUE);
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_NO_MATCH,
+                     "No namespaces matching the %s device name found.", device);
+        return NULL;
+    }
+
+    g_ptr_array_add (ptr_array, NULL);  /* trailing NULL element */
+    return (BDNVMENamespacePath **) g_ptr_array_free (ptr_array, FALSE);
+}
+
+
+static const gchar * const iopolicy_names[] = {
+    [BD_NVME_IOPOLICY_NUMA] = "numa",
+    [BD_NVME_IOPOLICY_ROUND_ROBIN] = "round-robin",
+    [BD_NVME_IOPOLICY_QUEUE_DEPTH] = "queue-depth",
+};
+
+/* Returns sysfs paths of all subsystems matching @subsysnqn */
+static gchar ** find_subsys_dirs (const gchar *subsysnqn, GError **error) {
+    GDir *dir;
+    const gchar *entry;
+    GPtrArray *ptr_array;
+    gchar *subsysnqn_p;
+
+    dir = g_dir_open (NVME_SUBSYS_CLASS_DIR, 0, error);
+    if (!dir) {
+        g_prefix_error (error, "Failed to list NVMe subsystems: ");
+        return NULL;
+    }
+
+    /* the kernel appends a newline to the attribute value */
+    subsysnqn_p = g_strstrip (g_strdup (subsysnqn));
+
+    ptr_array = g_ptr_array_new ();
+    while ((entry = g_dir_read_name (dir))) {
+        gchar *subsys_dir;
+        gchar *nqn;
+
+        subsys_dir = g_build_filename (NVME_SUBSYS_CLASS_DIR, entry, NULL);
+        nqn = read_sysfs_attr (subsys_dir, "subsysnqn");
+        if (g_strcmp0 (nqn, subsysnqn_p) == 0)
+            g_ptr_array_add (ptr_array, subsys_dir);
+        else
+            g_free (subsys_dir);
+        g_free (nqn);
+    }
+    g_dir_close (dir);
+    g_free (subsysnqn_p);
+
+    if (ptr_array->len == 0) {
+        g_ptr_array_free (ptr_array, TRUE);
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_NO_MATCH,
+                     "No subsystems matching '%s' NQN found.", subsysnqn);
+        return NULL;
+    }
+
+    g_ptr_array_add (ptr_array, NULL);  /* trailing NULL element */
+    return (gchar **) g_ptr_array_free (ptr_array, FALSE);
+}
+
+/**
+ * bd_nvme_get_iopolicy:
+ * @subsysnqn: The name of the NVMe subsystem.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves the native multipath I/O policy of the NVMe subsystem @subsysnqn.
+ *
+ * Returns: the I/O policy or %BD_NVME_IOPOLICY_UNKNOWN in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMEIOPolicy bd_nvme_get_iopolicy (const gchar *subsysnqn, GError **error) {
+    gchar **subsys_dirs;
+    gchar *policy;
+    guint i;
+
+    subsys_dirs = find_subsys_dirs (subsysnqn, error);
+    if (!subsys_dirs)
+        return BD_NVME_IOPOLICY_UNKNOWN;
+
+    policy = read_sysfs_attr (subsys_dirs[0], "iopolicy");
+    g_strfreev (subsys_dirs);
+    if (!policy) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                     "Failed to read the I/O policy of the '%s' subsystem", subsysnqn);
+        return BD_NVME_IOPOLICY_UNKNOWN;
+    }
+
+    for (i = BD_NVME_IOPOLICY_NUMA; i < G_N_ELEMENTS (iopolicy_names); i++)
+        if (g_strcmp0 (policy, iopolicy_names[i]) == 0) {
+            g_free (policy);
+            return (BDNVMEIOPolicy) i;
+        }
+
+    g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                 "Unknown I/O policy '%s'", policy);
+    g_free (policy);
+    return BD_NVME_IOPOLICY_UNKNOWN;
+}
+
+/**
+ * bd_nvme_set_iopolicy:
+ * @subsysnqn: The name of the NVMe subsystem.
+ * @policy: the I/O policy to set.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Changes the native multipath I/O policy of all NVMe subsystems matching @subsysnqn.
+ * Note that #BD_NVME_IOPOLICY_QUEUE_DEPTH is only supported by recent kernels.
+ * The setting is not persistent, use udev rules to apply it on every connect.
+ *
+ * Returns: %TRUE if the I/O policy was set successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_MANAGE
+ */
+gboolean bd_nvme_set_iopolicy (const gchar *subsysnqn, BDNVMEIOPolicy policy, GError **error) {
+    gchar **subsys_dirs;
+    gchar **d;
+
+    if (policy == BD_NVME_IOPOLICY_UNKNOWN || policy >= G_N_ELEMENTS (iopolicy_names)) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                     "Invalid I/O policy specified: %d", policy);
+        return FALSE;
+    }
+
+    subsys_dirs = find_subsys_dirs (subsysnqn, error);
+    if (!subsys_dirs)
+        return FALSE;
+
+    for (d = subsys_dirs; *d; d++) {
+        gchar *path;
+
+        path = g_build_filename (*d, "iopolicy", NULL);
+        if (!bd_utils_echo_str_to_file (iopolicy_names[policy], path, error)) {
+            g_prefix_error (error, "Failed to set the '%s' I/O policy: ", iopolicy_names[policy]);
+            g_free (path);
+            g_strfreev (subsys_dirs);
+            return FALSE;
+        }
+        g_free (path);
+    }
+    g_strfreev (subsys_dirs);
+
+    return TRUE;
+}
+
+
 /**
  * bd_nvme_get_host_nqn:
  * @error: (out) (nullable): Place to store error (if any).
@@ -0,0 +1,731 @@
+/*
+ * Copyright (C) 2026  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <malloc.h>
+
+#include <libnvme.h>
+
+#include <blockdev/utils.h>
+#include <check_deps.h>
+#include "nvme.h"
+#include "nvme-private.h"
+
+/* number of entries in the Autonomous Power State Transition table */
+#define APST_TABLE_ENTRIES 32
+/* Host Memory Buffer attributes data structure size */
+#define HMB_ATTRS_SIZE 4096
+/* the spec defines HSIZE in memory page size units (CC.MPS), the kernel driver always uses 4 KiB pages */
+#define HMB_PAGE_SIZE 4096
+
+
+/**
+ * bd_nvme_arbitration_free: (skip)
+ * @arb: (nullable): %BDNVMEArbitration to free
+ *
+ * Frees @arb.
+ */
+void bd_nvme_arbitration_free (BDNVMEArbitration *arb) {
+    g_free (arb);
+}
+
+/**
+ * bd_nvme_arbitration_copy: (skip)
+ * @arb: (nullable): %BDNVMEArbitration to copy
+ *
+ * Creates a new copy of @arb.
+ */
+BDNVMEArbitration * bd_nvme_arbitration_copy (BDNVMEArbitration *arb) {
+    BDNVMEArbitration *new_arb;
+
+    if (arb == NULL)
+        return NULL;
+
+    new_arb = g_new0 (BDNVMEArbitration, 1);
+    memcpy (new_arb, arb, sizeof (BDNVMEArbitration));
+
+    return new_arb;
+}
+
+/**
+ * bd_nvme_apst_entry_free: (skip)
+ * @entry: (nullable): %BDNVMEAPSTEntry to free
+ *
+ * Frees @entry.
+ */
+void bd_nvme_apst_entry_free (BDNVMEAPSTEntry *entry) {
+    g_free (entry);
+}
+
+/**
+ * bd_nvme_apst_entry_copy: (skip)
+ * @entry: (nullable): %BDNVMEAPSTEntry to copy
+ *
+ * Creates a new copy of @entry.
+ */
+BDNVMEAPSTEntry * bd_nvme_apst_entry_copy (BDNVMEAPSTEntry *entry) {
+    BDNVMEAPSTEntry *new_entry;
+
+    if (entry == NULL)
+        return NULL;
+
+    new_entry = g_new0 (BDNVMEAPSTEntry, 1);
+    memcpy (new_entry, entry, sizeof (BDNVMEAPSTEntry));
+
+    return new_entry;
+}
+
+/**
+ * bd_nvme_apst_free: (skip)
+ * @apst: (nullable): %BDNVMEAPST to free
+ *
+ * Frees @apst.
+ */
+void bd_nvme_apst_free (BDNVMEAPST *apst) {
+    BDNVMEAPSTEntry **entries;
+
+    if (apst == NULL)
+        return;
+
+    if (apst->entries)
+        for (entries = apst->entries; *entries; entries++)
+            bd_nvme_apst_entry_free (*entries);
+    g_free (apst->entries);
+    g_free (apst);
+}
+
+/**
+ * bd_nvme_apst_copy: (skip)
+ * @apst: (nullable): %BDNVMEAPST to copy
+ *
+ * Creates a new copy of @apst.
+ */
+BDNVMEAPST * bd_nvme_apst_copy (BDNVMEAPST *apst) {
+    BDNVMEAPST *new_apst;
+    BDNVMEAPSTEntry **entries;
+    GPtrArray *ptr_array;
+
+    if (apst == NULL)
+        return NULL;
+
+    new_apst = g_new0 (BDNVMEAPST, 1);
+    new_apst->enabled = apst->enabled;
+
+    ptr_array = g_ptr_array_new ();
+    if (apst->entries)
+        for (entries = apst->entries; *entries; entries++)
+            g_ptr_array_add (ptr_array, bd_nvme_apst_entry_copy (*entries));
+    g_ptr_array_add (ptr_array, NULL);
+    new_apst->entries = (BDNVMEAPSTEntry **) g_ptr_array_free (ptr_array, FALSE);
+
+    return new_apst;
+}
+
+/**
+ * bd_nvme_host_mem_buffer_free: (skip)
+ * @hmb: (nullable): %BDNVMEHostMemBuffer to free
+ *
+ * Frees @hmb.
+ */
+void bd_nvme_host_mem_buffer_free (BDNVMEHostMemBuffer *hmb) {
+    g_free (hmb);
+}
+
+/**
+ * bd_nvme_host_mem_buffer_copy: (skip)
+ * @hmb: (nullable): %BDNVMEHostMemBuffer to copy
+ *
+ * Creates a new copy of @hmb.
+ */
+BDNVMEHostMemBuffer * bd_nvme_host_mem_buffer_copy (BDNVMEHostMemBuffer *hmb) {
+    BDNVMEHostMemBuffer *new_hmb;
+
+    if (hmb == NULL)
+        return NULL;
+
+    new_hmb = g_new0 (BDNVMEHostMemBuffer, 1);
+    memcpy (new_hmb, hmb, sizeof (BDNVMEHostMemBuffer));
+
+    return new_hmb;
+}
+
+
+static gboolean check_select (BDNVMEFeatureSelect select, gboolean allow_supported, GError **error) {
+    switch (select) {
+        case BD_NVME_FEATURE_SEL_CURRENT:
+        case BD_NVME_FEATURE_SEL_DEFAULT:
+        case BD_NVME_FEATURE_SEL_SAVED:
+            return TRUE;
+        case BD_NVME_FEATURE_SEL_SUPPORTED:
+            if (allow_supported)
+                return TRUE;
+            g_set_error_literal (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                                 "Feature capabilities can only be queried through bd_nvme_get_feature()");
+            return FALSE;
+        default:
+            g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                         "Invalid value specified for the feature select: %d", select);
+            return FALSE;
+    }
+}
+
+/* Sends the Get Features admin command, @data is optional and must be allocated by _nvme_alloc() */
+static gboolean get_feature (const gchar *device, guint8 fid, BDNVMEFeatureSelect select, guint32 cdw11,
+                             void *data, guint32 data_len, guint32 *result, GError **error) {
+    int ret;
+    int fd;
+    guint32 res = 0;
+    struct nvme_get_features_args args = {
+        .args_size = sizeof(args),
+        .timeout = NVME_DEFAULT_IOCTL_TIMEOUT,
+        .nsid = NVME_NSID_NONE,
+    };
+
+    args.fid = fid;
+    args.sel = (enum nvme_get_features_sel) select;
+    args.cdw11 = cdw11;
+    args.data = data;
+    args.data_len = data_len;
+    args.result = &res;
+
+    fd = _open_dev (device, error);
+    if (fd < 0)
+        return FALSE;
+
+    args.fd = fd;
+    ret = nvme_get_features (&args);
+    if (ret != 0) {
+        _nvme_status_to_error (ret, FALSE, error);
+        g_prefix_error (error, "NVMe Get Features command error: ");
+        close (fd);
+        return FALSE;
+    }
+    close (fd);
+
+    if (result)
+        *result = res;
+    return TRUE;
+}
+
+/* Sends the Set Features admin command, @data is optional and must be allocated by _nvme_alloc() */
+static gboolean set_feature (const gchar *device, guint8 fid, guint32 cdw11, gboolean save,
+                             void *data, guint32 data_len, guint32 *result, GError **error) {
+    int ret;
+    int fd;
+    guint32 res = 0;
+    struct nvme_set_features_args args = {
+        .args_size = sizeof(args),
+        .timeout = NVME_DEFAULT_IOCTL_TIMEOUT,
+        .nsid = NVME_NSID_NONE,
+    };
+
+    args.fid = fid;
+    args.cdw11 = cdw11;
+    args.save = save;
+    args.data = data;
+    args.data_len = data_len;
+    args.result = &res;
+
+    fd = _open_dev (device, error);
+    if (fd < 0)
+        return FALSE;
+
+    args.fd = fd;
+    ret = nvme_set_features (&args);
+    if (ret != 0) {
+        _nvme_status_to_error (ret, FALSE, error);
+        g_prefix_error (error, "NVMe Set Features command error: ");
+        close (fd);
+        return FALSE;
+    }
+    close (fd);
+
+    if (result)
+        *result = res;
+    return TRUE;
+}
+
+
+/**
+ * bd_nvme_get_feature:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @feature_id: the Feature Identifier (see #BDNVMEFeatureId for the features with typed helpers).
+ * @select: which value of the feature to retrieve.
+ * @cdw11: feature specific Command Dword 11 value, `0` for most features.
+ * @result: (out): the value of the feature (Dword 0 of the completion queue entry)
+ *          or a bit mask of #BDNVMEFeatureCapability when @select is #BD_NVME_FEATURE_SEL_SUPPORTED.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves the value of the controller feature @feature_id (the Get Features command).
+ * Only features returning their value in the completion queue entry are supported,
+ * use the typed helpers like bd_nvme_get_apst() for the others.
+ *
+ * Returns: %TRUE if the feature was retrieved successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+gboolean bd_nvme_get_feature (const gchar *device, guint8 feature_id, BDNVMEFeatureSelect select, guint32 cdw11, guint32 *result, GError **error) {
+    if (!check_select (select, TRUE, error))
+        return FALSE;
+
+    return get_feature (device, feature_id, select, cdw11, NULL, 0, result, error);
+}
+
+/**
+ * bd_nvme_set_feature:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @feature_id: the Feature Identifier (see #BDNVMEFeatureId for the features with typed helpers).
+ * @cdw11: feature specific Command Dword 11 value (the new value of the feature).
+ * @save: whether to also save the value across power cycles (the feature must be saveable,
+ *        see #BD_NVME_FEATURE_CAP_SAVEABLE).
+ * @result: (out) (optional): feature specific result (Dword 0 of the completion queue entry).
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Changes the value of the controller feature @feature_id (the Set Features command).
+ * Only features taking their value in Command Dword 11 are supported, use the typed
+ * helpers like bd_nvme_set_apst() for the others.
+ *
+ * Returns: %TRUE if the feature was set successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_MANAGE
+ */
+gboolean bd_nvme_set_feature (const gchar *device, guint8 feature_id, guint32 cdw11, gboolean save, guint32 *result, GError **error) {
+    return set_feature (device, feature_id, cdw11, save, NULL, 0, result, error);
+}
+
+/**
+ * bd_nvme_get_volatile_write_cache:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @select: which value of the feature to retrieve (#BD_NVME_FEATURE_SEL_SUPPORTED is not allowed).
+ * @enabled: (out): whether the volatile write cache is enabled.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves the state of the Volatile Write Cache feature.
+ *
+ * Returns: %TRUE if the feature was retrieved successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+gboolean bd_nvme_get_volatile_write_cache (const gchar *device, BDNVMEFeatureSelect select, gboolean *enabled, GError **error) {
+    guint32 result = 0;
+
+    if (!check_select (select, FALSE, error))
+        return FALSE;
+    if (!get_feature (device, NVME_FEAT_FID_VOLATILE_WC, select, 0, NULL, 0, &result, error))
+        return FALSE;
+
+    *enabled = (result & NVME_FEAT_VWC_WCE_MASK) != 0;
+    return TRUE;
+}
+
+/**
+ * bd_nvme_set_volatile_write_cache:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @enabled: whether to enable the volatile write cache.
+ * @save: whether to also save the value across power cycles.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Enables or disables the Volatile Write Cache of the controller.
+ *
+ * Returns: %TRUE if the feature was set successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_MANAGE
+ */
+gboolean bd_nvme_set_volatile_write_cache (const gchar *device, gboolean enabled, gboolean save, GError **error) {
+    return set_feature (device, NVME_FEAT_FID_VOLATILE_WC, enabled ? 1 : 0, save, NULL, 0, NULL, error);
+}
+
+/**
+ * bd_nvme_get_power_state:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @select: which value of the feature to retrieve (#BD_NVME_FEATURE_SEL_SUPPORTED is not allowed).
+ * @power_state: (out): the power state of the controller.
+ * @workload_hint: (out): the type of workload expected.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves the Power Management feature.
+ *
+ * Returns: %TRUE if the feature was retrieved successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+gboolean bd_nvme_get_power_state (const gchar *device, BDNVMEFeatureSelect select, guint8 *power_state, guint8 *workload_hint, GError **error) {
+    guint32 result = 0;
+
+    if (!check_select (select, FALSE, error))
+        return FALSE;
+    if (!get_feature (device, NVME_FEAT_FID_POWER_MGMT, select, 0, NULL, 0, &result, error))
+        return FALSE;
+
+    *power_state = result & 0x1f;
+    *workload_hint = (result >> 5) & 0x07;
+    return TRUE;
+}
+
+/**
+ * bd_nvme_set_power_state:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @power_state: the new power state of the controller (`0`-`31`).
+ * @workload_hint: the type of workload expected (`0`-`7`).
+ * @save: whether to also save the value across power cycles.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Changes the Power Management feature (the power state of the controller).
+ *
+ * Returns: %TRUE if the feature was set successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_MANAGE
+ */
+gboolean bd_nvme_set_power_state (const gchar *device, guint8 power_state, guint8 workload_hint, gboolean save, GError **error) {
+    if (power_state > 0x1f || workload_hint > 0x07) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                     "Invalid power state (%u) or workload hint (%u) specified", power_state, workload_hint);
+        return FALSE;
+    }
+
+    return set_feature (device, NVME_FEAT_FID_POWER_MGMT, power_state | ((guint32) workload_hint << 5),
+                        save, NULL, 0, NULL, error);
+}
+
+/**
+ * bd_nvme_get_apst:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @select: which value of the feature to retrieve (#BD_NVME_FEATURE_SEL_SUPPORTED is not allowed).
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves the Autonomous Power State Transition feature including the transition table.
+ *
+ * Returns: (transfer full): the APST configuration or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMEAPST * bd_nvme_get_apst (const gchar *device, BDNVMEFeatureSelect select, GError **error) {
+    guint32 result = 0;
+    __le64 *table;
+    BDNVMEAPST *apst;
+    GPtrArray *ptr_array;
+    guint i;
+
+    if (!check_select (select, FALSE, error))
+        return NULL;
+
+    table = _nvme_alloc (APST_TABLE_ENTRIES * sizeof (__le64));
+    g_warn_if_fail (table != NULL);
+    if (!get_feature (device, NVME_FEAT_FID_AUTO_PST, select, 0, table,
+                      APST_TABLE_ENTRIES * sizeof (__le64), &result, error)) {
+        free (table);
+        return NULL;
+    }
+
+    apst = g_new0 (BDNVMEAPST, 1);
+    apst->enabled = (result & NVME_FEAT_APST_APSTE_MASK) != 0;
+
+    ptr_array = g_ptr_array_new ();
+    for (i = 0; i < APST_TABLE_ENTRIES; i++) {
+        guint64 e = GUINT64_FROM_LE (table[i]);
+        BDNVMEAPSTEntry *entry;
+
+        entry = g_new0 (BDNVMEAPSTEntry, 1);
+        entry->idle_transition_power_state = (e >> 3) & 0x1f;
+        entry->idle_time_prior_to_transition = (e >> 8) & 0xffffff;
+        g_ptr_array_add (ptr_array, entry);
+    }
+    g_ptr_array_add (ptr_array, NULL);
+    apst->entries = (BDNVMEAPSTEntry **) g_ptr_array_free (ptr_array, FALSE);
+    free (table);
+
+    return apst;
+}
+
+/**
+ * bd_nvme_set_apst:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @enabled: whether to enable Autonomous Power State Transitions.
+ * @entries: (nullable) (array zero-terminated=1): the new transition table (index in the array
+ *           corresponds to the power state) or %NULL to keep the current one.
+ * @save: whether to also save the value across power cycles.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Changes the Autonomous Power State Transition feature. Disabling APST (e.g. on latency
+ * critical systems) is as simple as calling this function with @enabled set to %FALSE
+ * and @entries set to %NULL.
+ *
+ * Returns: %TRUE if the feature was set successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_MANAGE
+ */
+gboolean bd_nvme_set_apst (const gchar *device, gboolean enabled, const BDNVMEAPSTEntry **entries, gboolean save, GError **error) {
+    __le64 *table;
+    gboolean ret;
+    guint i = 0;
+
+    if (entries)
+        while (entries[i])
+            i++;
+    if (i > APST_TABLE_ENTRIES) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                     "Too many APST table entries specified, the maximum is %d", APST_TABLE_ENTRIES);
+        return FALSE;
+    }
+
+    table = _nvme_alloc (APST_TABLE_ENTRIES * sizeof (__le64));
+    g_warn_if_fail (table != NULL);
+
+    if (entries == NULL) {
+        /* the Set Features command always transfers the table, reuse the current one */
+        if (!get_feature (device, NVME_FEAT_FID_AUTO_PST, BD_NVME_FEATURE_SEL_CURRENT, 0, table,
+                          APST_TABLE_ENTRIES * sizeof (__le64), NULL, error)) {
+            g_prefix_error (error, "Error retrieving the current APST table: ");
+            free (table);
+            return FALSE;
+        }
+    } else
+        for (i = 0; entries[i]; i++) {
+            if (entries[i]->idle_transition_power_state > 0x1f || entries[i]->idle_time_prior_to_transition > 0xffffff) {
+                g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                             "Invalid APST table entry %u specified", i);
+                free (table);
+                return FALSE;
+            }
+            table[i] = GUINT64_TO_LE (((guint64) entries[i]->idle_transition_power_state << 3) |
+                                ((guint64) entries[i]->idle_time_prior_to_transition << 8));
+        }
+
+    ret = set_feature (device, NVME_FEAT_FID_AUTO_PST, enabled ? 1 : 0, save, table,
+                       APST_TABLE_ENTRIES * sizeof (__le64), NULL, error);
+    free (table);
+
+    return ret;
+}
+
+/**
+ * bd_nvme_get_arbitration:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @select: which value of the feature to retrieve (#BD_NVME_FEATURE_SEL_SUPPORTED is not allowed).
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves the Arbitration feature (command arbitration among Submission Queues).
+ *
+ * Returns: (transfer full): the arbitration settings or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMEArbitration * bd_nvme_get_arbitration (const gchar *device, BDNVMEFeatureSelect select, GError **error) {
+    guint32 result = 0;
+    BDNVMEArbitration *arb;
+
+    if (!check_select (select, FALSE, error))
+        return NULL;
+    if (!get_feature (device, NVME_FEAT_FID_ARBITRATION, select, 0, NULL, 0, &result, error))
+        return NULL;
+
+    arb = g_new0 (BDNVMEArbitration, 1);
+    arb->burst = result & 0x07;
+    arb->low_priority_weight = (result >> 8) & 0xff;
+    arb->medium_priority_weight = (result >> 16) & 0xff;
+    arb->high_priority_weight = (result >> 24) & 0xff;
+
+    return arb;
+}
+
+/**
+ * bd_nvme_set_arbitration:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @arbitration: the new arbitration settings.
+ * @save: whether to also save the value across power cycles.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Changes the Arbitration feature (command arbitration among Submission Queues).
+ *
+ * Returns: %TRUE if the feature was set successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_MANAGE
+ */
+gboolean bd_nvme_set_arbitration (const gchar *device, BDNVMEArbitration *arbitration, gboolean save, GError **error) {
+    guint32 cdw11;
+
+    if (arbitration->burst > 0x07) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                     "Invalid arbitration burst specified: %u", arbitration->burst);
+        return FALSE;
+    }
+
+    cdw11 = arbitration->burst |
+            ((guint32) arbitration->low_priority_weight << 8) |
+            ((guint32) arbitration->medium_priority_weight << 16) |
+            ((guint32) arbitration->high_priority_weight << 24);
+
+    return set_feature (device, NVME_FEAT_FID_ARBITRATION, cdw11, save, NULL, 0, NULL, error);
+}
+
+/**
+ * bd_nvme_get_num_queues:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @select: which value of the feature to retrieve (#BD_NVME_FEATURE_SEL_SUPPORTED is not allowed).
+ * @num_sq: (out): number of I/O Submission Queues allocated by the controller.
+ * @num_cq: (out): number of I/O Completion Queues allocated by the controller.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves the Number of Queues feature.
+ *
+ * Returns: %TRUE if the feature was retrieved successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+gboolean bd_nvme_get_num_queues (const gchar *device, BDNVMEFeatureSelect select, guint32 *num_sq, guint32 *num_cq, GError **error) {
+    guint32 result = 0;
+
+    if (!check_select (select, FALSE, error))
+        return FALSE;
+    if (!get_feature (device, NVME_FEAT_FID_NUM_QUEUES, select, 0, NULL, 0, &result, error))
+        return FALSE;
+
+    /* both values are 0's based */
+    *num_sq = (result & 0xffff) + 1;
+    *num_cq = (result >> 16) + 1;
+    return TRUE;
+}
+
+/**
+ * bd_nvme_set_num_queues:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @num_sq: number of I/O Submission Queues requested.
+ * @num_cq: number of I/O Completion Queues requested.
+ * @allocated_sq: (out) (optional): number of I/O Submission Queues allocated by the controller.
+ * @allocated_cq: (out) (optional): number of I/O Completion Queues allocated by the controller.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Requests the number of I/O queues. Note that the controllers only allow this before
+ * the I/O queues are created (i.e. the kernel driver normally negotiates this
+ * on controller reset) and a Command Sequence Error is returned otherwise.
+ *
+ * Returns: %TRUE if the feature was set successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_MANAGE
+ */
+gboolean bd_nvme_set_num_queues (const gchar *device, guint32 num_sq, guint32 num_cq, guint32 *allocated_sq, guint32 *allocated_cq, GError **error) {
+    guint32 result = 0;
+
+    if (num_sq < 1 || num_sq > 0xffff || num_cq < 1 || num_cq > 0xffff) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                     "Invalid number of queues specified: %u submission, %u completion", num_sq, num_cq);
+        return FALSE;
+    }
+
+    if (!set_feature (device, NVME_FEAT_FID_NUM_QUEUES, (num_sq - 1) | ((num_cq - 1) << 16),
+                      FALSE, NULL, 0, &result, error))
+        return FALSE;
+
+    if (allocated_sq)
+        *allocated_sq = (result & 0xffff) + 1;
+    if (allocated_cq)
+        *allocated_cq = (result >> 16) + 1;
+    return TRUE;
+}
+
+/**
+ * bd_nvme_get_irq_coalescing:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @select: which value of the feature to retrieve (#BD_NVME_FEATURE_SEL_SUPPORTED is not allowed).
+ * @threshold: (out): Aggregation Threshold, the minimum number of completion queue entries
+ *             to aggregate per interrupt vector (0's based value).
+ * @time: (out): Aggregation Time, the maximum time in 100 microsecond increments that
+ *        the controller may delay an interrupt due to interrupt coalescing.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves the Interrupt Coalescing feature.
+ *
+ * Returns: %TRUE if the feature was retrieved successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+gboolean bd_nvme_get_irq_coalescing (const gchar *device, BDNVMEFeatureSelect select, guint8 *threshold, guint8 *time, GError **error) {
+    guint32 result = 0;
+
+    if (!check_select (select, FALSE, error))
+        return FALSE;
+    if (!get_feature (device, NVME_FEAT_FID_IRQ_COALESCE, select, 0, NULL, 0, &result, error))
+        return FALSE;
+
+    *threshold = result & 0xff;
+    *time = (result >> 8) & 0xff;
+    return TRUE;
+}
+
+/**
+ * bd_nvme_set_irq_coalescing:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @threshold: Aggregation Threshold (0's based value).
+ * @time: Aggregation Time in 100 microsecond increments, `0` disables interrupt coalescing.
+ * @save: whether to also save the value across power cycles.
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Changes the Interrupt Coalescing feature.
+ *
+ * Returns: %TRUE if the feature was set successfully, %FALSE otherwise with @error set.
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_MANAGE
+ */
+gboolean bd_nvme_set_irq_coalescing (const gchar *device, guint8 threshold, guint8 time, gboolean save, GError **error) {
+    return set_feature (device, NVME_FEAT_FID_IRQ_COALESCE, threshold | ((guint32) time << 8),
+                        save, NULL, 0, NULL, error);
+}
+
+/**
+ * bd_nvme_get_host_mem_buffer:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @select: which value of the feature to retrieve (#BD_NVME_FEATURE_SEL_SUPPORTED is not allowed).
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves the Host Memory Buffer feature and its attributes. There's no setter
+ * counterpart as the host memory buffer is owned and managed by the kernel driver,
+ * see the `max_host_mem_size_mb` parameter of the `nvme` kernel module instead.
+ *
+ * Returns: (transfer full): the host memory buffer information or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMEHostMemBuffer * bd_nvme_get_host_mem_buffer (const gchar *device, BDNVMEFeatureSelect select, GError **error) {
+    guint32 result = 0;
+    __le32 *attrs;
+    BDNVMEHostMemBuffer *hmb;
+
+    if (!check_select (select, FALSE, error))
+        return NULL;
+
+    attrs = _nvme_alloc (HMB_ATTRS_SIZE);
+    g_warn_if_fail (attrs != NULL);
+    if (!get_feature (device, NVME_FEAT_FID_HOST_MEM_BUF, select, 0, attrs, HMB_ATTRS_SIZE, &result, error)) {
+        free (attrs);
+        return NULL;
+    }
+
+    hmb = g_new0 (BDNVMEHostMemBuffer, 1);
+    hmb->enabled = (result & 0x01) != 0;
+    hmb->memory_return = (result & 0x02) != 0;
+    /* HSIZE, HMDLAL, HMDLAU, HMDLEC */
+    hmb->size = (guint64) GUINT32_FROM_LE (attrs[0]) * HMB_PAGE_SIZE;
+    hmb->num_descriptors = GUINT32_FROM_LE (attrs[3]);
+    free (attrs);
+
+    return hmb;
+}
@@ -364,6 +364,133 @@ BDNVMESanitizeLog * bd_nvme_sanitize_log_copy (BDNVMESanitizeLog *log) {
     return new_log;
 }
 
+/**
+ * bd_nvme_ana_group_descriptor_free: (skip)
+ * @desc: (nullable): %BDNVMEANAGroupDescriptor to free
+ *
+ * Frees @desc.
+ */
+void bd_nvme_ana_group_descriptor_free (BDNVMEANAGroupDescriptor *desc) {
+    if (desc == NULL)
+        return;
+
+    g_free (desc->nsids);
+    g_free (desc);
+}
+
+/**
+ * bd_nvme_ana_group_descriptor_copy: (skip)
+ * @desc: (nullable): %BDNVMEANAGroupDescriptor to copy
+ *
+ * Creates a new copy of @desc.
+ */
+BDNVMEANAGroupDescriptor * bd_nvme_ana_group_descriptor_copy (BDNVMEANAGroupDescriptor *desc) {
+    BDNVMEANAGroupDescriptor *new_desc;
+    guint n = 0;
+
+    if (desc == NULL)
+        return NULL;
+
+    new_desc = g_new0 (BDNVMEANAGroupDescriptor, 1);
+    memcpy (new_desc, desc, sizeof (BDNVMEANAGroupDescriptor));
+    if (desc->nsids) {
+        while (desc->nsids[n])
+            n++;
+        new_desc->nsids = g_new0 (guint32, n + 1);
+        memcpy (new_desc->nsids, desc->nsids, n * sizeof (guint32));
+    }
+
+    return new_desc;
+}
+
+/**
+ * bd_nvme_ana_log_free: (skip)
+ * @log: (nullable): %BDNVMEANALog to free
+ *
+ * Frees @log.
+ */
+void bd_nvme_ana_log_free (BDNVMEANALog *log) {
+    BDNVMEANAGroupDescriptor **groups;
+
+    if (log == NULL)
+        return;
+
+    if (log->groups)
+        for (groups = log->groups; *groups; groups++)
+            bd_nvme_ana_group_descriptor_free (*groups);
+    g_free (log->groups);
+    g_free (log);
+}
+
+/**
+ * bd_nvme_ana_log_copy: (skip)
+ * @log: (nullable): %BDNVMEANALog to copy
+ *
+ * Creates a new copy of @log.
+ */
+BDNVMEANALog * bd_nvme_ana_log_copy (BDNVMEANALog *log) {
+    BDNVMEANALog *new_log;
+    BDNVMEANAGroupDescriptor **groups;
+    GPtrArray *ptr_array;
+
+    if (log == NULL)
+        return NULL;
+
+    new_log = g_new0 (BDNVMEANALog, 1);
+    new_log->change_count = log->change_count;
+
+    ptr_array = g_ptr_array_new ();
+    if (log->groups)
+        for (groups = log->groups; *groups; groups++)
+            g_ptr_array_add (ptr_array, bd_nvme_ana_group_descriptor_copy (*groups));
+    g_ptr_array_add (ptr_array, NULL);
+    new_log->groups = (BDNVMEANAGroupDescriptor **) g_ptr_array_free (ptr_array, FALSE);
+
+    return new_log;
+}
+
+/**
+ * bd_nvme_namespace_path_free: (skip)
+ * @path: (nullable): %BDNVMENamespacePath to free
+ *
+ * Frees @path.
+ */
+void bd_nvme_namespace_path_free (BDNVMENamespacePath *path) {
+    if (path == NULL)
+        return;
+
+    g_free (path->name);
+    g_free (path->ctrl_name);
+    g_free (path->ctrl_state);
+    g_free (path->transport);
+    g_free (path->address);
+    g_free (path);
+}
+
+/**
+ * bd_nvme_namespace_path_copy: (skip)
+ * @path: (nullable): %BDNVMENamespacePath to copy
+ *
+ * Creates a new copy of @path.
+ */
+BDNVMENamespacePath * bd_nvme_namespace_path_copy (BDNVMENamespacePath *path) {
+    BDNVMENamespacePath *new_path;
+
+    if (path == NULL)
+        return NULL;
+
+    new_path = g_new0 (BDNVMENamespacePath, 1);
+    new_path->name = g_strdup (path->name);
+    new_path->ctrl_name = g_strdup (path->ctrl_name);
+    new_path->ctrl_state = g_strdup (path->ctrl_state);
+    new_path->transport = g_strdup (path->transport);
+    new_path->address = g_strdup (path->address);
+    new_path->ana_state = path->ana_state;
+    new_path->ana_grpid = path->ana_grpid;
+
+    return new_path;
+}
+
 
 /* can't use real __int128 due to gobject-introspection */
 static guint64 int128_to_guint64 (__u8 data[16])
@@ -1141,3 +1268,128 @@ BDNVMESanitizeLog * bd_nvme_get_sanitize_log (const gchar *device, GError **erro
     free (sanitize_log);
     return log;
 }
+
+
+/**
+ * bd_nvme_get_ana_log:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves the Asymmetric Namespace Access Log (Log Identifier `0Ch`) describing
+ * the ANA state of each ANA group as seen through the controller @device belongs to.
+ * Use bd_nvme_get_namespace_paths() to get the state of all paths to a namespace.
+ *
+ * Returns: (transfer full): parsed ANA log or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMEANALog * bd_nvme_get_ana_log (const gchar *device, GError **error) {
+    int ret;
+    int fd;
+    struct nvme_id_ctrl *ctrl_id;
+    struct nvme_ana_log *ana_log;
+    guint32 max_nsids;
+    gsize ana_log_len;
+    guint8 *ptr;
+    guint8 *end;
+    BDNVMEANALog *log;
+    GPtrArray *ptr_array;
+    guint16 ngrps;
+    guint i, j;
+
+    /* open the block device */
+    fd = _open_dev (device, error);
+    if (fd < 0)
+        return NULL;
+
+    /* the log size depends on the number of ANA groups and namespaces reported by the controller */
+    ctrl_id = _nvme_alloc (sizeof (struct nvme_id_ctrl));
+    g_warn_if_fail (ctrl_id != NULL);
+    ret = nvme_identify_ctrl (fd, ctrl_id);
+    if (ret != 0) {
+        _nvme_status_to_error (ret, FALSE, error);
+        g_prefix_error (error, "NVMe Identify Controller command error: ");
+        close (fd);
+        free (ctrl_id);
+        return NULL;
+    }
+    if ((ctrl_id->cmic & NVME_CTRL_CMIC_MULTI_ANA_REPORTING) == 0) {
+        g_set_error_literal (error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                             "The controller doesn't support Asymmetric Namespace Access reporting");
+        close (fd);
+        free (ctrl_id);
+        return NULL;
+    }
+    max_nsids = GUINT32_FROM_LE (ctrl_id->mnan);
+    if (max_nsids == 0)
+        max_nsids = GUINT32_FROM_LE (ctrl_id->nn);
+    ana_log_len = sizeof (struct nvme_ana_log) +
+                  GUINT32_FROM_LE (ctrl_id->nanagrpid) * sizeof (struct nvme_ana_group_desc) +
+                  max_nsids * sizeof (__le32);
+    free (ctrl_id);
+
+    /* send the NVME_LOG_LID_ANA ioctl */
+    ana_log = _nvme_alloc (ana_log_len);
+    g_warn_if_fail (ana_log != NULL);
+    ret = nvme_get_log_ana (fd, NVME_LOG_ANA_LSP_RGO_NAMESPACES, FALSE /* rae */, 0, ana_log_len, ana_log);
+    if (ret != 0) {
+        _nvme_status_to_error (ret, FALSE, error);
+        g_prefix_error (error, "NVMe Get Log Page - Asymmetric Namespace Access Log command error: ");
+        close (fd);
+        free (ana_log);
+        return NULL;
+    }
+    close (fd);
+
+    /* parse the log, group descriptors are of variable length */
+    log = g_new0 (BDNVMEANALog, 1);
+    log->change_count = GUINT64_FROM_LE (ana_log->chgcnt);
+
+    ptr_array = g_ptr_array_new ();
+    ngrps = GUINT16_FROM_LE (ana_log->ngrps);
+    ptr = (guint8 *) ana_log + sizeof (struct nvme_ana_log);
+    end = (guint8 *) ana_log + ana_log_len;
+    for (i = 0; i < ngrps && ptr + sizeof (struct nvme_ana_group_desc) <= end; i++) {
+        struct nvme_ana_group_desc *desc = (struct nvme_ana_group_desc *) ptr;
+        BDNVMEANAGroupDescriptor *group;
+        guint32 nnsids;
+
+        nnsids = GUINT32_FROM_LE (desc->nnsids);
+        if (ptr + sizeof (struct nvme_ana_group_desc) + nnsids * sizeof (__le32) > end)
+            break;
+
+        group = g_new0 (BDNVMEANAGroupDescriptor, 1);
+        group->grpid = GUINT32_FROM_LE (desc->grpid);
+        group->change_count = GUINT64_FROM_LE (desc->chgcnt);
+        switch (desc->state & 0x0f) {
+            case NVME_ANA_STATE_OPTIMIZED:
+                group->state = BD_NVME_ANA_STATE_OPTIMIZED;
+                break;
+            case NVME_ANA_STATE_NONOPTIMIZED:
+                group->state = BD_NVME_ANA_STATE_NON_OPTIMIZED;
+                break;
+            case NVME_ANA_STATE_INACCESSIBLE:
+                group->state = BD_NVME_ANA_STATE_INACCESSIBLE;
+                break;
+            case NVME_ANA_STATE_PERSISTENT_LOSS:
+                group->state = BD_NVME_ANA_STATE_PERSISTENT_LOSS;
+                break;
+            case NVME_ANA_STATE_CHANGE:
+                group->state = BD_NVME_ANA_STATE_CHANGE;
+                break;
+            default:
+                group->state = BD_NVME_ANA_STATE_UNKNOWN;
+        }
+        group->nsids = g_new0 (guint32, nnsids + 1);
+        for (j = 0; j < nnsids; j++)
+            group->nsids[j] = GUINT32_FROM_LE (desc->nsids[j]);
+
+        g_ptr_array_add (ptr_array, group);
+        ptr += sizeof (struct nvme_ana_group_desc) + nnsids * sizeof (__le32);
+    }
+    g_ptr_array_add (ptr_array, NULL);  /* trailing NULL element */
+    log->groups = (BDNVMEANAGroupDescriptor **) g_ptr_array_free (ptr_array, FALSE);
+    free (ana_log);
+
+    return log;
+}
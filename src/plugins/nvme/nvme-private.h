@@ -21,6 +21,10 @@ void _nvme_status_to_error (gint status, gboolean fabrics, GError **error);
 G_GNUC_INTERNAL
 void _nvme_fabrics_errno_to_gerror (int result, int _errno, GError **error);
 
+/* nvme-fabrics.c */
+G_GNUC_INTERNAL
+void _nvme_discovery_cache_clear (void);
+
 /* nvme-info.c */
 G_GNUC_INTERNAL
 gint _open_dev (const gchar *device, GError **error);
@@ -64,7 +64,7 @@ gboolean bd_nvme_init (void) {
  *
  */
 void bd_nvme_close (void) {
-    /* nothing to do here */
+    _nvme_discovery_cache_clear ();
 }
 
 /**
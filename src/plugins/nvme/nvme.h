@@ -534,6 +534,232 @@ typedef enum {
     BD_NVME_SANITIZE_ACTION_CRYPTO_ERASE = 3,
 } BDNVMESanitizeAction;
 
+/**
+ * BDNVMEFeatureSelect:
+ * @BD_NVME_FEATURE_SEL_CURRENT: The current operating value of the feature.
+ * @BD_NVME_FEATURE_SEL_DEFAULT: The default value of the feature.
+ * @BD_NVME_FEATURE_SEL_SAVED: The value of the feature saved across power cycles (only if the feature is saveable,
+ *                             see #BD_NVME_FEATURE_CAP_SAVEABLE).
+ * @BD_NVME_FEATURE_SEL_SUPPORTED: The capabilities of the feature (see #BDNVMEFeatureCapability) instead of its value.
+ */
+typedef enum {
+    BD_NVME_FEATURE_SEL_CURRENT = 0,
+    BD_NVME_FEATURE_SEL_DEFAULT = 1,
+    BD_NVME_FEATURE_SEL_SAVED = 2,
+    BD_NVME_FEATURE_SEL_SUPPORTED = 3,
+} BDNVMEFeatureSelect;
+
+/**
+ * BDNVMEFeatureCapability:
+ * @BD_NVME_FEATURE_CAP_SAVEABLE: The feature value may be saved across power cycles.
+ * @BD_NVME_FEATURE_CAP_NS_SPECIFIC: The feature is namespace specific.
+ * @BD_NVME_FEATURE_CAP_CHANGEABLE: The feature value may be changed.
+ */
+typedef enum {
+    BD_NVME_FEATURE_CAP_SAVEABLE    = 1 << 0,
+    BD_NVME_FEATURE_CAP_NS_SPECIFIC = 1 << 1,
+    BD_NVME_FEATURE_CAP_CHANGEABLE  = 1 << 2,
+} BDNVMEFeatureCapability;
+
+/**
+ * BDNVMEFeatureId:
+ * @BD_NVME_FEATURE_ARBITRATION: Arbitration (`01h`).
+ * @BD_NVME_FEATURE_POWER_MGMT: Power Management (`02h`).
+ * @BD_NVME_FEATURE_VOLATILE_WC: Volatile Write Cache (`06h`).
+ * @BD_NVME_FEATURE_NUM_QUEUES: Number of Queues (`07h`).
+ * @BD_NVME_FEATURE_IRQ_COALESCE: Interrupt Coalescing (`08h`).
+ * @BD_NVME_FEATURE_AUTO_PST: Autonomous Power State Transition (`0Ch`).
+ * @BD_NVME_FEATURE_HOST_MEM_BUF: Host Memory Buffer (`0Dh`).
+ */
+typedef enum {
+    BD_NVME_FEATURE_ARBITRATION  = 0x01,
+    BD_NVME_FEATURE_POWER_MGMT   = 0x02,
+    BD_NVME_FEATURE_VOLATILE_WC  = 0x06,
+    BD_NVME_FEATURE_NUM_QUEUES   = 0x07,
+    BD_NVME_FEATURE_IRQ_COALESCE = 0x08,
+    BD_NVME_FEATURE_AUTO_PST     = 0x0c,
+    BD_NVME_FEATURE_HOST_MEM_BUF = 0x0d,
+} BDNVMEFeatureId;
+
+/**
+ * BDNVMEArbitration:
+ * @burst: Arbitration Burst, the maximum number of commands that the controller may launch
+ *         at one time from a particular Submission Queue as a power of two (`7` means no limit).
+ * @low_priority_weight: Low Priority Weight, the number of commands that may be executed
+ *                       from the low priority service class in each arbitration round (0's based value).
+ * @medium_priority_weight: Medium Priority Weight (0's based value).
+ * @high_priority_weight: High Priority Weight (0's based value).
+ */
+typedef struct BDNVMEArbitration {
+    guint8 burst;
+    guint8 low_priority_weight;
+    guint8 medium_priority_weight;
+    guint8 high_priority_weight;
+} BDNVMEArbitration;
+
+/**
+ * BDNVMEAPSTEntry:
+ * @idle_transition_power_state: Idle Transition Power State, the non-operational power state
+ *                               the controller autonomously transitions to.
+ * @idle_time_prior_to_transition: Idle Time Prior to Transition in milliseconds, `0` disables
+ *                                 the transition.
+ */
+typedef struct BDNVMEAPSTEntry {
+    guint8 idle_transition_power_state;
+    guint32 idle_time_prior_to_transition;
+} BDNVMEAPSTEntry;
+
+/**
+ * BDNVMEAPST:
+ * @enabled: Whether Autonomous Power State Transitions are enabled.
+ * @entries: (array zero-terminated=1) (element-type BDNVMEAPSTEntry): The Autonomous Power State
+ *           Transition table, one entry per power state (index in the array corresponds to the power state).
+ */
+typedef struct BDNVMEAPST {
+    gboolean enabled;
+    BDNVMEAPSTEntry **entries;
+} BDNVMEAPST;
+
+/**
+ * BDNVMEHostMemBuffer:
+ * @enabled: Whether the host memory buffer is enabled.
+ * @memory_return: Whether the host memory buffer was returned to the controller in the same state
+ *                 as it was last enabled.
+ * @size: Size of the host memory buffer in bytes (assuming 4 KiB memory page size).
+ * @num_descriptors: Number of entries in the host memory buffer descriptor list.
+ */
+typedef struct BDNVMEHostMemBuffer {
+    gboolean enabled;
+    gboolean memory_return;
+    guint64 size;
+    guint32 num_descriptors;
+} BDNVMEHostMemBuffer;
+
+/**
+ * BDNVMEANAState:
+ * @BD_NVME_ANA_STATE_UNKNOWN: Unknown or not reported ANA state.
+ * @BD_NVME_ANA_STATE_OPTIMIZED: ANA Optimized state.
+ * @BD_NVME_ANA_STATE_NON_OPTIMIZED: ANA Non-Optimized state, the path is accessible but may perform worse.
+ * @BD_NVME_ANA_STATE_INACCESSIBLE: ANA Inaccessible state, the namespaces are not accessible through this path.
+ * @BD_NVME_ANA_STATE_PERSISTENT_LOSS: ANA Persistent Loss state, the namespaces are permanently not accessible through this path.
+ * @BD_NVME_ANA_STATE_CHANGE: ANA Change state, the ANA state is being transitioned.
+ */
+typedef enum {
+    BD_NVME_ANA_STATE_UNKNOWN = 0,
+    BD_NVME_ANA_STATE_OPTIMIZED = 1,
+    BD_NVME_ANA_STATE_NON_OPTIMIZED = 2,
+    BD_NVME_ANA_STATE_INACCESSIBLE = 3,
+    BD_NVME_ANA_STATE_PERSISTENT_LOSS = 4,
+    BD_NVME_ANA_STATE_CHANGE = 15,
+} BDNVMEANAState;
+
+/**
+ * BDNVMEANAGroupDescriptor:
+ * @grpid: ANA Group ID.
+ * @change_count: ANA change count of the group.
+ * @state: ANA state of the group as seen through the controller the log was retrieved from.
+ * @nsids: (array zero-terminated=1): Namespace Identifiers of attached namespaces in the group.
+ */
+typedef struct BDNVMEANAGroupDescriptor {
+    guint32 grpid;
+    guint64 change_count;
+    BDNVMEANAState state;
+    guint32 *nsids;
+} BDNVMEANAGroupDescriptor;
+
+/**
+ * BDNVMEANALog:
+ * @change_count: ANA change count, incremented each time the log page content changes.
+ * @groups: (array zero-terminated=1) (element-type BDNVMEANAGroupDescriptor): ANA group descriptors.
+ */
+typedef struct BDNVMEANALog {
+    guint64 change_count;
+    BDNVMEANAGroupDescriptor **groups;
+} BDNVMEANALog;
+
+/**
+ * BDNVMENamespacePath:
+ * @name: Name of the path (e.g. `nvme0c1n1`).
+ * @ctrl_name: Name of the controller the path goes through (e.g. `nvme1`).
+ * @ctrl_state: State of the controller (e.g. `live` or `connecting`).
+ * @transport: Transport type of the controller (e.g. `tcp`, `rdma`, `pcie`).
+ * @address: Transport address of the controller.
+ * @ana_state: ANA state of the path.
+ * @ana_grpid: ANA Group ID the namespace is a member of, `0` if not reported.
+ */
+typedef struct BDNVMENamespacePath {
+    gchar *name;
+    gchar *ctrl_name;
+    gchar *ctrl_state;
+    gchar *transport;
+    gchar *address;
+    BDNVMEANAState ana_state;
+    guint32 ana_grpid;
+} BDNVMENamespacePath;
+
+/**
+ * BDNVMEIOPolicy:
+ * @BD_NVME_IOPOLICY_UNKNOWN: Unknown or unsupported I/O policy.
+ * @BD_NVME_IOPOLICY_NUMA: Use the path closest to the submitting NUMA node (kernel default).
+ * @BD_NVME_IOPOLICY_ROUND_ROBIN: Distribute I/O across all optimized paths in a round-robin fashion.
+ * @BD_NVME_IOPOLICY_QUEUE_DEPTH: Send I/O to the optimized path with the least outstanding requests.
+ */
+typedef enum {
+    BD_NVME_IOPOLICY_UNKNOWN = 0,
+    BD_NVME_IOPOLICY_NUMA,
+    BD_NVME_IOPOLICY_ROUND_ROBIN,
+    BD_NVME_IOPOLICY_QUEUE_DEPTH,
+} BDNVMEIOPolicy;
+
+/**
+ * BDNVMEDiscoverySubsysType:
+ * @BD_NVME_DISC_SUBSYS_UNKNOWN: Unknown subsystem type.
+ * @BD_NVME_DISC_SUBSYS_REFERRAL: Referral to another Discovery Service.
+ * @BD_NVME_DISC_SUBSYS_NVME: NVM subsystem that may be connected to.
+ * @BD_NVME_DISC_SUBSYS_CURRENT: The Discovery Subsystem providing the log (current discovery subsystem).
+ */
+typedef enum {
+    BD_NVME_DISC_SUBSYS_UNKNOWN = 0,
+    BD_NVME_DISC_SUBSYS_REFERRAL,
+    BD_NVME_DISC_SUBSYS_NVME,
+    BD_NVME_DISC_SUBSYS_CURRENT,
+} BDNVMEDiscoverySubsysType;
+
+/**
+ * BDNVMEDiscoveryLogEntry:
+ * @transport_type: Transport type (e.g. `tcp`, `rdma`, `fc`, `loop`).
+ * @address_family: Address family (e.g. `ipv4`, `ipv6`, `fc`).
+ * @subsys_type: Subsystem type.
+ * @port_id: NVM subsystem port ID.
+ * @ctrl_id: Controller ID, `0xffff` for the dynamic controller model.
+ * @transport_addr: (nullable): Transport address of the subsystem port.
+ * @transport_svcid: (nullable): Transport service identifier (e.g. the TCP port number).
+ * @subsysnqn: NVM Subsystem Qualified Name.
+ */
+typedef struct BDNVMEDiscoveryLogEntry {
+    gchar *transport_type;
+    gchar *address_family;
+    BDNVMEDiscoverySubsysType subsys_type;
+    guint16 port_id;
+    guint16 ctrl_id;
+    gchar *transport_addr;
+    gchar *transport_svcid;
+    gchar *subsysnqn;
+} BDNVMEDiscoveryLogEntry;
+
+/**
+ * BDNVMEDiscoveryLog:
+ * @generation: Generation Counter, changes every time the log content changes.
+ * @discovery_ctrl: (nullable): Name of the persistent discovery controller the log was retrieved
+ *                  through (e.g. `nvme0`) or %NULL if the discovery controller was disconnected.
+ * @entries: (array zero-terminated=1) (element-type BDNVMEDiscoveryLogEntry): Discovery log entries.
+ */
+typedef struct BDNVMEDiscoveryLog {
+    guint64 generation;
+    gchar *discovery_ctrl;
+    BDNVMEDiscoveryLogEntry **entries;
+} BDNVMEDiscoveryLog;
+
 
 void bd_nvme_controller_info_free (BDNVMEControllerInfo *info);
 BDNVMEControllerInfo * bd_nvme_controller_info_copy (BDNVMEControllerInfo *info);
@@ -560,6 +786,33 @@ BDNVMESelfTestLog * bd_nvme_self_test_log_copy (BDNVMESelfTestLog *log);
 void bd_nvme_sanitize_log_free (BDNVMESanitizeLog *log);
 BDNVMESanitizeLog * bd_nvme_sanitize_log_copy (BDNVMESanitizeLog *log);
 
+void bd_nvme_arbitration_free (BDNVMEArbitration *arb);
+BDNVMEArbitration * bd_nvme_arbitration_copy (BDNVMEArbitration *arb);
+
+void bd_nvme_apst_entry_free (BDNVMEAPSTEntry *entry);
+BDNVMEAPSTEntry * bd_nvme_apst_entry_copy (BDNVMEAPSTEntry *entry);
+
+void bd_nvme_apst_free (BDNVMEAPST *apst);
+BDNVMEAPST * bd_nvme_apst_copy (BDNVMEAPST *apst);
+
+void bd_nvme_host_mem_buffer_free (BDNVMEHostMemBuffer *hmb);
+BDNVMEHostMemBuffer * bd_nvme_host_mem_buffer_copy (BDNVMEHostMemBuffer *hmb);
+
+void bd_nvme_ana_group_descriptor_free (BDNVMEANAGroupDescriptor *desc);
+BDNVMEANAGroupDescriptor * bd_nvme_ana_group_descriptor_copy (BDNVMEANAGroupDescriptor *desc);
+
+void bd_nvme_ana_log_free (BDNVMEANALog *log);
+BDNVMEANALog * bd_nvme_ana_log_copy (BDNVMEANALog *log);
+
+void bd_nvme_namespace_path_free (BDNVMENamespacePath *path);
+BDNVMENamespacePath * bd_nvme_namespace_path_copy (BDNVMENamespacePath *path);
+
+void bd_nvme_discovery_log_entry_free (BDNVMEDiscoveryLogEntry *entry);
+BDNVMEDiscoveryLogEntry * bd_nvme_discovery_log_entry_copy (BDNVMEDiscoveryLogEntry *entry);
+
+void bd_nvme_discovery_log_free (BDNVMEDiscoveryLog *log);
+BDNVMEDiscoveryLog * bd_nvme_discovery_log_copy (BDNVMEDiscoveryLog *log);
+
 /*
  * If using the plugin as a standalone library, the following functions should
  * be called to:
@@ -580,6 +833,8 @@ BDNVMESmartLog *       bd_nvme_get_smart_log         (const gchar *device, GErro
 BDNVMEErrorLogEntry ** bd_nvme_get_error_log_entries (const gchar *device, GError **error);
 BDNVMESelfTestLog *    bd_nvme_get_self_test_log     (const gchar *device, GError **error);
 BDNVMESanitizeLog *    bd_nvme_get_sanitize_log      (const gchar *device, GError **error);
+BDNVMEANALog *         bd_nvme_get_ana_log           (const gchar *device, GError **error);
+BDNVMENamespacePath ** bd_nvme_get_namespace_paths   (const gchar *device, GError **error);
 
 gboolean               bd_nvme_device_self_test      (const gchar                  *device,
                                                       BDNVMESelfTestAction          action,
@@ -620,12 +875,105 @@ gboolean               bd_nvme_disconnect            (const gchar       *subsysn
                                                       GError           **error);
 gboolean               bd_nvme_disconnect_by_path    (const gchar       *path,
                                                       GError           **error);
+BDNVMEDiscoveryLog *   bd_nvme_discover              (const gchar       *discovery_ctrl,
+                                                      gboolean           persistent,
+                                                      const gchar       *transport,
+                                                      const gchar       *transport_addr,
+                                                      const gchar       *transport_svcid,
+                                                      const gchar       *host_traddr,
+                                                      const gchar       *host_iface,
+                                                      const gchar       *host_nqn,
+                                                      const gchar       *host_id,
+                                                      const BDExtraArg **extra,
+                                                      GError           **error);
+gboolean               bd_nvme_connect_all           (const BDNVMEDiscoveryLogEntry **entries,
+                                                      const gchar       *host_traddr,
+                                                      const gchar       *host_iface,
+                                                      const gchar       *host_nqn,
+                                                      const gchar       *host_id,
+                                                      const BDExtraArg **extra,
+                                                      GError           **error);
 
 gchar **               bd_nvme_find_ctrls_for_ns     (const gchar       *ns_sysfs_path,
                                                       const gchar       *subsysnqn,
                                                       const gchar       *host_nqn,
                                                       const gchar       *host_id,
                                                       GError           **error);
+BDNVMEIOPolicy         bd_nvme_get_iopolicy          (const gchar       *subsysnqn,
+                                                      GError           **error);
+gboolean               bd_nvme_set_iopolicy          (const gchar       *subsysnqn,
+                                                      BDNVMEIOPolicy     policy,
+                                                      GError           **error);
+
+gboolean               bd_nvme_get_feature           (const gchar                  *device,
+                                                      guint8                        feature_id,
+                                                      BDNVMEFeatureSelect           select,
+                                                      guint32                       cdw11,
+                                                      guint32                      *result,
+                                                      GError                      **error);
+gboolean               bd_nvme_set_feature           (const gchar                  *device,
+                                                      guint8                        feature_id,
+                                                      guint32                       cdw11,
+                                                      gboolean                      save,
+                                                      guint32                      *result,
+                                                      GError                      **error);
+gboolean               bd_nvme_get_volatile_write_cache (const gchar               *device,
+                                                      BDNVMEFeatureSelect           select,
+                                                      gboolean                     *enabled,
+                                                      GError                      **error);
+gboolean               bd_nvme_set_volatile_write_cache (const gchar               *device,
+                                                      gboolean                      enabled,
+                                                      gboolean                      save,
+                                                      GError                      **error);
+gboolean               bd_nvme_get_power_state       (const gchar                  *device,
+                                                      BDNVMEFeatureSelect           select,
+                                                      guint8                       *power_state,
+                                                      guint8                       *workload_hint,
+                                                      GError                      **error);
+gboolean               bd_nvme_set_power_state       (const gchar                  *device,
+                                                      guint8                        power_state,
+                                                      guint8                        workload_hint,
+                                                      gboolean                      save,
+                                                      GError                      **error);
+BDNVMEAPST *           bd_nvme_get_apst              (const gchar                  *device,
+                                                      BDNVMEFeatureSelect           select,
+                                                      GError                      **error);
+gboolean               bd_nvme_set_apst              (const gchar                  *device,
+                                                      gboolean                      enabled,
+                                                      const BDNVMEAPSTEntry       **entries,
+                                                      gboolean                      save,
+                                                      GError                      **error);
+BDNVMEArbitration *    bd_nvme_get_arbitration       (const gchar                  *device,
+                                                      BDNVMEFeatureSelect           select,
+                                                      GError                      **error);
+gboolean               bd_nvme_set_arbitration       (const gchar                  *device,
+                                                      BDNVMEArbitration            *arbitration,
+                                                      gboolean                      save,
+                                                      GError                      **error);
+gboolean               bd_nvme_get_num_queues        (const gchar                  *device,
+                                                      BDNVMEFeatureSelect           select,
+                                                      guint32                      *num_sq,
+                                                      guint32                      *num_cq,
+                                                      GError                      **error);
+gboolean               bd_nvme_set_num_queues        (const gchar                  *device,
+                                                      guint32                       num_sq,
+                                                      guint32                       num_cq,
+                                                      guint32                      *allocated_sq,
+                                                      guint32                      *allocated_cq,
+                                                      GError                      **error);
+gboolean               bd_nvme_get_irq_coalescing    (const gchar                  *device,
+                                                      BDNVMEFeatureSelect           select,
+                                                      guint8                       *threshold,
+                                                      guint8                       *time,
+                                                      GError                      **error);
+gboolean               bd_nvme_set_irq_coalescing    (const gchar                  *device,
+                                                      guint8                        threshold,
+                                                      guint8                        time,
+                                                      gboolean                      save,
+                                                      GError                      **error);
+BDNVMEHostMemBuffer *  bd_nvme_get_host_mem_buffer   (const gchar                  *device,
+                                                      BDNVMEFeatureSelect           select,
+                                                      GError                      **error);
 
 
 #endif  /* BD_NVME */
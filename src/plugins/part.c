@@ -18,8 +18,11 @@
  */
 
 #include <ctype.h>
+#include <errno.h>
 #include <sys/file.h>
+#include <sys/ioctl.h>
 #include <fcntl.h>
+#include <linux/fs.h>
 #include <blockdev/utils.h>
 #include <libfdisk.h>
 #include <locale.h>
@@ -1490,77 +1493,48 @@ static gboolean get_max_part_size (struct fdisk_table *tb, guint partno, guint64
 }
 
 /**
- * bd_part_resize_part:
+ * resize_part: (skip)
+ * @cxt: context of the disk containing the partition
  * @disk: disk containing the partition
  * @part: partition to resize
+ * @part_num: libfdisk number of @part (starting from 0)
  * @size: new partition size, 0 for maximal size
  * @align: alignment to use for the partition end
+ * @write_unchanged: whether to write the label even if the size of @part doesn't change
+ *                   (e.g. because libfdisk relocated the GPT backup header)
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: whether the @part partition was successfully resized on @disk to @size
- *
- * NOTE: The resulting partition may be slightly bigger than requested due to alignment.
- *
- * Tech category: %BD_PART_TECH_MODE_MODIFY_TABLE + the tech according to the partition table type
+ * Resizes @part and writes the label. Only the changed partition is updated in
+ * the kernel (see write_label()) so this works with other partitions (or even
+ * @part itself when growing) in use.
  */
-gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size, BDPartAlign align, GError **error) {
-    gint part_num = 0;
-    struct fdisk_context *cxt = NULL;
+static gboolean resize_part (struct fdisk_context *cxt, const gchar *disk, const gchar *part, gint part_num, guint64 size, BDPartAlign align, gboolean write_unchanged, GError **error) {
     struct fdisk_table *table = NULL;
     struct fdisk_partition *pa = NULL;
     gint ret = 0;
     guint64 old_size = 0;
     guint64 sector_size = 0;
     guint64 grain_size = 0;
-    guint64 progress_id = 0;
     guint64 max_size = 0;
     guint64 start = 0;
     guint64 end = 0;
     gint version = 0;
-    gchar *msg = NULL;
-    GError *l_error = NULL;
-
-    msg = g_strdup_printf ("Started resizing partition '%s'", part);
-    progress_id = bd_utils_report_started (msg);
-    g_free (msg);
-
-    part_num = get_part_num (part, &l_error);
-    if (part_num == -1) {
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return FALSE;
-    }
-
-    /* /dev/sda1 is the partition number 0 in libfdisk */
-    part_num--;
-    cxt = get_device_context (disk, FALSE, &l_error);
-    if (!cxt) {
-        /* error is already populated */
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return FALSE;
-    }
+    gboolean resize = TRUE;
 
     /* get existing partitions and free spaces and sort the table */
     ret = fdisk_get_partitions (cxt, &table);
     if (ret != 0) {
-        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Failed to get existing partitions on the device: %s", strerror_l (-ret, c_locale));
         fdisk_unref_table (table);
-        close_context (cxt);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
         return FALSE;
     }
 
     ret = fdisk_get_freespaces (cxt, &table);
     if (ret != 0) {
-        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Failed to get free spaces on the device: %s", strerror_l (-ret, c_locale));
         fdisk_unref_table (table);
-        close_context (cxt);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
         return FALSE;
     }
 
@@ -1568,25 +1542,19 @@ gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size
 
     ret = fdisk_get_partition (cxt, part_num, &pa);
     if (ret != 0) {
-        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Failed to get partition %d on device '%s'", part_num, disk);
         fdisk_unref_table (table);
-        close_context (cxt);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
         return FALSE;
     }
 
     if (fdisk_partition_has_size (pa))
         old_size = (guint64) fdisk_partition_get_size (pa);
     else {
-        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Failed to get size for partition %d on device '%s'", part_num, disk);
         fdisk_unref_partition (pa);
         fdisk_unref_table (table);
-        close_context (cxt);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
         return FALSE;
     }
 
@@ -1600,44 +1568,37 @@ gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size
         grain_size = (guint64) fdisk_get_minimal_iosize (cxt);
     /* else OPTIMAL or unknown -> nothing to do */
 
-    if (!get_max_part_size (table, part_num, &max_size, &l_error)) {
-        g_prefix_error (&l_error, "Failed to get maximal size for '%s': ", part);
+    if (!get_max_part_size (table, part_num, &max_size, error)) {
+        g_prefix_error (error, "Failed to get maximal size for '%s': ", part);
         fdisk_unref_table (table);
         fdisk_unref_partition (pa);
-        close_context (cxt);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
         return FALSE;
     }
 
     if (size == 0) {
-        if (max_size == old_size) {
-            bd_utils_log_format (BD_UTILS_LOG_INFO, "Not resizing, partition '%s' is already at its maximum size.", part);
-            fdisk_unref_table (table);
-            fdisk_unref_partition (pa);
-            close_context (cxt);
-            bd_utils_report_finished (progress_id, "Completed");
-            return TRUE;
-        }
-
         /* latest libfdisk introduces default end alignment for new partitions, we should
            do the same for resizes where we calculate the size ourselves */
         version = fdisk_get_library_version (NULL);
-        if (version >= 2380 && align != BD_PART_ALIGN_NONE) {
+        if (version >= 2380 && align != BD_PART_ALIGN_NONE && max_size > old_size) {
             start = fdisk_partition_get_start (pa);
             end = start + max_size;
             end = fdisk_align_lba_in_range (cxt, end, start, end);
             max_size = end - start;
         }
 
-        if (fdisk_partition_set_size (pa, max_size) != 0) {
-            g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+        if (max_size <= old_size) {
+            if (!write_unchanged) {
+                bd_utils_log_format (BD_UTILS_LOG_INFO, "Not resizing, partition '%s' is already at its maximum size.", part);
+                fdisk_unref_table (table);
+                fdisk_unref_partition (pa);
+                return TRUE;
+            }
+            resize = FALSE;
+        } else if (fdisk_partition_set_size (pa, max_size) != 0) {
+            g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                          "Failed to set size for partition %d on device '%s'", part_num, disk);
             fdisk_unref_table (table);
             fdisk_unref_partition (pa);
-            close_context (cxt);
-            bd_utils_report_finished (progress_id, l_error->message);
-            g_propagate_error (error, l_error);
             return FALSE;
         }
     } else {
@@ -1647,70 +1608,114 @@ gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size
         size = size / sector_size;
 
         if (size == old_size) {
-            bd_utils_log_format (BD_UTILS_LOG_INFO, "Not resizing, new size after alignment is the same as the old size.");
-            fdisk_unref_table (table);
-            fdisk_unref_partition (pa);
-            close_context (cxt);
-            bd_utils_report_finished (progress_id, "Completed");
-            return TRUE;
+            if (!write_unchanged) {
+                bd_utils_log_format (BD_UTILS_LOG_INFO, "Not resizing, new size after alignment is the same as the old size.");
+                fdisk_unref_table (table);
+                fdisk_unref_partition (pa);
+                return TRUE;
+            }
+            resize = FALSE;
         }
 
-        if (size > old_size && size > max_size) {
+        if (resize && size > old_size && size > max_size) {
             if (size - max_size <= 4 MiB / sector_size) {
                 bd_utils_log_format (BD_UTILS_LOG_INFO,
                                      "Requested size %"G_GUINT64_FORMAT" is bigger than max size for partition '%s', adjusting to %"G_GUINT64_FORMAT".",
                                      size * sector_size, part, max_size * sector_size);
                 size = max_size;
             } else {
-                g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                              "Requested size %"G_GUINT64_FORMAT" is bigger than max size (%"G_GUINT64_FORMAT") for partition '%s'",
                              size * sector_size, max_size * sector_size, part);
                 fdisk_unref_table (table);
                 fdisk_unref_partition (pa);
-                close_context (cxt);
-                bd_utils_report_finished (progress_id, l_error->message);
-                g_propagate_error (error, l_error);
                 return FALSE;
             }
         }
 
-        if (fdisk_partition_set_size (pa, size) != 0) {
-            g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+        if (resize && fdisk_partition_set_size (pa, size) != 0) {
+            g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                          "Failed to set partition size");
             fdisk_unref_table (table);
             fdisk_unref_partition (pa);
-            close_context (cxt);
-            bd_utils_report_finished (progress_id, l_error->message);
-            g_propagate_error (error, l_error);
             return FALSE;
         }
     }
 
-    ret = fdisk_set_partition (cxt, part_num, pa);
-    if (ret != 0) {
-        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
-                     "Failed to resize partition '%s': %s", part, strerror_l (-ret, c_locale));
+    if (resize) {
+        ret = fdisk_set_partition (cxt, part_num, pa);
+        if (ret != 0) {
+            g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                         "Failed to resize partition '%s': %s", part, strerror_l (-ret, c_locale));
+            fdisk_unref_table (table);
+            fdisk_unref_partition (pa);
+            return FALSE;
+        }
+    }
+
+    if (!write_label (cxt, table, disk, FALSE, error)) {
         fdisk_unref_table (table);
         fdisk_unref_partition (pa);
-        close_context (cxt);
+        return FALSE;
+    }
+
+    fdisk_unref_table (table);
+
+    /* XXX: double free in libfdisk, see https://github.com/karelzak/util-linux/pull/822
+    fdisk_unref_partition (pa); */
+
+    return TRUE;
+}
+
+/**
+ * bd_part_resize_part:
+ * @disk: disk containing the partition
+ * @part: partition to resize
+ * @size: new partition size, 0 for maximal size
+ * @align: alignment to use for the partition end
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the @part partition was successfully resized on @disk to @size
+ *
+ * NOTE: The resulting partition may be slightly bigger than requested due to alignment.
+ *
+ * Tech category: %BD_PART_TECH_MODE_MODIFY_TABLE + the tech according to the partition table type
+ */
+gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size, BDPartAlign align, GError **error) {
+    gint part_num = 0;
+    struct fdisk_context *cxt = NULL;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    GError *l_error = NULL;
+
+    msg = g_strdup_printf ("Started resizing partition '%s'", part);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    part_num = get_part_num (part, &l_error);
+    if (part_num == -1) {
         bd_utils_report_finished (progress_id, l_error->message);
         g_propagate_error (error, l_error);
         return FALSE;
     }
 
-    if (!write_label (cxt, table, disk, FALSE, &l_error)) {
+    /* /dev/sda1 is the partition number 0 in libfdisk */
+    part_num--;
+    cxt = get_device_context (disk, FALSE, &l_error);
+    if (!cxt) {
+        /* error is already populated */
         bd_utils_report_finished (progress_id, l_error->message);
         g_propagate_error (error, l_error);
-        fdisk_unref_table (table);
-        fdisk_unref_partition (pa);
-        close_context (cxt);
         return FALSE;
     }
 
-    fdisk_unref_table (table);
+    if (!resize_part (cxt, disk, part, part_num, size, align, FALSE, &l_error)) {
+        close_context (cxt);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
 
-    /* XXX: double free in libfdisk, see https://github.com/karelzak/util-linux/pull/822
-    fdisk_unref_partition (pa); */
     close_context (cxt);
 
     bd_utils_report_finished (progress_id, "Completed");
@@ -1786,6 +1791,135 @@ static gboolean set_part_type (struct fdisk_context *cxt, gint part_num, const g
     return TRUE;
 }
 
+/**
+ * refresh_disk_size: (skip)
+ *
+ * Asks the kernel to re-read the capacity of @disk (if possible) and returns
+ * the current size of @disk in bytes.
+ */
+static guint64 refresh_disk_size (const gchar *disk, GError **error) {
+    gchar *dev_path = NULL;
+    gchar *dev_name = NULL;
+    gchar *rescan_path = NULL;
+    guint64 size = 0;
+    gint fd = 0;
+    GError *l_error = NULL;
+
+    dev_path = bd_utils_resolve_device (disk, NULL);
+    if (dev_path) {
+        /* SCSI devices don't notice the capacity change themselves */
+        dev_name = g_path_get_basename (dev_path);
+        rescan_path = g_strdup_printf ("/sys/class/block/%s/device/rescan", dev_name);
+        if (g_file_test (rescan_path, G_FILE_TEST_EXISTS) &&
+            !bd_utils_echo_str_to_file ("1", rescan_path, &l_error)) {
+            bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to rescan device '%s': %s", disk, l_error->message);
+            g_clear_error (&l_error);
+        }
+        g_free (rescan_path);
+        g_free (dev_name);
+        g_free (dev_path);
+    }
+
+    fd = open (disk, O_RDONLY|O_CLOEXEC);
+    if (fd < 0) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to open device '%s': %s", disk, strerror_l (errno, c_locale));
+        return 0;
+    }
+
+    if (ioctl (fd, BLKGETSIZE64, &size) != 0) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to get size of the device '%s': %s", disk, strerror_l (errno, c_locale));
+        close (fd);
+        return 0;
+    }
+
+    close (fd);
+    return size;
+}
+
+/**
+ * bd_part_grow_to_disk:
+ * @disk: disk containing the partition
+ * @part: partition to grow
+ * @align: alignment to use for the partition end
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Grows the @part partition to the end of the (expanded) @disk. The kernel
+ * is asked to re-read the capacity of @disk, the GPT backup header is moved
+ * to the new end of the disk and @part is extended to the maximum size the
+ * same way bd_part_resize_part() does it with @size 0. Only @part is updated
+ * in the kernel so this works for partitions that are in use (e.g. mounted)
+ * and the filesystem on top of @part can be grown right away.
+ *
+ * Returns: whether the @part partition was successfully grown (or already
+ *          had the maximum size) or not
+ *
+ * Tech category: %BD_PART_TECH_MODE_MODIFY_TABLE + the tech according to the partition table type
+ */
+gboolean bd_part_grow_to_disk (const gchar *disk, const gchar *part, BDPartAlign align, GError **error) {
+    gint part_num = 0;
+    struct fdisk_context *cxt = NULL;
+    struct fdisk_label *lb = NULL;
+    guint64 disk_size = 0;
+    guint64 progress_id = 0;
+    gboolean label_changed = FALSE;
+    gchar *msg = NULL;
+    GError *l_error = NULL;
+
+    msg = g_strdup_printf ("Started growing partition '%s'", part);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    part_num = get_part_num (part, &l_error);
+    if (part_num == -1) {
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    disk_size = refresh_disk_size (disk, &l_error);
+    if (disk_size == 0) {
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    /* /dev/sda1 is the partition number 0 in libfdisk */
+    part_num--;
+
+    /* libfdisk relocates the GPT backup header to the (new) end of the disk
+       and adjusts the last usable LBA when probing the label, the label is
+       then marked as changed and needs to be written even if the partition
+       cannot grow */
+    cxt = get_device_context (disk, FALSE, &l_error);
+    if (!cxt) {
+        /* error is already populated */
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+    lb = fdisk_get_label (cxt, NULL);
+    label_changed = lb && g_strcmp0 (fdisk_label_get_name (lb), table_type_str[BD_PART_TABLE_GPT]) == 0 &&
+                    fdisk_label_is_changed (lb);
+
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "Disk '%s' has %"G_GUINT64_FORMAT" bytes, last usable sector is %"G_GUINT64_FORMAT,
+                         disk, disk_size, (guint64) fdisk_get_last_lba (cxt));
+
+    if (!resize_part (cxt, disk, part, part_num, 0, align, label_changed, &l_error)) {
+        close_context (cxt);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    close_context (cxt);
+
+    bd_utils_report_finished (progress_id, "Completed");
+
+    return TRUE;
+}
+
 /**
  * bd_part_set_part_name:
  * @disk: device the partition belongs to
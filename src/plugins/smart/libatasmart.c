@@ -237,6 +237,34 @@ static void parse_attr_cb (G_GNUC_UNUSED SkDisk             *d,
     g_ptr_array_add (data->ptr_array, attr);
 }
 
+static BDSmartATASelfTestStatus convert_self_test_status (SkSmartSelfTestExecutionStatus status) {
+    switch (status) {
+        case SK_SMART_SELF_TEST_EXECUTION_STATUS_SUCCESS_OR_NEVER:
+            return BD_SMART_ATA_SELF_TEST_STATUS_COMPLETED_NO_ERROR;
+        case SK_SMART_SELF_TEST_EXECUTION_STATUS_ABORTED:
+            return BD_SMART_ATA_SELF_TEST_STATUS_ABORTED_HOST;
+        case SK_SMART_SELF_TEST_EXECUTION_STATUS_INTERRUPTED:
+            return BD_SMART_ATA_SELF_TEST_STATUS_INTR_HOST_RESET;
+        case SK_SMART_SELF_TEST_EXECUTION_STATUS_FATAL:
+            return BD_SMART_ATA_SELF_TEST_STATUS_ERROR_FATAL;
+        case SK_SMART_SELF_TEST_EXECUTION_STATUS_ERROR_UNKNOWN:
+            return BD_SMART_ATA_SELF_TEST_STATUS_ERROR_UNKNOWN;
+        case SK_SMART_SELF_TEST_EXECUTION_STATUS_ERROR_ELECTRICAL:
+            return BD_SMART_ATA_SELF_TEST_STATUS_ERROR_ELECTRICAL;
+        case SK_SMART_SELF_TEST_EXECUTION_STATUS_ERROR_SERVO:
+            return BD_SMART_ATA_SELF_TEST_STATUS_ERROR_SERVO;
+        case SK_SMART_SELF_TEST_EXECUTION_STATUS_ERROR_READ:
+            return BD_SMART_ATA_SELF_TEST_STATUS_ERROR_READ;
+        case SK_SMART_SELF_TEST_EXECUTION_STATUS_ERROR_HANDLING:
+            return BD_SMART_ATA_SELF_TEST_STATUS_ERROR_HANDLING;
+        case SK_SMART_SELF_TEST_EXECUTION_STATUS_INPROGRESS:
+            return BD_SMART_ATA_SELF_TEST_STATUS_IN_PROGRESS;
+        default:
+            g_warn_if_reached ();
+            return BD_SMART_ATA_SELF_TEST_STATUS_COMPLETED_NO_ERROR;
+    }
+}
+
 static BDSmartATA * parse_sk_data (SkDisk *d, GError **error) {
     SkBool good = FALSE;
     SkBool available = FALSE;
@@ -310,40 +338,7 @@ static BDSmartATA * parse_sk_data (SkDisk *d, GError **error) {
     data->offline_data_collection_completion = parsed_data->total_offline_data_collection_seconds;
     data->offline_data_collection_capabilities = 0;       /* TODO */
 
-    switch (parsed_data->self_test_execution_status) {
-        case SK_SMART_SELF_TEST_EXECUTION_STATUS_SUCCESS_OR_NEVER:
-            data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_COMPLETED_NO_ERROR;
-            break;
-        case SK_SMART_SELF_TEST_EXECUTION_STATUS_ABORTED:
-            data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ABORTED_HOST;
-            break;
-        case SK_SMART_SELF_TEST_EXECUTION_STATUS_INTERRUPTED:
-            data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_INTR_HOST_RESET;
-            break;
-        case SK_SMART_SELF_TEST_EXECUTION_STATUS_FATAL:
-            data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_FATAL;
-            break;
-        case SK_SMART_SELF_TEST_EXECUTION_STATUS_ERROR_UNKNOWN:
-            data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_UNKNOWN;
-            break;
-        case SK_SMART_SELF_TEST_EXECUTION_STATUS_ERROR_ELECTRICAL:
-            data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_ELECTRICAL;
-            break;
-        case SK_SMART_SELF_TEST_EXECUTION_STATUS_ERROR_SERVO:
-            data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_SERVO;
-            break;
-        case SK_SMART_SELF_TEST_EXECUTION_STATUS_ERROR_READ:
-            data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_READ;
-            break;
-        case SK_SMART_SELF_TEST_EXECUTION_STATUS_ERROR_HANDLING:
-            data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_HANDLING;
-            break;
-        case SK_SMART_SELF_TEST_EXECUTION_STATUS_INPROGRESS:
-            data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_IN_PROGRESS;
-            break;
-        default:
-            g_warn_if_reached ();
-    }
+    data->self_test_status = convert_self_test_status (parsed_data->self_test_execution_status);
 
     data->self_test_percent_remaining = parsed_data->self_test_execution_percent_remaining;
     data->self_test_polling_short = parsed_data->short_test_polling_minutes;
@@ -550,3 +545,55 @@ gboolean bd_smart_device_self_test (const gchar *device, BDSmartSelfTestOp opera
 
     return TRUE;
 }
+
+/**
+ * bd_smart_device_self_test_status:
+ * @device: device to check.
+ * @status: (out): place to store the self-test execution status.
+ * @percent_remaining: (out) (optional): place to store the percentage remaining of a running self-test.
+ * @extra: (nullable) (array zero-terminated=1): extra options to pass through.
+ * @error: (out) (optional): place to store error (if any).
+ *
+ * Retrieves just the self-test execution status of the device. This is much
+ * cheaper than bd_smart_ata_get_info() and suitable for polling a running self-test.
+ *
+ * Returns: %TRUE when the status was retrieved successfully or %FALSE in case of an error (with @error set).
+ *
+ * Tech category: %BD_SMART_TECH_ATA-%BD_SMART_TECH_MODE_SELFTEST
+ */
+gboolean bd_smart_device_self_test_status (const gchar *device, BDSmartATASelfTestStatus *status, gint *percent_remaining, G_GNUC_UNUSED const BDExtraArg **extra, GError **error) {
+    SkDisk *d;
+    const SkSmartParsedData *parsed_data;
+
+    if (sk_disk_open (device, &d) != 0) {
+        g_set_error (error, BD_SMART_ERROR, BD_SMART_ERROR_FAILED,
+                     "Error opening device %s: %s",
+                     device,
+                     strerror_l (errno, _C_LOCALE));
+        return FALSE;
+    }
+
+    /* only a single SMART READ DATA command, no thresholds nor identify parsing */
+    if (sk_disk_smart_read_data (d) != 0) {
+        g_set_error (error, BD_SMART_ERROR, BD_SMART_ERROR_FAILED,
+                     "Error reading SMART data from device: %s",
+                     strerror_l (errno, _C_LOCALE));
+        sk_disk_free (d);
+        return FALSE;
+    }
+
+    if (sk_disk_smart_parse (d, &parsed_data) != 0) {
+        g_set_error (error, BD_SMART_ERROR, BD_SMART_ERROR_FAILED,
+                     "Error parsing SMART data: %s",
+                     strerror_l (errno, _C_LOCALE));
+        sk_disk_free (d);
+        return FALSE;
+    }
+
+    *status = convert_self_test_status (parsed_data->self_test_execution_status);
+    if (percent_remaining)
+        *percent_remaining = parsed_data->self_test_execution_percent_remaining;
+    sk_disk_free (d);
+
+    return TRUE;
+}
@@ -20,6 +20,7 @@
 #include <glib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
 
@@ -29,6 +30,8 @@
 #include "smart.h"
 #include "smart-private.h"
 
+#define DEFAULT_SELF_TEST_POLL_INTERVAL 60
+
 /**
  * SECTION: smart
  * @short_description: S.M.A.R.T. device reporting and management.
@@ -310,3 +313,329 @@ BDSmartSCSI * bd_smart_scsi_copy (BDSmartSCSI *data) {
 
     return new_data;
 }
+
+/**
+ * bd_smart_self_test_progress_free: (skip)
+ * @progress: (nullable): %BDSmartSelfTestProgress to free
+ *
+ * Frees @progress.
+ */
+void bd_smart_self_test_progress_free (BDSmartSelfTestProgress *progress) {
+    if (progress == NULL)
+        return;
+
+    g_free (progress->device);
+    g_free (progress->group);
+    g_free (progress->message);
+    g_free (progress);
+}
+
+/**
+ * bd_smart_self_test_progress_copy: (skip)
+ * @progress: (nullable): %BDSmartSelfTestProgress to copy
+ *
+ * Creates a new copy of @progress.
+ */
+BDSmartSelfTestProgress * bd_smart_self_test_progress_copy (BDSmartSelfTestProgress *progress) {
+    BDSmartSelfTestProgress *new_progress;
+
+    if (progress == NULL)
+        return NULL;
+
+    new_progress = g_new0 (BDSmartSelfTestProgress, 1);
+    memcpy (new_progress, progress, sizeof (BDSmartSelfTestProgress));
+    new_progress->device = g_strdup (progress->device);
+    new_progress->group = g_strdup (progress->group);
+    new_progress->message = g_strdup (progress->message);
+
+    return new_progress;
+}
+
+
+static gboolean is_pci_address (const gchar *name) {
+    guint domain, bus, slot, func;
+    gint len = 0;
+
+    /* e.g. "0000:00:1f.2" */
+    return sscanf (name, "%4x:%2x:%2x.%1x%n", &domain, &bus, &slot, &func, &len) == 4 && name[len] == '\0';
+}
+
+static gchar * get_sysfs_block_path (const gchar *device) {
+    gchar *dev_path = NULL;
+    gchar *dev_name = NULL;
+    gchar *link = NULL;
+    gchar *ret = NULL;
+
+    dev_path = realpath (device, NULL);
+    if (!dev_path)
+        return NULL;
+
+    dev_name = g_path_get_basename (dev_path);
+    link = g_build_filename ("/sys/class/block", dev_name, NULL);
+    ret = realpath (link, NULL);
+
+    free (dev_path);
+    g_free (dev_name);
+    g_free (link);
+
+    return ret;
+}
+
+/**
+ * get_controller_path: (skip)
+ *
+ * The controller is the last PCI device on the sysfs path before the SCSI host, e.g.
+ * /sys/devices/pci0000:00/0000:00:1f.2 for /sys/devices/pci0000:00/0000:00:1f.2/ata1/host0/target0:0:0/0:0:0:0/block/sda.
+ * If there is no PCI device on the path, the SCSI host is used instead.
+ */
+static gchar * get_controller_path (const gchar *sysfs_path) {
+    gchar **parts = NULL;
+    gchar *saved = NULL;
+    gchar *ret = NULL;
+    gint end = -1;
+    gint i;
+
+    parts = g_strsplit (sysfs_path, "/", -1);
+    for (i = 0; parts[i]; i++) {
+        if (g_str_has_prefix (parts[i], "host") && g_ascii_isdigit (parts[i][4])) {
+            if (end < 0)
+                end = i + 1;
+            break;
+        }
+        if (is_pci_address (parts[i]))
+            end = i + 1;
+    }
+
+    if (end < 0) {
+        g_strfreev (parts);
+        return g_strdup (sysfs_path);
+    }
+
+    saved = parts[end];
+    parts[end] = NULL;
+    ret = g_strjoinv ("/", parts);
+    parts[end] = saved;
+    g_strfreev (parts);
+
+    return ret;
+}
+
+/**
+ * get_enclosure_path: (skip)
+ *
+ * SES enclosures link their slots from the SCSI device as device/enclosure_device:<slot>,
+ * the enclosure is the parent of the slot.
+ */
+static gchar * get_enclosure_path (const gchar *sysfs_path) {
+    gchar *dev_dir = NULL;
+    GDir *dir = NULL;
+    const gchar *name = NULL;
+    gchar *link = NULL;
+    gchar *slot = NULL;
+    gchar *ret = NULL;
+
+    dev_dir = g_build_filename (sysfs_path, "device", NULL);
+    dir = g_dir_open (dev_dir, 0, NULL);
+    if (!dir) {
+        g_free (dev_dir);
+        return NULL;
+    }
+
+    while (!ret && (name = g_dir_read_name (dir))) {
+        if (!g_str_has_prefix (name, "enclosure_device:"))
+            continue;
+        link = g_build_filename (dev_dir, name, NULL);
+        slot = realpath (link, NULL);
+        if (slot)
+            ret = g_path_get_dirname (slot);
+        free (slot);
+        g_free (link);
+    }
+
+    g_dir_close (dir);
+    g_free (dev_dir);
+
+    return ret;
+}
+
+static gchar * get_self_test_group (const gchar *device, BDSmartSelfTestGrouping grouping) {
+    gchar *sysfs_path = NULL;
+    gchar *ret = NULL;
+
+    if (grouping == BD_SMART_SELF_TEST_GROUPING_NONE)
+        return g_strdup ("");
+
+    sysfs_path = get_sysfs_block_path (device);
+    if (!sysfs_path)
+        /* self-test on such device is not going to start anyway */
+        return g_strdup (device);
+
+    if (grouping == BD_SMART_SELF_TEST_GROUPING_ENCLOSURE)
+        ret = get_enclosure_path (sysfs_path);
+    if (!ret)
+        ret = get_controller_path (sysfs_path);
+
+    free (sysfs_path);
+    return ret;
+}
+
+static void report_self_test (BDSmartSelfTestProgress *progress, BDSmartSelfTestFunc callback, gpointer user_data) {
+    if (callback)
+        callback (progress, user_data);
+}
+
+/**
+ * bd_smart_schedule_self_tests:
+ * @devices: (array zero-terminated=1): devices to run the self-test on.
+ * @operation: #BDSmartSelfTestOp self-test operation (%BD_SMART_SELF_TEST_OP_SHORT,
+ *             %BD_SMART_SELF_TEST_OP_LONG or %BD_SMART_SELF_TEST_OP_CONVEYANCE).
+ * @grouping: #BDSmartSelfTestGrouping how to group the @devices for the concurrency limit.
+ * @max_concurrent: maximum number of self-tests running at the same time in a single group or 0 for no limit.
+ * @poll_interval: interval (in seconds) for polling the self-test status or 0 for the default (60 seconds).
+ * @callback: (scope call) (closure user_data) (nullable): function to report the progress of the individual self-tests.
+ * @user_data: (nullable): user data for @callback.
+ * @extra: (nullable) (array zero-terminated=1): extra options to pass through.
+ * @error: (out) (optional): place to store error (if any).
+ *
+ * Runs self-tests on all the @devices, starting a new self-test only when fewer than
+ * @max_concurrent self-tests are running in the device's group, and waits for all of
+ * them to finish. Running self-tests are polled using bd_smart_device_self_test_status().
+ * Every change of the state or progress of a self-test is reported through @callback.
+ *
+ * Returns: %TRUE when all the self-tests passed or %FALSE in case of an error (with @error set).
+ *
+ * Tech category: %BD_SMART_TECH_ATA-%BD_SMART_TECH_MODE_SELFTEST
+ */
+gboolean bd_smart_schedule_self_tests (const gchar **devices, BDSmartSelfTestOp operation, BDSmartSelfTestGrouping grouping, guint max_concurrent, guint poll_interval, BDSmartSelfTestFunc callback, gpointer user_data, const BDExtraArg **extra, GError **error) {
+    BDSmartSelfTestProgress *jobs = NULL;
+    GHashTable *running = NULL;
+    guint n_devices = 0;
+    guint n_pending = 0;
+    guint n_running = 0;
+    guint n_finished = 0;
+    guint n_failed = 0;
+    guint count = 0;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    BDSmartATASelfTestStatus status = BD_SMART_ATA_SELF_TEST_STATUS_COMPLETED_NO_ERROR;
+    gint percent_remaining = 0;
+    GError *l_error = NULL;
+    guint i;
+
+    if (operation != BD_SMART_SELF_TEST_OP_SHORT && operation != BD_SMART_SELF_TEST_OP_LONG &&
+        operation != BD_SMART_SELF_TEST_OP_CONVEYANCE) {
+        g_set_error_literal (error, BD_SMART_ERROR, BD_SMART_ERROR_INVALID_ARGUMENT,
+                             "Only short, long and conveyance self-tests can be scheduled.");
+        return FALSE;
+    }
+
+    n_devices = devices ? g_strv_length ((gchar **) devices) : 0;
+    if (n_devices == 0)
+        return TRUE;
+
+    if (poll_interval == 0)
+        poll_interval = DEFAULT_SELF_TEST_POLL_INTERVAL;
+
+    msg = g_strdup_printf ("Started SMART self-tests on %u devices", n_devices);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    jobs = g_new0 (BDSmartSelfTestProgress, n_devices);
+    /* group -> number of self-tests running in it */
+    running = g_hash_table_new (g_str_hash, g_str_equal);
+    for (i = 0; i < n_devices; i++) {
+        jobs[i].device = g_strdup (devices[i]);
+        jobs[i].group = get_self_test_group (devices[i], grouping);
+        jobs[i].state = BD_SMART_SELF_TEST_STATE_PENDING;
+        report_self_test (&jobs[i], callback, user_data);
+    }
+    n_pending = n_devices;
+
+    while (n_pending > 0 || n_running > 0) {
+        /* start as many pending self-tests as the limits allow */
+        for (i = 0; i < n_devices && n_pending > 0; i++) {
+            if (jobs[i].state != BD_SMART_SELF_TEST_STATE_PENDING)
+                continue;
+
+            count = GPOINTER_TO_UINT (g_hash_table_lookup (running, jobs[i].group));
+            if (max_concurrent > 0 && count >= max_concurrent)
+                continue;
+
+            n_pending--;
+            if (!bd_smart_device_self_test (jobs[i].device, operation, extra, &l_error)) {
+                jobs[i].state = BD_SMART_SELF_TEST_STATE_ERROR;
+                jobs[i].message = g_strdup (l_error->message);
+                g_clear_error (&l_error);
+                n_finished++;
+                n_failed++;
+                bd_utils_report_progress (progress_id, n_finished * 100 / n_devices, NULL);
+            } else {
+                jobs[i].state = BD_SMART_SELF_TEST_STATE_RUNNING;
+                jobs[i].status = BD_SMART_ATA_SELF_TEST_STATUS_IN_PROGRESS;
+                jobs[i].percent_remaining = 100;
+                g_hash_table_insert (running, jobs[i].group, GUINT_TO_POINTER (count + 1));
+                n_running++;
+            }
+            report_self_test (&jobs[i], callback, user_data);
+        }
+
+        if (n_running == 0)
+            continue;
+
+        g_usleep ((gulong) poll_interval * G_USEC_PER_SEC);
+
+        for (i = 0; i < n_devices; i++) {
+            if (jobs[i].state != BD_SMART_SELF_TEST_STATE_RUNNING)
+                continue;
+
+            percent_remaining = 0;
+            if (!bd_smart_device_self_test_status (jobs[i].device, &status, &percent_remaining, extra, &l_error)) {
+                jobs[i].state = BD_SMART_SELF_TEST_STATE_ERROR;
+                jobs[i].message = g_strdup (l_error->message);
+                g_clear_error (&l_error);
+            } else if (status == BD_SMART_ATA_SELF_TEST_STATUS_IN_PROGRESS) {
+                if (percent_remaining != jobs[i].percent_remaining) {
+                    jobs[i].percent_remaining = percent_remaining;
+                    report_self_test (&jobs[i], callback, user_data);
+                }
+                continue;
+            } else {
+                jobs[i].status = status;
+                jobs[i].percent_remaining = 0;
+                if (status == BD_SMART_ATA_SELF_TEST_STATUS_COMPLETED_NO_ERROR)
+                    jobs[i].state = BD_SMART_SELF_TEST_STATE_PASSED;
+                else
+                    jobs[i].state = BD_SMART_SELF_TEST_STATE_FAILED;
+            }
+
+            /* the self-test is finished (one way or another), free its slot */
+            count = GPOINTER_TO_UINT (g_hash_table_lookup (running, jobs[i].group));
+            g_hash_table_insert (running, jobs[i].group, GUINT_TO_POINTER (count - 1));
+            n_running--;
+            n_finished++;
+            if (jobs[i].state != BD_SMART_SELF_TEST_STATE_PASSED)
+                n_failed++;
+            report_self_test (&jobs[i], callback, user_data);
+            bd_utils_report_progress (progress_id, n_finished * 100 / n_devices, NULL);
+        }
+    }
+
+    g_hash_table_destroy (running);
+    for (i = 0; i < n_devices; i++) {
+        g_free (jobs[i].device);
+        g_free (jobs[i].group);
+        g_free (jobs[i].message);
+    }
+    g_free (jobs);
+
+    if (n_failed > 0) {
+        g_set_error (&l_error, BD_SMART_ERROR, BD_SMART_ERROR_FAILED,
+                     "%u of %u SMART self-tests did not pass", n_failed, n_devices);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    bd_utils_report_finished (progress_id, "Completed");
+    return TRUE;
+}
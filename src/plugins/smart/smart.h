@@ -414,6 +414,64 @@ typedef enum {
 } BDSmartSelfTestOp;
 
 
+/**
+ * BDSmartSelfTestState:
+ * @BD_SMART_SELF_TEST_STATE_PENDING: Self-test is waiting for a free slot in the device's group.
+ * @BD_SMART_SELF_TEST_STATE_RUNNING: Self-test is running.
+ * @BD_SMART_SELF_TEST_STATE_PASSED: Self-test completed without error.
+ * @BD_SMART_SELF_TEST_STATE_FAILED: Self-test completed with an error or was aborted or interrupted.
+ * @BD_SMART_SELF_TEST_STATE_ERROR: Self-test could not be started or its status could not be retrieved.
+ */
+typedef enum {
+    BD_SMART_SELF_TEST_STATE_PENDING,
+    BD_SMART_SELF_TEST_STATE_RUNNING,
+    BD_SMART_SELF_TEST_STATE_PASSED,
+    BD_SMART_SELF_TEST_STATE_FAILED,
+    BD_SMART_SELF_TEST_STATE_ERROR,
+} BDSmartSelfTestState;
+
+/**
+ * BDSmartSelfTestGrouping:
+ * @BD_SMART_SELF_TEST_GROUPING_NONE: The concurrency limit applies to all devices together.
+ * @BD_SMART_SELF_TEST_GROUPING_CONTROLLER: The concurrency limit applies to devices behind the same storage controller.
+ * @BD_SMART_SELF_TEST_GROUPING_ENCLOSURE: The concurrency limit applies to devices in the same SES enclosure,
+ *                                         devices outside of any enclosure are grouped by their controller.
+ */
+typedef enum {
+    BD_SMART_SELF_TEST_GROUPING_NONE,
+    BD_SMART_SELF_TEST_GROUPING_CONTROLLER,
+    BD_SMART_SELF_TEST_GROUPING_ENCLOSURE,
+} BDSmartSelfTestGrouping;
+
+/**
+ * BDSmartSelfTestProgress:
+ * @device: device the self-test runs on.
+ * @group: concurrency group of the device (sysfs path of its controller or enclosure).
+ * @state: state of the self-test. See #BDSmartSelfTestState.
+ * @status: last self-test execution status reported by the device. See #BDSmartATASelfTestStatus.
+ * @percent_remaining: The percentage remaining of a running self-test.
+ * @message: (nullable): error message in case of the %BD_SMART_SELF_TEST_STATE_ERROR state.
+ */
+typedef struct BDSmartSelfTestProgress {
+    gchar *device;
+    gchar *group;
+    BDSmartSelfTestState state;
+    BDSmartATASelfTestStatus status;
+    gint percent_remaining;
+    gchar *message;
+} BDSmartSelfTestProgress;
+
+/**
+ * BDSmartSelfTestFunc:
+ * @progress: current state of the self-test on a single device.
+ * @user_data: (closure): user data passed to bd_smart_schedule_self_tests().
+ *
+ * Function called by bd_smart_schedule_self_tests() whenever the state or
+ * the progress of a self-test changes.
+ */
+typedef void (*BDSmartSelfTestFunc) (BDSmartSelfTestProgress *progress, gpointer user_data);
+
+
 void bd_smart_ata_free (BDSmartATA *data);
 BDSmartATA * bd_smart_ata_copy (BDSmartATA *data);
 
@@ -423,6 +481,9 @@ BDSmartATAAttribute * bd_smart_ata_attribute_copy (BDSmartATAAttribute *attr);
 void bd_smart_scsi_free (BDSmartSCSI *data);
 BDSmartSCSI * bd_smart_scsi_copy (BDSmartSCSI *data);
 
+void bd_smart_self_test_progress_free (BDSmartSelfTestProgress *progress);
+BDSmartSelfTestProgress * bd_smart_self_test_progress_copy (BDSmartSelfTestProgress *progress);
+
 /*
  * If using the plugin as a standalone library, the following functions should
  * be called to:
@@ -456,5 +517,19 @@ gboolean       bd_smart_device_self_test        (const gchar        *device,
                                                  BDSmartSelfTestOp   operation,
                                                  const BDExtraArg  **extra,
                                                  GError            **error);
+gboolean       bd_smart_device_self_test_status (const gchar        *device,
+                                                 BDSmartATASelfTestStatus *status,
+                                                 gint               *percent_remaining,
+                                                 const BDExtraArg  **extra,
+                                                 GError            **error);
+gboolean       bd_smart_schedule_self_tests     (const gchar       **devices,
+                                                 BDSmartSelfTestOp   operation,
+                                                 BDSmartSelfTestGrouping grouping,
+                                                 guint               max_concurrent,
+                                                 guint               poll_interval,
+                                                 BDSmartSelfTestFunc callback,
+                                                 gpointer            user_data,
+                                                 const BDExtraArg  **extra,
+                                                 GError            **error);
 
 #endif  /* BD_SMART */
@@ -443,6 +443,42 @@ static BDSmartATAAttribute ** parse_ata_smart_attributes (JsonReader *reader, GE
     return (BDSmartATAAttribute **) g_ptr_array_free (ptr_array, FALSE);
 }
 
+static void parse_self_test_status (gint64 val, BDSmartATASelfTestStatus *status, gint *percent_remaining) {
+    switch (val >> 4) {
+        case 0x00:
+            *status = BD_SMART_ATA_SELF_TEST_STATUS_COMPLETED_NO_ERROR;
+            break;
+        case 0x01:
+            *status = BD_SMART_ATA_SELF_TEST_STATUS_ABORTED_HOST;
+            break;
+        case 0x02:
+            *status = BD_SMART_ATA_SELF_TEST_STATUS_INTR_HOST_RESET;
+            break;
+        case 0x03:
+            *status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_FATAL;
+            break;
+        case 0x04:
+            *status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_UNKNOWN;
+            break;
+        case 0x05:
+            *status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_ELECTRICAL;
+            break;
+        case 0x06:
+            *status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_SERVO;
+            break;
+        case 0x07:
+            *status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_READ;
+            break;
+        case 0x08:
+            *status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_HANDLING;
+            break;
+        case 0x0f:
+            *status = BD_SMART_ATA_SELF_TEST_STATUS_IN_PROGRESS;
+            *percent_remaining = (val & 0x0f) * 10;
+            break;
+    }
+}
+
 static BDSmartATA * parse_ata_smart (JsonParser *parser, GError **error) {
     BDSmartATA *data;
     JsonReader *reader;
@@ -525,43 +561,10 @@ static BDSmartATA * parse_ata_smart (JsonParser *parser, GError **error) {
 
     if (json_reader_read_member (reader, "self_test")) {
         if (json_reader_read_member (reader, "status")) {
-            if (json_reader_read_member (reader, "value")) {
-                gint64 val = json_reader_get_int_value (reader);
-
-                switch (val >> 4) {
-                    case 0x00:
-                        data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_COMPLETED_NO_ERROR;
-                        break;
-                    case 0x01:
-                        data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ABORTED_HOST;
-                        break;
-                    case 0x02:
-                        data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_INTR_HOST_RESET;
-                        break;
-                    case 0x03:
-                        data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_FATAL;
-                        break;
-                    case 0x04:
-                        data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_UNKNOWN;
-                        break;
-                    case 0x05:
-                        data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_ELECTRICAL;
-                        break;
-                    case 0x06:
-                        data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_SERVO;
-                        break;
-                    case 0x07:
-                        data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_READ;
-                        break;
-                    case 0x08:
-                        data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_ERROR_HANDLING;
-                        break;
-                    case 0x0f:
-                        data->self_test_status = BD_SMART_ATA_SELF_TEST_STATUS_IN_PROGRESS;
-                        data->self_test_percent_remaining = (val & 0x0f) * 10;
-                        break;
-                }
-            }
+            if (json_reader_read_member (reader, "value"))
+                parse_self_test_status (json_reader_get_int_value (reader),
+                                        &data->self_test_status,
+                                        &data->self_test_percent_remaining);
             json_reader_end_member (reader);
         }
         json_reader_end_member (reader);
@@ -1241,3 +1244,74 @@ gboolean bd_smart_device_self_test (const gchar *device, BDSmartSelfTestOp opera
 
     return TRUE;
 }
+
+/**
+ * bd_smart_device_self_test_status:
+ * @device: device to check.
+ * @status: (out): place to store the self-test execution status.
+ * @percent_remaining: (out) (optional): place to store the percentage remaining of a running self-test.
+ * @extra: (nullable) (array zero-terminated=1): extra options to pass through.
+ * @error: (out) (optional): place to store error (if any).
+ *
+ * Retrieves just the self-test execution status of the device. This is much
+ * cheaper than bd_smart_ata_get_info() and suitable for polling a running self-test.
+ *
+ * Returns: %TRUE when the status was retrieved successfully or %FALSE in case of an error (with @error set).
+ *
+ * Tech category: %BD_SMART_TECH_ATA-%BD_SMART_TECH_MODE_SELFTEST
+ */
+gboolean bd_smart_device_self_test_status (const gchar *device, BDSmartATASelfTestStatus *status, gint *percent_remaining, const BDExtraArg **extra, GError **error) {
+    /* only the General SMART Values, no attributes nor logs */
+    const gchar *args[5] = { "smartctl", "--capabilities", "--json", device, NULL };
+    gint exit_status = 0;
+    gchar *stdout = NULL;
+    gchar *stderr = NULL;
+    JsonParser *parser;
+    JsonReader *reader;
+    gboolean found = FALSE;
+    gint remaining = 0;
+    gboolean ret;
+
+    if (!bd_utils_exec_and_capture_output_no_progress (args, extra, &stdout, &stderr, &exit_status, error)) {
+        g_prefix_error (error, "Error getting SMART self-test status: ");
+        return FALSE;
+    }
+
+    if (stdout)
+        g_strstrip (stdout);
+    if (stderr)
+        g_strstrip (stderr);
+
+    parser = json_parser_new ();
+    ret = parse_smartctl_error (exit_status, stdout, stderr, parser, error);
+    g_free (stdout);
+    g_free (stderr);
+    if (! ret) {
+        g_prefix_error (error, "Error getting SMART self-test status: ");
+        g_object_unref (parser);
+        return FALSE;
+    }
+
+    reader = json_reader_new (json_parser_get_root (parser));
+    if (json_reader_read_member (reader, "ata_smart_data") &&
+        json_reader_read_member (reader, "self_test") &&
+        json_reader_read_member (reader, "status") &&
+        json_reader_read_member (reader, "value")) {
+        *status = BD_SMART_ATA_SELF_TEST_STATUS_COMPLETED_NO_ERROR;
+        parse_self_test_status (json_reader_get_int_value (reader), status, &remaining);
+        found = TRUE;
+    }
+    g_object_unref (reader);
+    g_object_unref (parser);
+
+    if (!found) {
+        g_set_error_literal (error, BD_SMART_ERROR, BD_SMART_ERROR_FAILED,
+                             "Error getting SMART self-test status: Self-test execution status not reported by the device");
+        return FALSE;
+    }
+
+    if (percent_remaining)
+        *percent_remaining = remaining;
+
+    return TRUE;
+}
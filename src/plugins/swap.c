@@ -48,6 +48,46 @@ GQuark bd_swap_error_quark (void)
     return g_quark_from_static_string ("g-bd-swap-error-quark");
 }
 
+BDSwapZramStats* bd_swap_zram_stats_copy (BDSwapZramStats *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDSwapZramStats *new = g_new0 (BDSwapZramStats, 1);
+
+    new->device = g_strdup (data->device);
+    new->disksize = data->disksize;
+    new->comp_algorithm = g_strdup (data->comp_algorithm);
+    new->backing_dev = g_strdup (data->backing_dev);
+    new->orig_data_size = data->orig_data_size;
+    new->compr_data_size = data->compr_data_size;
+    new->mem_used_total = data->mem_used_total;
+    new->mem_limit = data->mem_limit;
+    new->mem_used_max = data->mem_used_max;
+    new->same_pages = data->same_pages;
+    new->pages_compacted = data->pages_compacted;
+    new->huge_pages = data->huge_pages;
+    new->failed_reads = data->failed_reads;
+    new->failed_writes = data->failed_writes;
+    new->invalid_io = data->invalid_io;
+    new->notify_free = data->notify_free;
+    new->bd_count = data->bd_count;
+    new->bd_reads = data->bd_reads;
+    new->bd_writes = data->bd_writes;
+    new->compression_ratio = data->compression_ratio;
+
+    return new;
+}
+
+void bd_swap_zram_stats_free (BDSwapZramStats *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->device);
+    g_free (data->comp_algorithm);
+    g_free (data->backing_dev);
+    g_free (data);
+}
+
 
 static volatile guint avail_deps = 0;
 static GMutex deps_check_lock;
@@ -63,6 +103,16 @@ static const UtilDep deps[DEPS_LAST] = {
     {"swaplabel", NULL, NULL, NULL},
 };
 
+static volatile guint avail_module_deps = 0;
+
+#define MODULE_DEPS_ZRAM 0
+#define MODULE_DEPS_ZRAM_MASK (1 << MODULE_DEPS_ZRAM)
+#define MODULE_DEPS_LAST 1
+
+static const gchar*const module_deps[MODULE_DEPS_LAST] = { "zram" };
+
+#define ZRAM_CONTROL_PATH "/sys/class/zram-control"
+
 
 /**
  * bd_swap_init:
@@ -97,8 +147,19 @@ void bd_swap_close (void) {
  * Returns: whether the @tech-@mode combination is available -- supported by the
  *          plugin implementation and having all the runtime dependencies available
  */
-gboolean bd_swap_is_tech_avail (BDSwapTech tech G_GNUC_UNUSED, guint64 mode, GError **error) {
+gboolean bd_swap_is_tech_avail (BDSwapTech tech, guint64 mode, GError **error) {
     guint32 requires = 0;
+
+    if (tech == BD_SWAP_TECH_ZRAM) {
+        if (mode & (BD_SWAP_TECH_MODE_SET_LABEL|BD_SWAP_TECH_MODE_SET_UUID)) {
+            g_set_error (error, BD_SWAP_ERROR, BD_SWAP_ERROR_TECH_UNAVAIL,
+                         "Only 'create', 'activate-deactivate' and 'query' supported for zram");
+            return FALSE;
+        }
+        if (!check_module_deps (&avail_module_deps, MODULE_DEPS_ZRAM_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
+            return FALSE;
+    }
+
     if (mode & BD_SWAP_TECH_MODE_CREATE)
         requires |= DEPS_MKSWAP_MASK;
     if (mode & BD_SWAP_TECH_MODE_SET_LABEL)
@@ -529,3 +590,299 @@ gboolean bd_swap_set_uuid (const gchar *device, const gchar *uuid, GError **erro
 
     return bd_utils_exec_and_report_error (argv, NULL, error);
 }
+
+/**
+ * get_zram_id: (skip)
+ *
+ * Returns: number of the zram @device (e.g. 0 for "/dev/zram0") or -1 if @device
+ *          is not a zram device
+ */
+static gint64 get_zram_id (const gchar *device) {
+    const gchar *name = device;
+    gchar *endptr = NULL;
+    gint64 id = 0;
+
+    if (g_str_has_prefix (name, "/dev/"))
+        name += 5;
+    if (!g_str_has_prefix (name, "zram"))
+        return -1;
+    name += 4;
+
+    id = g_ascii_strtoll (name, &endptr, 10);
+    if (endptr == name || *endptr != '\0' || id < 0)
+        return -1;
+
+    return id;
+}
+
+static gboolean zram_echo (guint64 id, const gchar *attr, const gchar *value, GError **error) {
+    g_autofree gchar *path = NULL;
+
+    path = g_strdup_printf ("/sys/block/zram%"G_GUINT64_FORMAT"/%s", id, attr);
+    if (!bd_utils_echo_str_to_file (value, path, error)) {
+        g_prefix_error (error, "Failed to set '%s' for zram%"G_GUINT64_FORMAT": ", attr, id);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean zram_remove (guint64 id, GError **error) {
+    g_autofree gchar *id_str = NULL;
+
+    if (!zram_echo (id, "reset", "1", error))
+        return FALSE;
+
+    id_str = g_strdup_printf ("%"G_GUINT64_FORMAT, id);
+    if (!bd_utils_echo_str_to_file (id_str, ZRAM_CONTROL_PATH"/hot_remove", error)) {
+        g_prefix_error (error, "Failed to remove zram%"G_GUINT64_FORMAT": ", id);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_swap_zram_create:
+ * @size: size of the new zram device
+ * @comp_algorithm: (nullable): compression algorithm to use or %NULL for the default
+ * @mem_limit: maximum amount of memory the device can use or 0 for no limit
+ * @backing_dev: (nullable): device to write idle/incompressible pages back to or %NULL
+ * @activate: whether to create and activate swap on the new device or not
+ * @priority: swap priority of the device or -1 to use the default (ignored if
+ *            @activate is %FALSE)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Creates a new zram device, the "zram" kernel module is loaded if needed. With
+ * @activate set to %FALSE the device can be used as a compressed RAM scratch
+ * device (e.g. for a temporary filesystem).
+ *
+ * Returns: (transfer full): path of the new zram device (e.g. "/dev/zram0") or
+ *                           %NULL in case of error
+ *
+ * Tech category: %BD_SWAP_TECH_ZRAM-%BD_SWAP_TECH_MODE_CREATE
+ */
+gchar* bd_swap_zram_create (guint64 size, const gchar *comp_algorithm, guint64 mem_limit, const gchar *backing_dev, gboolean activate, gint priority, GError **error) {
+    gchar *contents = NULL;
+    gchar *value = NULL;
+    gchar *device = NULL;
+    guint64 id = 0;
+    gboolean success = FALSE;
+    guint64 progress_id = 0;
+    GError *l_error = NULL;
+
+    if (!check_module_deps (&avail_module_deps, MODULE_DEPS_ZRAM_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
+        return NULL;
+
+    progress_id = bd_utils_report_started ("Started creating a zram device");
+
+    /* devices are only hot-added by us, no need to have any created on module load */
+    if (!g_file_test (ZRAM_CONTROL_PATH, G_FILE_TEST_IS_DIR) &&
+        !bd_utils_load_kernel_module ("zram", "num_devices=0", &l_error)) {
+        g_prefix_error (&l_error, "Failed to load the zram kernel module: ");
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return NULL;
+    }
+
+    /* reading hot_add creates a new device and returns its number */
+    if (!g_file_get_contents (ZRAM_CONTROL_PATH"/hot_add", &contents, NULL, &l_error)) {
+        g_prefix_error (&l_error, "Failed to add a new zram device: ");
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return NULL;
+    }
+    id = g_ascii_strtoull (g_strstrip (contents), NULL, 10);
+    g_free (contents);
+
+    bd_utils_report_progress (progress_id, 20, "zram device added");
+
+    /* backing device and compression algorithm can only be set before disksize */
+    success = !backing_dev || zram_echo (id, "backing_dev", backing_dev, &l_error);
+    if (success && comp_algorithm)
+        success = zram_echo (id, "comp_algorithm", comp_algorithm, &l_error);
+    if (success) {
+        value = g_strdup_printf ("%"G_GUINT64_FORMAT, size);
+        success = zram_echo (id, "disksize", value, &l_error);
+        g_free (value);
+    }
+    if (success && mem_limit != 0) {
+        value = g_strdup_printf ("%"G_GUINT64_FORMAT, mem_limit);
+        success = zram_echo (id, "mem_limit", value, &l_error);
+        g_free (value);
+    }
+
+    device = g_strdup_printf ("/dev/zram%"G_GUINT64_FORMAT, id);
+    if (success && activate) {
+        bd_utils_report_progress (progress_id, 60, "zram device configured");
+        success = bd_swap_mkswap (device, NULL, NULL, NULL, &l_error) &&
+                  bd_swap_swapon (device, priority, &l_error);
+    }
+
+    if (!success) {
+        /* try to remove the half-configured device, nothing more we can do */
+        zram_remove (id, NULL);
+        g_free (device);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return NULL;
+    }
+
+    bd_utils_report_finished (progress_id, "Completed");
+    return device;
+}
+
+/**
+ * bd_swap_zram_destroy:
+ * @device: zram device to destroy
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Deactivates swap on @device (if active), resets the device and removes it.
+ *
+ * Returns: whether the zram device was successfully destroyed or not
+ *
+ * Tech category: %BD_SWAP_TECH_ZRAM-%BD_SWAP_TECH_MODE_CREATE
+ */
+gboolean bd_swap_zram_destroy (const gchar *device, GError **error) {
+    gint64 id = 0;
+
+    id = get_zram_id (device);
+    if (id < 0) {
+        g_set_error (error, BD_SWAP_ERROR, BD_SWAP_ERROR_ZRAM_NOEXIST,
+                     "'%s' is not a zram device", device);
+        return FALSE;
+    }
+
+    if (bd_swap_swapstatus (device, NULL) && !bd_swap_swapoff (device, error))
+        return FALSE;
+
+    return zram_remove ((guint64) id, error);
+}
+
+/* reads a /sys/block/zramX/@attr file with @n_values numbers separated by whitespace */
+static gboolean read_zram_values (guint64 id, const gchar *attr, guint64 *values, guint n_values, GError **error) {
+    g_autofree gchar *path = NULL;
+    gchar *contents = NULL;
+    gchar **fields = NULL;
+    gchar **field_p = NULL;
+    guint i = 0;
+
+    path = g_strdup_printf ("/sys/block/zram%"G_GUINT64_FORMAT"/%s", id, attr);
+    if (!g_file_get_contents (path, &contents, NULL, error)) {
+        g_prefix_error (error, "Failed to get '%s' for zram%"G_GUINT64_FORMAT": ", attr, id);
+        return FALSE;
+    }
+
+    fields = g_strsplit_set (g_strstrip (contents), " \t", -1);
+    for (field_p = fields; *field_p && i < n_values; field_p++) {
+        if (**field_p == '\0')
+            continue;
+        values[i++] = g_ascii_strtoull (*field_p, NULL, 10);
+    }
+    g_strfreev (fields);
+    g_free (contents);
+
+    if (i < n_values) {
+        g_set_error (error, BD_SWAP_ERROR, BD_SWAP_ERROR_ZRAM_FAIL,
+                     "Failed to parse '%s' for zram%"G_GUINT64_FORMAT, attr, id);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gchar* read_zram_str (guint64 id, const gchar *attr, GError **error) {
+    g_autofree gchar *path = NULL;
+    gchar *contents = NULL;
+
+    path = g_strdup_printf ("/sys/block/zram%"G_GUINT64_FORMAT"/%s", id, attr);
+    if (!g_file_get_contents (path, &contents, NULL, error)) {
+        g_prefix_error (error, "Failed to get '%s' for zram%"G_GUINT64_FORMAT": ", attr, id);
+        return NULL;
+    }
+
+    return g_strstrip (contents);
+}
+
+/**
+ * bd_swap_zram_stats:
+ * @device: zram device to get stats for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): statistics for the zram device or %NULL in case of error
+ *
+ * Tech category: %BD_SWAP_TECH_ZRAM-%BD_SWAP_TECH_MODE_QUERY
+ */
+BDSwapZramStats* bd_swap_zram_stats (const gchar *device, GError **error) {
+    BDSwapZramStats *ret = NULL;
+    guint64 disksize = 0;
+    guint64 mm_stat[8] = {0};
+    guint64 io_stat[4] = {0};
+    guint64 bd_stat[3] = {0};
+    gchar *contents = NULL;
+    gchar *start = NULL;
+    gchar *end = NULL;
+    g_autofree gchar *path = NULL;
+    gint64 id = 0;
+
+    id = get_zram_id (device);
+    path = g_strdup_printf ("/sys/block/zram%"G_GINT64_FORMAT, id);
+    if (id < 0 || !g_file_test (path, G_FILE_TEST_IS_DIR)) {
+        g_set_error (error, BD_SWAP_ERROR, BD_SWAP_ERROR_ZRAM_NOEXIST,
+                     "'%s' is not an existing zram device", device);
+        return NULL;
+    }
+
+    if (!read_zram_values (id, "disksize", &disksize, 1, error) ||
+        !read_zram_values (id, "mm_stat", mm_stat, 8, error) ||
+        !read_zram_values (id, "io_stat", io_stat, 4, error))
+        return NULL;
+
+    /* only available with CONFIG_ZRAM_WRITEBACK */
+    if (!read_zram_values (id, "bd_stat", bd_stat, 3, NULL))
+        memset (bd_stat, 0, sizeof (bd_stat));
+
+    ret = g_new0 (BDSwapZramStats, 1);
+    ret->device = g_strdup_printf ("/dev/zram%"G_GINT64_FORMAT, id);
+    ret->disksize = disksize;
+    ret->orig_data_size = mm_stat[0];
+    ret->compr_data_size = mm_stat[1];
+    ret->mem_used_total = mm_stat[2];
+    ret->mem_limit = mm_stat[3];
+    ret->mem_used_max = mm_stat[4];
+    ret->same_pages = mm_stat[5];
+    ret->pages_compacted = mm_stat[6];
+    ret->huge_pages = mm_stat[7];
+    ret->failed_reads = io_stat[0];
+    ret->failed_writes = io_stat[1];
+    ret->invalid_io = io_stat[2];
+    ret->notify_free = io_stat[3];
+    ret->bd_count = bd_stat[0];
+    ret->bd_reads = bd_stat[1];
+    ret->bd_writes = bd_stat[2];
+
+    /* the algorithm in use is in brackets (e.g. "lzo [lz4] zstd") */
+    contents = read_zram_str (id, "comp_algorithm", error);
+    if (!contents) {
+        bd_swap_zram_stats_free (ret);
+        return NULL;
+    }
+    start = strchr (contents, '[');
+    end = start ? strchr (start, ']') : NULL;
+    if (start && end)
+        ret->comp_algorithm = g_strndup (start + 1, end - start - 1);
+    else
+        ret->comp_algorithm = g_strdup (contents);
+    g_free (contents);
+
+    /* "none" if not set */
+    contents = read_zram_str (id, "backing_dev", NULL);
+    if (contents && g_strcmp0 (contents, "none") != 0)
+        ret->backing_dev = g_strdup (contents);
+    g_free (contents);
+
+    if (ret->compr_data_size > 0)
+        ret->compression_ratio = (gdouble) ret->orig_data_size / ret->compr_data_size;
+
+    return ret;
+}
@@ -16,10 +16,13 @@ typedef enum {
     BD_SWAP_ERROR_ACTIVATE_PAGESIZE,
     BD_SWAP_ERROR_LABEL_INVALID,
     BD_SWAP_ERROR_UUID_INVALID,
+    BD_SWAP_ERROR_ZRAM_NOEXIST,
+    BD_SWAP_ERROR_ZRAM_FAIL,
 } BDSwapError;
 
 typedef enum {
     BD_SWAP_TECH_SWAP = 0,
+    BD_SWAP_TECH_ZRAM,
 } BDSwapTech;
 
 typedef enum {
@@ -30,6 +33,32 @@ typedef enum {
     BD_SWAP_TECH_MODE_SET_UUID            = 1 << 3,
 } BDSwapTechMode;
 
+typedef struct BDSwapZramStats {
+    gchar *device;
+    guint64 disksize;
+    gchar *comp_algorithm;
+    gchar *backing_dev;
+    guint64 orig_data_size;
+    guint64 compr_data_size;
+    guint64 mem_used_total;
+    guint64 mem_limit;
+    guint64 mem_used_max;
+    guint64 same_pages;
+    guint64 pages_compacted;
+    guint64 huge_pages;
+    guint64 failed_reads;
+    guint64 failed_writes;
+    guint64 invalid_io;
+    guint64 notify_free;
+    guint64 bd_count;
+    guint64 bd_reads;
+    guint64 bd_writes;
+    gdouble compression_ratio;
+} BDSwapZramStats;
+
+void bd_swap_zram_stats_free (BDSwapZramStats *data);
+BDSwapZramStats* bd_swap_zram_stats_copy (BDSwapZramStats *data);
+
 /*
  * If using the plugin as a standalone library, the following functions should
  * be called to:
@@ -52,4 +81,8 @@ gboolean bd_swap_check_label (const gchar *label, GError **error);
 gboolean bd_swap_set_uuid (const gchar *device, const gchar *uuid, GError **error);
 gboolean bd_swap_check_uuid (const gchar *uuid, GError **error);
 
+gchar* bd_swap_zram_create (guint64 size, const gchar *comp_algorithm, guint64 mem_limit, const gchar *backing_dev, gboolean activate, gint priority, GError **error);
+gboolean bd_swap_zram_destroy (const gchar *device, GError **error);
+BDSwapZramStats* bd_swap_zram_stats (const gchar *device, GError **error);
+
 #endif  /* BD_SWAP */
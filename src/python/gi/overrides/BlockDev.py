@@ -25,18 +25,30 @@ the :class:`ErrorProxy` class and makes sure the exception transformation
 happens. It of course calls the ``swap_swapon`` function internally so there's
 no code duplication and it propagates non-callable objects directly.
 
+Long-running functions can also be awaited from asyncio code through the
+:class:`AsyncProxy` instances in the ``aio`` namespace. For example
+``await BlockDev.aio.md.create(...)`` runs ``BlockDev.md.create(...)`` in a
+bounded pool of worker threads (so the exceptions are transformed the same
+way), streams the progress reported by the function and kills the external
+utility it runs if the awaiting task is cancelled.
+
 """
 
+import asyncio
+import concurrent.futures
 import copy
 import inspect
 import os
 import re
+import threading
 from collections import namedtuple, defaultdict
+from types import SimpleNamespace
 
 from bytesize import Size
 from gi.importer import modules
 from gi.module import FunctionInfo
 from gi.overrides import override
+from gi.repository import Gio
 from gi.repository import GLib
 from gi.repository import GObject
 
@@ -113,6 +125,37 @@ class ExtraArg(BlockDev.ExtraArg):
 ExtraArg = override(ExtraArg)
 __all__.append("ExtraArg")
 
+
+class UtilsExecPolicy(BlockDev.UtilsExecPolicy):
+    def __new__(cls, timeout=0, ioprio_class=BlockDev.UtilsIOPrioClass.NONE, ioprio_level=0, nice=0, cpu_affinity=None, cgroup=None):
+        ret = BlockDev.UtilsExecPolicy.new(timeout, ioprio_class, ioprio_level, nice, cpu_affinity, cgroup)
+        ret.__class__ = cls
+        return ret
+    def __init__(self, *args, **kwargs):  # pylint: disable=unused-argument
+        super(UtilsExecPolicy, self).__init__()  #pylint: disable=bad-super-call
+UtilsExecPolicy = override(UtilsExecPolicy)
+__all__.append("UtilsExecPolicy")
+
+class UtilsQueueSettings(BlockDev.UtilsQueueSettings):
+    def __new__(cls, scheduler=None, read_ahead_kb=-1, nr_requests=-1, rq_affinity=-1, wbt_lat_usec=-1,
+                max_sectors_kb=-1, add_random=-1):
+        ret = BlockDev.UtilsQueueSettings.new()
+        ret.__class__ = cls
+
+        ret.scheduler = scheduler
+        ret.read_ahead_kb = read_ahead_kb
+        ret.nr_requests = nr_requests
+        ret.rq_affinity = rq_affinity
+        ret.wbt_lat_usec = wbt_lat_usec
+        ret.max_sectors_kb = max_sectors_kb
+        ret.add_random = add_random
+
+        return ret
+    def __init__(self, *args, **kwargs):  # pylint: disable=unused-argument
+        super(UtilsQueueSettings, self).__init__()  #pylint: disable=bad-super-call
+UtilsQueueSettings = override(UtilsQueueSettings)
+__all__.append("UtilsQueueSettings")
+
 def _get_extra(extra, kwargs, cmd_extra=True):
     # pylint: disable=no-member
     # pylint doesn't really get how ExtraArg with overrides work
@@ -136,7 +179,10 @@ def _get_extra(extra, kwargs, cmd_extra=True):
 
 
 class FSMkfsOptions(BlockDev.FSMkfsOptions):
-    def __new__(cls, label=None, uuid=None, dry_run=False, no_discard=False, force=False, no_pt=False):
+    def __new__(cls, label=None, uuid=None, dry_run=False, no_discard=False, force=False, no_pt=False,
+                topology=False, lazy_itable_init=BlockDev.FSMkfsLazyInit.DEFAULT,
+                lazy_journal_init=BlockDev.FSMkfsLazyInit.DEFAULT, journal_size=0, journal_device=None,
+                stripe_unit=0, stripe_width=0):
         ret = BlockDev.FSMkfsOptions()
         ret.__class__ = cls
 
@@ -146,12 +192,34 @@ class FSMkfsOptions(BlockDev.FSMkfsOptions):
         ret.no_discard = no_discard
         ret.force = force
         ret.no_pt = no_pt
+        ret.topology = topology
+        ret.lazy_itable_init = lazy_itable_init
+        ret.lazy_journal_init = lazy_journal_init
+        ret.journal_size = journal_size
+        ret.journal_device = journal_device
+        ret.stripe_unit = stripe_unit
+        ret.stripe_width = stripe_width
 
         return ret
 FSMkfsOptions = override(FSMkfsOptions)
 __all__.append("FSMkfsOptions")
 
 
+class FSTrimOptions(BlockDev.FSTrimOptions):
+    def __new__(cls, min_extent=0, chunk_size=0, max_bandwidth=0, max_iops=0):
+        ret = BlockDev.FSTrimOptions()
+        ret.__class__ = cls
+
+        ret.min_extent = min_extent
+        ret.chunk_size = chunk_size
+        ret.max_bandwidth = max_bandwidth
+        ret.max_iops = max_iops
+
+        return ret
+FSTrimOptions = override(FSTrimOptions)
+__all__.append("FSTrimOptions")
+
+
 _init = BlockDev.init
 @override(BlockDev.init)
 def init(require_plugins=None, log_func=None):
@@ -336,6 +404,14 @@ def crypto_tc_open(device, name, passphrase, read_only=False, keyfiles=None, hid
     return _crypto_tc_open(device, name, passphrase, keyfiles, hidden, system, veracrypt, veracrypt_pim, read_only)
 __all__.append("crypto_tc_open")
 
+_crypto_tc_open_with_hints = BlockDev.crypto_tc_open_with_hints
+@override(BlockDev.crypto_tc_open_with_hints)
+def crypto_tc_open_with_hints(device, name, passphrase, read_only=False, keyfiles=None, hidden=False, system=False, veracrypt=False, veracrypt_pim=0, hash=None, cipher=None, parallel=False):
+    if isinstance(passphrase, str):
+        passphrase = passphrase.encode("utf-8")
+    return _crypto_tc_open_with_hints(device, name, passphrase, keyfiles, hidden, system, veracrypt, veracrypt_pim, read_only, hash, cipher, parallel)
+__all__.append("crypto_tc_open_with_hints")
+
 _crypto_bitlk_open = BlockDev.crypto_bitlk_open
 @override(BlockDev.crypto_bitlk_open)
 def crypto_bitlk_open(device, name, passphrase, read_only=False):
@@ -399,11 +475,29 @@ def dm_create_linear(map_name, device, length, uuid=None):
     return _dm_create_linear(map_name, device, length, uuid)
 __all__.append("dm_create_linear")
 
+_dm_stats_create = BlockDev.dm_stats_create
+@override(BlockDev.dm_stats_create)
+def dm_stats_create(map_name, start=0, length=0, area_size=0, n_areas=0, program_id=None, histogram_bounds=None, precise_timestamps=False):
+    return _dm_stats_create(map_name, start, length, area_size, n_areas, program_id, histogram_bounds, precise_timestamps)
+__all__.append("dm_stats_create")
 
-# XXX enums with just one member are broken with GI
-class DMTech():
-    MAP = BlockDev.DMTech.DM_TECH_MAP
-__all__.append("DMTech")
+_dm_stats_list = BlockDev.dm_stats_list
+@override(BlockDev.dm_stats_list)
+def dm_stats_list(map_name, program_id=None):
+    return _dm_stats_list(map_name, program_id)
+__all__.append("dm_stats_list")
+
+_dm_stats_print = BlockDev.dm_stats_print
+@override(BlockDev.dm_stats_print)
+def dm_stats_print(map_name, region_id, clear=False):
+    return _dm_stats_print(map_name, region_id, clear)
+__all__.append("dm_stats_print")
+
+_dm_stats_sample = BlockDev.dm_stats_sample
+@override(BlockDev.dm_stats_sample)
+def dm_stats_sample(map_name, region_id, interval=1000):
+    return _dm_stats_sample(map_name, region_id, interval)
+__all__.append("dm_stats_sample")
 
 
 _loop_setup = BlockDev.loop_setup
@@ -727,6 +821,12 @@ def fs_get_free_space(device, fstype=None):
     return _fs_get_free_space(device, fstype)
 __all__.append("fs_get_free_space")
 
+_fs_get_free_space_histogram = BlockDev.fs_get_free_space_histogram
+@override(BlockDev.fs_get_free_space_histogram)
+def fs_get_free_space_histogram(device, fstype=None):
+    return _fs_get_free_space_histogram(device, fstype)
+__all__.append("fs_get_free_space_histogram")
+
 
 _lvm_round_size_to_pe = BlockDev.lvm_round_size_to_pe
 @override(BlockDev.lvm_round_size_to_pe)
@@ -837,6 +937,13 @@ def lvm_lvcreate(vg_name, lv_name, size, type=None, pv_list=None, extra=None, **
     return _lvm_lvcreate(vg_name, lv_name, size, type, pv_list, extra)
 __all__.append("lvm_lvcreate")
 
+_lvm_lvcreate_spread = BlockDev.lvm_lvcreate_spread
+@override(BlockDev.lvm_lvcreate_spread)
+def lvm_lvcreate_spread(vg_name, lv_name, size, type=None, n_pvs=1, extra=None, **kwargs):
+    extra = _get_extra(extra, kwargs)
+    return _lvm_lvcreate_spread(vg_name, lv_name, size, type, n_pvs, extra)
+__all__.append("lvm_lvcreate_spread")
+
 _lvm_lvremove = BlockDev.lvm_lvremove
 @override(BlockDev.lvm_lvremove)
 def lvm_lvremove(vg_name, lv_name, force=False, extra=None, **kwargs):
@@ -920,6 +1027,46 @@ def lvm_cache_detach(vg_name, cached_lv, destroy=True, extra=None, **kwargs):
     return _lvm_cache_detach(vg_name, cached_lv, destroy, extra)
 __all__.append("lvm_cache_detach")
 
+class LVMCacheSettings(BlockDev.LVMCacheSettings):
+    def __new__(cls, policy=None, migration_threshold=-1, chunk_size=0):
+        ret = BlockDev.LVMCacheSettings.new()
+        ret.__class__ = cls
+
+        ret.policy = policy
+        ret.migration_threshold = migration_threshold
+        ret.chunk_size = chunk_size
+
+        return ret
+    def __init__(self, *args, **kwargs):  # pylint: disable=unused-argument
+        super(LVMCacheSettings, self).__init__()  #pylint: disable=bad-super-call
+LVMCacheSettings = override(LVMCacheSettings)
+__all__.append("LVMCacheSettings")
+
+_lvm_cache_set_settings = BlockDev.lvm_cache_set_settings
+@override(BlockDev.lvm_cache_set_settings)
+def lvm_cache_set_settings(vg_name, cached_lv, settings, persistent=True):
+    return _lvm_cache_set_settings(vg_name, cached_lv, settings, persistent)
+__all__.append("lvm_cache_set_settings")
+
+class LVMWritecacheSettings(BlockDev.LVMWritecacheSettings):
+    def __new__(cls, high_watermark=-1, low_watermark=-1, writeback_jobs=-1, autocommit_blocks=-1,
+                autocommit_time=-1, pause_writeback=-1):
+        ret = BlockDev.LVMWritecacheSettings.new()
+        ret.__class__ = cls
+
+        ret.high_watermark = high_watermark
+        ret.low_watermark = low_watermark
+        ret.writeback_jobs = writeback_jobs
+        ret.autocommit_blocks = autocommit_blocks
+        ret.autocommit_time = autocommit_time
+        ret.pause_writeback = pause_writeback
+
+        return ret
+    def __init__(self, *args, **kwargs):  # pylint: disable=unused-argument
+        super(LVMWritecacheSettings, self).__init__()  #pylint: disable=bad-super-call
+LVMWritecacheSettings = override(LVMWritecacheSettings)
+__all__.append("LVMWritecacheSettings")
+
 _lvm_is_valid_thpool_chunk_size = BlockDev.lvm_is_valid_thpool_chunk_size
 @override(BlockDev.lvm_is_valid_thpool_chunk_size)
 def lvm_is_valid_thpool_chunk_size(size, discard=False):
@@ -1044,6 +1191,13 @@ def md_remove(raid_spec, device, fail, extra=None, **kwargs):
     return _md_remove(raid_spec, device, fail, extra)
 __all__.append("md_remove")
 
+_md_replace = BlockDev.md_replace
+@override(BlockDev.md_replace)
+def md_replace(raid_spec, device, replacement=None, extra=None, **kwargs):
+    extra = _get_extra(extra, kwargs)
+    return _md_replace(raid_spec, device, replacement, extra)
+__all__.append("md_replace")
+
 _md_activate = BlockDev.md_activate
 @override(BlockDev.md_activate)
 def md_activate(raid_spec=None, members=None, uuid=None, start_degraded=True, extra=None, **kwargs):
@@ -1081,10 +1235,11 @@ def swap_swapon(device, priority=-1):
 __all__.append("swap_swapon")
 
 
-# XXX enums with just one member are broken with GI
-class SwapTech():
-    SWAP = BlockDev.SwapTech.SWAP_TECH_SWAP
-__all__.append("SwapTech")
+_swap_zram_create = BlockDev.swap_zram_create
+@override(BlockDev.swap_zram_create)
+def swap_zram_create(size, comp_algorithm=None, mem_limit=0, backing_dev=None, activate=True, priority=-1):
+    return _swap_zram_create(size, comp_algorithm, mem_limit, backing_dev, activate, priority)
+__all__.append("swap_zram_create")
 
 
 _part_create_table = BlockDev.part_create_table
@@ -1409,3 +1564,168 @@ __all__.append("smart")
 
 utils = ErrorProxy("utils", BlockDev, [(GLib.Error, UtilsError)])
 __all__.append("utils")
+
+
+ProgressEvent = namedtuple("ProgressEvent", ["task_id", "status", "completion", "msg"])
+ProgressEvent.__doc__ = """progress reported by a function run through an :class:`AsyncProxy`
+
+:field task_id: ID of the task/action the progress is reported for
+:field status: progress status (:class:`BlockDev.UtilsProgStatus`)
+:field completion: percentage of completion
+:field msg: arbitrary progress message or None
+
+"""
+__all__.append("ProgressEvent")
+
+_async_executor = None
+_async_executor_lock = threading.Lock()
+_async_max_workers = 4
+
+def set_async_workers(max_workers):
+    """Set the maximum number of worker threads used by the :class:`AsyncProxy` instances.
+
+    :param int max_workers: maximum number of functions running at the same time,
+                            further calls wait for a free worker
+
+    Already running functions are not affected.
+
+    """
+
+    global _async_executor, _async_max_workers  # pylint: disable=global-statement
+
+    if max_workers < 1:
+        raise ValueError("max_workers must be greater than 0")
+
+    with _async_executor_lock:
+        _async_max_workers = max_workers
+        if _async_executor:
+            _async_executor.shutdown(wait=False)
+            _async_executor = None
+__all__.append("set_async_workers")
+
+def _get_async_executor():
+    global _async_executor  # pylint: disable=global-statement
+
+    with _async_executor_lock:
+        if not _async_executor:
+            _async_executor = concurrent.futures.ThreadPoolExecutor(max_workers=_async_max_workers,
+                                                                    thread_name_prefix="blockdev-aio")
+        return _async_executor
+
+class AsyncOperation(object):
+    """
+    A libblockdev function running in a worker thread. Awaiting the operation
+    gives the function's return value (or raises its exception), the
+    :meth:`progress` async iterator gives the progress reported by the function.
+
+    """
+
+    _done = object()
+
+    def __init__(self, func, args, kwargs):
+        self._loop = asyncio.get_running_loop()
+        self._events = asyncio.Queue()
+        self._cancellable = Gio.Cancellable()
+        self._future = self._loop.run_in_executor(_get_async_executor(), self._run, func, args, kwargs)
+        self._future.add_done_callback(self._on_done)
+
+    def _run(self, func, args, kwargs):
+        if self._cancellable.is_cancelled():
+            # cancelled while waiting for a free worker
+            raise asyncio.CancelledError()
+
+        BlockDev.utils_init_prog_reporting_thread(self._report)
+        BlockDev.utils_set_cancellable_thread(self._cancellable)
+        try:
+            return func(*args, **kwargs)
+        finally:
+            BlockDev.utils_set_cancellable_thread(None)
+            BlockDev.utils_init_prog_reporting_thread(None)
+
+    def _report(self, task_id, status, completion, msg):
+        event = ProgressEvent(task_id, status, completion, msg)
+        try:
+            self._loop.call_soon_threadsafe(self._events.put_nowait, event)
+        except RuntimeError:
+            # the awaiting task was cancelled and the loop closed before the
+            # function finished, nobody is interested in the event anymore
+            pass
+
+    def _on_done(self, _future):
+        # queued after all the progress events reported by the worker thread
+        self._events.put_nowait(self._done)
+
+    def cancel(self):
+        """Cancel the operation.
+
+        Kills the external utility run by the function (if any). Functions not
+        running external utilities cannot be interrupted and only their result
+        is dropped.
+
+        """
+
+        self._cancellable.cancel()
+        return self._future.cancel()
+
+    def done(self):
+        return self._future.done()
+
+    async def progress(self):
+        """Async iterator over the :class:`ProgressEvent` instances reported by the function.
+
+        Ends once the function finishes. Only one iterator should be used per operation.
+
+        """
+
+        while True:
+            event = await self._events.get()
+            if event is self._done:
+                return
+            yield event
+
+    def __await__(self):
+        try:
+            return (yield from self._future.__await__())
+        except asyncio.CancelledError:
+            # the awaiting task was cancelled, stop the function too
+            self._cancellable.cancel()
+            raise
+__all__.append("AsyncOperation")
+
+class AsyncProxy(object):
+    """
+    Proxy providing awaitable variants of the functions of an
+    :class:`ErrorProxy` instance. Calling a function through it (from a running
+    asyncio event loop) returns an :class:`AsyncOperation` instance.
+
+    """
+
+    def __init__(self, proxy):
+        """Constructor for the :class:`AsyncProxy` class.
+
+        :param proxy: proxy providing the original functions
+        :type proxy: :class:`ErrorProxy`
+
+        """
+
+        self._proxy = proxy
+
+    def __dir__(self):
+        return dir(self._proxy)
+
+    def __getattr__(self, attr):
+        orig_obj = getattr(self._proxy, attr)
+
+        if not callable(orig_obj):
+            return orig_obj
+
+        def wrapped(*args, **kwargs):
+            return AsyncOperation(orig_obj, args, kwargs)
+
+        return wrapped
+__all__.append("AsyncProxy")
+
+aio = SimpleNamespace(**{name: AsyncProxy(globals()[name])
+                         for name in ("btrfs", "crypto", "dm", "loop", "lvm", "md", "mpath", "swap",
+                                      "part", "fs", "nvdimm", "nvme", "s390", "smart", "utils")})
+__all__.append("aio")
@@ -0,0 +1,15 @@
+#include <glib.h>
+
+#include "context.h"
+
+#ifndef BD_UTILS_CONTEXT_PRIVATE
+#define BD_UTILS_CONTEXT_PRIVATE
+
+G_GNUC_INTERNAL void _bd_context_get_log (BDContext *ctx, BDUtilsLogFunc *log_func, gint *level);
+G_GNUC_INTERNAL BDUtilsProgFunc _bd_context_get_prog_func (BDContext *ctx);
+G_GNUC_INTERNAL BDUtilsExecPolicy* _bd_context_get_exec_policy (BDContext *ctx, gboolean *is_set);
+
+/* implemented in exec.c */
+G_GNUC_INTERNAL gboolean _bd_utils_exec_policy_validate (const BDUtilsExecPolicy *policy, GError **error);
+
+#endif  /* BD_UTILS_CONTEXT_PRIVATE */
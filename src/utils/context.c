@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2024  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "context.h"
+#include "context-private.h"
+
+/* the logging settings are read for every log message (even the ones which are
+   dropped), they are published atomically so that they can be read without
+   locking, with the special values below meaning "not set" */
+#define LOG_LEVEL_UNSET G_MININT
+
+static void log_func_unset (gint level G_GNUC_UNUSED, const gchar *msg G_GNUC_UNUSED) {
+}
+
+struct BDContext {
+    gint ref_count;
+    GMutex lock;
+
+    volatile gpointer log_func;
+    volatile gint log_level;
+
+    BDUtilsProgFunc prog_func;
+
+    gboolean exec_policy_set;
+    BDUtilsExecPolicy *exec_policy;
+
+    gboolean lvm_config_set;
+    gchar *lvm_config;
+    gboolean lvm_devices_set;
+    gchar **lvm_devices;
+};
+
+static GPrivate thread_context = G_PRIVATE_INIT ((GDestroyNotify) bd_context_unref);
+
+/**
+ * bd_context_new: (constructor)
+ *
+ * Returns: (transfer full): a new context with no settings (i.e. all falling
+ *                           back to the process-global ones)
+ */
+BDContext* bd_context_new (void) {
+    BDContext *ctx = g_new0 (BDContext, 1);
+
+    ctx->ref_count = 1;
+    g_mutex_init (&ctx->lock);
+    ctx->log_func = (gpointer) log_func_unset;
+    ctx->log_level = LOG_LEVEL_UNSET;
+
+    return ctx;
+}
+
+/**
+ * bd_context_ref:
+ * @ctx: context to ref
+ *
+ * Returns: (transfer full): @ctx
+ */
+BDContext* bd_context_ref (BDContext *ctx) {
+    g_return_val_if_fail (ctx != NULL, NULL);
+
+    g_atomic_int_inc (&ctx->ref_count);
+    return ctx;
+}
+
+/**
+ * bd_context_unref:
+ * @ctx: (nullable): context to unref
+ */
+void bd_context_unref (BDContext *ctx) {
+    if (ctx == NULL)
+        return;
+
+    if (!g_atomic_int_dec_and_test (&ctx->ref_count))
+        return;
+
+    bd_utils_exec_policy_free (ctx->exec_policy);
+    g_free (ctx->lvm_config);
+    g_strfreev (ctx->lvm_devices);
+    g_mutex_clear (&ctx->lock);
+    g_free (ctx);
+}
+
+GType bd_context_get_type (void) {
+    static GType type = 0;
+
+    if (G_UNLIKELY (!type))
+        type = g_boxed_type_register_static ("BDContext",
+                                             (GBoxedCopyFunc) bd_context_ref,
+                                             (GBoxedFreeFunc) bd_context_unref);
+
+    return type;
+}
+
+/**
+ * bd_context_set_log_func:
+ * @ctx: context to set the logging function for
+ * @log_func: (nullable) (scope notified): logging function to use, #bd_utils_log_stdout
+ *                                         for the default behaviour or %NULL to disable logging
+ *
+ * Note: Once set on @ctx, the logging function cannot be reset to the process-global
+ *       one, see bd_context_reset().
+ */
+void bd_context_set_log_func (BDContext *ctx, BDUtilsLogFunc log_func) {
+    g_atomic_pointer_set (&ctx->log_func, (gpointer) log_func);
+}
+
+/**
+ * bd_context_set_log_level:
+ * @ctx: context to set the log level for
+ * @level: log level, see bd_utils_set_log_level()
+ */
+void bd_context_set_log_level (BDContext *ctx, gint level) {
+    /* the lowest level means nothing is logged, just like the next one */
+    if (level == LOG_LEVEL_UNSET)
+        level++;
+    g_atomic_int_set (&ctx->log_level, level);
+}
+
+/**
+ * bd_context_set_prog_func:
+ * @ctx: context to set the progress reporting function for
+ * @prog_func: (nullable) (scope notified): progress reporting function to use or %NULL
+ *                                          to use the process-global one
+ *
+ * A progress reporting function set with bd_utils_init_prog_reporting_thread()
+ * takes precedence.
+ */
+void bd_context_set_prog_func (BDContext *ctx, BDUtilsProgFunc prog_func) {
+    g_mutex_lock (&ctx->lock);
+    ctx->prog_func = prog_func;
+    g_mutex_unlock (&ctx->lock);
+}
+
+/**
+ * bd_context_set_exec_policy:
+ * @ctx: context to set the execution policy for
+ * @policy: (nullable): execution policy to use or %NULL to use the process-global one
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * An execution policy set with bd_utils_set_exec_policy_thread() takes precedence.
+ *
+ * Returns: whether the execution policy was successfully set or not
+ */
+gboolean bd_context_set_exec_policy (BDContext *ctx, const BDUtilsExecPolicy *policy, GError **error) {
+    if (policy && !_bd_utils_exec_policy_validate (policy, error))
+        return FALSE;
+
+    g_mutex_lock (&ctx->lock);
+    bd_utils_exec_policy_free (ctx->exec_policy);
+    ctx->exec_policy = bd_utils_exec_policy_copy ((BDUtilsExecPolicy *) policy);
+    ctx->exec_policy_set = policy != NULL;
+    g_mutex_unlock (&ctx->lock);
+
+    return TRUE;
+}
+
+/**
+ * bd_context_set_lvm_config:
+ * @ctx: context to set the LVM config for
+ * @config: (nullable): LVM config string to use for LVM calls made in @ctx (see
+ *          bd_lvm_set_global_config()), an empty string for no config or %NULL
+ *          to use the global LVM config
+ */
+void bd_context_set_lvm_config (BDContext *ctx, const gchar *config) {
+    g_mutex_lock (&ctx->lock);
+    g_free (ctx->lvm_config);
+    ctx->lvm_config = (config && *config) ? g_strdup (config) : NULL;
+    ctx->lvm_config_set = config != NULL;
+    g_mutex_unlock (&ctx->lock);
+}
+
+/**
+ * bd_context_get_lvm_config:
+ * @ctx: context to get the LVM config from
+ * @config: (out) (transfer full) (nullable): LVM config string set on @ctx (%NULL for no config)
+ *
+ * Returns: whether @ctx overrides the global LVM config or not (@config is not set in such case)
+ */
+gboolean bd_context_get_lvm_config (BDContext *ctx, gchar **config) {
+    gboolean ret = FALSE;
+
+    g_mutex_lock (&ctx->lock);
+    ret = ctx->lvm_config_set;
+    if (ret)
+        *config = g_strdup (ctx->lvm_config);
+    g_mutex_unlock (&ctx->lock);
+
+    return ret;
+}
+
+/**
+ * bd_context_set_lvm_devices:
+ * @ctx: context to set the LVM devices filter for
+ * @devices: (nullable) (array zero-terminated=1): list of devices for LVM calls made
+ *           in @ctx (see bd_lvm_set_devices_filter()), an empty list for no filter or
+ *           %NULL to use the global devices filter
+ */
+void bd_context_set_lvm_devices (BDContext *ctx, const gchar **devices) {
+    g_mutex_lock (&ctx->lock);
+    g_strfreev (ctx->lvm_devices);
+    ctx->lvm_devices = (devices && *devices) ? g_strdupv ((gchar **) devices) : NULL;
+    ctx->lvm_devices_set = devices != NULL;
+    g_mutex_unlock (&ctx->lock);
+}
+
+/**
+ * bd_context_get_lvm_devices:
+ * @ctx: context to get the LVM devices filter from
+ * @devices: (out) (transfer full) (nullable) (array zero-terminated=1): devices filter set
+ *           on @ctx (%NULL for no filter)
+ *
+ * Returns: whether @ctx overrides the global LVM devices filter or not (@devices is not
+ *          set in such case)
+ */
+gboolean bd_context_get_lvm_devices (BDContext *ctx, gchar ***devices) {
+    gboolean ret = FALSE;
+
+    g_mutex_lock (&ctx->lock);
+    ret = ctx->lvm_devices_set;
+    if (ret)
+        *devices = g_strdupv (ctx->lvm_devices);
+    g_mutex_unlock (&ctx->lock);
+
+    return ret;
+}
+
+/**
+ * bd_context_reset:
+ * @ctx: context to reset
+ *
+ * Resets all settings of @ctx so that they fall back to the process-global ones.
+ */
+void bd_context_reset (BDContext *ctx) {
+    g_atomic_pointer_set (&ctx->log_func, (gpointer) log_func_unset);
+    g_atomic_int_set (&ctx->log_level, LOG_LEVEL_UNSET);
+
+    g_mutex_lock (&ctx->lock);
+    ctx->prog_func = NULL;
+    ctx->exec_policy_set = FALSE;
+    g_clear_pointer (&ctx->exec_policy, bd_utils_exec_policy_free);
+    ctx->lvm_config_set = FALSE;
+    g_clear_pointer (&ctx->lvm_config, g_free);
+    ctx->lvm_devices_set = FALSE;
+    g_clear_pointer (&ctx->lvm_devices, g_strfreev);
+    g_mutex_unlock (&ctx->lock);
+}
+
+/**
+ * bd_context_set_thread:
+ * @ctx: (nullable): context to use on the current thread or %NULL to use the
+ *                   process-global settings
+ *
+ * Makes @ctx the context of the current thread (a reference is taken). The
+ * same context can be used on multiple threads at the same time.
+ */
+void bd_context_set_thread (BDContext *ctx) {
+    g_private_replace (&thread_context, ctx ? bd_context_ref (ctx) : NULL);
+}
+
+/**
+ * bd_context_get_thread:
+ *
+ * Returns: (transfer none) (nullable): context of the current thread or %NULL if
+ *                                      none is set
+ */
+BDContext* bd_context_get_thread (void) {
+    return g_private_get (&thread_context);
+}
+
+/* overrides @log_func and @level with the values set on @ctx (if any) */
+void _bd_context_get_log (BDContext *ctx, BDUtilsLogFunc *log_func, gint *level) {
+    gpointer func = g_atomic_pointer_get (&ctx->log_func);
+    gint lvl = g_atomic_int_get (&ctx->log_level);
+
+    if (func != (gpointer) log_func_unset)
+        *log_func = (BDUtilsLogFunc) func;
+    if (lvl != LOG_LEVEL_UNSET)
+        *level = lvl;
+}
+
+BDUtilsProgFunc _bd_context_get_prog_func (BDContext *ctx) {
+    BDUtilsProgFunc ret = NULL;
+
+    g_mutex_lock (&ctx->lock);
+    ret = ctx->prog_func;
+    g_mutex_unlock (&ctx->lock);
+
+    return ret;
+}
+
+BDUtilsExecPolicy* _bd_context_get_exec_policy (BDContext *ctx, gboolean *is_set) {
+    BDUtilsExecPolicy *ret = NULL;
+
+    g_mutex_lock (&ctx->lock);
+    *is_set = ctx->exec_policy_set;
+    ret = bd_utils_exec_policy_copy (ctx->exec_policy);
+    g_mutex_unlock (&ctx->lock);
+
+    return ret;
+}
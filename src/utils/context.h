@@ -0,0 +1,44 @@
+#include <glib.h>
+#include <glib-object.h>
+
+#include "exec.h"
+#include "logging.h"
+
+#ifndef BD_UTILS_CONTEXT
+#define BD_UTILS_CONTEXT
+
+#define BD_UTILS_TYPE_CONTEXT (bd_context_get_type ())
+GType bd_context_get_type (void);
+
+/**
+ * BDContext:
+ *
+ * Opaque structure holding settings (logging, progress reporting, execution policy,
+ * LVM configuration) that would otherwise be process-global. Settings of a context
+ * are effective for the threads it is set on with bd_context_set_thread(), settings
+ * not set on the context fall back to the process-global ones. This allows multiple
+ * independent users of the library in one process (e.g. a daemon serving multiple
+ * clients) without changing the global state with bd_reinit().
+ *
+ * Note: Loaded plugins are always shared by the whole process.
+ */
+typedef struct BDContext BDContext;
+
+BDContext* bd_context_new (void);
+BDContext* bd_context_ref (BDContext *ctx);
+void bd_context_unref (BDContext *ctx);
+
+void bd_context_set_log_func (BDContext *ctx, BDUtilsLogFunc log_func);
+void bd_context_set_log_level (BDContext *ctx, gint level);
+void bd_context_set_prog_func (BDContext *ctx, BDUtilsProgFunc prog_func);
+gboolean bd_context_set_exec_policy (BDContext *ctx, const BDUtilsExecPolicy *policy, GError **error);
+void bd_context_set_lvm_config (BDContext *ctx, const gchar *config);
+gboolean bd_context_get_lvm_config (BDContext *ctx, gchar **config);
+void bd_context_set_lvm_devices (BDContext *ctx, const gchar **devices);
+gboolean bd_context_get_lvm_devices (BDContext *ctx, gchar ***devices);
+void bd_context_reset (BDContext *ctx);
+
+void bd_context_set_thread (BDContext *ctx);
+BDContext* bd_context_get_thread (void);
+
+#endif  /* BD_UTILS_CONTEXT */
@@ -19,8 +19,12 @@
 
 #include <glib.h>
 #include <libudev.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "dev_utils.h"
+#include "exec.h"
 
 /**
  * bd_utils_dev_utils_error_quark: (skip)
@@ -142,3 +146,893 @@ gchar** bd_utils_get_device_symlinks (const gchar *dev_spec, GError **error) {
 
     return ret;
 }
+
+/**
+ * bd_utils_get_whole_disk_name:
+ * @name: kernel name of a block device (e.g. "sda1")
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): kernel name of the disk @name is a partition of (e.g.
+ *                           "sda"), @name itself if it is not a partition or %NULL
+ *                           in case of error
+ */
+gchar* bd_utils_get_whole_disk_name (const gchar *name, GError **error) {
+    gchar *path = NULL;
+    gchar *real_path = NULL;
+    gchar *disk_path = NULL;
+    gchar *ret = NULL;
+    gboolean is_part = FALSE;
+
+    path = g_strdup_printf ("/sys/class/block/%s/partition", name);
+    is_part = g_file_test (path, G_FILE_TEST_EXISTS);
+    g_free (path);
+    if (!is_part)
+        return g_strdup (name);
+
+    /* partitions are subdirectories of their disks in sysfs */
+    path = g_strdup_printf ("/sys/class/block/%s", name);
+    real_path = realpath (path, NULL);
+    g_free (path);
+    if (!real_path) {
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Failed to resolve the sysfs path of the device '%s'", name);
+        return NULL;
+    }
+
+    disk_path = g_path_get_dirname (real_path);
+    ret = g_path_get_basename (disk_path);
+    g_free (disk_path);
+    free (real_path);
+
+    return ret;
+}
+
+/**
+ * bd_utils_iostat_copy: (skip)
+ * @stat: (nullable): %BDUtilsIOStat to copy
+ *
+ * Creates a new copy of @stat.
+ */
+BDUtilsIOStat* bd_utils_iostat_copy (BDUtilsIOStat *stat) {
+    BDUtilsIOStat *ret = NULL;
+
+    if (stat == NULL)
+        return NULL;
+
+    ret = g_new0 (BDUtilsIOStat, 1);
+    *ret = *stat;
+    ret->device = g_strdup (stat->device);
+    ret->slaves = g_strdupv (stat->slaves);
+
+    return ret;
+}
+
+/**
+ * bd_utils_iostat_free: (skip)
+ * @stat: (nullable): %BDUtilsIOStat to free
+ *
+ * Frees @stat.
+ */
+void bd_utils_iostat_free (BDUtilsIOStat *stat) {
+    if (stat == NULL)
+        return;
+
+    g_free (stat->device);
+    g_strfreev (stat->slaves);
+    g_free (stat);
+}
+
+GType bd_utils_iostat_get_type (void) {
+    static GType type = 0;
+
+    if (G_UNLIKELY (!type))
+        type = g_boxed_type_register_static ("BDUtilsIOStat",
+                                             (GBoxedCopyFunc) bd_utils_iostat_copy,
+                                             (GBoxedFreeFunc) bd_utils_iostat_free);
+
+    return type;
+}
+
+/**
+ * bd_utils_iostat_rates_copy: (skip)
+ * @rates: (nullable): %BDUtilsIOStatRates to copy
+ *
+ * Creates a new copy of @rates.
+ */
+BDUtilsIOStatRates* bd_utils_iostat_rates_copy (BDUtilsIOStatRates *rates) {
+    BDUtilsIOStatRates *ret = NULL;
+
+    if (rates == NULL)
+        return NULL;
+
+    ret = g_new0 (BDUtilsIOStatRates, 1);
+    *ret = *rates;
+    ret->device = g_strdup (rates->device);
+    ret->slaves = g_strdupv (rates->slaves);
+
+    return ret;
+}
+
+/**
+ * bd_utils_iostat_rates_free: (skip)
+ * @rates: (nullable): %BDUtilsIOStatRates to free
+ *
+ * Frees @rates.
+ */
+void bd_utils_iostat_rates_free (BDUtilsIOStatRates *rates) {
+    if (rates == NULL)
+        return;
+
+    g_free (rates->device);
+    g_strfreev (rates->slaves);
+    g_free (rates);
+}
+
+GType bd_utils_iostat_rates_get_type (void) {
+    static GType type = 0;
+
+    if (G_UNLIKELY (!type))
+        type = g_boxed_type_register_static ("BDUtilsIOStatRates",
+                                             (GBoxedCopyFunc) bd_utils_iostat_rates_copy,
+                                             (GBoxedFreeFunc) bd_utils_iostat_rates_free);
+
+    return type;
+}
+
+/* adds names of the entries in @sys_dir/@subdir (symlinks to other block devices) to @names */
+static void add_dir_entries (const gchar *sys_dir, const gchar *subdir, GPtrArray *names) {
+    gchar *path = NULL;
+    GDir *dir = NULL;
+    const gchar *name = NULL;
+
+    path = g_build_filename (sys_dir, subdir, NULL);
+    dir = g_dir_open (path, 0, NULL);
+    g_free (path);
+    if (!dir)
+        return;
+
+    while ((name = g_dir_read_name (dir)))
+        g_ptr_array_add (names, g_strdup (name));
+    g_dir_close (dir);
+}
+
+/**
+ * read_iostat:
+ * @sys_dir: sysfs directory of the device (e.g. "/sys/block/sda")
+ * @device: kernel name of the device
+ * @disk: (nullable): kernel name of the disk if @device is a partition
+ *
+ * Returns: (transfer full): I/O statistics of @device or %NULL if they cannot be read
+ */
+static BDUtilsIOStat* read_iostat (const gchar *sys_dir, const gchar *device, const gchar *disk) {
+    gchar *path = NULL;
+    gchar *contents = NULL;
+    gboolean success = FALSE;
+    BDUtilsIOStat *stat = NULL;
+    GPtrArray *slaves = NULL;
+    gint scanned = 0;
+
+    path = g_build_filename (sys_dir, "stat", NULL);
+    success = g_file_get_contents (path, &contents, NULL, NULL);
+    g_free (path);
+    if (!success)
+        return NULL;
+
+    stat = g_new0 (BDUtilsIOStat, 1);
+    /* older kernels only provide the first 11 fields, discard fields were added
+       in 4.18 and flush fields in 5.5 */
+    scanned = sscanf (contents,
+                      "%"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT
+                      " %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT
+                      " %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT
+                      " %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT
+                      " %"G_GUINT64_FORMAT" %"G_GUINT64_FORMAT,
+                      &(stat->read_ios), &(stat->read_merges), &(stat->read_sectors), &(stat->read_ticks),
+                      &(stat->write_ios), &(stat->write_merges), &(stat->write_sectors), &(stat->write_ticks),
+                      &(stat->in_flight), &(stat->io_ticks), &(stat->time_in_queue),
+                      &(stat->discard_ios), &(stat->discard_merges), &(stat->discard_sectors), &(stat->discard_ticks),
+                      &(stat->flush_ios), &(stat->flush_ticks));
+    g_free (contents);
+    if (scanned < 11) {
+        bd_utils_iostat_free (stat);
+        return NULL;
+    }
+
+    stat->device = g_strdup (device);
+
+    slaves = g_ptr_array_new ();
+    if (disk)
+        g_ptr_array_add (slaves, g_strdup (disk));
+    else {
+        add_dir_entries (sys_dir, "slaves", slaves);
+        /* paths of an NVMe multipath head device */
+        add_dir_entries (sys_dir, "multipath", slaves);
+    }
+    g_ptr_array_add (slaves, NULL);
+    stat->slaves = (gchar **) g_ptr_array_free (slaves, FALSE);
+
+    return stat;
+}
+
+/**
+ * bd_utils_iostat_sample:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Reads the I/O statistics of all block devices (including their partitions and
+ * stacked devices like DM, MD, loop or NVMe multipath heads) from sysfs in one pass.
+ * Use bd_utils_iostat_compute_rates() on two such snapshots to get the rates.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): I/O statistics of all block
+ *                                                     devices or %NULL in case of error
+ */
+BDUtilsIOStat** bd_utils_iostat_sample (GError **error) {
+    GDir *dir = NULL;
+    GDir *dev_dir = NULL;
+    const gchar *name = NULL;
+    const gchar *part_name = NULL;
+    gchar *sys_dir = NULL;
+    gchar *part_sys_dir = NULL;
+    gchar *path = NULL;
+    gboolean is_part = FALSE;
+    BDUtilsIOStat *stat = NULL;
+    GPtrArray *stats = NULL;
+    GError *l_error = NULL;
+    gint64 now = 0;
+
+    dir = g_dir_open ("/sys/block", 0, &l_error);
+    if (!dir) {
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Failed to list block devices: %s", l_error->message);
+        g_clear_error (&l_error);
+        return NULL;
+    }
+
+    now = g_get_monotonic_time ();
+    stats = g_ptr_array_new ();
+    while ((name = g_dir_read_name (dir))) {
+        sys_dir = g_build_filename ("/sys/block", name, NULL);
+
+        /* devices may disappear while we are reading the stats, just skip them */
+        stat = read_iostat (sys_dir, name, NULL);
+        if (stat) {
+            stat->timestamp = now;
+            g_ptr_array_add (stats, stat);
+        }
+
+        dev_dir = g_dir_open (sys_dir, 0, NULL);
+        while (dev_dir && (part_name = g_dir_read_name (dev_dir))) {
+            part_sys_dir = g_build_filename (sys_dir, part_name, NULL);
+            path = g_build_filename (part_sys_dir, "partition", NULL);
+            is_part = g_file_test (path, G_FILE_TEST_EXISTS);
+            g_free (path);
+
+            if (is_part) {
+                stat = read_iostat (part_sys_dir, part_name, name);
+                if (stat) {
+                    stat->timestamp = now;
+                    g_ptr_array_add (stats, stat);
+                }
+            }
+            g_free (part_sys_dir);
+        }
+        if (dev_dir)
+            g_dir_close (dev_dir);
+        g_free (sys_dir);
+    }
+    g_dir_close (dir);
+
+    g_ptr_array_add (stats, NULL);
+    return (BDUtilsIOStat **) g_ptr_array_free (stats, FALSE);
+}
+
+/* counters may be reset (e.g. device re-created with the same name), never return
+   negative differences */
+#define STAT_DELTA(field) (after->field >= before->field ? after->field - before->field : 0)
+
+static BDUtilsIOStatRates* compute_rates (const BDUtilsIOStat *before, const BDUtilsIOStat *after, gdouble interval) {
+    BDUtilsIOStatRates *rates = g_new0 (BDUtilsIOStatRates, 1);
+    guint64 ios = 0;
+    guint64 ticks = 0;
+
+    rates->device = g_strdup (after->device);
+    rates->slaves = g_strdupv (after->slaves);
+    rates->interval = interval;
+
+    rates->read_iops = STAT_DELTA (read_ios) / interval;
+    rates->write_iops = STAT_DELTA (write_ios) / interval;
+    rates->discard_iops = STAT_DELTA (discard_ios) / interval;
+    rates->read_bps = STAT_DELTA (read_sectors) * 512 / interval;
+    rates->write_bps = STAT_DELTA (write_sectors) * 512 / interval;
+
+    if (STAT_DELTA (read_ios) > 0)
+        rates->read_latency = (gdouble) STAT_DELTA (read_ticks) / STAT_DELTA (read_ios);
+    if (STAT_DELTA (write_ios) > 0)
+        rates->write_latency = (gdouble) STAT_DELTA (write_ticks) / STAT_DELTA (write_ios);
+
+    ios = STAT_DELTA (read_ios) + STAT_DELTA (write_ios) + STAT_DELTA (discard_ios);
+    ticks = STAT_DELTA (read_ticks) + STAT_DELTA (write_ticks) + STAT_DELTA (discard_ticks);
+    if (ios > 0)
+        rates->latency = (gdouble) ticks / ios;
+
+    /* time_in_queue and io_ticks are in milliseconds */
+    rates->queue_depth = STAT_DELTA (time_in_queue) / (interval * 1000);
+    rates->utilization = MIN (STAT_DELTA (io_ticks) / (interval * 10), 100.0);
+
+    return rates;
+}
+
+#undef STAT_DELTA
+
+/**
+ * bd_utils_iostat_compute_rates:
+ * @before: (array zero-terminated=1): older snapshot from bd_utils_iostat_sample()
+ * @after: (array zero-terminated=1): newer snapshot from bd_utils_iostat_sample()
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Computes IOPS, throughput, average latency, queue depth and utilization of the
+ * devices present in both @before and @after. The rates are also mapped onto the
+ * device stack (see #BDUtilsIOStatRates.added_latency) to show which layer adds latency.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): rates for the devices present in
+ *                                                     both snapshots or %NULL in case
+ *                                                     of error
+ */
+BDUtilsIOStatRates** bd_utils_iostat_compute_rates (BDUtilsIOStat **before, BDUtilsIOStat **after, GError **error) {
+    GHashTable *before_table = NULL;
+    GHashTable *rates_table = NULL;
+    GPtrArray *rates = NULL;
+    BDUtilsIOStat **stat_p = NULL;
+    BDUtilsIOStat *old_stat = NULL;
+    BDUtilsIOStatRates *dev_rates = NULL;
+    BDUtilsIOStatRates *slave_rates = NULL;
+    gchar **slave_p = NULL;
+    gdouble interval = 0;
+    gdouble max_slave_latency = 0;
+    guint i = 0;
+
+    before_table = g_hash_table_new (g_str_hash, g_str_equal);
+    for (stat_p = before; stat_p && *stat_p; stat_p++)
+        g_hash_table_insert (before_table, (*stat_p)->device, *stat_p);
+
+    rates = g_ptr_array_new ();
+    rates_table = g_hash_table_new (g_str_hash, g_str_equal);
+    for (stat_p = after; stat_p && *stat_p; stat_p++) {
+        old_stat = g_hash_table_lookup (before_table, (*stat_p)->device);
+        if (!old_stat)
+            /* new device */
+            continue;
+
+        interval = ((*stat_p)->timestamp - old_stat->timestamp) / (gdouble) G_USEC_PER_SEC;
+        if (interval <= 0) {
+            g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                         "Statistics for '%s' are not newer than the previous ones", (*stat_p)->device);
+            g_ptr_array_set_free_func (rates, (GDestroyNotify) bd_utils_iostat_rates_free);
+            g_ptr_array_free (rates, TRUE);
+            g_hash_table_destroy (rates_table);
+            g_hash_table_destroy (before_table);
+            return NULL;
+        }
+
+        dev_rates = compute_rates (old_stat, *stat_p, interval);
+        g_ptr_array_add (rates, dev_rates);
+        g_hash_table_insert (rates_table, dev_rates->device, dev_rates);
+    }
+
+    /* map the latencies onto the device stack */
+    for (i = 0; i < rates->len; i++) {
+        dev_rates = g_ptr_array_index (rates, i);
+        max_slave_latency = 0;
+        for (slave_p = dev_rates->slaves; slave_p && *slave_p; slave_p++) {
+            slave_rates = g_hash_table_lookup (rates_table, *slave_p);
+            if (slave_rates)
+                max_slave_latency = MAX (max_slave_latency, slave_rates->latency);
+        }
+        dev_rates->added_latency = MAX (dev_rates->latency - max_slave_latency, 0);
+    }
+
+    g_hash_table_destroy (rates_table);
+    g_hash_table_destroy (before_table);
+
+    g_ptr_array_add (rates, NULL);
+    return (BDUtilsIOStatRates **) g_ptr_array_free (rates, FALSE);
+}
+
+/**
+ * bd_utils_queue_settings_new: (constructor)
+ *
+ * Returns: (transfer full): new queue settings with all settings unset
+ */
+BDUtilsQueueSettings* bd_utils_queue_settings_new (void) {
+    BDUtilsQueueSettings *ret = g_new0 (BDUtilsQueueSettings, 1);
+
+    ret->read_ahead_kb = -1;
+    ret->nr_requests = -1;
+    ret->rq_affinity = -1;
+    ret->wbt_lat_usec = -1;
+    ret->max_sectors_kb = -1;
+    ret->add_random = -1;
+
+    return ret;
+}
+
+/**
+ * bd_utils_queue_settings_copy: (skip)
+ * @settings: (nullable): %BDUtilsQueueSettings to copy
+ *
+ * Creates a new copy of @settings.
+ */
+BDUtilsQueueSettings* bd_utils_queue_settings_copy (BDUtilsQueueSettings *settings) {
+    BDUtilsQueueSettings *ret = NULL;
+
+    if (settings == NULL)
+        return NULL;
+
+    ret = g_new0 (BDUtilsQueueSettings, 1);
+    *ret = *settings;
+    ret->device = g_strdup (settings->device);
+    ret->scheduler = g_strdup (settings->scheduler);
+
+    return ret;
+}
+
+/**
+ * bd_utils_queue_settings_free: (skip)
+ * @settings: (nullable): %BDUtilsQueueSettings to free
+ *
+ * Frees @settings.
+ */
+void bd_utils_queue_settings_free (BDUtilsQueueSettings *settings) {
+    if (settings == NULL)
+        return;
+
+    g_free (settings->device);
+    g_free (settings->scheduler);
+    g_free (settings);
+}
+
+GType bd_utils_queue_settings_get_type (void) {
+    static GType type = 0;
+
+    if (G_UNLIKELY (!type))
+        type = g_boxed_type_register_static ("BDUtilsQueueSettings",
+                                             (GBoxedCopyFunc) bd_utils_queue_settings_copy,
+                                             (GBoxedFreeFunc) bd_utils_queue_settings_free);
+
+    return type;
+}
+
+/* numeric queue attributes and the values the kernel accepts for them */
+static const struct {
+    const gchar *attr;
+    glong offset;
+    gint64 min;
+    gint64 max;
+} queue_int_attrs[] = {
+    {"read_ahead_kb", G_STRUCT_OFFSET (BDUtilsQueueSettings, read_ahead_kb), 0, G_MAXINT64},
+    {"nr_requests", G_STRUCT_OFFSET (BDUtilsQueueSettings, nr_requests), 4, G_MAXINT64},
+    {"rq_affinity", G_STRUCT_OFFSET (BDUtilsQueueSettings, rq_affinity), 0, 2},
+    {"wbt_lat_usec", G_STRUCT_OFFSET (BDUtilsQueueSettings, wbt_lat_usec), 0, G_MAXINT64},
+    /* also limited by max_hw_sectors_kb of the device */
+    {"max_sectors_kb", G_STRUCT_OFFSET (BDUtilsQueueSettings, max_sectors_kb), 1, G_MAXINT64},
+    {"add_random", G_STRUCT_OFFSET (BDUtilsQueueSettings, add_random), 0, 1},
+};
+
+#define QUEUE_INT_ATTR(settings, i) (G_STRUCT_MEMBER (gint64, (settings), queue_int_attrs[(i)].offset))
+
+static gchar* read_queue_attr (const gchar *name, const gchar *attr) {
+    gchar *path = NULL;
+    gchar *contents = NULL;
+    gboolean success = FALSE;
+
+    path = g_strdup_printf ("/sys/block/%s/queue/%s", name, attr);
+    success = g_file_get_contents (path, &contents, NULL, NULL);
+    g_free (path);
+    if (!success)
+        return NULL;
+
+    return g_strstrip (contents);
+}
+
+static gboolean write_queue_attr (const gchar *name, const gchar *attr, const gchar *value, GError **error) {
+    gchar *path = NULL;
+    gboolean success = FALSE;
+
+    path = g_strdup_printf ("/sys/block/%s/queue/%s", name, attr);
+    success = bd_utils_echo_str_to_file (value, path, error);
+    g_free (path);
+
+    return success;
+}
+
+static gint64 read_queue_int_attr (const gchar *name, const gchar *attr) {
+    gchar *value = NULL;
+    gchar *endptr = NULL;
+    gint64 ret = -1;
+
+    value = read_queue_attr (name, attr);
+    if (!value)
+        return -1;
+
+    ret = g_ascii_strtoll (value, &endptr, 10);
+    if (endptr == value)
+        ret = -1;
+    g_free (value);
+
+    return ret;
+}
+
+/**
+ * get_schedulers:
+ * @name: kernel name of the device
+ * @current: (out) (optional) (transfer full): currently used scheduler
+ *
+ * Returns: (transfer full): schedulers available for @name (the "scheduler" file
+ *                           contains e.g. "mq-deadline kyber [bfq] none") or %NULL
+ *                           if the device doesn't have a scheduler
+ */
+static gchar** get_schedulers (const gchar *name, gchar **current) {
+    gchar *value = NULL;
+    gchar **schedulers = NULL;
+    gchar **sched_p = NULL;
+    gsize len = 0;
+
+    value = read_queue_attr (name, "scheduler");
+    if (!value)
+        return NULL;
+
+    schedulers = g_strsplit (value, " ", -1);
+    g_free (value);
+
+    for (sched_p = schedulers; *sched_p; sched_p++) {
+        len = strlen (*sched_p);
+        if (len > 2 && (*sched_p)[0] == '[' && (*sched_p)[len - 1] == ']') {
+            memmove (*sched_p, *sched_p + 1, len - 2);
+            (*sched_p)[len - 2] = '\0';
+            if (current)
+                *current = g_strdup (*sched_p);
+        }
+    }
+
+    return schedulers;
+}
+
+static BDUtilsQueueSettings* read_queue_settings (const gchar *name) {
+    BDUtilsQueueSettings *settings = bd_utils_queue_settings_new ();
+    gchar **schedulers = NULL;
+    guint i = 0;
+
+    settings->device = g_strdup (name);
+    schedulers = get_schedulers (name, &(settings->scheduler));
+    g_strfreev (schedulers);
+    for (i = 0; i < G_N_ELEMENTS (queue_int_attrs); i++)
+        QUEUE_INT_ATTR (settings, i) = read_queue_int_attr (name, queue_int_attrs[i].attr);
+
+    return settings;
+}
+
+static gchar* resolve_queue_dev_name (const gchar *device, GError **error) {
+    gchar *path = NULL;
+    gchar *name = NULL;
+    gchar *ret = NULL;
+    gchar *queue_path = NULL;
+    gboolean exists = FALSE;
+
+    path = bd_utils_resolve_device (device, error);
+    if (!path)
+        return NULL;
+
+    name = g_path_get_basename (path);
+    g_free (path);
+    /* the disk has the request queue for partitions */
+    ret = bd_utils_get_whole_disk_name (name, NULL);
+    g_free (name);
+
+    if (ret) {
+        queue_path = g_strdup_printf ("/sys/block/%s/queue", ret);
+        exists = g_file_test (queue_path, G_FILE_TEST_IS_DIR);
+        g_free (queue_path);
+    }
+    if (!exists) {
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Device '%s' doesn't have a request queue", device);
+        g_free (ret);
+        return NULL;
+    }
+
+    return ret;
+}
+
+/* adds @name and (recursively) all devices it is stacked on to @names (bottom first) */
+static void add_queue_stack (const gchar *name, GPtrArray *names) {
+    gchar *path = NULL;
+    GDir *dir = NULL;
+    const gchar *slave = NULL;
+    gchar *slave_name = NULL;
+    guint i = 0;
+
+    for (i = 0; i < names->len; i++)
+        if (g_strcmp0 (g_ptr_array_index (names, i), name) == 0)
+            return;
+
+    path = g_strdup_printf ("/sys/block/%s/slaves", name);
+    dir = g_dir_open (path, 0, NULL);
+    g_free (path);
+    while (dir && (slave = g_dir_read_name (dir))) {
+        slave_name = bd_utils_get_whole_disk_name (slave, NULL);
+        if (slave_name)
+            add_queue_stack (slave_name, names);
+        g_free (slave_name);
+    }
+    if (dir)
+        g_dir_close (dir);
+
+    g_ptr_array_add (names, g_strdup (name));
+}
+
+/**
+ * get_changes:
+ * @name: kernel name of the device
+ * @settings: requested settings
+ * @strict: whether settings not supported by the device are an error or should be skipped
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): settings that need to be changed on @name, @settings
+ *                           validated against the values the kernel allows for @name
+ */
+static BDUtilsQueueSettings* get_changes (const gchar *name, const BDUtilsQueueSettings *settings, gboolean strict, GError **error) {
+    BDUtilsQueueSettings *current = NULL;
+    BDUtilsQueueSettings *changes = NULL;
+    gchar **schedulers = NULL;
+    gint64 value = 0;
+    gint64 max_hw = 0;
+    guint i = 0;
+
+    current = read_queue_settings (name);
+    changes = bd_utils_queue_settings_new ();
+    changes->device = g_strdup (name);
+
+    if (settings->scheduler && g_strcmp0 (settings->scheduler, current->scheduler) != 0) {
+        schedulers = get_schedulers (name, NULL);
+        if (schedulers && g_strv_contains ((const gchar * const *) schedulers, settings->scheduler))
+            changes->scheduler = g_strdup (settings->scheduler);
+        else if (strict) {
+            g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                         "Scheduler '%s' is not available for device '%s'", settings->scheduler, name);
+            g_strfreev (schedulers);
+            bd_utils_queue_settings_free (current);
+            bd_utils_queue_settings_free (changes);
+            return NULL;
+        }
+        g_strfreev (schedulers);
+    }
+
+    for (i = 0; i < G_N_ELEMENTS (queue_int_attrs); i++) {
+        value = QUEUE_INT_ATTR (settings, i);
+        if (value < 0 || value == QUEUE_INT_ATTR (current, i))
+            continue;
+
+        if (QUEUE_INT_ATTR (current, i) < 0) {
+            if (!strict)
+                continue;
+            g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                         "Setting '%s' is not supported by device '%s'", queue_int_attrs[i].attr, name);
+            bd_utils_queue_settings_free (current);
+            bd_utils_queue_settings_free (changes);
+            return NULL;
+        }
+
+        max_hw = queue_int_attrs[i].max;
+        if (g_strcmp0 (queue_int_attrs[i].attr, "max_sectors_kb") == 0) {
+            max_hw = read_queue_int_attr (name, "max_hw_sectors_kb");
+            if (max_hw < 0)
+                max_hw = queue_int_attrs[i].max;
+        }
+        if (value < queue_int_attrs[i].min || value > max_hw) {
+            g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                         "Invalid value %"G_GINT64_FORMAT" for '%s' of device '%s', must be between %"G_GINT64_FORMAT" and %"G_GINT64_FORMAT,
+                         value, queue_int_attrs[i].attr, name, queue_int_attrs[i].min, max_hw);
+            bd_utils_queue_settings_free (current);
+            bd_utils_queue_settings_free (changes);
+            return NULL;
+        }
+
+        QUEUE_INT_ATTR (changes, i) = value;
+    }
+
+    bd_utils_queue_settings_free (current);
+    return changes;
+}
+
+static gboolean has_changes (const BDUtilsQueueSettings *changes) {
+    guint i = 0;
+
+    if (changes->scheduler)
+        return TRUE;
+    for (i = 0; i < G_N_ELEMENTS (queue_int_attrs); i++)
+        if (QUEUE_INT_ATTR (changes, i) >= 0)
+            return TRUE;
+
+    return FALSE;
+}
+
+/**
+ * apply_changes:
+ * @changes: validated settings to apply to @changes->device
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): previous values of the changed settings or %NULL in case
+ *                           of error (settings already changed are reverted)
+ */
+static BDUtilsQueueSettings* apply_changes (const BDUtilsQueueSettings *changes, GError **error) {
+    BDUtilsQueueSettings *current = NULL;
+    BDUtilsQueueSettings *previous = NULL;
+    gchar *value = NULL;
+    gboolean success = FALSE;
+    guint i = 0;
+
+    current = read_queue_settings (changes->device);
+    previous = bd_utils_queue_settings_new ();
+    previous->device = g_strdup (changes->device);
+
+    /* scheduler first, nr_requests depends on it */
+    if (changes->scheduler) {
+        if (!write_queue_attr (changes->device, "scheduler", changes->scheduler, error)) {
+            bd_utils_queue_settings_free (current);
+            bd_utils_queue_settings_free (previous);
+            return NULL;
+        }
+        previous->scheduler = g_strdup (current->scheduler);
+    }
+
+    for (i = 0; i < G_N_ELEMENTS (queue_int_attrs); i++) {
+        if (QUEUE_INT_ATTR (changes, i) < 0)
+            continue;
+
+        value = g_strdup_printf ("%"G_GINT64_FORMAT, QUEUE_INT_ATTR (changes, i));
+        success = write_queue_attr (changes->device, queue_int_attrs[i].attr, value, error);
+        g_free (value);
+        if (!success) {
+            /* revert what we have already changed */
+            bd_utils_queue_settings_free (apply_changes (previous, NULL));
+            bd_utils_queue_settings_free (current);
+            bd_utils_queue_settings_free (previous);
+            return NULL;
+        }
+        QUEUE_INT_ATTR (previous, i) = QUEUE_INT_ATTR (current, i);
+    }
+
+    bd_utils_queue_settings_free (current);
+    return previous;
+}
+
+/**
+ * bd_utils_get_queue_settings:
+ * @device: device to get the queue settings for (e.g. "/dev/sda", "dm-0" or a symlink,
+ *          the disk is used for partitions)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): current queue settings of @device or %NULL in case of error
+ */
+BDUtilsQueueSettings* bd_utils_get_queue_settings (const gchar *device, GError **error) {
+    gchar *name = NULL;
+    BDUtilsQueueSettings *ret = NULL;
+
+    name = resolve_queue_dev_name (device, error);
+    if (!name)
+        return NULL;
+
+    ret = read_queue_settings (name);
+    g_free (name);
+
+    return ret;
+}
+
+/**
+ * bd_utils_set_queue_settings:
+ * @device: device to set the queue settings for (e.g. "/dev/sda", "dm-0" or a symlink,
+ *          the disk is used for partitions)
+ * @settings: settings to set (unset ones are not changed)
+ * @recursive: whether to also apply @settings to all devices @device is stacked on
+ *             (found via the "slaves" directories in sysfs)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Stacked devices (e.g. DM or MD) don't inherit settings of the underlying devices
+ * and vice versa. With @recursive, the settings are applied to the whole device stack
+ * and settings not supported by some of the devices (e.g. I/O scheduler of a bio-based
+ * DM device) are skipped for them. Without @recursive, all settings have to be
+ * supported by @device. All values are validated against the values the kernel allows
+ * before anything is changed.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): previous values of all changed
+ *                                                     settings (one item per changed device)
+ *                                                     that can be passed to
+ *                                                     bd_utils_restore_queue_settings() or
+ *                                                     %NULL in case of error (nothing is
+ *                                                     changed in such case)
+ */
+BDUtilsQueueSettings** bd_utils_set_queue_settings (const gchar *device, const BDUtilsQueueSettings *settings, gboolean recursive, GError **error) {
+    gchar *name = NULL;
+    GPtrArray *names = NULL;
+    GPtrArray *changes = NULL;
+    GPtrArray *previous = NULL;
+    BDUtilsQueueSettings *dev_changes = NULL;
+    BDUtilsQueueSettings *dev_previous = NULL;
+    guint i = 0;
+
+    name = resolve_queue_dev_name (device, error);
+    if (!name)
+        return NULL;
+
+    names = g_ptr_array_new_with_free_func (g_free);
+    if (recursive)
+        add_queue_stack (name, names);
+    else
+        g_ptr_array_add (names, g_strdup (name));
+    g_free (name);
+
+    /* validate everything first */
+    changes = g_ptr_array_new_with_free_func ((GDestroyNotify) bd_utils_queue_settings_free);
+    for (i = 0; i < names->len; i++) {
+        dev_changes = get_changes (g_ptr_array_index (names, i), settings, !recursive, error);
+        if (!dev_changes) {
+            g_ptr_array_free (changes, TRUE);
+            g_ptr_array_free (names, TRUE);
+            return NULL;
+        }
+        if (has_changes (dev_changes))
+            g_ptr_array_add (changes, dev_changes);
+        else
+            bd_utils_queue_settings_free (dev_changes);
+    }
+    g_ptr_array_free (names, TRUE);
+
+    previous = g_ptr_array_new ();
+    for (i = 0; i < changes->len; i++) {
+        dev_previous = apply_changes (g_ptr_array_index (changes, i), error);
+        if (!dev_previous) {
+            g_prefix_error (error, "Failed to set queue settings: ");
+            /* revert the changes on the devices already done */
+            g_ptr_array_add (previous, NULL);
+            bd_utils_restore_queue_settings ((BDUtilsQueueSettings **) previous->pdata, NULL);
+            g_ptr_array_set_free_func (previous, (GDestroyNotify) bd_utils_queue_settings_free);
+            g_ptr_array_free (previous, TRUE);
+            g_ptr_array_free (changes, TRUE);
+            return NULL;
+        }
+        g_ptr_array_add (previous, dev_previous);
+    }
+    g_ptr_array_free (changes, TRUE);
+
+    g_ptr_array_add (previous, NULL);
+    return (BDUtilsQueueSettings **) g_ptr_array_free (previous, FALSE);
+}
+
+/**
+ * bd_utils_restore_queue_settings:
+ * @previous: (array zero-terminated=1): previous settings as returned by bd_utils_set_queue_settings()
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether all the @previous settings were successfully restored or not
+ */
+gboolean bd_utils_restore_queue_settings (BDUtilsQueueSettings **previous, GError **error) {
+    BDUtilsQueueSettings **settings_p = NULL;
+    BDUtilsQueueSettings *dev_previous = NULL;
+    GError *l_error = NULL;
+    gboolean ret = TRUE;
+
+    for (settings_p = previous; settings_p && *settings_p; settings_p++) {
+        dev_previous = apply_changes (*settings_p, &l_error);
+        if (!dev_previous) {
+            /* try to restore as much as possible, report the first error */
+            if (ret)
+                g_propagate_prefixed_error (error, l_error, "Failed to restore queue settings of '%s': ",
+                                            (*settings_p)->device);
+            else
+                g_clear_error (&l_error);
+            ret = FALSE;
+        }
+        bd_utils_queue_settings_free (dev_previous);
+    }
+
+    return ret;
+}
@@ -18,6 +18,7 @@
  */
 
 #include <glib.h>
+#include <glib-object.h>
 
 #ifndef BD_UTILS_DEV_UTILS
 #define BD_UTILS_DEV_UTILS
@@ -31,5 +32,145 @@ typedef enum {
 
 gchar* bd_utils_resolve_device (const gchar *dev_spec, GError **error);
 gchar** bd_utils_get_device_symlinks (const gchar *dev_spec, GError **error);
+gchar* bd_utils_get_whole_disk_name (const gchar *name, GError **error);
+
+#define BD_UTILS_TYPE_IOSTAT (bd_utils_iostat_get_type ())
+GType bd_utils_iostat_get_type (void);
+
+/**
+ * BDUtilsIOStat:
+ * @device: kernel name of the device (e.g. "sda", "dm-0" or "nvme0n1")
+ * @slaves: (array zero-terminated=1): kernel names of the devices @device is
+ *          stacked on (DM/MD members, NVMe multipath paths, disk of a partition)
+ * @timestamp: monotonic time (in microseconds) the statistics were read at
+ * @read_ios: number of read I/Os completed
+ * @read_merges: number of read I/Os merged with in-queue I/O
+ * @read_sectors: number of 512-byte sectors read
+ * @read_ticks: total wait time for read requests (in milliseconds)
+ * @write_ios: number of write I/Os completed
+ * @write_merges: number of write I/Os merged with in-queue I/O
+ * @write_sectors: number of 512-byte sectors written
+ * @write_ticks: total wait time for write requests (in milliseconds)
+ * @in_flight: number of I/Os currently in flight
+ * @io_ticks: total time the device has been active (in milliseconds)
+ * @time_in_queue: total wait time for all requests (in milliseconds)
+ * @discard_ios: number of discard I/Os completed
+ * @discard_merges: number of discard I/Os merged with in-queue I/O
+ * @discard_sectors: number of 512-byte sectors discarded
+ * @discard_ticks: total wait time for discard requests (in milliseconds)
+ * @flush_ios: number of flush I/Os completed
+ * @flush_ticks: total wait time for flush requests (in milliseconds)
+ *
+ * Snapshot of the block layer I/O statistics of a device (see the kernel's
+ * Documentation/block/stat.rst). Fields not provided by the running kernel are 0.
+ */
+typedef struct BDUtilsIOStat {
+    gchar *device;
+    gchar **slaves;
+    gint64 timestamp;
+    guint64 read_ios;
+    guint64 read_merges;
+    guint64 read_sectors;
+    guint64 read_ticks;
+    guint64 write_ios;
+    guint64 write_merges;
+    guint64 write_sectors;
+    guint64 write_ticks;
+    guint64 in_flight;
+    guint64 io_ticks;
+    guint64 time_in_queue;
+    guint64 discard_ios;
+    guint64 discard_merges;
+    guint64 discard_sectors;
+    guint64 discard_ticks;
+    guint64 flush_ios;
+    guint64 flush_ticks;
+} BDUtilsIOStat;
+
+BDUtilsIOStat* bd_utils_iostat_copy (BDUtilsIOStat *stat);
+void bd_utils_iostat_free (BDUtilsIOStat *stat);
+
+#define BD_UTILS_TYPE_IOSTAT_RATES (bd_utils_iostat_rates_get_type ())
+GType bd_utils_iostat_rates_get_type (void);
+
+/**
+ * BDUtilsIOStatRates:
+ * @device: kernel name of the device
+ * @slaves: (array zero-terminated=1): kernel names of the devices @device is stacked on
+ * @interval: time between the two snapshots (in seconds)
+ * @read_iops: read I/Os completed per second
+ * @write_iops: write I/Os completed per second
+ * @discard_iops: discard I/Os completed per second
+ * @read_bps: bytes read per second
+ * @write_bps: bytes written per second
+ * @read_latency: average latency of read I/Os (in milliseconds)
+ * @write_latency: average latency of write I/Os (in milliseconds)
+ * @latency: average latency of all I/Os (in milliseconds)
+ * @queue_depth: average number of I/Os in flight
+ * @utilization: percentage of time the device was busy
+ * @added_latency: latency added by this layer of the device stack, i.e. @latency minus
+ *                 the highest @latency of the devices in @slaves (in milliseconds, never
+ *                 negative); equals @latency for devices with no @slaves
+ */
+typedef struct BDUtilsIOStatRates {
+    gchar *device;
+    gchar **slaves;
+    gdouble interval;
+    gdouble read_iops;
+    gdouble write_iops;
+    gdouble discard_iops;
+    gdouble read_bps;
+    gdouble write_bps;
+    gdouble read_latency;
+    gdouble write_latency;
+    gdouble latency;
+    gdouble queue_depth;
+    gdouble utilization;
+    gdouble added_latency;
+} BDUtilsIOStatRates;
+
+BDUtilsIOStatRates* bd_utils_iostat_rates_copy (BDUtilsIOStatRates *rates);
+void bd_utils_iostat_rates_free (BDUtilsIOStatRates *rates);
+
+BDUtilsIOStat** bd_utils_iostat_sample (GError **error);
+BDUtilsIOStatRates** bd_utils_iostat_compute_rates (BDUtilsIOStat **before, BDUtilsIOStat **after, GError **error);
+
+#define BD_UTILS_TYPE_QUEUE_SETTINGS (bd_utils_queue_settings_get_type ())
+GType bd_utils_queue_settings_get_type (void);
+
+/**
+ * BDUtilsQueueSettings:
+ * @device: (nullable): kernel name of the device the settings belong to (ignored by
+ *          bd_utils_set_queue_settings())
+ * @scheduler: (nullable): I/O scheduler
+ * @read_ahead_kb: maximum read-ahead (in KiB)
+ * @nr_requests: maximum number of requests queued by the scheduler
+ * @rq_affinity: completion CPU affinity (0, 1 or 2)
+ * @wbt_lat_usec: writeback throttling latency target (in microseconds, 0 disables throttling)
+ * @max_sectors_kb: maximum I/O size (in KiB), at most the device's max_hw_sectors_kb
+ * @add_random: whether the device contributes to the entropy pool (0 or 1)
+ *
+ * Block queue settings of a device (see the kernel's Documentation/block/queue-sysfs.rst).
+ * Negative numbers and %NULL mean the setting is unknown (not supported by the
+ * device) or should not be changed.
+ */
+typedef struct BDUtilsQueueSettings {
+    gchar *device;
+    gchar *scheduler;
+    gint64 read_ahead_kb;
+    gint64 nr_requests;
+    gint64 rq_affinity;
+    gint64 wbt_lat_usec;
+    gint64 max_sectors_kb;
+    gint64 add_random;
+} BDUtilsQueueSettings;
+
+BDUtilsQueueSettings* bd_utils_queue_settings_new (void);
+BDUtilsQueueSettings* bd_utils_queue_settings_copy (BDUtilsQueueSettings *settings);
+void bd_utils_queue_settings_free (BDUtilsQueueSettings *settings);
+
+BDUtilsQueueSettings* bd_utils_get_queue_settings (const gchar *device, GError **error);
+BDUtilsQueueSettings** bd_utils_set_queue_settings (const gchar *device, const BDUtilsQueueSettings *settings, gboolean recursive, GError **error);
+gboolean bd_utils_restore_queue_settings (BDUtilsQueueSettings **previous, GError **error);
 
 #endif  /* BD_UTILS_DEV_UTILS */
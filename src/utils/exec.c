@@ -17,17 +17,28 @@
  * Author: Vratislav Podzimek <vpodzime@redhat.com>
  */
 
+#define _GNU_SOURCE
 #include <glib.h>
+#include <glib-object.h>
+#include <gio/gio.h>
 #include "exec.h"
 #include "extra_arg.h"
 #include "logging.h"
+#include "context.h"
+#include "context-private.h"
 #include <stdlib.h>
 #include <poll.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/syscall.h>
 #include <unistd.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/utsname.h>
 
 #ifdef __clang__
 #define ZERO_INIT {}
@@ -46,6 +57,11 @@ static guint64 task_id_counter = 0;
 static BDUtilsProgFunc prog_func = NULL;
 static __thread BDUtilsProgFunc thread_prog_func = NULL;
 
+static GMutex exec_policy_lock;
+static BDUtilsExecPolicy *exec_policy = NULL;
+static GPrivate thread_exec_policy = G_PRIVATE_INIT ((GDestroyNotify) bd_utils_exec_policy_free);
+static GPrivate thread_cancellable = G_PRIVATE_INIT ((GDestroyNotify) g_object_unref);
+
 /**
  * bd_utils_exec_error_quark: (skip)
  */
@@ -166,6 +182,363 @@ static const gchar ** _append_extra_args (const gchar **argv, const BDExtraArg *
     return args;
 }
 
+/**
+ * bd_utils_exec_policy_new: (constructor)
+ * @timeout: wall-clock timeout in seconds or 0 for no timeout
+ * @ioprio_class: I/O scheduling class
+ * @ioprio_level: I/O priority level within @ioprio_class
+ * @nice: niceness increment
+ * @cpu_affinity: (nullable): list of allowed CPUs (e.g. "0-3,8") or %NULL
+ * @cgroup: (nullable): path to a cgroup v2 directory or %NULL
+ *
+ * See #BDUtilsExecPolicy for details about the individual fields.
+ *
+ * Returns: (transfer full): a new execution policy
+ */
+BDUtilsExecPolicy* bd_utils_exec_policy_new (guint64 timeout, BDUtilsIOPrioClass ioprio_class, guint8 ioprio_level, gint nice, const gchar *cpu_affinity, const gchar *cgroup) {
+    BDUtilsExecPolicy *ret = g_new0 (BDUtilsExecPolicy, 1);
+
+    ret->timeout = timeout;
+    ret->ioprio_class = ioprio_class;
+    ret->ioprio_level = ioprio_level;
+    ret->nice = nice;
+    ret->cpu_affinity = g_strdup (cpu_affinity);
+    ret->cgroup = g_strdup (cgroup);
+
+    return ret;
+}
+
+/**
+ * bd_utils_exec_policy_copy: (skip)
+ * @policy: (nullable): %BDUtilsExecPolicy to copy
+ *
+ * Creates a new copy of @policy.
+ */
+BDUtilsExecPolicy* bd_utils_exec_policy_copy (BDUtilsExecPolicy *policy) {
+    if (policy == NULL)
+        return NULL;
+
+    return bd_utils_exec_policy_new (policy->timeout, policy->ioprio_class, policy->ioprio_level,
+                                     policy->nice, policy->cpu_affinity, policy->cgroup);
+}
+
+/**
+ * bd_utils_exec_policy_free: (skip)
+ * @policy: (nullable): %BDUtilsExecPolicy to free
+ *
+ * Frees @policy.
+ */
+void bd_utils_exec_policy_free (BDUtilsExecPolicy *policy) {
+    if (policy == NULL)
+        return;
+
+    g_free (policy->cpu_affinity);
+    g_free (policy->cgroup);
+    g_free (policy);
+}
+
+GType bd_utils_exec_policy_get_type (void) {
+    static GType type = 0;
+
+    if (G_UNLIKELY (!type))
+        type = g_boxed_type_register_static ("BDUtilsExecPolicy",
+                                             (GBoxedCopyFunc) bd_utils_exec_policy_copy,
+                                             (GBoxedFreeFunc) bd_utils_exec_policy_free);
+
+    return type;
+}
+
+static gboolean _parse_cpu_list (const gchar *list, cpu_set_t *cpus, GError **error) {
+    gchar **ranges = NULL;
+    gchar **range_p = NULL;
+    guint64 first = 0;
+    guint64 last = 0;
+    gchar *endptr = NULL;
+
+    CPU_ZERO (cpus);
+    ranges = g_strsplit (list, ",", -1);
+    for (range_p = ranges; *range_p; range_p++) {
+        first = g_ascii_strtoull (*range_p, &endptr, 10);
+        if (endptr == *range_p)
+            break;
+        last = first;
+        if (*endptr == '-') {
+            gchar *start = endptr + 1;
+            last = g_ascii_strtoull (start, &endptr, 10);
+            if (endptr == start)
+                break;
+        }
+        if (*endptr != '\0' || last < first || last >= CPU_SETSIZE)
+            break;
+        for (; first <= last; first++)
+            CPU_SET (first, cpus);
+    }
+
+    if (*range_p || CPU_COUNT (cpus) == 0) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_INVAL_POLICY,
+                     "Invalid CPU list '%s'", list);
+        g_strfreev (ranges);
+        return FALSE;
+    }
+
+    g_strfreev (ranges);
+    return TRUE;
+}
+
+gboolean _bd_utils_exec_policy_validate (const BDUtilsExecPolicy *policy, GError **error) {
+    cpu_set_t cpus;
+    gchar *procs_path = NULL;
+    gboolean exists = FALSE;
+
+    if (policy->ioprio_class > BD_UTILS_IOPRIO_CLASS_IDLE) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_INVAL_POLICY,
+                     "Invalid I/O scheduling class: %d", policy->ioprio_class);
+        return FALSE;
+    }
+    if (policy->ioprio_level > 7) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_INVAL_POLICY,
+                     "Invalid I/O priority level %d, must be between 0 and 7", policy->ioprio_level);
+        return FALSE;
+    }
+    if (policy->nice < -40 || policy->nice > 40) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_INVAL_POLICY,
+                     "Invalid niceness increment: %d", policy->nice);
+        return FALSE;
+    }
+    if (policy->cpu_affinity && !_parse_cpu_list (policy->cpu_affinity, &cpus, error))
+        return FALSE;
+    if (policy->cgroup) {
+        procs_path = g_build_filename (policy->cgroup, "cgroup.procs", NULL);
+        exists = g_file_test (procs_path, G_FILE_TEST_EXISTS);
+        g_free (procs_path);
+        if (!exists) {
+            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_INVAL_POLICY,
+                         "'%s' is not a cgroup v2 directory", policy->cgroup);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_utils_set_exec_policy:
+ * @policy: (nullable): execution policy to use or %NULL to reset to default
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Sets the process-wide execution policy applied to all external utilities
+ * spawned by libblockdev. A policy set with bd_utils_set_exec_policy_thread()
+ * takes precedence.
+ *
+ * Note: The policy only applies to the utilities libblockdev spawns itself. The
+ *       lvm-dbus plugin runs LVM operations through the lvmdbusd daemon which
+ *       ignores the policy.
+ *
+ * Returns: whether the execution policy was successfully set or not
+ */
+gboolean bd_utils_set_exec_policy (const BDUtilsExecPolicy *policy, GError **error) {
+    if (policy && !_bd_utils_exec_policy_validate (policy, error))
+        return FALSE;
+
+    g_mutex_lock (&exec_policy_lock);
+    bd_utils_exec_policy_free (exec_policy);
+    exec_policy = bd_utils_exec_policy_copy ((BDUtilsExecPolicy *) policy);
+    g_mutex_unlock (&exec_policy_lock);
+
+    return TRUE;
+}
+
+/**
+ * bd_utils_set_exec_policy_thread:
+ * @policy: (nullable): execution policy to use on current thread or %NULL
+ *                      to reset to the process-wide one
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Sets the execution policy applied to external utilities spawned by libblockdev
+ * from the current thread. To apply a policy to a single call, set it right before
+ * the call and reset it afterwards.
+ *
+ * Returns: whether the execution policy was successfully set or not
+ */
+gboolean bd_utils_set_exec_policy_thread (const BDUtilsExecPolicy *policy, GError **error) {
+    if (policy && !_bd_utils_exec_policy_validate (policy, error))
+        return FALSE;
+
+    g_private_replace (&thread_exec_policy, bd_utils_exec_policy_copy ((BDUtilsExecPolicy *) policy));
+
+    return TRUE;
+}
+
+/**
+ * bd_utils_set_cancellable_thread:
+ * @cancellable: (nullable): cancellable for the utilities spawned from the current
+ *                           thread or %NULL to unset it
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Once @cancellable is cancelled, the whole process group of the external utility
+ * libblockdev is running from the current thread (if any) is killed and no new
+ * utilities are spawned. The function that spawned the utility fails with
+ * %BD_UTILS_EXEC_ERROR_CANCELLED. Operations not using external utilities are
+ * not affected.
+ *
+ * Returns: whether the @cancellable was successfully set or not
+ */
+gboolean bd_utils_set_cancellable_thread (GCancellable *cancellable, GError **error G_GNUC_UNUSED) {
+    g_private_replace (&thread_cancellable, cancellable ? g_object_ref (cancellable) : NULL);
+
+    return TRUE;
+}
+
+/**
+ * bd_utils_get_exec_policy:
+ *
+ * Returns: (transfer full) (nullable): execution policy effective for the current
+ *                                      thread or %NULL if no policy is set
+ *
+ * The policy set for the thread takes precedence over the one set on the thread's
+ * #BDContext (if any) which takes precedence over the process-wide one.
+ */
+BDUtilsExecPolicy* bd_utils_get_exec_policy (void) {
+    BDUtilsExecPolicy *policy = NULL;
+    BDContext *ctx = NULL;
+    gboolean ctx_set = FALSE;
+
+    policy = g_private_get (&thread_exec_policy);
+    if (policy)
+        return bd_utils_exec_policy_copy (policy);
+
+    ctx = bd_context_get_thread ();
+    if (ctx) {
+        policy = _bd_context_get_exec_policy (ctx, &ctx_set);
+        if (ctx_set)
+            return policy;
+    }
+
+    g_mutex_lock (&exec_policy_lock);
+    policy = bd_utils_exec_policy_copy (exec_policy);
+    g_mutex_unlock (&exec_policy_lock);
+
+    return policy;
+}
+
+/* everything the child needs to apply the policy, prepared in the parent
+   process so that the child setup function only needs to do syscalls */
+typedef struct ExecChildSetup {
+    gint ioprio;
+    gint nice;
+    gboolean set_affinity;
+    cpu_set_t cpus;
+    gint cgroup_fd;
+    gboolean new_pgrp;
+} ExecChildSetup;
+
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_SHIFT 13
+
+/* Returns: whether @setup needs to be applied or not (the policy is a no-op) */
+static gboolean _exec_child_setup_prepare (const BDUtilsExecPolicy *policy, ExecChildSetup *setup, GError **error) {
+    gchar *procs_path = NULL;
+
+    memset (setup, 0, sizeof (ExecChildSetup));
+    setup->ioprio = -1;
+    setup->cgroup_fd = -1;
+
+    if (!policy)
+        return FALSE;
+
+    if (policy->ioprio_class != BD_UTILS_IOPRIO_CLASS_NONE)
+        setup->ioprio = (policy->ioprio_class << IOPRIO_CLASS_SHIFT) | policy->ioprio_level;
+    setup->nice = policy->nice;
+    setup->new_pgrp = policy->timeout > 0;
+    if (policy->cpu_affinity) {
+        if (!_parse_cpu_list (policy->cpu_affinity, &(setup->cpus), error))
+            return FALSE;
+        setup->set_affinity = TRUE;
+    }
+    if (policy->cgroup) {
+        procs_path = g_build_filename (policy->cgroup, "cgroup.procs", NULL);
+        setup->cgroup_fd = open (procs_path, O_WRONLY | O_CLOEXEC);
+        if (setup->cgroup_fd < 0) {
+            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_INVAL_POLICY,
+                         "Failed to open '%s': %m", procs_path);
+            g_free (procs_path);
+            return FALSE;
+        }
+        g_free (procs_path);
+    }
+
+    return TRUE;
+}
+
+static void _exec_child_setup_cleanup (ExecChildSetup *setup) {
+    if (setup->cgroup_fd >= 0)
+        close (setup->cgroup_fd);
+    setup->cgroup_fd = -1;
+}
+
+/* runs in the child between fork() and exec(), only async-signal-safe calls here */
+static void _exec_child_setup (gpointer user_data) {
+    ExecChildSetup *setup = (ExecChildSetup *) user_data;
+
+    /* everything is best-effort here, there's no way to report errors back */
+    if (setup->cgroup_fd >= 0)
+        (void) !write (setup->cgroup_fd, "0", 1);
+    if (setup->new_pgrp)
+        setpgid (0, 0);
+    if (setup->ioprio >= 0)
+        syscall (SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, setup->ioprio);
+    if (setup->nice != 0)
+        (void) !nice (setup->nice);
+    if (setup->set_affinity)
+        sched_setaffinity (0, sizeof (cpu_set_t), &(setup->cpus));
+}
+
+/* how often to check for the child to exit when a timeout is set (in microseconds) */
+#define _EXEC_WAIT_INTERVAL (10 * 1000)
+/* how long to wait for the child to die after being killed (in microseconds) */
+#define _EXEC_KILL_GRACE (1000 * 1000)
+
+static gpointer _reap_child (gpointer data) {
+    waitpid (GPOINTER_TO_INT (data), NULL, 0);
+    return NULL;
+}
+
+/* like waitpid(), but kills the child's whole process group once @deadline (monotonic time)
+   is reached or @cancellable is cancelled, 0 means no deadline */
+static pid_t _wait_for_child (GPid pid, gint64 deadline, GCancellable *cancellable, gint *status, gboolean *killed) {
+    pid_t ret = 0;
+    guint i = 0;
+
+    if (deadline == 0 && !cancellable)
+        return waitpid (pid, status, 0);
+
+    while (!*killed) {
+        ret = waitpid (pid, status, WNOHANG);
+        if (ret != 0)
+            return ret;
+        if ((deadline > 0 && g_get_monotonic_time () >= deadline) || g_cancellable_is_cancelled (cancellable))
+            *killed = TRUE;
+        else
+            g_usleep (_EXEC_WAIT_INTERVAL);
+    }
+
+    /* the child may have not gotten to setpgid() yet */
+    if (kill (-pid, SIGKILL) != 0)
+        kill (pid, SIGKILL);
+
+    for (i = 0; i < _EXEC_KILL_GRACE / _EXEC_WAIT_INTERVAL; i++) {
+        ret = waitpid (pid, status, WNOHANG);
+        if (ret != 0)
+            return ret;
+        g_usleep (_EXEC_WAIT_INTERVAL);
+    }
+
+    /* most likely stuck in an uninterruptible sleep (e.g. I/O on a dead path),
+       don't block the caller and let it be reaped whenever it dies */
+    g_thread_unref (g_thread_new ("bd-exec-reaper", _reap_child, GINT_TO_POINTER (pid)));
+    return 0;
+}
+
 /**
  * bd_utils_exec_and_report_error:
  * @argv: (array zero-terminated=1): the argv array for the call
@@ -195,6 +568,8 @@ gboolean bd_utils_exec_and_report_error_no_progress (const gchar **argv, const B
     return bd_utils_exec_and_report_status_error (argv, extra, &status, error);
 }
 
+static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, const gchar *input, gboolean no_progress, gboolean ignore_status, gint *proc_status, gchar **stdout, gchar **stderr, GError **error);
+
 /**
  * bd_utils_exec_and_capture_output_no_progress:
  * @argv: (array zero-terminated=1): the argv array for the call
@@ -215,8 +590,25 @@ gboolean bd_utils_exec_and_capture_output_no_progress (const gchar **argv, const
     gint exit_status = 0;
     gchar **old_env = NULL;
     gchar **new_env = NULL;
+    BDUtilsExecPolicy *policy = NULL;
+    ExecChildSetup setup;
+    gboolean need_setup = FALSE;
     GError *l_error = NULL;
 
+    policy = bd_utils_get_exec_policy ();
+    if ((policy && policy->timeout > 0) || g_private_get (&thread_cancellable)) {
+        /* g_spawn_sync() has no way to interrupt the process, use the async code
+           path that can kill it (with progress reporting muted) */
+        bd_utils_exec_policy_free (policy);
+        return _utils_exec_and_report_progress (argv, extra, NULL, NULL, TRUE, TRUE, status, output, stderr, error);
+    }
+    need_setup = _exec_child_setup_prepare (policy, &setup, &l_error);
+    bd_utils_exec_policy_free (policy);
+    if (l_error) {
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
     args = _append_extra_args (argv, extra);
 
     old_env = g_get_environ ();
@@ -225,7 +617,9 @@ gboolean bd_utils_exec_and_capture_output_no_progress (const gchar **argv, const
 
     task_id = log_running (args ? args : argv);
     success = g_spawn_sync (NULL, args ? (gchar **) args : (gchar **) argv, new_env, G_SPAWN_SEARCH_PATH,
-                            NULL, NULL, &stdout_data, &stderr_data, &exit_status, error);
+                            need_setup ? _exec_child_setup : NULL, &setup,
+                            &stdout_data, &stderr_data, &exit_status, error);
+    _exec_child_setup_cleanup (&setup);
     g_strfreev (new_env);
     if (!success) {
         /* error is already populated from the call */
@@ -383,7 +777,15 @@ _process_fd_event (gint fd, struct pollfd *poll_fd, GString *read_buffer, GStrin
     return TRUE;
 }
 
-static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, const gchar *input, gint *proc_status, gchar **stdout, gchar **stderr, GError **error) {
+/* progress reporting is muted for @progress_id 0 */
+static void _report_finished (guint64 progress_id, const gchar *msg) {
+    if (progress_id != 0)
+        bd_utils_report_finished (progress_id, msg);
+}
+
+/* @no_progress mutes the progress reporting, with @ignore_status a non-zero exit code
+   is not an error (it's just stored in @proc_status) */
+static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, const gchar *input, gboolean no_progress, gboolean ignore_status, gint *proc_status, gchar **stdout, gchar **stderr, GError **error) {
     const gchar **args = NULL;
     gchar *args_str = NULL;
     guint64 task_id = 0;
@@ -398,7 +800,7 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
     gboolean ret = FALSE;
     gint poll_status = 0;
     guint8 completion = 0;
-    struct pollfd fds[2] = { ZERO_INIT, ZERO_INIT };
+    struct pollfd fds[3] = { ZERO_INIT, ZERO_INIT, ZERO_INIT };
     int flags;
     gboolean out_done = FALSE;
     gboolean err_done = FALSE;
@@ -411,8 +813,39 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
     gchar **old_env = NULL;
     gchar **new_env = NULL;
     gboolean success = TRUE;
+    BDUtilsExecPolicy *policy = NULL;
+    ExecChildSetup setup;
+    gboolean need_setup = FALSE;
+    guint64 timeout = 0;
+    gint64 deadline = 0;
+    gint poll_timeout = -1;
+    gboolean killed = FALSE;
+    GCancellable *cancellable = NULL;
+    GPollFD cancel_fd = ZERO_INIT;
+    nfds_t n_fds = 2;
     GError *l_error = NULL;
 
+    cancellable = g_private_get (&thread_cancellable);
+    if (g_cancellable_is_cancelled (cancellable)) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_CANCELLED,
+                     "Operation was cancelled");
+        return FALSE;
+    }
+
+    policy = bd_utils_get_exec_policy ();
+    need_setup = _exec_child_setup_prepare (policy, &setup, &l_error);
+    timeout = policy ? policy->timeout : 0;
+    bd_utils_exec_policy_free (policy);
+    if (l_error) {
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+    if (cancellable) {
+        /* killing the whole process group needs its own process group */
+        setup.new_pgrp = TRUE;
+        need_setup = TRUE;
+    }
+
     args = _append_extra_args (argv, extra);
 
     task_id = log_running (args ? args : argv);
@@ -423,8 +856,10 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
 
     ret = g_spawn_async_with_pipes (NULL, args ? (gchar**) args : (gchar**) argv, new_env,
                                     G_SPAWN_DEFAULT|G_SPAWN_SEARCH_PATH|G_SPAWN_DO_NOT_REAP_CHILD,
-                                    NULL, NULL, &pid, input ? &in_fd : NULL, &out_fd, &err_fd, error);
+                                    need_setup ? _exec_child_setup : NULL, &setup,
+                                    &pid, input ? &in_fd : NULL, &out_fd, &err_fd, error);
 
+    _exec_child_setup_cleanup (&setup);
     g_strfreev (new_env);
 
     if (!ret) {
@@ -433,12 +868,20 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
         return FALSE;
     }
 
-    args_str = g_strjoinv (" ", args ? (gchar **) args : (gchar **) argv);
-    msg = g_strdup_printf ("Started '%s'", args_str);
-    progress_id = bd_utils_report_started (msg);
-    g_free (args_str);
+    if (timeout > 0)
+        deadline = g_get_monotonic_time () + timeout * G_USEC_PER_SEC;
+    if (setup.new_pgrp)
+        /* avoid racing with the child's own setpgid() call */
+        setpgid (pid, pid);
+
+    if (!no_progress) {
+        args_str = g_strjoinv (" ", args ? (gchar **) args : (gchar **) argv);
+        msg = g_strdup_printf ("Started '%s'", args_str);
+        progress_id = bd_utils_report_started (msg);
+        g_free (args_str);
+        g_free (msg);
+    }
     g_free (args);
-    g_free (msg);
 
     /* set both fds for non-blocking read */
     flags = fcntl (out_fd, F_GETFL, 0);
@@ -461,7 +904,7 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
         if (num_written < 0) {
             g_set_error (&l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
                          "Failed to write to stdin of the process: %m");
-            bd_utils_report_finished (progress_id, l_error->message);
+            _report_finished (progress_id, l_error->message);
             g_propagate_error (error, l_error);
             /* would overwrite errno, need to close as a last step */
             close (in_fd);
@@ -480,15 +923,42 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
     fds[1].fd = err_fd;
     fds[0].events = POLLIN | POLLHUP | POLLERR;
     fds[1].events = POLLIN | POLLHUP | POLLERR;
+    if (cancellable) {
+        if (g_cancellable_make_pollfd (cancellable, &cancel_fd)) {
+            fds[2].fd = cancel_fd.fd;
+            fds[2].events = POLLIN;
+            n_fds = 3;
+        } else
+            /* no FD to wait on, check for cancellation periodically */
+            poll_timeout = _EXEC_WAIT_INTERVAL / 1000;
+    }
     while (! (out_done && err_done)) {
-        poll_status = poll (fds, 2, -1 /* timeout */);
-        g_warn_if_fail (poll_status != 0);  /* no timeout specified, zero should never be returned */
+        if (g_cancellable_is_cancelled (cancellable)) {
+            /* the process is killed when waiting for it below */
+            killed = TRUE;
+            break;
+        }
+        if (deadline > 0) {
+            /* round up to not spin on the last millisecond */
+            poll_timeout = (deadline - g_get_monotonic_time () + 999) / 1000;
+            if (poll_timeout <= 0) {
+                /* the process is killed when waiting for it below */
+                killed = TRUE;
+                break;
+            }
+            if (cancellable && n_fds == 2)
+                poll_timeout = MIN (poll_timeout, _EXEC_WAIT_INTERVAL / 1000);
+        }
+        poll_status = poll (fds, n_fds, poll_timeout);
+        g_warn_if_fail (poll_status != 0 || poll_timeout >= 0);  /* no timeout specified, zero should never be returned */
+        if (poll_status == 0)
+            continue;
         if (poll_status < 0) {
             if (errno == EAGAIN || errno == EINTR)
                 continue;
             g_set_error (&l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
                          "Failed to poll output FDs: %m");
-            bd_utils_report_finished (progress_id, l_error->message);
+            _report_finished (progress_id, l_error->message);
             g_propagate_error (error, l_error);
             success = FALSE;
             break;
@@ -496,7 +966,7 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
 
         if (!out_done) {
             if (! _process_fd_event (out_fd, &fds[0], stdout_buffer, stdout_data, &stdout_buffer_pos, &out_done, progress_id, &completion, prog_extract, &l_error)) {
-                bd_utils_report_finished (progress_id, l_error->message);
+                _report_finished (progress_id, l_error->message);
                 g_propagate_error (error, l_error);
                 success = FALSE;
                 break;
@@ -505,7 +975,7 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
 
         if (!err_done) {
             if (! _process_fd_event (err_fd, &fds[1], stderr_buffer, stderr_data, &stderr_buffer_pos, &err_done, progress_id, &completion, prog_extract, &l_error)) {
-                bd_utils_report_finished (progress_id, l_error->message);
+                _report_finished (progress_id, l_error->message);
                 g_propagate_error (error, l_error);
                 success = FALSE;
                 break;
@@ -518,21 +988,35 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
     close (out_fd);
     close (err_fd);
 
-    child_ret = waitpid (pid, &status, 0);
+    child_ret = _wait_for_child (pid, deadline, cancellable, &status, &killed);
+    if (n_fds == 3)
+        g_cancellable_release_fd (cancellable);
     *proc_status = WEXITSTATUS (status);
     if (success) {
-        if (child_ret > 0) {
-            if (*proc_status != 0) {
+        if (killed && g_cancellable_is_cancelled (cancellable)) {
+            g_set_error (&l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_CANCELLED,
+                         "Process was cancelled and killed");
+            _report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            success = FALSE;
+        } else if (killed) {
+            g_set_error (&l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_TIMED_OUT,
+                         "Process didn't finish in %"G_GUINT64_FORMAT" seconds and was killed", timeout);
+            _report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            success = FALSE;
+        } else if (child_ret > 0) {
+            if (*proc_status != 0 && !ignore_status) {
                 msg = stderr_data->len > 0 ? stderr_data->str : stdout_data->str;
                 g_set_error (&l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
                              "Process reported exit code %d: %s", *proc_status, msg);
-                bd_utils_report_finished (progress_id, l_error->message);
+                _report_finished (progress_id, l_error->message);
                 g_propagate_error (error, l_error);
                 success = FALSE;
             } else if (WIFSIGNALED (status)) {
                 g_set_error (&l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
                              "Process killed with a signal");
-                bd_utils_report_finished (progress_id, l_error->message);
+                _report_finished (progress_id, l_error->message);
                 g_propagate_error (error, l_error);
                 success = FALSE;
             }
@@ -541,7 +1025,7 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
                 errno = 0;
                 g_set_error (&l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
                              "Failed to wait for the process");
-                bd_utils_report_finished (progress_id, l_error->message);
+                _report_finished (progress_id, l_error->message);
                 g_propagate_error (error, l_error);
                 success = FALSE;
             } else {
@@ -550,7 +1034,7 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
             }
         }
         if (success)
-            bd_utils_report_finished (progress_id, "Completed");
+            _report_finished (progress_id, "Completed");
     }
     log_out (task_id, stdout_data->str, stderr_data->str);
     log_done (task_id, *proc_status);
@@ -582,7 +1066,7 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
  * Returns: whether the @argv was successfully executed (no error and exit code 0) or not
  */
 gboolean bd_utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, gint *proc_status, GError **error) {
-    return _utils_exec_and_report_progress (argv, extra, prog_extract, NULL, proc_status, NULL, NULL, error);
+    return _utils_exec_and_report_progress (argv, extra, prog_extract, NULL, FALSE, FALSE, proc_status, NULL, NULL, error);
 }
 
 /**
@@ -598,7 +1082,7 @@ gboolean bd_utils_exec_with_input (const gchar **argv, const gchar *input, const
     gint status = 0;
     /* just use the "stronger" function providing dumb progress reporting (just
        'started' and 'finished') and throw away the returned status */
-    return _utils_exec_and_report_progress (argv, extra, NULL, input, &status, NULL, NULL, error);
+    return _utils_exec_and_report_progress (argv, extra, NULL, input, FALSE, FALSE, &status, NULL, NULL, error);
 }
 
 /**
@@ -619,7 +1103,7 @@ gboolean bd_utils_exec_and_capture_output (const gchar **argv, const BDExtraArg
     gchar *stderr = NULL;
     gboolean ret = FALSE;
 
-    ret = _utils_exec_and_report_progress (argv, extra, NULL, NULL, &status, &stdout, &stderr, error);
+    ret = _utils_exec_and_report_progress (argv, extra, NULL, NULL, FALSE, FALSE, &status, &stdout, &stderr, error);
     if (!ret)
         return ret;
 
@@ -820,6 +1304,109 @@ gboolean bd_utils_check_util_version (const gchar *util, const gchar *version, c
     return TRUE;
 }
 
+/* generation of the dependency checks, changes whenever a previously missing
+   dependency may have become available */
+static volatile gint deps_generation = 1;
+static volatile guint deps_path_hash = 0;
+static gint deps_inotify_fd = -1;
+static GArray *deps_watches = NULL;
+static GMutex deps_watch_lock;
+
+static void add_deps_watch (const gchar *dir) {
+    gint wd = 0;
+
+    wd = inotify_add_watch (deps_inotify_fd, dir, IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM |
+                                                  IN_CLOSE_WRITE | IN_ATTRIB | IN_ONLYDIR);
+    if (wd >= 0)
+        g_array_append_val (deps_watches, wd);
+}
+
+/* (re)creates the watches for the directories where the dependencies are searched
+   for -- the PATH directories and the kernel modules directory */
+static void setup_deps_watches (const gchar *path) {
+    gchar **dirs = NULL;
+    gchar **dir_p = NULL;
+    gchar *modules_dir = NULL;
+    struct utsname uts;
+    guint i = 0;
+
+    if (deps_inotify_fd < 0) {
+        deps_inotify_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+        if (deps_inotify_fd < 0)
+            return;
+        deps_watches = g_array_new (FALSE, FALSE, sizeof (gint));
+    }
+
+    for (i = 0; i < deps_watches->len; i++)
+        inotify_rm_watch (deps_inotify_fd, g_array_index (deps_watches, gint, i));
+    g_array_set_size (deps_watches, 0);
+
+    dirs = g_strsplit (path ? path : "", ":", -1);
+    for (dir_p = dirs; *dir_p; dir_p++)
+        if (**dir_p != '\0')
+            add_deps_watch (*dir_p);
+    g_strfreev (dirs);
+
+    add_deps_watch ("/lib/modules");
+    if (uname (&uts) == 0) {
+        modules_dir = g_build_filename ("/lib/modules", uts.release, NULL);
+        add_deps_watch (modules_dir);
+        g_free (modules_dir);
+    }
+}
+
+/**
+ * bd_utils_get_deps_cache_generation: (skip)
+ *
+ * Used by the plugins to invalidate the cached results of failed dependency
+ * checks. Doesn't take any lock unless the PATH environment variable changed.
+ *
+ * Returns: current generation of the dependency checks, changes when the PATH
+ *          directories or the kernel modules directory change, when the PATH
+ *          environment variable changes and on bd_utils_refresh_deps_cache()
+ */
+guint bd_utils_get_deps_cache_generation (void) {
+    const gchar *path = g_getenv ("PATH");
+    guint path_hash = g_str_hash (path ? path : "");
+    gchar buf[4096];
+    gboolean changed = FALSE;
+    gint fd = -1;
+
+    if (path_hash != (guint) g_atomic_int_get (&deps_path_hash)) {
+        g_mutex_lock (&deps_watch_lock);
+        if (path_hash != (guint) g_atomic_int_get (&deps_path_hash)) {
+            setup_deps_watches (path);
+            g_atomic_int_set (&deps_path_hash, path_hash);
+            g_atomic_int_inc (&deps_generation);
+        }
+        g_mutex_unlock (&deps_watch_lock);
+    }
+
+    /* the inotify file descriptor is never closed once created */
+    fd = g_atomic_int_get (&deps_inotify_fd);
+    if (fd >= 0)
+        while (read (fd, buf, sizeof (buf)) > 0)
+            changed = TRUE;
+    if (changed)
+        g_atomic_int_inc (&deps_generation);
+
+    return (guint) g_atomic_int_get (&deps_generation);
+}
+
+/**
+ * bd_utils_refresh_deps_cache:
+ *
+ * Makes the plugins forget about all previously failed checks of their runtime
+ * dependencies (utilities and kernel modules), the dependencies are checked
+ * again the next time they are needed.
+ *
+ * Note: This is usually not needed, changes of the PATH directories and of the
+ *       kernel modules directory are detected automatically.
+ */
+void bd_utils_refresh_deps_cache (void) {
+    g_atomic_int_inc (&deps_generation);
+}
+
 /**
  * bd_utils_init_prog_reporting:
  * @new_prog_func: (nullable) (scope notified): progress reporting function to
@@ -880,6 +1467,24 @@ gboolean bd_utils_mute_prog_reporting_thread (GError **error G_GNUC_UNUSED) {
     return TRUE;
 }
 
+/* thread-specific function first, then the one from the thread's context, then the global one */
+static BDUtilsProgFunc get_current_prog_func (void) {
+    BDContext *ctx = NULL;
+    BDUtilsProgFunc ctx_prog_func = NULL;
+
+    if (thread_prog_func)
+        return thread_prog_func;
+
+    ctx = bd_context_get_thread ();
+    if (ctx) {
+        ctx_prog_func = _bd_context_get_prog_func (ctx);
+        if (ctx_prog_func)
+            return ctx_prog_func;
+    }
+
+    return prog_func;
+}
+
 /**
  * bd_utils_prog_reporting_initialized:
  *
@@ -889,7 +1494,7 @@ gboolean bd_utils_mute_prog_reporting_thread (GError **error G_GNUC_UNUSED) {
  * bd_utils_mute_prog_reporting_thread was used to mute the thread.
  */
 gboolean bd_utils_prog_reporting_initialized (void) {
-    return (thread_prog_func != NULL || prog_func != NULL) && thread_prog_func != thread_progress_muted;
+    return get_current_prog_func () != NULL && thread_prog_func != thread_progress_muted;
 }
 
 /**
@@ -902,7 +1507,7 @@ guint64 bd_utils_report_started (const gchar *msg) {
     guint64 task_id = 0;
     BDUtilsProgFunc current_prog_func;
 
-    current_prog_func = thread_prog_func != NULL ? thread_prog_func : prog_func;
+    current_prog_func = get_current_prog_func ();
 
     g_mutex_lock (&task_id_counter_lock);
     task_id_counter++;
@@ -923,7 +1528,7 @@ guint64 bd_utils_report_started (const gchar *msg) {
 void bd_utils_report_progress (guint64 task_id, guint64 completion, const gchar *msg) {
     BDUtilsProgFunc current_prog_func;
 
-    current_prog_func = thread_prog_func != NULL ? thread_prog_func : prog_func;
+    current_prog_func = get_current_prog_func ();
     if (current_prog_func)
         current_prog_func (task_id, BD_UTILS_PROG_PROGRESS, completion, (gchar *)msg);
 }
@@ -936,7 +1541,7 @@ void bd_utils_report_progress (guint64 task_id, guint64 completion, const gchar
 void bd_utils_report_finished (guint64 task_id, const gchar *msg) {
     BDUtilsProgFunc current_prog_func;
 
-    current_prog_func = thread_prog_func != NULL ? thread_prog_func : prog_func;
+    current_prog_func = get_current_prog_func ();
     if (current_prog_func)
         current_prog_func (task_id, BD_UTILS_PROG_FINISHED, 100, (gchar *)msg);
 }
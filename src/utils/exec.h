@@ -1,4 +1,6 @@
 #include <glib.h>
+#include <glib-object.h>
+#include <gio/gio.h>
 #include "extra_arg.h"
 
 #ifndef BD_UTILS_EXEC
@@ -60,8 +62,59 @@ typedef enum {
     BD_UTILS_EXEC_ERROR_UTIL_CHECK_ERROR,
     BD_UTILS_EXEC_ERROR_UTIL_FEATURE_CHECK_ERROR,
     BD_UTILS_EXEC_ERROR_UTIL_FEATURE_UNAVAILABLE,
+    BD_UTILS_EXEC_ERROR_TIMED_OUT,
+    BD_UTILS_EXEC_ERROR_INVAL_POLICY,
+    BD_UTILS_EXEC_ERROR_CANCELLED,
 } BDUtilsExecError;
 
+/**
+ * BDUtilsIOPrioClass:
+ * @BD_UTILS_IOPRIO_CLASS_NONE: keep the I/O scheduling class of the calling process
+ * @BD_UTILS_IOPRIO_CLASS_RT: real-time I/O scheduling class
+ * @BD_UTILS_IOPRIO_CLASS_BE: best-effort I/O scheduling class
+ * @BD_UTILS_IOPRIO_CLASS_IDLE: idle I/O scheduling class
+ *
+ * See ioprio_set(2) for details.
+ */
+typedef enum {
+    BD_UTILS_IOPRIO_CLASS_NONE = 0,
+    BD_UTILS_IOPRIO_CLASS_RT,
+    BD_UTILS_IOPRIO_CLASS_BE,
+    BD_UTILS_IOPRIO_CLASS_IDLE,
+} BDUtilsIOPrioClass;
+
+#define BD_UTILS_TYPE_EXEC_POLICY (bd_utils_exec_policy_get_type ())
+GType bd_utils_exec_policy_get_type (void);
+
+/**
+ * BDUtilsExecPolicy:
+ * @timeout: wall-clock timeout in seconds after which the whole process group
+ *           of the spawned utility is killed or 0 for no timeout
+ * @ioprio_class: I/O scheduling class for the spawned utility
+ * @ioprio_level: I/O priority level (0-7, lower is higher priority) within @ioprio_class,
+ *                ignored for %BD_UTILS_IOPRIO_CLASS_NONE and %BD_UTILS_IOPRIO_CLASS_IDLE
+ * @nice: niceness increment for the spawned utility (see nice(2)), 0 to keep the caller's
+ * @cpu_affinity: (nullable): list of CPUs the spawned utility is allowed to run on in the
+ *                cpuset(7) "list format" (e.g. "0-3,8") or %NULL to keep the caller's
+ * @cgroup: (nullable): path to a cgroup v2 directory the spawned utility should be
+ *          placed into or %NULL to keep it in the caller's cgroup
+ *
+ * Execution policy applied to all external utilities spawned by libblockdev.
+ * See bd_utils_set_exec_policy() and bd_utils_set_exec_policy_thread().
+ */
+typedef struct BDUtilsExecPolicy {
+    guint64 timeout;
+    BDUtilsIOPrioClass ioprio_class;
+    guint8 ioprio_level;
+    gint nice;
+    gchar *cpu_affinity;
+    gchar *cgroup;
+} BDUtilsExecPolicy;
+
+BDUtilsExecPolicy* bd_utils_exec_policy_new (guint64 timeout, BDUtilsIOPrioClass ioprio_class, guint8 ioprio_level, gint nice, const gchar *cpu_affinity, const gchar *cgroup);
+BDUtilsExecPolicy* bd_utils_exec_policy_copy (BDUtilsExecPolicy *policy);
+void bd_utils_exec_policy_free (BDUtilsExecPolicy *policy);
+
 gboolean bd_utils_exec_and_report_error (const gchar **argv, const BDExtraArg **extra, GError **error);
 gboolean bd_utils_exec_and_report_error_no_progress (const gchar **argv, const BDExtraArg **extra, GError **error);
 gboolean bd_utils_exec_and_report_status_error (const gchar **argv, const BDExtraArg **extra, gint *status, GError **error);
@@ -71,11 +124,18 @@ gboolean bd_utils_exec_and_report_progress (const gchar **argv, const BDExtraArg
 gboolean bd_utils_exec_with_input (const gchar **argv, const gchar *input, const BDExtraArg **extra, GError **error);
 gint bd_utils_version_cmp (const gchar *ver_string1, const gchar *ver_string2, GError **error);
 gboolean bd_utils_check_util_version (const gchar *util, const gchar *version, const gchar *version_arg, const gchar *version_regexp, GError **error);
+guint bd_utils_get_deps_cache_generation (void);
+void bd_utils_refresh_deps_cache (void);
 
 gboolean bd_utils_init_prog_reporting (BDUtilsProgFunc new_prog_func, GError **error);
 gboolean bd_utils_init_prog_reporting_thread (BDUtilsProgFunc new_prog_func, GError **error);
 gboolean bd_utils_mute_prog_reporting_thread (GError **error);
 gboolean bd_utils_prog_reporting_initialized (void);
+
+gboolean bd_utils_set_exec_policy (const BDUtilsExecPolicy *policy, GError **error);
+gboolean bd_utils_set_exec_policy_thread (const BDUtilsExecPolicy *policy, GError **error);
+gboolean bd_utils_set_cancellable_thread (GCancellable *cancellable, GError **error);
+BDUtilsExecPolicy* bd_utils_get_exec_policy (void);
 guint64 bd_utils_report_started (const gchar *msg);
 void bd_utils_report_progress (guint64 task_id, guint64 completion, const gchar *msg);
 void bd_utils_report_finished (guint64 task_id, const gchar *msg);
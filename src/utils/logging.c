@@ -22,6 +22,8 @@
 #include <stdarg.h>
 
 #include "logging.h"
+#include "context.h"
+#include "context-private.h"
 
 static BDUtilsLogFunc log_func = &bd_utils_log_stdout;
 
@@ -31,6 +33,17 @@ static int log_level = BD_UTILS_LOG_DEBUG;
 static int log_level = BD_UTILS_LOG_WARNING;
 #endif
 
+/* logging function and level effective for the current thread -- the ones set
+   on the thread's context take precedence over the global ones */
+static void get_current_log (BDUtilsLogFunc *cur_func, gint *cur_level) {
+    BDContext *ctx = bd_context_get_thread ();
+
+    *cur_func = log_func;
+    *cur_level = log_level;
+    if (ctx)
+        _bd_context_get_log (ctx, cur_func, cur_level);
+}
+
 /**
  * bd_utils_init_logging:
  * @new_log_func: (nullable) (scope notified): logging function to use or
@@ -72,8 +85,12 @@ void bd_utils_set_log_level (gint level) {
  * @msg: log message
  */
 void bd_utils_log (gint level, const gchar *msg) {
-    if (log_func && level <= log_level)
-        log_func (level, msg);
+    BDUtilsLogFunc cur_func = NULL;
+    gint cur_level = 0;
+
+    get_current_log (&cur_func, &cur_level);
+    if (cur_func && level <= cur_level)
+        cur_func (level, msg);
 }
 
 /**
@@ -86,8 +103,11 @@ void bd_utils_log_format (gint level, const gchar *format, ...) {
     gchar *msg = NULL;
     va_list args;
     gint ret = 0;
+    BDUtilsLogFunc cur_func = NULL;
+    gint cur_level = 0;
 
-    if (log_func && level <= log_level) {
+    get_current_log (&cur_func, &cur_level);
+    if (cur_func && level <= cur_level) {
         va_start (args, format);
         ret = g_vasprintf (&msg, format, args);
         va_end (args);
@@ -97,7 +117,7 @@ void bd_utils_log_format (gint level, const gchar *format, ...) {
             return;
         }
 
-        log_func (level, msg);
+        cur_func (level, msg);
     }
 
     g_free (msg);
@@ -112,7 +132,11 @@ void bd_utils_log_format (gint level, const gchar *format, ...) {
  *
  */
 void bd_utils_log_stdout (gint level, const gchar *msg) {
-    if (level > log_level)
+    BDUtilsLogFunc cur_func = NULL;
+    gint cur_level = 0;
+
+    get_current_log (&cur_func, &cur_level);
+    if (level > cur_level)
         return;
 
     switch (level) {
@@ -1444,6 +1444,45 @@ class CryptoTestTrueCrypt(CryptoTestCase):
         self.assertTrue(succ)
         self.assertFalse(os.path.exists("/dev/mapper/libblockdevTestTC"))
 
+    @tag_test(TestTags.NOSTORAGE)
+    def test_tc_open_with_hints(self):
+        """Verify that opening TrueCrypt/VeraCrypt device with hints works"""
+
+        ctx = BlockDev.CryptoKeyslotContext(passphrase=self.passphrase)
+
+        # wrong hash hint, nothing else is tried
+        with self.assertRaises(GLib.GError):
+            BlockDev.crypto_tc_open_with_hints(self.tc_dev, "libblockdevTestTC", ctx, hash="whirlpool")
+        self.assertFalse(os.path.exists("/dev/mapper/libblockdevTestTC"))
+
+        succ, match = BlockDev.crypto_tc_open_with_hints(self.tc_dev, "libblockdevTestTC", ctx,
+                                                         hash="sha512", cipher="aes")
+        self.assertTrue(succ)
+        self.assertTrue(os.path.exists("/dev/mapper/libblockdevTestTC"))
+        self.assertEqual(match.hash, "sha512")
+        self.assertEqual(match.cipher, "aes")
+        self.assertEqual(match.mode, "xts-plain64")
+
+        succ = BlockDev.crypto_tc_close("libblockdevTestTC")
+        self.assertTrue(succ)
+
+        # no hints, try all the hashes in parallel
+        with self.assertRaises(GLib.GError):
+            wrong_ctx = BlockDev.CryptoKeyslotContext(passphrase="wrong-passphrase")
+            BlockDev.crypto_tc_open_with_hints(self.vc_dev, "libblockdevTestTC", wrong_ctx,
+                                               veracrypt=True, parallel=True)
+
+        succ, match = BlockDev.crypto_tc_open_with_hints(self.vc_dev, "libblockdevTestTC", ctx,
+                                                         veracrypt=True, parallel=True)
+        self.assertTrue(succ)
+        self.assertTrue(os.path.exists("/dev/mapper/libblockdevTestTC"))
+        self.assertEqual(match.hash, "sha512")
+        self.assertEqual(match.cipher, "aes")
+
+        succ = BlockDev.crypto_tc_close("libblockdevTestTC")
+        self.assertTrue(succ)
+        self.assertFalse(os.path.exists("/dev/mapper/libblockdevTestTC"))
+
     @tag_test(TestTags.NOSTORAGE)
     def test_seems_encrypted(self):
         """Verify that BlockDev.crypto_device_seems_encrypted works"""
@@ -1746,6 +1785,71 @@ class CryptoTestIntegrity(CryptoTestCase):
         self.assertFalse(os.path.exists("/dev/mapper/%s" % self._dm_name))
 
 
+    @tag_test(TestTags.SLOW)
+    def test_integrity_status(self):
+        succ = BlockDev.crypto_integrity_format(self.loop_dev, "crc32c", False)
+        self.assertTrue(succ)
+
+        # not active yet
+        with self.assertRaises(GLib.GError):
+            BlockDev.crypto_integrity_status(self._dm_name)
+
+        succ = BlockDev.crypto_integrity_open(self.loop_dev, self._dm_name, "crc32c")
+        self.assertTrue(succ)
+        self.assertTrue(os.path.exists("/dev/mapper/%s" % self._dm_name))
+
+        status = BlockDev.crypto_integrity_status(self._dm_name)
+        self.assertEqual(status.name, self._dm_name)
+        self.assertEqual(status.mode, BlockDev.CryptoIntegrityMode.JOURNAL)
+        self.assertEqual(status.algorithm, "crc32c")
+        self.assertEqual(status.tag_size, 4)
+        self.assertEqual(status.mismatches, 0)
+        self.assertGreater(status.provided_data_sectors, 0)
+        self.assertFalse(status.recalculating)
+
+        # path to the device works too
+        status = BlockDev.crypto_integrity_status("/dev/mapper/%s" % self._dm_name)
+        self.assertEqual(status.name, self._dm_name)
+
+        all_status = BlockDev.crypto_integrity_status_all()
+        self.assertIn(self._dm_name, [st.name for st in all_status])
+
+        # no recalculation running
+        succ = BlockDev.crypto_integrity_wait_recalculation(self._dm_name, 0)
+        self.assertTrue(succ)
+
+        succ = BlockDev.crypto_integrity_close(self._dm_name)
+        self.assertTrue(succ)
+
+        # now with bitmap mode and recalculation
+        progress_log = []
+
+        def _my_progress_func(_task, _status, completion, msg):
+            progress_log.append((completion, msg))
+
+        succ = BlockDev.utils_init_prog_reporting(_my_progress_func)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.utils_init_prog_reporting, None)
+
+        flags = BlockDev.CryptoIntegrityOpenFlags.NO_JOURNAL_BITMAP | BlockDev.CryptoIntegrityOpenFlags.RECALCULATE
+        succ = BlockDev.crypto_integrity_open(self.loop_dev, self._dm_name, "crc32c", flags=flags)
+        self.assertTrue(succ)
+
+        status = BlockDev.crypto_integrity_status(self._dm_name)
+        self.assertEqual(status.mode, BlockDev.CryptoIntegrityMode.BITMAP)
+        self.assertGreater(status.sectors_per_bit, 0)
+
+        succ = BlockDev.crypto_integrity_wait_recalculation(self._dm_name, 0)
+        self.assertTrue(succ)
+        self.assertTrue(any(prog[1] == "Completed" for prog in progress_log))
+
+        status = BlockDev.crypto_integrity_status(self._dm_name)
+        self.assertFalse(status.recalculating)
+
+        succ = BlockDev.crypto_integrity_close(self._dm_name)
+        self.assertTrue(succ)
+
+
 class CryptoTestLUKSOpal(CryptoTestCase):
 
     @unittest.skipUnless(HAVE_OPAL, "OPAL not supported")
@@ -127,6 +127,70 @@ class DevMapperNameNodeBijection(DevMapperTestCase):
 
         self.assertTrue(succ)
 
+class DevMapperStats(DevMapperTestCase):
+    def test_stats_regions(self):
+        """Verify that dm-stats regions can be created, queried and removed"""
+
+        succ = BlockDev.dm_create_linear("testMap", self.loop_dev, 2048, None)
+        self.assertTrue(succ)
+
+        # udev probes the new map, its reads would show up in the counters
+        run("udevadm settle")
+
+        succ, region_id = BlockDev.dm_stats_create("testMap", n_areas=4, program_id="bd_test",
+                                                   histogram_bounds=[1, 10, 100])
+        self.assertTrue(succ)
+
+        regions = BlockDev.dm_stats_list("testMap")
+        self.assertEqual(len(regions), 1)
+        self.assertEqual(regions[0].region_id, region_id)
+        self.assertEqual(regions[0].start, 0)
+        self.assertEqual(regions[0].length, 2048)
+        self.assertEqual(regions[0].area_size, 512)
+        self.assertEqual(regions[0].program_id, "bd_test")
+        self.assertFalse(regions[0].precise_timestamps)
+        self.assertEqual(regions[0].histogram_bounds, [1, 10, 100])
+
+        self.assertEqual(BlockDev.dm_stats_list("testMap", "other_program"), [])
+
+        # read the first area of the device
+        run("dd if=/dev/mapper/testMap of=/dev/null bs=512 count=512 iflag=direct >/dev/null 2>&1")
+
+        areas = BlockDev.dm_stats_print("testMap", region_id)
+        self.assertEqual(len(areas), 4)
+        self.assertEqual([a.start for a in areas], [0, 512, 1024, 1536])
+        self.assertGreater(areas[0].reads, 0)
+        self.assertEqual(areas[0].sectors_read, 512)
+        self.assertEqual(areas[1].reads, 0)
+        self.assertEqual(len(areas[0].histogram), 4)
+        self.assertEqual(sum(areas[0].histogram), areas[0].reads)
+
+        rates = BlockDev.dm_stats_sample("testMap", region_id, 100)
+        self.assertEqual(len(rates), 4)
+        for rate in rates:
+            self.assertEqual(rate.read_iops, 0)
+            self.assertEqual(rate.write_bytes_per_sec, 0)
+
+        succ = BlockDev.dm_stats_clear("testMap", region_id)
+        self.assertTrue(succ)
+        areas = BlockDev.dm_stats_print("testMap", region_id)
+        self.assertEqual(areas[0].reads, 0)
+
+        succ = BlockDev.dm_stats_delete("testMap", region_id)
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.dm_stats_list("testMap"), [])
+
+        # invalid region specification
+        with self.assertRaises(GLib.GError):
+            BlockDev.dm_stats_create("testMap", start=10)
+
+        # no such region
+        with self.assertRaises(GLib.GError):
+            BlockDev.dm_stats_print("testMap", region_id + 1)
+
+        succ = BlockDev.dm_remove("testMap")
+        self.assertTrue(succ)
+
 class DMDepsTest(DevMapperTest):
 
     @tag_test(TestTags.NOSTORAGE)
@@ -147,3 +211,4 @@ class DMDepsTest(DevMapperTest):
     def test_check_dm_tech(self):
         """ Verify that BlockDev.DMTech works from Python as expected """
         self.assertTrue(hasattr(BlockDev.DMTech, "MAP"))
+        self.assertTrue(hasattr(BlockDev.DMTech, "STATS"))
@@ -243,6 +243,39 @@ class BtrfsResize(BtrfsTestCase):
             fi = BlockDev.fs_btrfs_get_info(self.mount_dir)
             self.assertEqual(fi.size, self.loop_size)
 
+    def test_btrfs_online_grow(self):
+        """Verify that a mounted btrfs file system is grown without the btrfs utility"""
+
+        succ = BlockDev.fs_btrfs_mkfs(self.loop_dev)
+        self.assertTrue(succ)
+
+        with mounted(self.loop_dev, self.mount_dir):
+            succ = BlockDev.fs_btrfs_resize(self.mount_dir, 300 * 1024**2)
+            self.assertTrue(succ)
+
+            fi = BlockDev.fs_btrfs_get_info(self.mount_dir)
+            self.assertEqual(fi.size, 300 * 1024**2)
+
+            with utils.fake_path(all_but="btrfs"):
+                succ = BlockDev.fs_btrfs_resize(self.mount_dir, 350 * 1024**2)
+                self.assertTrue(succ)
+
+            fi = BlockDev.fs_btrfs_get_info(self.mount_dir)
+            self.assertEqual(fi.size, 350 * 1024**2)
+
+            # shrinking needs the btrfs utility
+            with utils.fake_path(all_but="btrfs"):
+                with self.assertRaises(GLib.GError):
+                    BlockDev.fs_btrfs_resize(self.mount_dir, 300 * 1024**2)
+
+            # grow to the size of the device
+            with utils.fake_path(all_but="btrfs"):
+                succ = BlockDev.fs_btrfs_resize(self.mount_dir, 0)
+                self.assertTrue(succ)
+
+            fi = BlockDev.fs_btrfs_get_info(self.mount_dir)
+            self.assertEqual(fi.size, self.loop_size)
+
 
 class BtrfsMultiDevice(BtrfsTestCase):
 
@@ -410,6 +410,34 @@ class ExtResize(ExtTestCase):
                               resize_function=BlockDev.fs_ext4_resize,
                               minsize_function=BlockDev.fs_ext4_get_min_size)
 
+    def test_ext4_online_grow(self):
+        """Verify that a mounted ext4 file system is grown without resize2fs"""
+
+        succ = BlockDev.fs_ext4_mkfs(self.loop_dev, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.fs_ext4_resize(self.loop_dev, 80 * 1024**2, None)
+        self.assertTrue(succ)
+        fi = BlockDev.fs_ext4_get_info(self.loop_dev)
+        self.assertEqual(fi.block_size * fi.block_count, 80 * 1024**2)
+
+        with mounted(self.loop_dev, self.mount_dir):
+            with utils.fake_path(all_but="resize2fs"):
+                succ = BlockDev.fs_ext4_resize(self.loop_dev, 100 * 1024**2, None)
+                self.assertTrue(succ)
+                fi = BlockDev.fs_ext4_get_info(self.loop_dev)
+                self.assertEqual(fi.block_size * fi.block_count, 100 * 1024**2)
+
+                # grow to the size of the device
+                succ = BlockDev.fs_ext4_resize(self.loop_dev, 0, None)
+                self.assertTrue(succ)
+                fi = BlockDev.fs_ext4_get_info(self.loop_dev)
+                self.assertEqual(fi.block_size * fi.block_count, self.loop_size)
+
+                # online shrink needs resize2fs (which doesn't support it anyway)
+                with self.assertRaises(GLib.GError):
+                    BlockDev.fs_ext4_resize(self.loop_dev, 80 * 1024**2, None)
+
 
 class ExtSetUUID(ExtTestCase):
 
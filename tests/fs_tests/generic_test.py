@@ -590,6 +590,44 @@ class GenericMkfs(GenericTestCase):
         self.assertIsNotNone(info)
         self.assertFalse(info.label)  # label should be empty by default
 
+    def test_generic_mkfs_geometry(self):
+        """ Test that fs_mkfs applies the stripe geometry and reports it back """
+        # loop device has no stripe geometry, nothing should be applied
+        options = BlockDev.FSMkfsOptions(topology=True)
+        succ = BlockDev.fs_mkfs(self.loop_dev, "ext4", options)
+        self.assertTrue(succ)
+        self.assertEqual(options.stripe_unit, 0)
+        self.assertEqual(options.stripe_width, 0)
+
+        # explicit geometry: 64 KiB chunks, 4 data disks
+        options = BlockDev.FSMkfsOptions(stripe_unit=64 * 1024, stripe_width=4,
+                                         lazy_itable_init=BlockDev.FSMkfsLazyInit.DISABLE,
+                                         journal_size=16)
+        succ = BlockDev.fs_mkfs(self.loop_dev, "ext4", options, [BlockDev.ExtraArg("-b", "4096")])
+        self.assertTrue(succ)
+        self.assertEqual(options.stripe_unit, 64 * 1024)
+        self.assertEqual(options.stripe_width, 4)
+
+        out = check_output(["dumpe2fs", "-h", self.loop_dev]).decode()
+        self.assertRegex(out, r"RAID stride:\s+16")
+        self.assertRegex(out, r"RAID stripe width:\s+64")
+        self.assertRegex(out, r"Journal size:\s+16M")
+
+        # stripe unit not aligned to the F2FS segments and the stripes can't be applied
+        if self.f2fs_avail:
+            options = BlockDev.FSMkfsOptions(force=True, stripe_unit=96 * 1024, stripe_width=3)
+            succ = BlockDev.fs_mkfs(self.loop_dev, "f2fs", options)
+            self.assertTrue(succ)
+            self.assertEqual(options.stripe_unit, 0)
+            self.assertEqual(options.stripe_width, 0)
+
+        # no geometry support for vfat
+        options = BlockDev.FSMkfsOptions(stripe_unit=64 * 1024, stripe_width=4)
+        succ = BlockDev.fs_mkfs(self.loop_dev, "vfat", options)
+        self.assertTrue(succ)
+        self.assertEqual(options.stripe_unit, 0)
+        self.assertEqual(options.stripe_width, 0)
+
     def test_fail_generic_mkfs(self):
         """ Test that generic mkfs fails correctly with unknown/unsupported filesystem """
 
@@ -1226,6 +1264,58 @@ class GenericGetFreeSpace(GenericTestCase):
             BlockDev.fs_get_free_space(self.loop_dev)
 
 
+class GenericGetFreeSpaceHistogram(GenericTestCase):
+    def _check_histogram(self, buckets, free):
+        self.assertTrue(buckets)
+        self.assertEqual(sum(b.bytes for b in buckets), free)
+        for bucket in buckets:
+            self.assertGreater(bucket.extents, 0)
+            self.assertEqual(bucket.max_size, 2 * bucket.min_size)
+            self.assertGreaterEqual(bucket.bytes, bucket.extents * bucket.min_size)
+            self.assertLess(bucket.bytes, bucket.extents * bucket.max_size)
+        self.assertEqual(sorted(buckets, key=lambda b: b.min_size), buckets)
+
+    def test_ext4_free_space_histogram(self):
+        """Test getting free space histogram and space map of an ext4 file system"""
+        succ = BlockDev.fs_ext4_mkfs(self.loop_dev, None)
+        self.assertTrue(succ)
+
+        buckets = BlockDev.fs_get_free_space_histogram(self.loop_dev)
+        self._check_histogram(buckets, BlockDev.fs_get_free_space(self.loop_dev))
+
+        with self.assertRaisesRegex(GLib.GError, "not supported"):
+            BlockDev.fs_get_free_space_histogram(self.loop_dev, "vfat")
+
+        with mounted(self.loop_dev, self.mount_dir):
+            extents = BlockDev.fs_get_space_map(self.mount_dir)
+        self.assertTrue(extents)
+        # superblock and group descriptors at the start are metadata
+        self.assertTrue(extents[0].metadata)
+        for prev, ext in zip(extents, extents[1:]):
+            self.assertGreaterEqual(ext.offset, prev.offset + prev.length)
+
+    def test_xfs_free_space_histogram(self):
+        """Test getting free space histogram of an XFS file system"""
+        succ = BlockDev.fs_xfs_mkfs(self.loop_dev, None)
+        self.assertTrue(succ)
+
+        # needs to be mounted
+        with self.assertRaisesRegex(GLib.GError, "needs to be mounted"):
+            BlockDev.fs_get_free_space_histogram(self.loop_dev, "xfs")
+
+        with mounted(self.loop_dev, self.mount_dir):
+            buckets = BlockDev.fs_get_free_space_histogram(self.loop_dev, "xfs")
+            self.assertTrue(buckets)
+            # one big free extent per AG in an empty file system
+            fi = BlockDev.fs_xfs_get_info(self.loop_dev)
+            self.assertGreater(buckets[-1].min_size, fi.block_size * fi.block_count / 16)
+
+            extents = BlockDev.fs_get_space_map(self.mount_dir)
+            self.assertTrue(extents)
+            used = sum(ext.length for ext in extents)
+            self.assertLessEqual(used, fi.block_size * fi.block_count - sum(b.bytes for b in buckets))
+
+
 class GenericGetMinSize(GenericTestCase):
     def _test_get_min_size(self, mkfs_function, fstype):
         # clean the device
@@ -1328,6 +1418,76 @@ class FSFreezeTest(GenericTestCase):
             BlockDev.fs_freeze(tmp)
 
 
+class FSTrimTest(GenericNoDevTestCase):
+
+    def setUp(self):
+        self.addCleanup(self._clean_up)
+        self.dev_files = []
+        self.loop_devs = []
+        self.mount_dirs = []
+
+        # LIO devices don't support discard, use loop devices instead
+        for _i in range(2):
+            dev_file = utils.create_sparse_tempfile("trim_test", 200 * 1024**2)
+            self.dev_files.append(dev_file)
+            succ, loop = BlockDev.loop_setup(dev_file)
+            if not succ:
+                raise RuntimeError("Failed to setup loop device for testing")
+            self.loop_devs.append("/dev/%s" % loop)
+            self.mount_dirs.append(tempfile.mkdtemp(prefix="libblockdev.", suffix="trim_test"))
+
+    def _clean_up(self):
+        for mount_dir in self.mount_dirs:
+            utils.umount(mount_dir)
+        for loop_dev in self.loop_devs:
+            BlockDev.loop_teardown(loop_dev)
+        for dev_file in self.dev_files:
+            os.unlink(dev_file)
+
+    def _mkfs_and_mount(self, idx):
+        succ = BlockDev.fs_ext4_mkfs(self.loop_devs[idx], [BlockDev.ExtraArg.new("-E", "nodiscard")])
+        self.assertTrue(succ)
+        succ = BlockDev.fs_mount(self.loop_devs[idx], self.mount_dirs[idx], "ext4", None)
+        self.assertTrue(succ)
+
+    def test_trim(self):
+        """ Test trimming a mounted filesystem """
+
+        with self.assertRaisesRegex(GLib.GError, "doesn't appear to be a mountpoint"):
+            BlockDev.fs_trim("/not/a/mountpoint", None)
+
+        self._mkfs_and_mount(0)
+
+        # nothing discarded by mkfs, all the free space should be trimmed now
+        res = BlockDev.fs_trim(self.mount_dirs[0], None)
+        self.assertEqual(res.mountpoint, self.mount_dirs[0])
+        self.assertGreater(res.trimmed, 100 * 1024**2)
+        self.assertIsNone(res.thin_pool)
+
+        # 200 MiB filesystem in 32 MiB chunks with at most 10 chunks per second
+        opts = BlockDev.FSTrimOptions(chunk_size=32 * 1024**2, max_iops=10, min_extent=1024**2)
+        start = time.monotonic()
+        res = BlockDev.fs_trim(self.mount_dirs[0], opts)
+        self.assertEqual(res.mountpoint, self.mount_dirs[0])
+        self.assertGreaterEqual(time.monotonic() - start, 0.5)
+
+    def test_trim_many(self):
+        """ Test trimming multiple mounted filesystems """
+
+        self._mkfs_and_mount(0)
+        self._mkfs_and_mount(1)
+
+        res = BlockDev.fs_trim_many(self.mount_dirs, None)
+        self.assertEqual(len(res), 2)
+        for i in range(2):
+            self.assertEqual(res[i].mountpoint, self.mount_dirs[i])
+            self.assertGreater(res[i].trimmed, 100 * 1024**2)
+
+        # errors are reported even if some filesystems were trimmed
+        with self.assertRaisesRegex(GLib.GError, "/not/a/mountpoint"):
+            BlockDev.fs_trim_many(self.mount_dirs + ["/not/a/mountpoint"], None)
+
+
 class SupportedFilesystemsTest(GenericNoDevTestCase):
     def test_supported_filesystems(self):
         filesystems = BlockDev.fs_supported_filesystems()
@@ -283,6 +283,49 @@ class XfsResize(XfsTestCase):
         self.assertTrue(fi)
         self.assertEqual(fi.block_size * fi.block_count, 450 * 1024**2)
 
+    def test_xfs_online_grow(self):
+        """Verify that a mounted xfs file system is grown without xfs_growfs"""
+
+        lv = self._setup_lvm(vgname="libbd_fs_tests", lvname="xfs_test", lvsize="350M")
+
+        succ = BlockDev.fs_xfs_mkfs(lv, None)
+        self.assertTrue(succ)
+
+        with mounted(lv, self.mount_dir):
+            fi = BlockDev.fs_xfs_get_info(lv)
+            self.assertEqual(fi.block_size * fi.block_count, 350 * 1024**2)
+
+            self._lvresize("libbd_fs_tests", "xfs_test", "450M")
+
+            # grow just to 430 MiB (the last AG is not full)
+            with utils.fake_path(all_but=("xfs_growfs", "xfs_spaceman")):
+                succ = BlockDev.fs_xfs_resize(self.mount_dir, 430 * 1024**2 / fi.block_size, None)
+                self.assertTrue(succ)
+            fi = BlockDev.fs_xfs_get_info(lv)
+            self.assertEqual(fi.block_size * fi.block_count, 430 * 1024**2)
+
+            # grow to the size of the device
+            with utils.fake_path(all_but=("xfs_growfs", "xfs_spaceman")):
+                succ = BlockDev.fs_xfs_resize(self.mount_dir, 0, None)
+                self.assertTrue(succ)
+            fi = BlockDev.fs_xfs_get_info(lv)
+            self.assertEqual(fi.block_size * fi.block_count, 450 * 1024**2)
+
+            self._lvresize("libbd_fs_tests", "xfs_test", "500M")
+
+            # the generic resize function needs the block size of the mounted file system
+            with utils.fake_path(all_but=("xfs_growfs", "xfs_spaceman")):
+                succ = BlockDev.fs_resize(lv, 480 * 1024**2)
+                self.assertTrue(succ)
+            fi = BlockDev.fs_xfs_get_info(lv)
+            self.assertEqual(fi.block_size * fi.block_count, 480 * 1024**2)
+
+            with utils.fake_path(all_but=("xfs_growfs", "xfs_spaceman")):
+                succ = BlockDev.fs_resize(lv, 0)
+                self.assertTrue(succ)
+            fi = BlockDev.fs_xfs_get_info(lv)
+            self.assertEqual(fi.block_size * fi.block_count, 500 * 1024**2)
+
 
 class XfsSetUUID(XfsTestCase):
 
@@ -962,6 +962,75 @@ class LvmTestLVcreateWithExtra(LvmPVVGLVTestCase):
         succ = BlockDev.lvm_lvremove("testVG", "testLV", True, None)
         self.assertTrue(succ)
 
+@unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
+class LvmTestLVcreateSpread(LvmPVVGLVTestCase):
+    _sparse_size = 200 * 1024**2
+
+    def _clean_up(self):
+        try:
+            BlockDev.lvm_lvremove("testVG", "testLV", True, None)
+        except:
+            pass
+        try:
+            BlockDev.lvm_vgremove("testVG", None)
+        except:
+            pass
+        for dm in ("testSpread1", "testSpread2"):
+            try:
+                BlockDev.lvm_pvremove("/dev/mapper/" + dm)
+            except:
+                pass
+            run_command("dmsetup remove %s" % dm)
+
+        LvmPVVGLVTestCase._clean_up(self)
+
+    @tag_test(TestTags.CORE)
+    def test_lvcreate_spread(self):
+        """Verify that PVs for new LVs are spread over physical devices"""
+
+        # two PVs on the same physical device
+        sectors = self._sparse_size // 512 // 2
+        for i, dm in enumerate(("testSpread1", "testSpread2")):
+            ret, _out, _err = run_command("dmsetup create %s --table '0 %d linear %s %d'" % (dm, sectors, self.loop_dev3, i * sectors))
+            self.assertEqual(ret, 0)
+
+        pvs = [self.loop_dev, "/dev/mapper/testSpread1", "/dev/mapper/testSpread2"]
+        for pv in pvs:
+            succ = BlockDev.lvm_pvcreate(pv, 0, 0, None)
+            self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", pvs, 0, None)
+        self.assertTrue(succ)
+
+        # only two distinct physical devices
+        with self.assertRaisesRegex(GLib.GError, "Only 2 of the 3 requested PVs"):
+            BlockDev.lvm_select_pvs("testVG", 20 * 1024**2, "striped", 3)
+
+        selected = BlockDev.lvm_select_pvs("testVG", 20 * 1024**2, "striped", 2)
+        self.assertEqual(len(selected), 2)
+        self.assertIn(self.loop_dev, selected)
+
+        # not enough space on the PVs
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_select_pvs("testVG", 1024**3, "striped", 2)
+
+        # invalid number of PVs for the type
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_select_pvs("testVG", 20 * 1024**2, "raid5", 2)
+
+        succ = BlockDev.lvm_lvcreate_spread("testVG", "testLV", 20 * 1024**2, "striped", 2)
+        self.assertTrue(succ)
+
+        info = BlockDev.lvm_lvinfo("testVG", "testLV")
+        self.assertEqual(info.segtype, "striped")
+
+        _ret, out, _err = run_command("lvs --noheadings -o devices testVG/testLV")
+        self.assertIn(self.loop_dev, out)
+
+        # striped over both the selected PVs
+        _ret, out, _err = run_command("lvs --noheadings -o stripes testVG/testLV")
+        self.assertEqual(out.strip(), "2")
+
 @unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
 class LvmTestLVcreateType(LvmPVVGLVTestCase):
 
@@ -1609,6 +1678,109 @@ class LvmTestThSnapshotCreate(LvmPVVGLVthLVsnapshotTestCase):
         self.assertIn("snapshot", info.roles.split(","))
         self.assertIn("thinsnapshot", info.roles.split(","))
 
+@unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
+class LvmTestThpoolSpaceUsage(LvmPVVGLVthLVsnapshotTestCase):
+    def test_thpool_space_usage(self):
+        """Verify that it is possible to get exclusive and shared space of thin LVs"""
+
+        if not shutil.which("thin_ls"):
+            self.skipTest("thin_ls not available, skipping")
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thpoolcreate("testVG", "testPool", 512 * 1024**2, 4 * 1024**2, 512 * 1024, None, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thlvcreate("testVG", "testPool", "testThLV", 1024**3, None)
+        self.assertTrue(succ)
+
+        # 8 blocks shared with the snapshot and 4 more blocks written after it was taken
+        ret, _out, err = run_command("dd if=/dev/zero of=/dev/testVG/testThLV bs=1M count=4 oflag=direct conv=fsync")
+        self.assertEqual(ret, 0, err)
+
+        succ = BlockDev.lvm_thsnapshotcreate("testVG", "testThLV", "testThLV_bak", "testPool", None)
+        self.assertTrue(succ)
+
+        ret, _out, err = run_command("dd if=/dev/zero of=/dev/testVG/testThLV bs=1M count=2 seek=8 oflag=direct conv=fsync")
+        self.assertEqual(ret, 0, err)
+
+        usage = {u.lv_name: u for u in BlockDev.lvm_thpool_space_usage("testVG", "testPool")}
+        self.assertEqual(set(usage.keys()), {"testThLV", "testThLV_bak"})
+
+        self.assertEqual(usage["testThLV"].block_size, 512 * 1024)
+        self.assertEqual(usage["testThLV"].mapped_blocks, 12)
+        self.assertEqual(usage["testThLV"].exclusive_blocks, 4)
+        self.assertEqual(usage["testThLV"].shared_blocks, 8)
+
+        self.assertEqual(usage["testThLV_bak"].mapped_blocks, 8)
+        self.assertEqual(usage["testThLV_bak"].exclusive_blocks, 0)
+        self.assertEqual(usage["testThLV_bak"].shared_blocks, 8)
+        self.assertNotEqual(usage["testThLV"].thin_id, usage["testThLV_bak"].thin_id)
+
+        # the metadata snapshot must have been released, so it can be taken again
+        usage2 = BlockDev.lvm_thpool_space_usage("testVG", "testPool")
+        self.assertEqual(len(usage2), 2)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_thpool_space_usage("testVG", "nonexistingPool")
+
+@unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
+class LvmTestThinDelta(LvmPVVGLVthLVsnapshotTestCase):
+    def test_thin_delta(self):
+        """Verify that it is possible to get changed ranges between thin snapshots"""
+
+        if not shutil.which("thin_delta"):
+            self.skipTest("thin_delta not available, skipping")
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thpoolcreate("testVG", "testPool", 512 * 1024**2, 4 * 1024**2, 512 * 1024, None, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thlvcreate("testVG", "testPool", "testThLV", 1024**3, None)
+        self.assertTrue(succ)
+
+        ret, _out, err = run_command("dd if=/dev/zero of=/dev/testVG/testThLV bs=1M count=4 oflag=direct conv=fsync")
+        self.assertEqual(ret, 0, err)
+
+        succ = BlockDev.lvm_thsnapshotcreate("testVG", "testThLV", "testThLV_bak", "testPool", None)
+        self.assertTrue(succ)
+
+        # no changes yet
+        self.assertEqual(BlockDev.lvm_thin_delta("testVG", "testThLV_bak", "testThLV"), [])
+
+        # overwrite the first MiB (shared blocks get remapped) and write 2 MiB of new data
+        ret, _out, err = run_command("dd if=/dev/zero of=/dev/testVG/testThLV bs=1M count=1 oflag=direct conv=fsync")
+        self.assertEqual(ret, 0, err)
+        ret, _out, err = run_command("dd if=/dev/zero of=/dev/testVG/testThLV bs=1M count=2 seek=8 oflag=direct conv=fsync")
+        self.assertEqual(ret, 0, err)
+
+        delta = BlockDev.lvm_thin_delta("testVG", "testThLV_bak", "testThLV")
+        self.assertEqual([(r.offset, r.length, r.type) for r in delta],
+                         [(0, 1024**2, BlockDev.LVMThinDeltaType.DIFFERENT),
+                          (8 * 1024**2, 2 * 1024**2, BlockDev.LVMThinDeltaType.RIGHT_ONLY)])
+
+        # the other way around the new data is only in the first thin LV
+        delta = BlockDev.lvm_thin_delta("testVG", "testThLV", "testThLV_bak")
+        self.assertEqual(delta[-1].type, BlockDev.LVMThinDeltaType.LEFT_ONLY)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_thin_delta("testVG", "testThLV", "nonexistingLV")
+
 @unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
 class LvmPVVGLVcachePoolTestCase(LvmPVVGLVTestCase):
     def _clean_up(self):
@@ -1822,6 +1994,57 @@ class LvmPVVGLVWritecacheAttachDetachTestCase(LvmPVVGLVcachePoolTestCase):
         lvs = BlockDev.lvm_lvs("testVG")
         self.assertTrue(any(info.lv_name == "testCache" for info in lvs))
 
+@unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
+class LvmPVVGLVWritecacheSettingsTestCase(LvmPVVGLVcachePoolTestCase):
+    @tag_test(TestTags.SLOW)
+    def test_writecache_settings(self):
+        """Verify that it is possible to set and get settings of a writecached LV"""
+
+        lvm_version = self._get_lvm_version()
+        if lvm_version < Version("2.03.10"):
+            self.skipTest("LVM writecache support in DBus API not available")
+
+        lvm_segtypes = self._get_lvm_segtypes()
+        if "writecache" not in lvm_segtypes:
+            self.skipTest("LVM writecache support not available")
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testCache", 512 * 1024**2, None, [self.loop_dev2], None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV", 512 * 1024**2, None, [self.loop_dev], None)
+        self.assertTrue(succ)
+
+        settings = BlockDev.LVMWritecacheSettings(high_watermark=60, low_watermark=40)
+        succ = BlockDev.lvm_writecache_attach("testVG", "testLV", "testCache", BlockDev.lvm_writecache_settings_to_extra(settings))
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvactivate("testVG", "testLV", True, None)
+        self.assertTrue(succ)
+
+        settings = BlockDev.lvm_writecache_get_settings("testVG", "testLV")
+        self.assertEqual(settings.high_watermark, 60)
+        self.assertEqual(settings.low_watermark, 40)
+        self.assertEqual(settings.writeback_jobs, -1)
+
+        settings = BlockDev.LVMWritecacheSettings(writeback_jobs=16, autocommit_time=500)
+        succ = BlockDev.lvm_writecache_set_settings("testVG", "testLV", settings)
+        self.assertTrue(succ)
+
+        settings = BlockDev.lvm_writecache_get_settings("testVG", "testLV")
+        self.assertEqual(settings.high_watermark, 60)
+        self.assertEqual(settings.low_watermark, 40)
+        self.assertEqual(settings.writeback_jobs, 16)
+        self.assertEqual(settings.autocommit_time, 500)
+
 @unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
 class LvmPVVGWritecachedLVTestCase(LvmPVVGLVTestCase):
     @tag_test(TestTags.SLOW)
@@ -1883,6 +2106,64 @@ class LvmPVVGcachedLVstatsTestCase(LvmPVVGLVTestCase):
         self.assertEqual(stats.md_size, 8 * 1024**2)
         self.assertEqual(stats.mode, BlockDev.LVMCacheMode.WRITETHROUGH)
 
+@unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
+class LvmPVVGcachedLVsettingsTestCase(LvmPVVGLVTestCase):
+    @tag_test(TestTags.SLOW)
+    def test_cache_settings(self):
+        """Verify that it is possible to set and get settings of a cached LV"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_cache_create_pool("testVG", "testCache", 512 * 1024**2, 0, BlockDev.LVMCacheMode.WRITETHROUGH, 0, [self.loop_dev2])
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV", 512 * 1024**2, None, [self.loop_dev], None)
+        self.assertTrue(succ)
+
+        settings = BlockDev.LVMCacheSettings(policy="smq", migration_threshold=4096)
+        succ = BlockDev.lvm_cache_attach("testVG", "testLV", "testCache", BlockDev.lvm_cache_settings_to_extra(settings))
+        self.assertTrue(succ)
+
+        settings = BlockDev.lvm_cache_get_settings("testVG", "testLV")
+        self.assertEqual(settings.policy, "smq")
+        self.assertEqual(settings.migration_threshold, 4096)
+        self.assertGreater(settings.chunk_size, 0)
+
+        # change the migration threshold only in the active target
+        succ = BlockDev.lvm_cache_set_settings("testVG", "testLV", BlockDev.LVMCacheSettings(migration_threshold=8192), False)
+        self.assertTrue(succ)
+
+        settings = BlockDev.lvm_cache_get_settings("testVG", "testLV")
+        self.assertEqual(settings.migration_threshold, 8192)
+
+        # policy can be changed only persistently
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_cache_set_settings("testVG", "testLV", BlockDev.LVMCacheSettings(policy="cleaner"), False)
+
+        # chunk size cannot be changed at all
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_cache_set_settings("testVG", "testLV", BlockDev.LVMCacheSettings(chunk_size=settings.chunk_size * 2), True)
+
+        succ = BlockDev.lvm_cache_set_settings("testVG", "testLV", BlockDev.LVMCacheSettings(policy="cleaner"), True)
+        self.assertTrue(succ)
+
+        settings = BlockDev.lvm_cache_get_settings("testVG", "testLV")
+        self.assertEqual(settings.policy, "cleaner")
+
+        # not a cached LV
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV2", 16 * 1024**2, None, [self.loop_dev], None)
+        self.assertTrue(succ)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_cache_get_settings("testVG", "testLV2")
+
 class LvmPVVGcachedThpoolstatsTestCase(LvmPVVGLVTestCase):
     @tag_test(TestTags.SLOW)
     def test_cache_get_stats(self):
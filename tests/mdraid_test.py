@@ -418,6 +418,70 @@ class MDTestAddRemove(MDTestCase):
         self.assertEqual(md_info.active_devices, 2)
         self.assertEqual(md_info.spare_devices, 0)
 
+class MDTestReplace(MDTestCase):
+    @tag_test(TestTags.SLOW)
+    def test_replace(self):
+        """Verify that it is possible to hot-replace a member of an MD RAID"""
+
+        with wait_for_action("resync"):
+            succ = BlockDev.md_create("bd_test_md", "raid1",
+                                      [self.loop_dev, self.loop_dev2],
+                                      0, None, None)
+            self.assertTrue(succ)
+
+        # not a member of the array
+        with self.assertRaisesRegex(GLib.GError, "not a member"):
+            BlockDev.md_replace("bd_test_md", self.loop_dev3, None)
+
+        # limit the speed so that we can see the replacement in progress
+        succ = BlockDev.md_set_sync_speed_limits("bd_test_md", 1024, 1024)
+        self.assertTrue(succ)
+
+        progress = BlockDev.md_get_sync_progress("bd_test_md")
+        self.assertEqual(progress.action, "idle")
+        self.assertEqual(progress.total, 0)
+        self.assertEqual(progress.speed_min, 1024)
+        self.assertEqual(progress.speed_max, 1024)
+        self.assertTrue(progress.speed_limits_local)
+
+        with wait_for_action("recovery"):
+            succ = BlockDev.md_replace("bd_test_md", self.loop_dev2, self.loop_dev3)
+            self.assertTrue(succ)
+
+            # the array is never degraded during the replacement
+            md_info = BlockDev.md_detail("bd_test_md")
+            self.assertEqual(md_info.active_devices, 2)
+
+            progress = BlockDev.md_get_sync_progress("bd_test_md")
+            self.assertEqual(progress.action, "recover")
+            self.assertGreater(progress.total, 0)
+            self.assertLessEqual(progress.completed, progress.total)
+
+            # back to the defaults to finish quickly
+            succ = BlockDev.md_set_sync_speed_limits("bd_test_md", 0, 0)
+            self.assertTrue(succ)
+
+        progress = BlockDev.md_get_sync_progress("bd_test_md")
+        self.assertFalse(progress.speed_limits_local)
+
+        # the replaced device is marked as failed and can be removed now
+        md_info = BlockDev.md_detail("bd_test_md")
+        self.assertEqual(md_info.active_devices, 2)
+        self.assertEqual(md_info.failed_devices, 1)
+
+        succ = BlockDev.md_remove("bd_test_md", self.loop_dev2, False, None)
+        self.assertTrue(succ)
+
+        md_info = BlockDev.md_detail("bd_test_md")
+        self.assertEqual(md_info.active_devices, 2)
+        self.assertEqual(md_info.failed_devices, 0)
+
+        with self.assertRaisesRegex(GLib.GError, "must be at least"):
+            BlockDev.md_set_sync_speed_limits("bd_test_md", 1, 0)
+
+        with self.assertRaisesRegex(GLib.GError, "cannot be bigger"):
+            BlockDev.md_set_sync_speed_limits("bd_test_md", 2048, 1024)
+
 class MDTestExamineDetail(MDTestCase):
     # sleeps to let MD RAID sync things
     @tag_test(TestTags.SLOW)
@@ -569,6 +633,77 @@ class MDTestSetBitmapLocation(MDTestCase):
         self.assertEqual(loc, "none")
 
 
+class MDTestConsistencyBitmapTuning(MDTestCase):
+    @tag_test(TestTags.SLOW)
+    def test_consistency_bitmap_tuning(self):
+        """Verify that it is possible to tune consistency policy, bitmap and member flags"""
+
+        with wait_for_action("resync"):
+            succ = BlockDev.md_create("bd_test_md", "raid1",
+                                      [self.loop_dev, self.loop_dev2],
+                                      0, None, "none")
+            self.assertTrue(succ)
+
+        policy = BlockDev.md_get_consistency_policy("bd_test_md")
+        self.assertEqual(policy, BlockDev.MDConsistencyPolicy.RESYNC)
+
+        # journal can only be added when creating the array
+        with self.assertRaises(GLib.GError):
+            BlockDev.md_set_consistency_policy("bd_test_md", BlockDev.MDConsistencyPolicy.JOURNAL)
+
+        succ = BlockDev.md_set_consistency_policy("bd_test_md", BlockDev.MDConsistencyPolicy.BITMAP)
+        self.assertTrue(succ)
+        policy = BlockDev.md_get_consistency_policy("bd_test_md")
+        self.assertEqual(policy, BlockDev.MDConsistencyPolicy.BITMAP)
+
+        info = BlockDev.md_get_bitmap_info("bd_test_md")
+        self.assertNotEqual(info.location, "none")
+        self.assertEqual(info.metadata, "internal")
+
+        with self.assertRaisesRegex(GLib.GError, "power of two"):
+            BlockDev.md_set_bitmap_chunk_size("bd_test_md", 3 * 1024**2)
+
+        succ = BlockDev.md_set_bitmap_chunk_size("bd_test_md", 2 * 1024**2)
+        self.assertTrue(succ)
+        info = BlockDev.md_get_bitmap_info("bd_test_md")
+        self.assertEqual(info.chunk_size, 2 * 1024**2)
+
+        # member flags
+        flags = BlockDev.md_get_member_flags("bd_test_md", self.loop_dev2)
+        self.assertEqual(flags, 0)
+
+        succ = BlockDev.md_set_member_flags("bd_test_md", self.loop_dev2,
+                                            BlockDev.MDMemberFlag.WRITEMOSTLY | BlockDev.MDMemberFlag.FAILFAST)
+        self.assertTrue(succ)
+        flags = BlockDev.md_get_member_flags("bd_test_md", self.loop_dev2)
+        self.assertEqual(flags, BlockDev.MDMemberFlag.WRITEMOSTLY | BlockDev.MDMemberFlag.FAILFAST)
+
+        # write-behind needs a write-mostly member
+        succ = BlockDev.md_set_write_behind("bd_test_md", 256)
+        self.assertTrue(succ)
+        info = BlockDev.md_get_bitmap_info("bd_test_md")
+        self.assertEqual(info.backlog, 256)
+
+        succ = BlockDev.md_set_write_behind("bd_test_md", 0)
+        self.assertTrue(succ)
+
+        succ = BlockDev.md_set_member_flags("bd_test_md", self.loop_dev2, BlockDev.MDMemberFlag.FAILFAST)
+        self.assertTrue(succ)
+        flags = BlockDev.md_get_member_flags("bd_test_md", self.loop_dev2)
+        self.assertEqual(flags, BlockDev.MDMemberFlag.FAILFAST)
+
+        with self.assertRaisesRegex(GLib.GError, "not a member"):
+            BlockDev.md_get_member_flags("bd_test_md", self.loop_dev3)
+
+        # and back to resync
+        succ = BlockDev.md_set_consistency_policy("bd_test_md", BlockDev.MDConsistencyPolicy.RESYNC)
+        self.assertTrue(succ)
+        policy = BlockDev.md_get_consistency_policy("bd_test_md")
+        self.assertEqual(policy, BlockDev.MDConsistencyPolicy.RESYNC)
+        info = BlockDev.md_get_bitmap_info("bd_test_md")
+        self.assertEqual(info.location, "none")
+
+
 class MDTestRequestSyncAction(MDTestCase):
     @tag_test(TestTags.SLOW)
     def test_request_sync_action(self):
@@ -307,6 +307,62 @@ class NVMeTestCase(NVMeTest):
                 BlockDev.nvme_sanitize(self.nvme_ns_dev, i, False, 0, 0, False)
 
 
+    @tag_test(TestTags.CORE)
+    def test_features(self):
+        """Test retrieving and changing controller features"""
+
+        with self.assertRaisesRegex(GLib.GError, r".*Failed to open device .*': No such file or directory"):
+            BlockDev.nvme_get_volatile_write_cache("/dev/nonexistent", BlockDev.NVMEFeatureSelect.CURRENT)
+        with self.assertRaisesRegex(GLib.GError, r"Feature capabilities can only be queried through"):
+            BlockDev.nvme_get_volatile_write_cache(self.nvme_dev, BlockDev.NVMEFeatureSelect.SUPPORTED)
+
+        for dev in [self.nvme_dev, self.nvme_ns_dev]:
+            # nvme target loop devices always report volatile write cache enabled
+            ret, enabled = BlockDev.nvme_get_volatile_write_cache(dev, BlockDev.NVMEFeatureSelect.CURRENT)
+            self.assertTrue(ret)
+            self.assertTrue(enabled)
+
+            ret, result = BlockDev.nvme_get_feature(dev, BlockDev.NVMEFeatureId.VOLATILE_WC,
+                                                    BlockDev.NVMEFeatureSelect.CURRENT, 0)
+            self.assertTrue(ret)
+            self.assertEqual(result, 1)
+
+            ret, num_sq, num_cq = BlockDev.nvme_get_num_queues(dev, BlockDev.NVMEFeatureSelect.CURRENT)
+            self.assertTrue(ret)
+            self.assertGreaterEqual(num_sq, 1)
+            self.assertGreaterEqual(num_cq, 1)
+
+            # the target always returns the number of queues it has allocated
+            ret, allocated_sq, allocated_cq = BlockDev.nvme_set_num_queues(dev, 1, 1)
+            self.assertTrue(ret)
+            self.assertEqual(allocated_sq, num_sq)
+            self.assertEqual(allocated_cq, num_cq)
+
+            # the target implements just a small subset of the features
+            message = r"NVMe Get Features command error: Invalid Field in Command: A reserved coded value or an unsupported value in a defined field"
+            with self.assertRaisesRegex(GLib.GError, message):
+                BlockDev.nvme_get_arbitration(dev, BlockDev.NVMEFeatureSelect.CURRENT)
+            with self.assertRaisesRegex(GLib.GError, message):
+                BlockDev.nvme_get_power_state(dev, BlockDev.NVMEFeatureSelect.CURRENT)
+            with self.assertRaisesRegex(GLib.GError, message):
+                BlockDev.nvme_get_irq_coalescing(dev, BlockDev.NVMEFeatureSelect.CURRENT)
+            with self.assertRaisesRegex(GLib.GError, message):
+                BlockDev.nvme_get_apst(dev, BlockDev.NVMEFeatureSelect.CURRENT)
+            with self.assertRaisesRegex(GLib.GError, message):
+                BlockDev.nvme_get_host_mem_buffer(dev, BlockDev.NVMEFeatureSelect.CURRENT)
+
+            message = r"NVMe Set Features command error: Invalid Field in Command: A reserved coded value or an unsupported value in a defined field"
+            with self.assertRaisesRegex(GLib.GError, message):
+                BlockDev.nvme_set_volatile_write_cache(dev, False, False)
+            with self.assertRaisesRegex(GLib.GError, r"Error retrieving the current APST table"):
+                BlockDev.nvme_set_apst(dev, False, None, False)
+
+        with self.assertRaisesRegex(GLib.GError, r"Invalid power state"):
+            BlockDev.nvme_set_power_state(self.nvme_dev, 32, 0, False)
+        with self.assertRaisesRegex(GLib.GError, r"Invalid number of queues specified"):
+            BlockDev.nvme_set_num_queues(self.nvme_dev, 0, 1)
+
+
 class NVMeFabricsTestCase(NVMeTest):
     SUBNQN = 'libblockdev_nvme'
     DISCOVERY_NQN = 'nqn.2014-08.org.nvmexpress.discovery'
@@ -316,11 +372,11 @@ class NVMeFabricsTestCase(NVMeTest):
         self.hostnqn = get_nvme_hostnqn()
         self.have_stable_nqn = os.path.exists('/sys/class/dmi/id/product_uuid')
 
-    def _setup_target(self, num_devices):
+    def _setup_target(self, num_devices, ana_states=None):
         self.addCleanup(self._clean_up)
         for i in range(num_devices):
             self.dev_files += [create_sparse_tempfile("nvmeof_test%d" % i, 1024**3, dir=self.TMPDIR)]
-        setup_nvme_target(self.dev_files, self.SUBNQN)
+        setup_nvme_target(self.dev_files, self.SUBNQN, ana_states)
         for d in self.dev_files:
             os.unlink(d)
 
@@ -366,7 +422,7 @@ class NVMeFabricsTestCase(NVMeTest):
         self._setup_target(1)
 
         # make a connection
-        ret = BlockDev.nvme_connect(self.SUBNQN, 'loop', None, None, None, None, None, None)
+        ret = BlockDev.nvme_connect(self.SUBNQN, 'loop', None, None, None, None, self.hostnqn, None)
         self.addCleanup(self._nvme_disconnect, self.SUBNQN, ignore_errors=True)
         self.assertTrue(ret)
 
@@ -488,6 +544,68 @@ class NVMeFabricsTestCase(NVMeTest):
         self.assertEqual(len(namespaces), 0)
 
 
+    @tag_test(TestTags.CORE)
+    def test_multipath_ana(self):
+        """Test ANA log, namespace paths and I/O policy with multiple ports"""
+
+        try:
+            multipath = read_file("/sys/module/nvme_core/parameters/multipath").strip()
+        except OSError:
+            multipath = "N"
+        if multipath != "Y":
+            self.skipTest("NVMe native multipath is disabled")
+
+        with self.assertRaisesRegex(GLib.GError, r"No namespaces matching the /dev/nonexistent device name found."):
+            BlockDev.nvme_get_namespace_paths("/dev/nonexistent")
+        with self.assertRaisesRegex(GLib.GError, r"No subsystems matching '.*' NQN found."):
+            BlockDev.nvme_get_iopolicy(self.SUBNQN)
+        with self.assertRaisesRegex(GLib.GError, r"No subsystems matching '.*' NQN found."):
+            BlockDev.nvme_set_iopolicy(self.SUBNQN, BlockDev.NVMEIOPolicy.ROUND_ROBIN)
+
+        # two loop ports with the default ANA group in different states
+        self._setup_target(1, ["optimized", "non-optimized"])
+
+        for traddr in ["1", "2"]:
+            ret = BlockDev.nvme_connect(self.SUBNQN, 'loop', traddr, None, None, None, None, None)
+            self.assertTrue(ret)
+        self.addCleanup(self._nvme_disconnect, self.SUBNQN, ignore_errors=True)
+
+        ctrls = find_nvme_ctrl_devs_for_subnqn(self.SUBNQN)
+        self.assertEqual(len(ctrls), 2)
+        namespaces = find_nvme_ns_devs_for_subnqn(self.SUBNQN)
+        self.assertEqual(len(namespaces), 1)
+
+        paths = BlockDev.nvme_get_namespace_paths(namespaces[0])
+        self.assertEqual(len(paths), 2)
+        self.assertEqual(sorted(p.ana_state for p in paths),
+                         [BlockDev.NVMEANAState.OPTIMIZED, BlockDev.NVMEANAState.NON_OPTIMIZED])
+        for path in paths:
+            self.assertTrue(re.match(r'nvme[0-9]+c[0-9]+n1', path.name))
+            self.assertIn("/dev/" + path.ctrl_name, ctrls)
+            self.assertEqual(path.transport, "loop")
+            self.assertEqual(path.ctrl_state, "live")
+            self.assertEqual(path.ana_grpid, 1)
+
+            # the ANA log reports the group state as seen through the respective controller
+            log = BlockDev.nvme_get_ana_log("/dev/" + path.ctrl_name)
+            self.assertGreater(len(log.groups), 0)
+            groups = [g for g in log.groups if g.grpid == 1]
+            self.assertEqual(len(groups), 1)
+            self.assertEqual(groups[0].state, path.ana_state)
+            self.assertEqual(groups[0].nsids, [1])
+
+        policy = BlockDev.nvme_get_iopolicy(self.SUBNQN)
+        self.assertNotEqual(policy, BlockDev.NVMEIOPolicy.UNKNOWN)
+        self.addCleanup(BlockDev.nvme_set_iopolicy, self.SUBNQN, policy)
+
+        BlockDev.nvme_set_iopolicy(self.SUBNQN, BlockDev.NVMEIOPolicy.ROUND_ROBIN)
+        self.assertEqual(BlockDev.nvme_get_iopolicy(self.SUBNQN), BlockDev.NVMEIOPolicy.ROUND_ROBIN)
+        BlockDev.nvme_set_iopolicy(self.SUBNQN, BlockDev.NVMEIOPolicy.NUMA)
+        self.assertEqual(BlockDev.nvme_get_iopolicy(self.SUBNQN), BlockDev.NVMEIOPolicy.NUMA)
+
+        with self.assertRaisesRegex(GLib.GError, r"Invalid I/O policy specified"):
+            BlockDev.nvme_set_iopolicy(self.SUBNQN, BlockDev.NVMEIOPolicy.UNKNOWN)
+
     @tag_test(TestTags.CORE)
     def test_host_nqn(self):
         """Test Host NQN/ID manipulation and a simple connect"""
@@ -533,7 +651,7 @@ class NVMeFabricsTestCase(NVMeTest):
 
         # connection without hostnqn set
         self._setup_target(1)
-        ret = BlockDev.nvme_connect(self.SUBNQN, 'loop', None, None, None, None, None, None)
+        ret = BlockDev.nvme_connect(self.SUBNQN, 'loop', None, None, None, None, self.hostnqn, None)
         self.addCleanup(self._nvme_disconnect, self.SUBNQN, ignore_errors=True)
         self.assertTrue(ret)
         ctrls = find_nvme_ctrl_devs_for_subnqn(self.SUBNQN)
@@ -599,6 +717,60 @@ class NVMeFabricsTestCase(NVMeTest):
         self._safe_unlink(HOSTID_PATH)
 
 
+    @tag_test(TestTags.CORE)
+    def test_discover(self):
+        """Test discovery and connecting all discovered subsystems"""
+
+        # nothing to discover
+        with self.assertRaisesRegex(GLib.GError, r"Error connecting the discovery controller: "):
+            BlockDev.nvme_discover(None, False, 'loop', None, None, None, None, None, None)
+        with self.assertRaisesRegex(GLib.GError, r"No controllers matching the /dev/nvme.*xx device name found."):
+            BlockDev.nvme_discover("/dev/nvme1234xx", False, None, None, None, None, None, None, None)
+
+        self._setup_target(1)
+
+        # one-shot discovery, the discovery controller is disconnected afterwards
+        log = BlockDev.nvme_discover(None, False, 'loop', None, None, None, None, None, None)
+        self.assertIsNone(log.discovery_ctrl)
+        self.assertEqual(len(find_nvme_ctrl_devs_for_subnqn(self.DISCOVERY_NQN)), 0)
+        entries = [e for e in log.entries if e.subsysnqn == self.SUBNQN]
+        self.assertEqual(len(entries), 1)
+        self.assertEqual(entries[0].transport_type, 'loop')
+        self.assertEqual(entries[0].subsys_type, BlockDev.NVMEDiscoverySubsysType.NVME)
+        self.assertEqual(entries[0].port_id, 1)
+
+        # persistent discovery controller
+        log = BlockDev.nvme_discover(None, True, 'loop', None, None, None, None, None, None)
+        self.addCleanup(self._nvme_disconnect, self.DISCOVERY_NQN, ignore_errors=True)
+        self.assertIsNotNone(log.discovery_ctrl)
+        ctrls = find_nvme_ctrl_devs_for_subnqn(self.DISCOVERY_NQN)
+        self.assertEqual(ctrls, ["/dev/" + log.discovery_ctrl])
+
+        # the cached log is returned as long as the generation counter stays the same
+        log2 = BlockDev.nvme_discover(ctrls[0], False, None, None, None, None, None, None, None)
+        self.assertEqual(log2.discovery_ctrl, log.discovery_ctrl)
+        self.assertEqual(log2.generation, log.generation)
+        self.assertEqual([e.subsysnqn for e in log2.entries], [e.subsysnqn for e in log.entries])
+
+        # not a discovery controller
+        ret = BlockDev.nvme_connect(self.SUBNQN, 'loop', None, None, None, None, self.hostnqn, None)
+        self.addCleanup(self._nvme_disconnect, self.SUBNQN, ignore_errors=True)
+        self.assertTrue(ret)
+        subsys_ctrls = find_nvme_ctrl_devs_for_subnqn(self.SUBNQN)
+        self.assertEqual(len(subsys_ctrls), 1)
+        with self.assertRaisesRegex(GLib.GError, r"is not a discovery controller"):
+            BlockDev.nvme_discover(subsys_ctrls[0], False, None, None, None, None, None, None, None)
+
+        # connect-all skips subsystem ports already connected
+        BlockDev.nvme_connect_all(log.entries, None, None, self.hostnqn, None)
+        self.assertEqual(find_nvme_ctrl_devs_for_subnqn(self.SUBNQN), subsys_ctrls)
+
+        BlockDev.nvme_disconnect(self.SUBNQN)
+        self.assertEqual(len(find_nvme_ctrl_devs_for_subnqn(self.SUBNQN)), 0)
+        BlockDev.nvme_connect_all(log.entries, None, None, self.hostnqn, None)
+        self.assertEqual(len(find_nvme_ctrl_devs_for_subnqn(self.SUBNQN)), 1)
+        self.assertEqual(len(find_nvme_ctrl_devs_for_subnqn(self.DISCOVERY_NQN)), 1)
+
     @tag_test(TestTags.CORE)
     def test_persistent_dc(self):
         """Test connecting a persistent Discovery Controller"""
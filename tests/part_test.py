@@ -1106,6 +1106,69 @@ class PartCreateResizePartCase4k(PartCreateResizePartCase):
     block_size = 4096
 
 
+class PartGrowToDiskCase(PartTestCase):
+    def setUp(self):
+        super(PartGrowToDiskCase, self).setUp()
+
+        # LIO fileio backstores have a fixed size, we need a loop device for this
+        self.grow_file = create_sparse_tempfile("part_grow_test", 100 * 1024**2)
+        self.addCleanup(os.unlink, self.grow_file)
+        ret, out, err = run_command("losetup --partscan --find --show %s" % self.grow_file)
+        if ret != 0:
+            raise RuntimeError("Failed to setup loop device for testing: %s" % err)
+        self.grow_dev = out
+        self.addCleanup(run_command, "losetup -d %s" % self.grow_dev)
+
+    @tag_test(TestTags.CORE)
+    def test_grow_to_disk(self):
+        """Verify that it is possible to grow a partition to the end of an expanded disk"""
+
+        succ = BlockDev.part_create_table (self.grow_dev, BlockDev.PartTableType.GPT, True)
+        self.assertTrue(succ)
+
+        ps = BlockDev.part_create_part (self.grow_dev, BlockDev.PartTypeReq.NORMAL, 2 * 1024**2, 0, BlockDev.PartAlign.OPTIMAL)
+        self.assertTrue(ps)
+        initial_start = ps.start
+        initial_size = ps.size
+
+        # nothing to grow yet
+        succ = BlockDev.part_grow_to_disk (self.grow_dev, ps.path, BlockDev.PartAlign.OPTIMAL)
+        self.assertTrue(succ)
+        ps = BlockDev.part_get_part_spec (self.grow_dev, ps.path)
+        self.assertEqual(ps.size, initial_size)
+
+        # grow the disk and keep the partition in use
+        os.truncate(self.grow_file, 200 * 1024**2)
+        ret, _out, err = run_command("losetup -c %s" % self.grow_dev)
+        self.assertEqual(ret, 0, msg="Failed to refresh loop device capacity: %s" % err)
+
+        fd = os.open(ps.path, os.O_RDONLY | os.O_EXCL)
+        try:
+            succ = BlockDev.part_grow_to_disk (self.grow_dev, ps.path, BlockDev.PartAlign.OPTIMAL)
+            self.assertTrue(succ)
+
+            # the kernel knows about the new size without re-reading the table
+            part_size = os.lseek(fd, 0, os.SEEK_END)
+        finally:
+            os.close(fd)
+
+        ps = BlockDev.part_get_part_spec (self.grow_dev, ps.path)
+        self.assertEqual(ps.start, initial_start)
+        self.assertGreater(ps.size, initial_size + 90 * 1024**2)
+        self.assertEqual(part_size, ps.size)
+
+        # backup GPT header was moved to the end of the disk
+        ds = BlockDev.part_get_disk_spec (self.grow_dev)
+        self.assertEqual(ds.size, 200 * 1024**2)
+        self.assertGreater(ps.start + ps.size, 199 * 1024**2)
+
+        # the partition is already at its maximum size
+        succ = BlockDev.part_grow_to_disk (self.grow_dev, ps.path, BlockDev.PartAlign.OPTIMAL)
+        self.assertTrue(succ)
+        ps2 = BlockDev.part_get_part_spec (self.grow_dev, ps.path)
+        self.assertEqual(ps2.size, ps.size)
+
+
 class PartCreateDeletePartCase(PartTestCase):
     @tag_test(TestTags.CORE)
     def test_create_delete_part_simple(self):
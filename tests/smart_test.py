@@ -190,6 +190,40 @@ class SMARTTest(unittest.TestCase):
             with self.assertRaisesRegex(GLib.GError, msg):
                 BlockDev.smart_device_self_test(self.scsi_debug_dev, t)
 
+    @tag_test(TestTags.CORE)
+    def test_smart_selftest_schedule(self):
+        """Test scheduling SMART self-tests over multiple devices"""
+
+        # non-existing device
+        msg = r"Error opening device /dev/.*: No such file or directory"
+        with self.assertRaisesRegex(GLib.GError, msg):
+            BlockDev.smart_device_self_test_status("/dev/nonexistent")
+
+        with self.assertRaisesRegex(GLib.GError, r"Only short, long and conveyance self-tests can be scheduled"):
+            BlockDev.smart_schedule_self_tests(["/dev/nonexistent"], BlockDev.SmartSelfTestOp.ABORT,
+                                               BlockDev.SmartSelfTestGrouping.NONE, 1, 1, None, None)
+
+        # loop devices, self-tests cannot be started there
+        self._setup_loop()
+        self.addCleanup(self._clean_loop)
+
+        reports = []
+        def progress_cb(progress, user_data):
+            reports.append((progress.device, progress.state, progress.message))
+
+        devices = ["/dev/nonexistent", self.loop_dev]
+        with self.assertRaisesRegex(GLib.GError, r"2 of 2 SMART self-tests did not pass"):
+            BlockDev.smart_schedule_self_tests(devices, BlockDev.SmartSelfTestOp.SHORT,
+                                               BlockDev.SmartSelfTestGrouping.CONTROLLER, 1, 1,
+                                               progress_cb, None)
+
+        for dev in devices:
+            states = [r[1] for r in reports if r[0] == dev]
+            self.assertEqual(states, [BlockDev.SmartSelfTestState.PENDING, BlockDev.SmartSelfTestState.ERROR])
+        messages = [r[2] for r in reports if r[1] == BlockDev.SmartSelfTestState.ERROR]
+        self.assertRegex(messages[0], r"Error opening device /dev/nonexistent")
+        self.assertRegex(messages[1], r"Error triggering device self-test: Operation not supported")
+
     @tag_test(TestTags.CORE)
     def test_scsi_info(self):
         """Test SMART SCSI info on LIO, loop and scsi_debug devices"""
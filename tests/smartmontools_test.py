@@ -222,6 +222,36 @@ class SmartmontoolsTest(unittest.TestCase):
             with self.assertRaisesRegex(GLib.GError, msg):
                 BlockDev.smart_ata_get_info("05_empty")
 
+    @tag_test(TestTags.CORE)
+    def test_self_test_status_dumps(self):
+        """Test SMART self-test status on supplied JSON dumps via fake smartctl"""
+
+        with fake_utils("tests/fake_utils/smartctl"):
+            for d in self.ATA_JSON_DUMPS:
+                ret, status, remaining = BlockDev.smart_device_self_test_status(d)
+                self.assertTrue(ret)
+                self.assertEqual(status, BlockDev.SmartATASelfTestStatus.COMPLETED_NO_ERROR)
+                self.assertEqual(remaining, 0)
+
+            ret, status, remaining = BlockDev.smart_device_self_test_status("06_self_test_in_progress")
+            self.assertTrue(ret)
+            self.assertEqual(status, BlockDev.SmartATASelfTestStatus.IN_PROGRESS)
+            self.assertEqual(remaining, 30)
+
+            ret, status, remaining = BlockDev.smart_device_self_test_status("07_self_test_read_failure")
+            self.assertTrue(ret)
+            self.assertEqual(status, BlockDev.SmartATASelfTestStatus.ERROR_READ)
+            self.assertEqual(remaining, 0)
+
+            # SCSI devices don't report the ATA self-test execution status
+            msg = r"Error getting SMART self-test status: Self-test execution status not reported by the device"
+            with self.assertRaisesRegex(GLib.GError, msg):
+                BlockDev.smart_device_self_test_status(self.SCSI_JSON_DUMPS[0])
+
+            msg = r"Error getting SMART self-test status: Command line did not parse."
+            with self.assertRaisesRegex(GLib.GError, msg):
+                BlockDev.smart_device_self_test_status("02_exit_err")
+
     @tag_test(TestTags.CORE)
     def test_smart_enable_disable(self):
         """Test turning SMART functionality on/off over LIO, loop and scsi_debug devices"""
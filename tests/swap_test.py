@@ -1,6 +1,7 @@
 import unittest
 import os
 import resource
+import tempfile
 import overrides_hack
 
 from utils import create_sparse_tempfile, create_lio_device, delete_lio_device, fake_utils, fake_path, run_command, run, TestTags, tag_test, required_plugins
@@ -195,6 +196,78 @@ class SwapTestCase(SwapTest):
         self.assertFalse(on)
 
 
+class SwapZramTestCase(SwapTest):
+    def setUp(self):
+        if not BlockDev.utils_have_kernel_module("zram"):
+            self.skipTest("zram kernel module not available")
+
+        self.zram_dev = None
+        self.addCleanup(self._clean_up)
+
+    def _clean_up(self):
+        if self.zram_dev:
+            try:
+                BlockDev.swap_zram_destroy(self.zram_dev)
+            except:
+                pass
+
+    @tag_test(TestTags.CORE)
+    def test_zram_swap(self):
+        """Verify that it is possible to create zram swap and get its stats"""
+
+        succ = BlockDev.swap_is_tech_avail(BlockDev.SwapTech.ZRAM, BlockDev.SwapTechMode.CREATE)
+        self.assertTrue(succ)
+
+        self.zram_dev = BlockDev.swap_zram_create(50 * 1024**2, mem_limit=20 * 1024**2, priority=10)
+        self.assertTrue(self.zram_dev.startswith("/dev/zram"))
+        self.assertTrue(BlockDev.swap_swapstatus(self.zram_dev))
+
+        with open("/proc/swaps") as f:
+            swaps = f.read()
+        line = next(l for l in swaps.splitlines() if l.startswith(self.zram_dev))
+        self.assertEqual(line.split()[-1], "10")
+
+        stats = BlockDev.swap_zram_stats(self.zram_dev)
+        self.assertEqual(stats.device, self.zram_dev)
+        self.assertEqual(stats.disksize, 50 * 1024**2)
+        self.assertEqual(stats.mem_limit, 20 * 1024**2)
+        self.assertTrue(stats.comp_algorithm)
+        self.assertNotIn("[", stats.comp_algorithm)
+        self.assertIsNone(stats.backing_dev)
+
+        succ = BlockDev.swap_zram_destroy(self.zram_dev)
+        self.assertTrue(succ)
+        self.assertFalse(os.path.exists(self.zram_dev))
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.swap_zram_stats(self.zram_dev)
+        self.zram_dev = None
+
+    @tag_test(TestTags.CORE)
+    def test_zram_scratch(self):
+        """Verify that it is possible to create zram device without swap on it"""
+
+        self.zram_dev = BlockDev.swap_zram_create(50 * 1024**2, activate=False)
+        self.assertFalse(BlockDev.swap_swapstatus(self.zram_dev))
+
+        stats = BlockDev.swap_zram_stats(self.zram_dev)
+        self.assertEqual(stats.disksize, 50 * 1024**2)
+        self.assertEqual(stats.orig_data_size, 0)
+        self.assertEqual(stats.compression_ratio, 0)
+
+        # write some well compressible data
+        with open(self.zram_dev, "wb") as f:
+            f.write(b"libblockdev zram test " * (512 * 1024))
+            os.fsync(f.fileno())
+
+        stats = BlockDev.swap_zram_stats(self.zram_dev)
+        self.assertGreater(stats.orig_data_size, 0)
+        self.assertGreater(stats.compression_ratio, 1)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.swap_zram_destroy("/dev/sda")
+
+
 class SwapDepsTest(SwapTest):
     @tag_test(TestTags.NOSTORAGE)
     def test_missing_dependencies(self):
@@ -221,6 +294,56 @@ class SwapDepsTest(SwapTest):
                 # error before any other checks or actions
                 BlockDev.swap_mkswap("/dev/device", "LABEL", None)
 
+    @tag_test(TestTags.NOSTORAGE)
+    def test_missing_dependencies_cache(self):
+        """Verify that failed dependency checks are cached and invalidated"""
+
+        mkswap = GLib.find_program_in_path("mkswap")
+        if not mkswap:
+            self.skipTest("skipping dependency cache test: mkswap not available")
+
+        BlockDev.reinit(self.requested_plugins, True, None)
+
+        path = tempfile.mkdtemp(prefix="libblockdev-fake-path", dir="/tmp")
+        self.addCleanup(os.rmdir, path)
+        with fake_path(path=path, all_but="mkswap"):
+            # the failure is reported again and again (cached or not)
+            for _i in range(3):
+                with self.assertRaisesRegex(GLib.GError, "The 'mkswap' utility is not available"):
+                    BlockDev.swap_is_tech_avail(BlockDev.SwapTech.SWAP, BlockDev.SwapTechMode.CREATE)
+
+            # mkswap appearing in PATH invalidates the cached failure
+            os.symlink(mkswap, os.path.join(path, "mkswap"))
+            try:
+                succ = BlockDev.swap_is_tech_avail(BlockDev.SwapTech.SWAP, BlockDev.SwapTechMode.CREATE)
+                self.assertTrue(succ)
+            finally:
+                os.unlink(os.path.join(path, "mkswap"))
+
+        # mkswap in PATH is a dangling symlink, making its target appear changes
+        # nothing in the watched directories so only an explicit refresh helps
+        target_dir = tempfile.mkdtemp(prefix="libblockdev-fake-target", dir="/tmp")
+        self.addCleanup(os.rmdir, target_dir)
+        os.symlink(os.path.join(target_dir, "mkswap"), os.path.join(path, "mkswap"))
+        self.addCleanup(os.unlink, os.path.join(path, "mkswap"))
+
+        BlockDev.reinit(self.requested_plugins, True, None)
+        with fake_path(path=path, all_but="mkswap"):
+            with self.assertRaisesRegex(GLib.GError, "The 'mkswap' utility is not available"):
+                BlockDev.swap_is_tech_avail(BlockDev.SwapTech.SWAP, BlockDev.SwapTechMode.CREATE)
+
+            os.symlink(mkswap, os.path.join(target_dir, "mkswap"))
+            try:
+                # the failure is still cached
+                with self.assertRaisesRegex(GLib.GError, "The 'mkswap' utility is not available"):
+                    BlockDev.swap_is_tech_avail(BlockDev.SwapTech.SWAP, BlockDev.SwapTechMode.CREATE)
+
+                BlockDev.utils_refresh_deps_cache()
+                succ = BlockDev.swap_is_tech_avail(BlockDev.SwapTech.SWAP, BlockDev.SwapTechMode.CREATE)
+                self.assertTrue(succ)
+            finally:
+                os.unlink(os.path.join(target_dir, "mkswap"))
+
 
 class SwapTechAvailable(SwapTest):
 
@@ -343,13 +343,16 @@ def get_nvme_hostnqn():
     return hostnqn.strip()
 
 
-def setup_nvme_target(dev_paths, subnqn):
+def setup_nvme_target(dev_paths, subnqn, ana_states=None):
     """
     Sets up a new NVMe target loop device (using nvmetcli) on top of the
     :param:`dev_paths` backing block devices.
 
     :param set dev_paths: set of backing block device paths
     :param str subnqn: Subsystem NQN
+    :param list ana_states: optional list of ANA states (e.g. "optimized"), one loop port
+                            (with ``traddr`` set to its port ID) is created for each state
+                            with the default ANA group in the specified state
     """
 
     # modprobe required nvme target modules
@@ -372,23 +375,53 @@ def setup_nvme_target(dev_paths, subnqn):
         }}
         """.format(nguid=uuid.uuid4(), path=dev_path, nsid=i) for i, dev_path in enumerate(dev_paths, start=1)])
 
-        json = """
-{
-  "ports": [
-    {
-      "addr": {
+        if not ana_states:
+            ports = """
+    {{
+      "addr": {{
         "adrfam": "",
         "traddr": "",
         "treq": "not specified",
         "trsvcid": "",
         "trtype": "loop"
-      },
+      }},
       "portid": 1,
       "referrals": [],
       "subsystems": [
-        "%s"
+        "{subnqn}"
       ]
-    }
+    }}
+""".format(subnqn=subnqn)
+        else:
+            ports = ",".join(["""
+    {{
+      "addr": {{
+        "adrfam": "",
+        "traddr": "{portid}",
+        "treq": "not specified",
+        "trsvcid": "",
+        "trtype": "loop"
+      }},
+      "ana_groups": [
+        {{
+          "ana": {{
+            "state": "{state}"
+          }},
+          "grpid": 1
+        }}
+      ],
+      "portid": {portid},
+      "referrals": [],
+      "subsystems": [
+        "{subnqn}"
+      ]
+    }}
+""".format(subnqn=subnqn, state=state, portid=i) for i, state in enumerate(ana_states, start=1)])
+
+        json = """
+{
+  "ports": [
+%s
   ],
   "subsystems": [
     {
@@ -403,7 +436,7 @@ def setup_nvme_target(dev_paths, subnqn):
   ]
 }
 """
-        tmp.write(json % (subnqn, namespaces, subnqn))
+        tmp.write(json % (ports, namespaces, subnqn))
 
     # export the loop device on the target
     ret, out, err = run_command("nvmetcli restore %s" % tcli_json_file)
@@ -1,13 +1,18 @@
+import asyncio
 import unittest
 import re
 import os
+import shutil
+import time
+import threading
 import overrides_hack
 from utils import fake_utils, create_sparse_tempfile, create_lio_device, delete_lio_device, run_command, TestTags, tag_test, read_file
 
 import gi
 gi.require_version('GLib', '2.0')
+gi.require_version('Gio', '2.0')
 gi.require_version('BlockDev', '3.0')
-from gi.repository import GLib, BlockDev
+from gi.repository import GLib, Gio, BlockDev
 
 
 class UtilsTestCase(unittest.TestCase):
@@ -396,6 +401,315 @@ class UtilsExecLoggingTest(UtilsTestCase):
         self.assertTrue(status)
 
 
+class UtilsExecPolicyTest(UtilsTestCase):
+
+    def setUp(self):
+        self.addCleanup(self._clean_up)
+
+    def _clean_up(self):
+        BlockDev.utils_set_exec_policy_thread(None)
+        BlockDev.utils_set_exec_policy(None)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_exec_policy_set(self):
+        """Verify that setting the exec policy works as expected"""
+
+        self.assertIsNone(BlockDev.utils_get_exec_policy())
+
+        policy = BlockDev.UtilsExecPolicy(timeout=10, nice=5)
+        succ = BlockDev.utils_set_exec_policy(policy)
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.utils_get_exec_policy().timeout, 10)
+
+        # thread policy takes precedence
+        policy = BlockDev.UtilsExecPolicy(timeout=20)
+        succ = BlockDev.utils_set_exec_policy_thread(policy)
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.utils_get_exec_policy().timeout, 20)
+        self.assertEqual(BlockDev.utils_get_exec_policy().nice, 0)
+
+        succ = BlockDev.utils_set_exec_policy_thread(None)
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.utils_get_exec_policy().timeout, 10)
+
+        with self.assertRaisesRegex(GLib.GError, "Invalid I/O priority level"):
+            BlockDev.utils_set_exec_policy_thread(BlockDev.UtilsExecPolicy(ioprio_class=BlockDev.UtilsIOPrioClass.BE, ioprio_level=8))
+        with self.assertRaisesRegex(GLib.GError, "Invalid CPU list"):
+            BlockDev.utils_set_exec_policy_thread(BlockDev.UtilsExecPolicy(cpu_affinity="0-"))
+        with self.assertRaisesRegex(GLib.GError, "is not a cgroup v2 directory"):
+            BlockDev.utils_set_exec_policy_thread(BlockDev.UtilsExecPolicy(cgroup="/tmp"))
+
+        # invalid policy doesn't replace the previous one
+        self.assertEqual(BlockDev.utils_get_exec_policy().timeout, 10)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_exec_policy_timeout(self):
+        """Verify that processes are killed after the exec policy timeout"""
+
+        BlockDev.utils_set_exec_policy_thread(BlockDev.UtilsExecPolicy(timeout=1))
+
+        start = time.monotonic()
+        with self.assertRaisesRegex(GLib.GError, r"Process didn't finish in 1 seconds and was killed"):
+            BlockDev.utils_exec_and_report_error(["sleep", "30"])
+        self.assertLess(time.monotonic() - start, 10)
+
+        # the whole process group is killed, not just the direct child
+        start = time.monotonic()
+        with self.assertRaisesRegex(GLib.GError, r"Process didn't finish in 1 seconds and was killed"):
+            BlockDev.utils_exec_and_capture_output(["bash", "-c", "sleep 37 | cat"])
+        self.assertLess(time.monotonic() - start, 10)
+        time.sleep(0.5)
+        ret, _out, _err = run_command("pgrep -f '[s]leep 37'")
+        self.assertNotEqual(ret, 0)
+
+        # no-progress variant normally uses a different code path
+        start = time.monotonic()
+        with self.assertRaisesRegex(GLib.GError, r"Process didn't finish in 1 seconds and was killed"):
+            BlockDev.utils_exec_and_report_error_no_progress(["sleep", "30"])
+        self.assertLess(time.monotonic() - start, 10)
+
+        # quick processes are not affected
+        succ, out, err, status = BlockDev.utils_exec_and_capture_output_no_progress(["bash", "-c", "echo out; echo err >&2; exit 3"])
+        self.assertTrue(succ)
+        self.assertEqual(out, "out\n")
+        self.assertEqual(err, "err\n")
+        self.assertEqual(status, 3)
+
+        succ, out = BlockDev.utils_exec_and_capture_output(["echo", "hello"])
+        self.assertTrue(succ)
+        self.assertEqual(out, "hello\n")
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_exec_policy_priority(self):
+        """Verify that niceness, I/O priority and CPU affinity are applied"""
+
+        niceness = os.nice(0)
+        BlockDev.utils_set_exec_policy_thread(BlockDev.UtilsExecPolicy(nice=3, cpu_affinity="0"))
+
+        succ, out = BlockDev.utils_exec_and_capture_output(["nice"])
+        self.assertTrue(succ)
+        self.assertEqual(int(out), min(niceness + 3, 19))
+
+        succ, out = BlockDev.utils_exec_and_capture_output(["grep", "Cpus_allowed_list", "/proc/self/status"])
+        self.assertTrue(succ)
+        self.assertEqual(out.split()[-1], "0")
+
+        if not shutil.which("ionice"):
+            self.skipTest("skipping I/O priority test: ionice not available")
+
+        BlockDev.utils_set_exec_policy_thread(BlockDev.UtilsExecPolicy(ioprio_class=BlockDev.UtilsIOPrioClass.IDLE))
+        succ, out = BlockDev.utils_exec_and_capture_output(["bash", "-c", "ionice -p $$"])
+        self.assertTrue(succ)
+        self.assertEqual(out.strip(), "idle")
+
+        BlockDev.utils_set_exec_policy_thread(BlockDev.UtilsExecPolicy(ioprio_class=BlockDev.UtilsIOPrioClass.BE, ioprio_level=6))
+        succ, out = BlockDev.utils_exec_and_capture_output(["bash", "-c", "ionice -p $$"])
+        self.assertTrue(succ)
+        self.assertEqual(out.strip(), "best-effort: prio 6")
+
+
+class UtilsExecCancelTest(UtilsTestCase):
+
+    def setUp(self):
+        self.addCleanup(BlockDev.utils_set_cancellable_thread, None)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_exec_cancel(self):
+        """Verify that processes are killed when the thread's cancellable is cancelled"""
+
+        cancellable = Gio.Cancellable()
+        succ = BlockDev.utils_set_cancellable_thread(cancellable)
+        self.assertTrue(succ)
+
+        # not cancelled, no effect
+        succ, out = BlockDev.utils_exec_and_capture_output(["echo", "hello"])
+        self.assertTrue(succ)
+        self.assertEqual(out, "hello\n")
+
+        timer = threading.Timer(1, cancellable.cancel)
+        timer.start()
+        start = time.monotonic()
+        with self.assertRaisesRegex(GLib.GError, r"Process was cancelled and killed"):
+            BlockDev.utils_exec_and_report_error(["bash", "-c", "sleep 38 | cat"])
+        self.assertLess(time.monotonic() - start, 10)
+        timer.join()
+        time.sleep(0.5)
+        ret, _out, _err = run_command("pgrep -f '[s]leep 38'")
+        self.assertNotEqual(ret, 0)
+
+        # already cancelled, nothing is run
+        with self.assertRaisesRegex(GLib.GError, r"Operation was cancelled"):
+            BlockDev.utils_exec_and_report_error_no_progress(["true"])
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_async_proxy(self):
+        """Verify that functions can be awaited, cancelled and report progress"""
+
+        async def run_ok():
+            op = BlockDev.aio.utils.exec_and_capture_output(["echo", "hello"])
+            events = [event async for event in op.progress()]
+            succ, out = await op
+            return events, succ, out
+
+        events, succ, out = asyncio.run(run_ok())
+        self.assertTrue(succ)
+        self.assertEqual(out, "hello\n")
+        self.assertEqual(events[0].status, BlockDev.UtilsProgStatus.STARTED)
+        self.assertEqual(events[-1].status, BlockDev.UtilsProgStatus.FINISHED)
+
+        async def run_fail():
+            await BlockDev.aio.utils.exec_and_report_error(["false"])
+
+        # exceptions are transformed the same way as with BlockDev.utils
+        with self.assertRaises(BlockDev.UtilsError):
+            asyncio.run(run_fail())
+
+        async def run_cancel():
+            task = asyncio.ensure_future(BlockDev.aio.utils.exec_and_report_error(["sleep", "39"]))
+            await asyncio.sleep(1)
+            task.cancel()
+            try:
+                await task
+            except asyncio.CancelledError:
+                pass
+
+        start = time.monotonic()
+        asyncio.run(run_cancel())
+        self.assertLess(time.monotonic() - start, 10)
+        time.sleep(0.5)
+        ret, _out, _err = run_command("pgrep -f '[s]leep 39'")
+        self.assertNotEqual(ret, 0)
+
+
+class UtilsContextTest(UtilsTestCase):
+    global_log = ""
+    ctx_log = ""
+
+    def my_global_log_func(self, level, msg):
+        self.global_log += msg + "\n"
+
+    def my_ctx_log_func(self, level, msg):
+        self.ctx_log += msg + "\n"
+
+    def setUp(self):
+        self.addCleanup(self._clean_up)
+
+    def _clean_up(self):
+        self.global_log = ""
+        self.ctx_log = ""
+        BlockDev.utils_init_logging(None)
+        BlockDev.utils_set_log_level(BlockDev.UTILS_LOG_WARNING)
+
+    def _run_in_thread(self, func):
+        result = {}
+
+        def _thread_func():
+            try:
+                result["ret"] = func()
+            except Exception as e:  # pylint: disable=broad-except
+                result["exc"] = e
+
+        thread = threading.Thread(target=_thread_func)
+        thread.start()
+        thread.join()
+
+        if "exc" in result:
+            raise result["exc"]
+        return result["ret"]
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_context_logging(self):
+        """Verify that logging settings from a context are used only in its threads"""
+
+        BlockDev.utils_init_logging(self.my_global_log_func)
+
+        ctx = BlockDev.Context.new()
+        ctx.set_log_func(self.my_ctx_log_func)
+        ctx.set_log_level(BlockDev.UTILS_LOG_INFO)
+
+        def _ctx_thread():
+            ctx.set_thread()
+            self.assertIsNotNone(BlockDev.context_get_thread())
+            return BlockDev.utils_exec_and_report_error(["echo", "context"])
+
+        self.assertTrue(self._run_in_thread(_ctx_thread))
+        self.assertIn("Running", self.ctx_log)
+        self.assertIn("echo context", self.ctx_log)
+        self.assertFalse(self.global_log)
+
+        # no context in this thread -> global settings (log level warning)
+        self.assertIsNone(BlockDev.context_get_thread())
+        succ = BlockDev.utils_exec_and_report_error(["echo", "global"])
+        self.assertTrue(succ)
+        self.assertNotIn("echo global", self.ctx_log)
+        self.assertFalse(self.global_log)
+
+        # unset settings fall back to the global ones
+        ctx.reset()
+        ctx.set_log_level(BlockDev.UTILS_LOG_INFO)
+        self.ctx_log = ""
+        self.assertTrue(self._run_in_thread(_ctx_thread))
+        self.assertIn("echo context", self.global_log)
+        self.assertFalse(self.ctx_log)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_context_exec_policy(self):
+        """Verify that exec policy from a context is used only in its threads"""
+
+        ctx = BlockDev.Context.new()
+        succ = ctx.set_exec_policy(BlockDev.UtilsExecPolicy(timeout=42))
+        self.assertTrue(succ)
+
+        with self.assertRaisesRegex(GLib.GError, "Invalid I/O priority level"):
+            ctx.set_exec_policy(BlockDev.UtilsExecPolicy(ioprio_class=BlockDev.UtilsIOPrioClass.BE, ioprio_level=8))
+
+        def _ctx_thread():
+            ctx.set_thread()
+            return BlockDev.utils_get_exec_policy()
+
+        policy = self._run_in_thread(_ctx_thread)
+        self.assertEqual(policy.timeout, 42)
+        self.assertIsNone(BlockDev.utils_get_exec_policy())
+
+        # thread policy takes precedence over the context one
+        def _ctx_thread_policy():
+            ctx.set_thread()
+            BlockDev.utils_set_exec_policy_thread(BlockDev.UtilsExecPolicy(timeout=7))
+            return BlockDev.utils_get_exec_policy()
+
+        policy = self._run_in_thread(_ctx_thread_policy)
+        self.assertEqual(policy.timeout, 7)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_context_lvm_config(self):
+        """Verify that LVM settings can be stored in a context"""
+
+        ctx = BlockDev.Context.new()
+
+        succ, config = ctx.get_lvm_config()
+        self.assertFalse(succ)
+
+        ctx.set_lvm_config("backup {backup=0 archive=0}")
+        succ, config = ctx.get_lvm_config()
+        self.assertTrue(succ)
+        self.assertEqual(config, "backup {backup=0 archive=0}")
+
+        # empty string means no config (not the global one)
+        ctx.set_lvm_config("")
+        succ, config = ctx.get_lvm_config()
+        self.assertTrue(succ)
+        self.assertIsNone(config)
+
+        ctx.set_lvm_devices(["/dev/sda", "/dev/sdb"])
+        succ, devices = ctx.get_lvm_devices()
+        self.assertTrue(succ)
+        self.assertEqual(devices, ["/dev/sda", "/dev/sdb"])
+
+        ctx.set_lvm_devices(None)
+        succ, devices = ctx.get_lvm_devices()
+        self.assertFalse(succ)
+
+
 class UtilsDevUtilsTestCase(UtilsTestCase):
     @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
     def test_resolve_device(self):
@@ -478,6 +792,140 @@ class UtilsDevUtilsSymlinksTestCase(UtilsTestCase):
         # there should be at least 4 symlinks for an LV
         self.assertGreaterEqual(len(symlinks), 4)
 
+    @tag_test(TestTags.CORE)
+    def test_get_whole_disk_name(self):
+        """Verify that getting the disk of a partition works as expected"""
+
+        disk = os.path.basename(self.loop_dev)
+        self.assertEqual(BlockDev.utils_get_whole_disk_name(disk), disk)
+
+        ret, _out, _err = run_command("sfdisk %s" % self.loop_dev, cmd_input=b",16M\n")
+        self.assertEqual(ret, 0)
+        run_command("udevadm settle")
+
+        self.assertEqual(BlockDev.utils_get_whole_disk_name(disk + "1"), disk)
+
+
+class UtilsIOStatTestCase(UtilsTestCase):
+    def setUp(self):
+        self.addCleanup(self._clean_up)
+        self.dev_file = create_sparse_tempfile("iostat_test", 1024**3)
+        try:
+            self.loop_dev = create_lio_device(self.dev_file)
+        except RuntimeError as e:
+            raise RuntimeError("Failed to setup loop device for testing: %s" % e)
+
+    def _clean_up(self):
+        run_command("dmsetup remove utilsTestIOStat")
+        try:
+            delete_lio_device(self.loop_dev)
+        except RuntimeError:
+            # just move on, we can do no better here
+            pass
+        os.unlink(self.dev_file)
+
+    @tag_test(TestTags.CORE)
+    def test_iostat_sample(self):
+        """Verify that sampling I/O statistics works as expected"""
+
+        disk = os.path.basename(self.loop_dev)
+
+        # stack a DM device on top of the disk
+        ret, _out, _err = run_command("dmsetup create utilsTestIOStat --table '0 204800 linear %s 0'" % self.loop_dev)
+        self.assertEqual(ret, 0)
+        dm_dev = os.path.basename(os.path.realpath("/dev/mapper/utilsTestIOStat"))
+
+        before = BlockDev.utils_iostat_sample()
+        stats = {stat.device: stat for stat in before}
+        self.assertIn(disk, stats)
+        self.assertIn(dm_dev, stats)
+        self.assertEqual(stats[dm_dev].slaves, [disk])
+
+        ret, _out, _err = run_command("dd if=/dev/zero of=/dev/mapper/utilsTestIOStat bs=4096 count=256 oflag=direct")
+        self.assertEqual(ret, 0)
+        time.sleep(0.5)
+
+        after = BlockDev.utils_iostat_sample()
+        stats = {stat.device: stat for stat in after}
+        self.assertGreaterEqual(stats[dm_dev].write_ios, 256)
+
+        rates = {r.device: r for r in BlockDev.utils_iostat_compute_rates(before, after)}
+        self.assertIn(dm_dev, rates)
+        self.assertGreater(rates[dm_dev].interval, 0)
+        self.assertGreater(rates[dm_dev].write_iops, 0)
+        self.assertAlmostEqual(rates[dm_dev].write_bps * rates[dm_dev].interval, 256 * 4096, delta=64 * 4096)
+        self.assertGreater(rates[disk].write_iops, 0)
+        self.assertGreaterEqual(rates[dm_dev].added_latency, 0)
+        self.assertLessEqual(rates[dm_dev].added_latency, rates[dm_dev].latency)
+        self.assertLessEqual(rates[dm_dev].utilization, 100)
+
+        # snapshots in the wrong order
+        with self.assertRaisesRegex(GLib.GError, "not newer"):
+            BlockDev.utils_iostat_compute_rates(after, before)
+
+
+class UtilsQueueSettingsTestCase(UtilsTestCase):
+    def setUp(self):
+        self.addCleanup(self._clean_up)
+        self.dev_file = create_sparse_tempfile("queue_test", 1024**3)
+        try:
+            self.loop_dev = create_lio_device(self.dev_file)
+        except RuntimeError as e:
+            raise RuntimeError("Failed to setup loop device for testing: %s" % e)
+
+    def _clean_up(self):
+        run_command("dmsetup remove utilsTestQueue")
+        try:
+            delete_lio_device(self.loop_dev)
+        except RuntimeError:
+            # just move on, we can do no better here
+            pass
+        os.unlink(self.dev_file)
+
+    @tag_test(TestTags.CORE)
+    def test_queue_settings(self):
+        """Verify that getting and setting queue settings works as expected"""
+
+        disk = os.path.basename(self.loop_dev)
+
+        settings = BlockDev.utils_get_queue_settings(self.loop_dev)
+        self.assertEqual(settings.device, disk)
+        self.assertEqual(settings.read_ahead_kb, int(read_file("/sys/block/%s/queue/read_ahead_kb" % disk)))
+        self.assertIn("[%s]" % settings.scheduler, read_file("/sys/block/%s/queue/scheduler" % disk))
+        orig_read_ahead = settings.read_ahead_kb
+
+        with self.assertRaisesRegex(GLib.GError, "Invalid value"):
+            BlockDev.utils_set_queue_settings(self.loop_dev, BlockDev.UtilsQueueSettings(rq_affinity=3), False)
+        with self.assertRaisesRegex(GLib.GError, "not available"):
+            BlockDev.utils_set_queue_settings(self.loop_dev, BlockDev.UtilsQueueSettings(scheduler="no-such-scheduler"), False)
+
+        new_read_ahead = orig_read_ahead + 128
+        previous = BlockDev.utils_set_queue_settings(self.loop_dev, BlockDev.UtilsQueueSettings(read_ahead_kb=new_read_ahead), False)
+        self.assertEqual(len(previous), 1)
+        self.assertEqual(previous[0].device, disk)
+        self.assertEqual(previous[0].read_ahead_kb, orig_read_ahead)
+        self.assertEqual(previous[0].nr_requests, -1)
+        self.assertEqual(BlockDev.utils_get_queue_settings(self.loop_dev).read_ahead_kb, new_read_ahead)
+
+        succ = BlockDev.utils_restore_queue_settings(previous)
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.utils_get_queue_settings(self.loop_dev).read_ahead_kb, orig_read_ahead)
+
+        # the settings should be applied to the whole stack
+        ret, _out, _err = run_command("dmsetup create utilsTestQueue --table '0 204800 linear %s 0'" % self.loop_dev)
+        self.assertEqual(ret, 0)
+        dm_dev = os.path.basename(os.path.realpath("/dev/mapper/utilsTestQueue"))
+
+        previous = BlockDev.utils_set_queue_settings("/dev/mapper/utilsTestQueue",
+                                                     BlockDev.UtilsQueueSettings(read_ahead_kb=new_read_ahead), True)
+        self.assertEqual(sorted(p.device for p in previous), sorted([disk, dm_dev]))
+        self.assertEqual(BlockDev.utils_get_queue_settings(self.loop_dev).read_ahead_kb, new_read_ahead)
+        self.assertEqual(BlockDev.utils_get_queue_settings(dm_dev).read_ahead_kb, new_read_ahead)
+
+        succ = BlockDev.utils_restore_queue_settings(previous)
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.utils_get_queue_settings(self.loop_dev).read_ahead_kb, orig_read_ahead)
+
 
 class UtilsLinuxKernelVersionTest(UtilsTestCase):
     @tag_test(TestTags.NOSTORAGE, TestTags.CORE)